@@ -1,5 +1,6 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
+using System.IO;
 using UnrealBuildTool;
 
 public class GraphicTools : ModuleRules
@@ -17,6 +18,8 @@ public class GraphicTools : ModuleRules
 		
 		PrivateIncludePaths.AddRange(
 			new string[] {
+				// the tracers draw from a scene view extension, which is handed the renderer's FPostProcessingInputs and FViewInfo
+				Path.Combine(EngineDirectory, "Source/Runtime/Renderer/Private"),
 				// ... add other private include paths required here ...
 			}
 			);
@@ -42,6 +45,7 @@ public class GraphicTools : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"ImageWrapper",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
@@ -0,0 +1,752 @@
+#include "GraphicToolsBlockCompression.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsGPUScheduler.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "GlobalShader.h"
+#include "Math/RandomStream.h"
+#include "RenderTargetPool.h"
+#include "RHIGPUReadback.h"
+#include "ShaderParameterUtils.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsBlockCompression, Log, All);
+
+template<EGraphicToolsBlockFormat Format>
+class TBlockCompressionCS : public FGlobalShader
+{
+	DECLARE_SHADER_TYPE(TBlockCompressionCS, Global);
+public:
+
+	TBlockCompressionCS()
+	{
+	}
+
+	TBlockCompressionCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGlobalShader(Initializer)
+	{
+		SourceTexture.Bind(Initializer.ParameterMap, TEXT("SourceTexture"));
+		SourceSize.Bind(Initializer.ParameterMap, TEXT("SourceSize"));
+		Blocks.Bind(Initializer.ParameterMap, TEXT("RWBlocks"));
+		NumBlocks.Bind(Initializer.ParameterMap, TEXT("NumBlocks"));
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("BLOCK_FORMAT"), (uint32)Format);
+	}
+
+	void SetParameters(FRHICommandList& RHICmdList, FRHITexture* Source, FIntPoint InSourceSize, FRHIUnorderedAccessView* BlocksUAV, FIntPoint InNumBlocks)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetTextureParameter(RHICmdList, ShaderRHI, SourceTexture, Source);
+		SetShaderValue(RHICmdList, ShaderRHI, SourceSize, InSourceSize);
+		SetUAVParameter(RHICmdList, ShaderRHI, Blocks, BlocksUAV);
+		SetShaderValue(RHICmdList, ShaderRHI, NumBlocks, InNumBlocks);
+	}
+
+	void UnsetParameters(FRHICommandList& RHICmdList)
+	{
+		SetUAVParameter(RHICmdList, RHICmdList.GetBoundComputeShader(), Blocks, nullptr);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, SourceTexture);
+	LAYOUT_FIELD(FShaderParameter, SourceSize);
+	LAYOUT_FIELD(FShaderResourceParameter, Blocks);
+	LAYOUT_FIELD(FShaderParameter, NumBlocks);
+};
+
+IMPLEMENT_SHADER_TYPE(template<>, TBlockCompressionCS<EGraphicToolsBlockFormat::BC1>, TEXT("/Plugin/GraphicTools/Private/BlockCompression.usf"), TEXT("CompressCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TBlockCompressionCS<EGraphicToolsBlockFormat::BC3>, TEXT("/Plugin/GraphicTools/Private/BlockCompression.usf"), TEXT("CompressCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TBlockCompressionCS<EGraphicToolsBlockFormat::BC5>, TEXT("/Plugin/GraphicTools/Private/BlockCompression.usf"), TEXT("CompressCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TBlockCompressionCS<EGraphicToolsBlockFormat::BC7>, TEXT("/Plugin/GraphicTools/Private/BlockCompression.usf"), TEXT("CompressCS"), SF_Compute);
+
+template<EGraphicToolsBlockFormat Format>
+static void DispatchBlockCompression_RenderThread(FRHICommandListImmediate& RHICmdList, FGlobalShaderMap* ShaderMap, FRHITexture2D* Source, FRHIUnorderedAccessView* BlocksUAV, FIntPoint NumBlocks)
+{
+	TShaderMapRef<TBlockCompressionCS<Format>> ComputeShader(ShaderMap);
+	RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
+	ComputeShader->SetParameters(RHICmdList, Source, Source->GetSizeXY(), BlocksUAV, NumBlocks);
+	DispatchComputeShader(RHICmdList, ComputeShader, FMath::DivideAndRoundUp(NumBlocks.X, 8), FMath::DivideAndRoundUp(NumBlocks.Y, 8), 1);
+	ComputeShader->UnsetParameters(RHICmdList);
+}
+
+TRefCountPtr<IPooledRenderTarget> CompressBlocks_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRHITexture2D* Source,
+	EGraphicToolsBlockFormat Format
+)
+{
+	check(IsInRenderingThread());
+
+	const FIntPoint NumBlocks(FMath::DivideAndRoundUp<int32>(Source->GetSizeX(), 4), FMath::DivideAndRoundUp<int32>(Source->GetSizeY(), 4));
+	const EPixelFormat BlockFormat = FGraphicToolsBlockCompression::GetBlockBytes(Format) == 8 ? PF_R32G32_UINT : PF_R32G32B32A32_UINT;
+	TRefCountPtr<IPooledRenderTarget> Blocks = AllocateImageIntermediate(RHICmdList, NumBlocks, BlockFormat, 1, TEXT("GraphicTools.CompressedBlocks"));
+	const FSceneRenderTargetItem& BlocksItem = Blocks->GetRenderTargetItem();
+
+	SCOPED_DRAW_EVENT(RHICmdList, GraphicToolsBlockCompression);
+
+	RHICmdList.Transition({
+		FRHITransitionInfo(Source, ERHIAccess::Unknown, ERHIAccess::SRVCompute),
+		FRHITransitionInfo(BlocksItem.UAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute)
+	});
+
+	FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(FeatureLevel);
+	switch (Format)
+	{
+	case EGraphicToolsBlockFormat::BC1: DispatchBlockCompression_RenderThread<EGraphicToolsBlockFormat::BC1>(RHICmdList, ShaderMap, Source, BlocksItem.UAV, NumBlocks); break;
+	case EGraphicToolsBlockFormat::BC3: DispatchBlockCompression_RenderThread<EGraphicToolsBlockFormat::BC3>(RHICmdList, ShaderMap, Source, BlocksItem.UAV, NumBlocks); break;
+	case EGraphicToolsBlockFormat::BC5: DispatchBlockCompression_RenderThread<EGraphicToolsBlockFormat::BC5>(RHICmdList, ShaderMap, Source, BlocksItem.UAV, NumBlocks); break;
+	case EGraphicToolsBlockFormat::BC7: DispatchBlockCompression_RenderThread<EGraphicToolsBlockFormat::BC7>(RHICmdList, ShaderMap, Source, BlocksItem.UAV, NumBlocks); break;
+	}
+
+	return Blocks;
+}
+
+void ReadBackBlocks_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FRHITexture2D* Blocks,
+	EGraphicToolsBlockFormat Format,
+	TArray<uint8>& OutBlocks
+)
+{
+	check(IsInRenderingThread());
+
+	RHICmdList.Transition(FRHITransitionInfo(Blocks, ERHIAccess::Unknown, ERHIAccess::CopySrc));
+
+	FRHIGPUTextureReadback Readback(TEXT("GraphicTools.BlocksReadback"));
+	Readback.EnqueueCopy(RHICmdList, Blocks);
+	RHICmdList.BlockUntilGPUIdle();
+
+	const int32 BlockBytes = FGraphicToolsBlockCompression::GetBlockBytes(Format);
+	const int32 RowBytes = Blocks->GetSizeX() * BlockBytes;
+	OutBlocks.SetNumUninitialized(RowBytes * Blocks->GetSizeY());
+
+	void* Data = nullptr;
+	int32 RowPitchInPixels = 0;
+	Readback.LockTexture(RHICmdList, Data, RowPitchInPixels);
+	for (uint32 Row = 0; Row < Blocks->GetSizeY(); ++Row)
+	{
+		FMemory::Memcpy(OutBlocks.GetData() + Row * RowBytes, static_cast<const uint8*>(Data) + Row * RowPitchInPixels * BlockBytes, RowBytes);
+	}
+	Readback.Unlock();
+}
+
+void MakeBlockCompressionTestImage(int32 Size, TArray<FLinearColor>& OutPixels)
+{
+	OutPixels.SetNumUninitialized(Size * Size);
+	FRandomStream Random(Size);
+	for (int32 Y = 0; Y < Size; ++Y)
+	{
+		for (int32 X = 0; X < Size; ++X)
+		{
+			const float U = (float)X / Size;
+			const float V = (float)Y / Size;
+			const float Checker = ((X / 64) + (Y / 64)) % 2 == 0 ? 1.0f : 0.6f;
+			const float Noise = (Random.GetFraction() - 0.5f) * 0.04f;
+			const float Falloff = FMath::Clamp(1.5f - 2.0f * FVector2D(U - 0.5f, V - 0.5f).Size(), 0.0f, 1.0f);
+			OutPixels[Y * Size + X] = FLinearColor(U * Checker + Noise, V * Checker + Noise, 0.5f + 0.5f * FMath::Sin(U * 20.0f) * Checker, Falloff);
+		}
+	}
+}
+
+// Blocks and compressed textures have the same bytes per block, so the copy moves one texel of Blocks into
+// each 4x4 block of Destination. Size counts blocks.
+static void CopyBlocksToTexture_RenderThread(FRHICommandListImmediate& RHICmdList, FRHITexture2D* Blocks, FRHITexture2D* Destination)
+{
+	RHICmdList.Transition({
+		FRHITransitionInfo(Blocks, ERHIAccess::Unknown, ERHIAccess::CopySrc),
+		FRHITransitionInfo(Destination, ERHIAccess::Unknown, ERHIAccess::CopyDest)
+	});
+
+	FRHICopyTextureInfo CopyInfo;
+	CopyInfo.Size = FIntVector(Blocks->GetSizeX(), Blocks->GetSizeY(), 1);
+	RHICmdList.CopyTexture(Blocks, Destination, CopyInfo);
+
+	RHICmdList.Transition(FRHITransitionInfo(Destination, ERHIAccess::CopyDest, ERHIAccess::SRVMask));
+}
+
+// The CPU encoders below mirror BlockCompression.usf function for function
+
+static float LinearToSRGB(float Value)
+{
+	Value = FMath::Clamp(Value, 0.0f, 1.0f);
+	return Value <= 0.0031308f ? Value * 12.92f : 1.055f * FMath::Pow(Value, 1.0f / 2.4f) - 0.055f;
+}
+
+/** The values a format stores for a linear color: sRGB colors or linear BC5, clamped to [0, 1] */
+static FVector4 ToStoredValues(const FLinearColor& Color, EGraphicToolsBlockFormat Format)
+{
+	if (Format == EGraphicToolsBlockFormat::BC5)
+	{
+		return FVector4(FMath::Clamp(Color.R, 0.0f, 1.0f), FMath::Clamp(Color.G, 0.0f, 1.0f), 0.0f, 1.0f);
+	}
+	return FVector4(LinearToSRGB(Color.R), LinearToSRGB(Color.G), LinearToSRGB(Color.B), FMath::Clamp(Color.A, 0.0f, 1.0f));
+}
+
+static uint32 Quantize(float Value, float Scale)
+{
+	return (uint32)FMath::RoundToInt(FMath::Clamp(Value, 0.0f, 1.0f) * Scale);
+}
+
+struct FBlockBits
+{
+	uint32 Words[4] = {};
+	uint32 Offset = 0;
+
+	void Write(uint32 Value, uint32 Count)
+	{
+		const uint32 Word = Offset >> 5;
+		const uint32 Shift = Offset & 31;
+		Words[Word] |= Value << Shift;
+		if (Shift + Count > 32)
+		{
+			Words[Word + 1] |= Value >> (32 - Shift);
+		}
+		Offset += Count;
+	}
+
+	uint32 Read(uint32 Count)
+	{
+		const uint32 Word = Offset >> 5;
+		const uint32 Shift = Offset & 31;
+		uint64 Value = Words[Word] >> Shift;
+		if (Shift + Count > 32)
+		{
+			Value |= (uint64)Words[Word + 1] << (32 - Shift);
+		}
+		Offset += Count;
+		return (uint32)Value & ((1u << Count) - 1);
+	}
+};
+
+static uint32 PackRGB565(const FVector& Color)
+{
+	return (Quantize(Color.X, 31.0f) << 11) | (Quantize(Color.Y, 63.0f) << 5) | Quantize(Color.Z, 31.0f);
+}
+
+static FVector UnpackRGB565(uint32 Packed)
+{
+	return FVector(((Packed >> 11) & 31) / 31.0f, ((Packed >> 5) & 63) / 63.0f, (Packed & 31) / 31.0f);
+}
+
+static void EncodeBC1(const FVector4 Texels[16], uint32 OutWords[2])
+{
+	FVector MinColor(Texels[0]);
+	FVector MaxColor(Texels[0]);
+	for (int32 Index = 1; Index < 16; ++Index)
+	{
+		MinColor = MinColor.ComponentMin(FVector(Texels[Index]));
+		MaxColor = MaxColor.ComponentMax(FVector(Texels[Index]));
+	}
+
+	const FVector Inset = (MaxColor - MinColor) / 16.0f;
+	uint32 Color0 = PackRGB565(MaxColor - Inset);
+	uint32 Color1 = PackRGB565(MinColor + Inset);
+
+	// Color0 > Color1 selects the four color mode
+	if (Color0 < Color1)
+	{
+		Swap(Color0, Color1);
+	}
+	OutWords[0] = Color0 | (Color1 << 16);
+	OutWords[1] = 0;
+	if (Color0 == Color1)
+	{
+		return;
+	}
+
+	const FVector Endpoint0 = UnpackRGB565(Color0);
+	const FVector Axis = UnpackRGB565(Color1) - Endpoint0;
+	const float InvLengthSquared = 1.0f / FMath::Max(Axis.SizeSquared(), 1e-8f);
+
+	// steps from Color0 to Color1 to the index that names them
+	static const uint32 StepToIndex[4] = { 0, 2, 3, 1 };
+
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		const uint32 Step = Quantize(((FVector(Texels[Index]) - Endpoint0) | Axis) * InvLengthSquared, 3.0f);
+		OutWords[1] |= StepToIndex[Step] << (2 * Index);
+	}
+}
+
+static void EncodeBC4(const float Values[16], uint32 OutWords[2])
+{
+	float MinValue = Values[0];
+	float MaxValue = Values[0];
+	for (int32 Index = 1; Index < 16; ++Index)
+	{
+		MinValue = FMath::Min(MinValue, Values[Index]);
+		MaxValue = FMath::Max(MaxValue, Values[Index]);
+	}
+
+	// Value0 > Value1 selects the eight value mode
+	const uint32 Value0 = Quantize(MaxValue, 255.0f);
+	const uint32 Value1 = Quantize(MinValue, 255.0f);
+
+	FBlockBits Bits;
+	Bits.Write(Value0, 8);
+	Bits.Write(Value1, 8);
+	if (Value0 != Value1)
+	{
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			// 0 is Value1 and 7 is Value0, the indices run 1, 7, 6, .. 2, 0 along the same line
+			const uint32 Step = Quantize((FMath::Clamp(Values[Index], 0.0f, 1.0f) * 255.0f - Value1) / (float)(Value0 - Value1), 7.0f);
+			Bits.Write(Step == 7 ? 0 : (Step == 0 ? 1 : 8 - Step), 3);
+		}
+	}
+	OutWords[0] = Bits.Words[0];
+	OutWords[1] = Bits.Words[1];
+}
+
+// 7 bit endpoint plus the p-bit that lands closest to Value
+static void QuantizeBC7Endpoint(const FVector4& Value, uint32 OutQuantized[4], uint32& OutPBit)
+{
+	float BestError = MAX_flt;
+	for (uint32 Bit = 0; Bit < 2; ++Bit)
+	{
+		uint32 Candidate[4];
+		float Error = 0.0f;
+		for (int32 Channel = 0; Channel < 4; ++Channel)
+		{
+			Candidate[Channel] = (uint32)FMath::Clamp(FMath::RoundToInt((FMath::Clamp(Value[Channel], 0.0f, 1.0f) * 255.0f - Bit) * 0.5f), 0, 127);
+			Error += FMath::Square((Candidate[Channel] * 2 + Bit) / 255.0f - Value[Channel]);
+		}
+		if (Error < BestError)
+		{
+			BestError = Error;
+			FMemory::Memcpy(OutQuantized, Candidate, sizeof(Candidate));
+			OutPBit = Bit;
+		}
+	}
+}
+
+static void EncodeBC7(const FVector4 Texels[16], uint32 OutWords[4])
+{
+	FVector4 MinColor = Texels[0];
+	FVector4 MaxColor = Texels[0];
+	for (int32 Index = 1; Index < 16; ++Index)
+	{
+		for (int32 Channel = 0; Channel < 4; ++Channel)
+		{
+			MinColor[Channel] = FMath::Min(MinColor[Channel], Texels[Index][Channel]);
+			MaxColor[Channel] = FMath::Max(MaxColor[Channel], Texels[Index][Channel]);
+		}
+	}
+
+	const FVector4 Inset = (MaxColor - MinColor) / 32.0f;
+	uint32 Endpoints[2][4];
+	uint32 PBits[2];
+	QuantizeBC7Endpoint(MinColor + Inset, Endpoints[0], PBits[0]);
+	QuantizeBC7Endpoint(MaxColor - Inset, Endpoints[1], PBits[1]);
+
+	FVector4 Endpoint0;
+	FVector4 Axis;
+	for (int32 Channel = 0; Channel < 4; ++Channel)
+	{
+		Endpoint0[Channel] = (Endpoints[0][Channel] * 2 + PBits[0]) / 255.0f;
+		Axis[Channel] = (Endpoints[1][Channel] * 2 + PBits[1]) / 255.0f - Endpoint0[Channel];
+	}
+	const float InvLengthSquared = 1.0f / FMath::Max(Dot4(Axis, Axis), 1e-8f);
+
+	uint32 Indices[16];
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		Indices[Index] = Quantize(Dot4(Texels[Index] - Endpoint0, Axis) * InvLengthSquared, 15.0f);
+	}
+
+	// the first index is stored without its top bit, which must be 0
+	if (Indices[0] >= 8)
+	{
+		for (int32 Channel = 0; Channel < 4; ++Channel)
+		{
+			Swap(Endpoints[0][Channel], Endpoints[1][Channel]);
+		}
+		Swap(PBits[0], PBits[1]);
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			Indices[Index] = 15 - Indices[Index];
+		}
+	}
+
+	FBlockBits Bits;
+	Bits.Write(1 << 6, 7);
+	for (int32 Channel = 0; Channel < 4; ++Channel)
+	{
+		Bits.Write(Endpoints[0][Channel], 7);
+		Bits.Write(Endpoints[1][Channel], 7);
+	}
+	Bits.Write(PBits[0], 1);
+	Bits.Write(PBits[1], 1);
+	Bits.Write(Indices[0], 3);
+	for (int32 Index = 1; Index < 16; ++Index)
+	{
+		Bits.Write(Indices[Index], 4);
+	}
+	FMemory::Memcpy(OutWords, Bits.Words, sizeof(Bits.Words));
+}
+
+static void EncodeBlock(const FVector4 Texels[16], EGraphicToolsBlockFormat Format, uint32 OutWords[4])
+{
+	float Channels[2][16];
+	switch (Format)
+	{
+	case EGraphicToolsBlockFormat::BC1:
+		EncodeBC1(Texels, OutWords);
+		break;
+	case EGraphicToolsBlockFormat::BC3:
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			Channels[0][Index] = Texels[Index].W;
+		}
+		EncodeBC4(Channels[0], OutWords);
+		EncodeBC1(Texels, OutWords + 2);
+		break;
+	case EGraphicToolsBlockFormat::BC5:
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			Channels[0][Index] = Texels[Index].X;
+			Channels[1][Index] = Texels[Index].Y;
+		}
+		EncodeBC4(Channels[0], OutWords);
+		EncodeBC4(Channels[1], OutWords + 2);
+		break;
+	case EGraphicToolsBlockFormat::BC7:
+		EncodeBC7(Texels, OutWords);
+		break;
+	}
+}
+
+static void DecodeBC1(const uint32 Words[2], FVector4 OutTexels[16])
+{
+	const uint32 Color0 = Words[0] & 0xFFFF;
+	const uint32 Color1 = Words[0] >> 16;
+	const FVector Endpoint0 = UnpackRGB565(Color0);
+	const FVector Endpoint1 = UnpackRGB565(Color1);
+
+	FVector Palette[4] = { Endpoint0, Endpoint1 };
+	if (Color0 > Color1)
+	{
+		Palette[2] = (Endpoint0 * 2.0f + Endpoint1) / 3.0f;
+		Palette[3] = (Endpoint0 + Endpoint1 * 2.0f) / 3.0f;
+	}
+	else
+	{
+		Palette[2] = (Endpoint0 + Endpoint1) * 0.5f;
+		Palette[3] = FVector::ZeroVector;
+	}
+
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		const FVector& Color = Palette[(Words[1] >> (2 * Index)) & 3];
+		OutTexels[Index] = FVector4(Color.X, Color.Y, Color.Z, OutTexels[Index].W);
+	}
+}
+
+static void DecodeBC4(const uint32 Words[2], float OutValues[16])
+{
+	FBlockBits Bits;
+	Bits.Words[0] = Words[0];
+	Bits.Words[1] = Words[1];
+	const uint32 Value0 = Bits.Read(8);
+	const uint32 Value1 = Bits.Read(8);
+
+	float Palette[8] = { Value0 / 255.0f, Value1 / 255.0f };
+	for (uint32 Index = 2; Index < 8; ++Index)
+	{
+		Palette[Index] = Value0 > Value1
+			? ((8 - Index) * Value0 + (Index - 1) * Value1) / (7.0f * 255.0f)
+			: Index < 6 ? ((6 - Index) * Value0 + (Index - 1) * Value1) / (5.0f * 255.0f) : (Index == 6 ? 0.0f : 1.0f);
+	}
+
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		OutValues[Index] = Value0 == Value1 ? Palette[0] : Palette[Bits.Read(3)];
+	}
+}
+
+static void DecodeBC7(const uint32 Words[4], FVector4 OutTexels[16])
+{
+	FBlockBits Bits;
+	FMemory::Memcpy(Bits.Words, Words, sizeof(Bits.Words));
+	if (Bits.Read(7) != 1 << 6)
+	{
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			OutTexels[Index] = FVector4(0.0f, 0.0f, 0.0f, 0.0f);
+		}
+		return;
+	}
+
+	uint32 Endpoints[2][4];
+	for (int32 Channel = 0; Channel < 4; ++Channel)
+	{
+		Endpoints[0][Channel] = Bits.Read(7);
+		Endpoints[1][Channel] = Bits.Read(7);
+	}
+	const uint32 PBit0 = Bits.Read(1);
+	const uint32 PBit1 = Bits.Read(1);
+
+	static const uint32 Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		const uint32 Weight = Weights[Bits.Read(Index == 0 ? 3 : 4)];
+		for (int32 Channel = 0; Channel < 4; ++Channel)
+		{
+			const uint32 Value0 = Endpoints[0][Channel] * 2 + PBit0;
+			const uint32 Value1 = Endpoints[1][Channel] * 2 + PBit1;
+			OutTexels[Index][Channel] = (((64 - Weight) * Value0 + Weight * Value1 + 32) >> 6) / 255.0f;
+		}
+	}
+}
+
+static void DecodeBlock(const uint32 Words[4], EGraphicToolsBlockFormat Format, FVector4 OutTexels[16])
+{
+	float Channels[2][16];
+	switch (Format)
+	{
+	case EGraphicToolsBlockFormat::BC1:
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			OutTexels[Index].W = 1.0f;
+		}
+		DecodeBC1(Words, OutTexels);
+		break;
+	case EGraphicToolsBlockFormat::BC3:
+		DecodeBC4(Words, Channels[0]);
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			OutTexels[Index].W = Channels[0][Index];
+		}
+		DecodeBC1(Words + 2, OutTexels);
+		break;
+	case EGraphicToolsBlockFormat::BC5:
+		DecodeBC4(Words, Channels[0]);
+		DecodeBC4(Words + 2, Channels[1]);
+		for (int32 Index = 0; Index < 16; ++Index)
+		{
+			OutTexels[Index] = FVector4(Channels[0][Index], Channels[1][Index], 0.0f, 1.0f);
+		}
+		break;
+	case EGraphicToolsBlockFormat::BC7:
+		DecodeBC7(Words, OutTexels);
+		break;
+	}
+}
+
+EPixelFormat FGraphicToolsBlockCompression::GetPixelFormat(EGraphicToolsBlockFormat Format)
+{
+	switch (Format)
+	{
+	case EGraphicToolsBlockFormat::BC1: return PF_DXT1;
+	case EGraphicToolsBlockFormat::BC3: return PF_DXT5;
+	case EGraphicToolsBlockFormat::BC5: return PF_BC5;
+	case EGraphicToolsBlockFormat::BC7: return PF_BC7;
+	}
+	return PF_Unknown;
+}
+
+int32 FGraphicToolsBlockCompression::GetBlockBytes(EGraphicToolsBlockFormat Format)
+{
+	return Format == EGraphicToolsBlockFormat::BC1 ? 8 : 16;
+}
+
+void FGraphicToolsBlockCompression::EncodeBlocks(const FLinearColor* Pixels, FIntPoint Size, EGraphicToolsBlockFormat Format, TArray<uint8>& OutBlocks)
+{
+	const FIntPoint NumBlocks(FMath::DivideAndRoundUp(Size.X, 4), FMath::DivideAndRoundUp(Size.Y, 4));
+	const int32 BlockBytes = GetBlockBytes(Format);
+	OutBlocks.SetNumUninitialized(NumBlocks.X * NumBlocks.Y * BlockBytes);
+
+	ParallelFor(NumBlocks.Y, [Pixels, Size, Format, NumBlocks, BlockBytes, &OutBlocks](int32 BlockY)
+	{
+		for (int32 BlockX = 0; BlockX < NumBlocks.X; ++BlockX)
+		{
+			FVector4 Texels[16];
+			for (int32 Index = 0; Index < 16; ++Index)
+			{
+				const int32 X = FMath::Min(BlockX * 4 + (Index & 3), Size.X - 1);
+				const int32 Y = FMath::Min(BlockY * 4 + (Index >> 2), Size.Y - 1);
+				Texels[Index] = ToStoredValues(Pixels[Y * Size.X + X], Format);
+			}
+
+			uint32 Words[4] = {};
+			EncodeBlock(Texels, Format, Words);
+			FMemory::Memcpy(OutBlocks.GetData() + (BlockY * NumBlocks.X + BlockX) * BlockBytes, Words, BlockBytes);
+		}
+	});
+}
+
+void FGraphicToolsBlockCompression::DecodeBlocks(const uint8* Blocks, FIntPoint Size, EGraphicToolsBlockFormat Format, TArray<FLinearColor>& OutPixels)
+{
+	const int32 NumBlocksX = FMath::DivideAndRoundUp(Size.X, 4);
+	const int32 BlockBytes = GetBlockBytes(Format);
+	OutPixels.SetNumUninitialized(Size.X * Size.Y);
+
+	for (int32 BlockY = 0; BlockY * 4 < Size.Y; ++BlockY)
+	{
+		for (int32 BlockX = 0; BlockX < NumBlocksX; ++BlockX)
+		{
+			uint32 Words[4] = {};
+			FMemory::Memcpy(Words, Blocks + (BlockY * NumBlocksX + BlockX) * BlockBytes, BlockBytes);
+
+			FVector4 Texels[16];
+			DecodeBlock(Words, Format, Texels);
+
+			for (int32 Index = 0; Index < 16; ++Index)
+			{
+				const int32 X = BlockX * 4 + (Index & 3);
+				const int32 Y = BlockY * 4 + (Index >> 2);
+				if (X < Size.X && Y < Size.Y)
+				{
+					OutPixels[Y * Size.X + X] = FLinearColor(Texels[Index]);
+				}
+			}
+		}
+	}
+}
+
+double FGraphicToolsBlockCompression::ComputePSNR(const FLinearColor* Reference, const uint8* Blocks, FIntPoint Size, EGraphicToolsBlockFormat Format)
+{
+	TArray<FLinearColor> Decoded;
+	DecodeBlocks(Blocks, Size, Format, Decoded);
+
+	const int32 NumChannels = Format == EGraphicToolsBlockFormat::BC1 ? 3 : (Format == EGraphicToolsBlockFormat::BC5 ? 2 : 4);
+	double SquaredError = 0.0;
+	for (int32 PixelIndex = 0; PixelIndex < Decoded.Num(); ++PixelIndex)
+	{
+		const FVector4 Expected = ToStoredValues(Reference[PixelIndex], Format);
+		const FLinearColor& Actual = Decoded[PixelIndex];
+		const float ActualChannels[4] = { Actual.R, Actual.G, Actual.B, Actual.A };
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			SquaredError += FMath::Square((double)Expected[Channel] - ActualChannels[Channel]);
+		}
+	}
+
+	// identical images come out at 100 dB rather than infinity
+	const double MeanSquaredError = FMath::Max(SquaredError / ((double)Decoded.Num() * NumChannels), 1e-10);
+	return 10.0 * FMath::LogX(10.0, 1.0 / MeanSquaredError);
+}
+
+static UTexture2D* CreateCompressedTexture(FIntPoint Size, EGraphicToolsBlockFormat Format)
+{
+	UTexture2D* Texture = UTexture2D::CreateTransient(Size.X, Size.Y, FGraphicToolsBlockCompression::GetPixelFormat(Format));
+	if (Texture != nullptr)
+	{
+		Texture->SRGB = Format != EGraphicToolsBlockFormat::BC5;
+	}
+	return Texture;
+}
+
+static bool CheckBlockSize(FIntPoint Size)
+{
+	if (Size.X <= 0 || Size.Y <= 0 || Size.X % 4 != 0 || Size.Y % 4 != 0)
+	{
+		UE_LOG(LogGraphicToolsBlockCompression, Warning, TEXT("Can't compress %dx%d, block compressed sizes must be multiples of 4"), Size.X, Size.Y);
+		return false;
+	}
+	return true;
+}
+
+UTexture2D* FGraphicToolsBlockCompression::CompressPixels(const TArray<FLinearColor>& Pixels, FIntPoint Size, EGraphicToolsBlockFormat Format)
+{
+	check(IsInGameThread());
+
+	if (!CheckBlockSize(Size) || Pixels.Num() != Size.X * Size.Y)
+	{
+		return nullptr;
+	}
+
+	UTexture2D* Texture = CreateCompressedTexture(Size, Format);
+	if (Texture == nullptr)
+	{
+		return nullptr;
+	}
+
+	TArray<uint8> Blocks;
+	EncodeBlocks(Pixels.GetData(), Size, Format, Blocks);
+
+	FTexture2DMipMap& Mip = Texture->PlatformData->Mips[0];
+	void* MipData = Mip.BulkData.Lock(LOCK_READ_WRITE);
+	check(Mip.BulkData.GetBulkDataSize() == Blocks.Num());
+	FMemory::Memcpy(MipData, Blocks.GetData(), Blocks.Num());
+	Mip.BulkData.Unlock();
+
+	Texture->UpdateResource();
+	return Texture;
+}
+
+UTexture2D* FGraphicToolsBlockCompression::CompressRenderTarget(UTextureRenderTarget2D* Source, EGraphicToolsBlockFormat Format, ERHIFeatureLevel::Type FeatureLevel)
+{
+	check(IsInGameThread());
+
+	if (Source == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (!CanDispatchGPUWork())
+	{
+		UE_LOG(LogGraphicToolsBlockCompression, Warning, TEXT("%s has no contents without a GPU, CompressPixels encodes pixels generated on the CPU"), *Source->GetName());
+		return nullptr;
+	}
+
+	const FIntPoint Size(Source->SizeX, Source->SizeY);
+	FTextureRenderTargetResource* TextureRenderTargetResource = Source->GameThread_GetRenderTargetResource();
+	if (!CheckBlockSize(Size) || TextureRenderTargetResource == nullptr)
+	{
+		return nullptr;
+	}
+
+	// without compute shaders the target takes a round trip through the CPU encoder
+	if (FeatureLevel < ERHIFeatureLevel::SM5)
+	{
+		TArray<FLinearColor> Pixels;
+		if (!TextureRenderTargetResource->ReadLinearColorPixels(Pixels))
+		{
+			UE_LOG(LogGraphicToolsBlockCompression, Warning, TEXT("Couldn't read back %s"), *Source->GetName());
+			return nullptr;
+		}
+		return CompressPixels(Pixels, Size, Format);
+	}
+
+	UTexture2D* Texture = CreateCompressedTexture(Size, Format);
+	if (Texture == nullptr)
+	{
+		return nullptr;
+	}
+
+	// the texture's resource is created with the placeholder contents of its bulk data and overwritten below
+	Texture->UpdateResource();
+	FTextureResource* TextureResource = Texture->Resource;
+
+	// ordered after the jobs drawing the target, so it compresses what they drew
+	FGraphicToolsGPUJob Job;
+	Job.Name = TEXT("BlockCompression");
+	Job.Objects.Add(Source);
+	Job.Objects.Add(Texture);
+	Job.Work = [TextureRenderTargetResource, TextureResource, Format, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+	{
+		FRHITexture2D* Destination = TextureResource->TextureRHI ? TextureResource->TextureRHI->GetTexture2D() : nullptr;
+		if (Destination == nullptr)
+		{
+			return;
+		}
+
+		TRefCountPtr<IPooledRenderTarget> Blocks = CompressBlocks_RenderThread(RHICmdList, FeatureLevel, TextureRenderTargetResource->GetRenderTargetTexture(), Format);
+		CopyBlocksToTexture_RenderThread(RHICmdList, Blocks->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D(), Destination);
+	};
+	FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+
+	return Texture;
+}
@@ -1,8 +1,11 @@
 #include "GraphicToolsBlueprintFunctionLib.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsGPUScheduler.h"
 
 #include "Engine/TextureRenderTarget2D.h"
 #include "Engine/World.h"
 #include "GlobalShader.h"
+#include "ShaderPermutation.h"
 
 #define LOCTEXT_NAMESPACE "GraphicToolsPlugin"
 
@@ -11,6 +14,9 @@ class FCheckerBoardComputeShader : public FGlobalShader
 	DECLARE_SHADER_TYPE(FCheckerBoardComputeShader, Global, /*MYMODULE_API*/)
 public:
 
+	class FOutputFormatDim : SHADER_PERMUTATION_INT("OUTPUT_FORMAT", GraphicToolsNumOutputFormats);
+	using FPermutationDomain = TShaderPermutationDomain<FOutputFormatDim>;
+
 	FCheckerBoardComputeShader() 
 	{
 	}
@@ -55,32 +61,39 @@ private:
 
 IMPLEMENT_SHADER_TYPE(, FCheckerBoardComputeShader, TEXT("/Plugin/GraphicTools/Private/CheckerBoard.usf"), TEXT("MainCS"), SF_Compute);
 
-static void DrawCheckerBoard_RenderThread(
+void DrawCheckerBoard_RenderThread(
 	FRHICommandListImmediate& RHICmdList,
-	FTextureRenderTargetResource* TextureRenderTargetResource,
-	// FMyShaderStructData ShaderStructData,
+	FRHITexture2D* Target,
 	ERHIFeatureLevel::Type FeatureLevel
 )
 {
 	check(IsInRenderingThread());
 
-	FTexture2DRHIRef RenderTargetTexture = TextureRenderTargetResource->GetRenderTargetTexture();
+	EGraphicToolsOutputFormat OutputFormat;
+	if (!FindOutputFormat(Target->GetFormat(), OutputFormat))
+	{
+		return;
+	}
+
+	FTexture2DRHIRef RenderTargetTexture = Target;
 
 	FIntPoint FullResolution = FIntPoint(RenderTargetTexture->GetSizeX(), RenderTargetTexture->GetSizeY());
 	uint32 GGroupSize = 32;
 	uint32 GroupSizeX = FMath::DivideAndRoundUp((uint32)RenderTargetTexture->GetSizeX(), GGroupSize);
 	uint32 GroupSizeY = FMath::DivideAndRoundUp((uint32)RenderTargetTexture->GetSizeY(), GGroupSize);
 
-	TShaderMapRef<FCheckerBoardComputeShader> ComputeShader(GetGlobalShaderMap(FeatureLevel));
+	FCheckerBoardComputeShader::FPermutationDomain PermutationVector;
+	PermutationVector.Set<FCheckerBoardComputeShader::FOutputFormatDim>((int32)OutputFormat);
+	TShaderMapRef<FCheckerBoardComputeShader> ComputeShader(GetGlobalShaderMap(FeatureLevel), PermutationVector);
 	RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
 
 	FRHIResourceCreateInfo CreateInfo;
 
-	// Create a temp resource
+	// Create a temp resource in the target's format, the copy below can't convert
 	FTexture2DRHIRef GSurfaceTexture2D = RHICreateTexture2D(
 		RenderTargetTexture->GetSizeX(),
 		RenderTargetTexture->GetSizeY(),
-		PF_FloatRGBA,
+		RenderTargetTexture->GetFormat(),
 		1,
 		1,
 		TexCreate_ShaderResource | TexCreate_UAV,
@@ -96,10 +109,15 @@ static void DrawCheckerBoard_RenderThread(
 	RHICmdList.CopyTexture(GSurfaceTexture2D, RenderTargetTexture, CopyInfo);
 }
 
-void UGraphicToolsBlueprintLibrary::DrawCheckerBoard(const UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget)
+void UGraphicToolsBlueprintLibrary::DrawCheckerBoard(const UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget, EGraphicToolsOutputFormat Format)
 {
 	check(IsInGameThread());
 
+	if (!CanDispatchGPUWork())
+	{
+		return;
+	}
+
 	if (!OutputRenderTarget)
 	{
 		FMessageLog("Blueprint").Warning(
@@ -108,21 +126,164 @@ void UGraphicToolsBlueprintLibrary::DrawCheckerBoard(const UObject* WorldContext
 		return;
 	}
 
+	if (!PrepareOutputRenderTarget(OutputRenderTarget, Format, TEXT("DrawCheckerBoard")))
+	{
+		return;
+	}
+
 	FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();
 	ERHIFeatureLevel::Type FeatureLevel = WorldContextObject->GetWorld()->Scene->GetFeatureLevel();
 
-	ENQUEUE_RENDER_COMMAND(CaptureCommand)
-	(
-		[TextureRenderTargetResource, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+	FGraphicToolsGPUJob Job;
+	Job.Name = TEXT("CheckerBoard");
+	Job.CoalesceKey = OutputRenderTarget;
+	Job.Work = [TextureRenderTargetResource, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+	{
+		DrawCheckerBoard_RenderThread
+		(
+			RHICmdList,
+			TextureRenderTargetResource->GetRenderTargetTexture(),
+			FeatureLevel
+		);
+	};
+	FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+}
+
+// The single operation nodes share the render target checks and each submit a batch of one
+static bool CheckRenderTargets(const TCHAR* NodeName, const UTextureRenderTarget2D* Source, const UTextureRenderTarget2D* Destination)
+{
+	if (!Source || !Destination)
+	{
+		FMessageLog("Blueprint").Warning(FText::Format(
+			LOCTEXT("UGraphicToolsBlueprintLibrary::ImageOperator", "{0}: Source and destination render targets are required."),
+			FText::FromString(NodeName)));
+		return false;
+	}
+	return true;
+}
+
+void UGraphicToolsBlueprintLibrary::BlurRenderTarget(const UObject* WorldContextObject, UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsBlurKernel Kernel, int32 Radius, float Sigma)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !CheckRenderTargets(TEXT("BlurRenderTarget"), Source, Destination))
+	{
+		return;
+	}
+
+	FGraphicToolsImageBatch Batch(WorldContextObject->GetWorld()->Scene->GetFeatureLevel());
+	Batch.Blur(Source, Destination, Kernel, Radius, Sigma);
+	Batch.Submit();
+}
+
+void UGraphicToolsBlueprintLibrary::DownsampleRenderTarget(const UObject* WorldContextObject, UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !CheckRenderTargets(TEXT("DownsampleRenderTarget"), Source, Destination))
+	{
+		return;
+	}
+
+	FGraphicToolsImageBatch Batch(WorldContextObject->GetWorld()->Scene->GetFeatureLevel());
+	Batch.Downsample(Source, Destination);
+	Batch.Submit();
+}
+
+void UGraphicToolsBlueprintLibrary::GenerateRenderTargetMips(const UObject* WorldContextObject, UTextureRenderTarget2D* Target)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !CheckRenderTargets(TEXT("GenerateRenderTargetMips"), Target, Target))
+	{
+		return;
+	}
+
+	FGraphicToolsImageBatch Batch(WorldContextObject->GetWorld()->Scene->GetFeatureLevel());
+	Batch.GenerateMips(Target);
+	Batch.Submit();
+}
+
+void UGraphicToolsBlueprintLibrary::ConvertRenderTargetColorSpace(const UObject* WorldContextObject, UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsColorConversion Conversion)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !CheckRenderTargets(TEXT("ConvertRenderTargetColorSpace"), Source, Destination))
+	{
+		return;
+	}
+
+	FGraphicToolsImageBatch Batch(WorldContextObject->GetWorld()->Scene->GetFeatureLevel());
+	Batch.ConvertColorSpace(Source, Destination, Conversion);
+	Batch.Submit();
+}
+
+void UGraphicToolsBlueprintLibrary::ResizeRenderTarget(const UObject* WorldContextObject, UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsResizeFilter Filter)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !CheckRenderTargets(TEXT("ResizeRenderTarget"), Source, Destination))
+	{
+		return;
+	}
+
+	FGraphicToolsImageBatch Batch(WorldContextObject->GetWorld()->Scene->GetFeatureLevel());
+	Batch.Resize(Source, Destination, Filter);
+	Batch.Submit();
+}
+
+void UGraphicToolsBlueprintLibrary::ComputeRenderTargetStatistics(const UObject* WorldContextObject, UTextureRenderTarget2D* Target, float HistogramMax, FOnGraphicToolsStatisticsComputed OnComputed)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !CheckRenderTargets(TEXT("ComputeRenderTargetStatistics"), Target, Target))
+	{
+		return;
+	}
+
+	FGraphicToolsImageStatisticsReduction::Request(
+		Target,
+		WorldContextObject->GetWorld()->Scene->GetFeatureLevel(),
+		HistogramMax > 0.0f ? HistogramMax : 1.0f,
+		[OnComputed](const FGraphicToolsImageStatistics& Statistics)
 		{
-			DrawCheckerBoard_RenderThread
-			(
-				RHICmdList,
-				TextureRenderTargetResource,
-				FeatureLevel
-			);
-		}
-	);
+			OnComputed.ExecuteIfBound(Statistics);
+		});
+}
+
+UTexture2D* UGraphicToolsBlueprintLibrary::CompressRenderTarget(const UObject* WorldContextObject, UTextureRenderTarget2D* Source, EGraphicToolsBlockFormat Format)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !CheckRenderTargets(TEXT("CompressRenderTarget"), Source, Source))
+	{
+		return nullptr;
+	}
+
+	return FGraphicToolsBlockCompression::CompressRenderTarget(Source, Format, WorldContextObject->GetWorld()->Scene->GetFeatureLevel());
+}
+
+void UGraphicToolsBlueprintLibrary::ManageRenderTargetResolution(UTextureRenderTarget2D* Target, UPrimitiveComponent* Surface, FGraphicToolsScreenSizeSettings Settings, FOnGraphicToolsRenderTargetResized OnResized)
+{
+	check(IsInGameThread());
+
+	if (Target == nullptr || Surface == nullptr)
+	{
+		FMessageLog("Blueprint").Warning(LOCTEXT("UGraphicToolsBlueprintLibrary::ManageRenderTargetResolution", "ManageRenderTargetResolution: A render target and a surface showing it are required."));
+		return;
+	}
+
+	FGraphicToolsRenderTargetResolution::Manage(Target, Surface, Settings, [OnResized](UTextureRenderTarget2D* Resized)
+	{
+		OnResized.ExecuteIfBound(Resized);
+	});
+}
+
+void UGraphicToolsBlueprintLibrary::StopManagingRenderTargetResolution(UTextureRenderTarget2D* Target)
+{
+	check(IsInGameThread());
+
+	FGraphicToolsRenderTargetResolution::StopManaging(Target);
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,492 @@
+#include "GraphicToolsCaptureRecorder.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsRawCapture.h"
+
+#include "Async/Async.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "RHIGPUReadback.h"
+#include "RenderingThread.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsCapture, Log, All);
+
+/** Everything the render thread and the encoders need, fixed once recording first starts */
+struct FGraphicToolsCaptureState
+{
+	struct FSlot
+	{
+		TUniquePtr<FRHIGPUTextureReadback> Readback;
+		int32 FrameIndex = INDEX_NONE;
+		double CaptureSeconds = 0.0;
+	};
+
+	FIntPoint Size = FIntPoint::ZeroValue;
+	EPixelFormat Format = PF_Unknown;
+	int32 BytesPerPixel = 0;
+
+	/** Tightly packed pixels of one frame as read back */
+	int64 FrameBytes = 0;
+
+	/** What a frame costs from the moment it leaves the GPU until it is written: the pixels and their conversion */
+	int64 FrameCost = 0;
+
+	/** What the budget leaves for frames waiting to be encoded once the readback buffers are reserved */
+	int64 EncodeBudget = 0;
+	int64 ReadbackBytes = 0;
+
+	int32 NumEncoders = 1;
+	EGraphicToolsCaptureBackpressure Backpressure = EGraphicToolsCaptureBackpressure::Drop;
+	EGraphicToolsCaptureFileFormat FileFormat = EGraphicToolsCaptureFileFormat::PNG;
+	FString PathPrefix;
+	IImageWrapperModule* ImageWrapperModule = nullptr;
+	TUniquePtr<FGraphicToolsRawCaptureWriter> RawWriter;
+
+	/** Render thread, the number of slots never changes */
+	TArray<FSlot> Slots;
+
+	/** Render thread, busy slots oldest first */
+	TArray<int32> InFlight;
+
+	/** Reserved by the game thread when it enqueues a capture, released by the render thread */
+	FThreadSafeCounter NumBusyReadbacks;
+	FThreadSafeCounter NumEncoding;
+	FThreadSafeCounter64 PendingBytes;
+	FThreadSafeCounter64 PeakBytes;
+
+	FThreadSafeCounter Captured;
+	FThreadSafeCounter Written;
+	FThreadSafeCounter Failed;
+	FThreadSafeCounter DroppedNoReadback;
+	FThreadSafeCounter DroppedOverBudget;
+	FThreadSafeCounter Throttled;
+};
+
+static bool IsSupportedCaptureFormat(EPixelFormat Format, EGraphicToolsCaptureFileFormat FileFormat)
+{
+	if (FileFormat == EGraphicToolsCaptureFileFormat::Raw)
+	{
+		return GraphicToolsRawCapture::FromPixelFormat(Format) != EGraphicToolsRawPixelFormat::Unknown;
+	}
+	return Format == PF_B8G8R8A8 || Format == PF_R8G8B8A8 || Format == PF_FloatRGBA;
+}
+
+static void ConvertToColors(EPixelFormat Format, const TArray<uint8>& Pixels, TArray<FColor>& OutColors)
+{
+	switch (Format)
+	{
+	case PF_B8G8R8A8:
+		OutColors.SetNumUninitialized(Pixels.Num() / sizeof(FColor));
+		FMemory::Memcpy(OutColors.GetData(), Pixels.GetData(), Pixels.Num());
+		break;
+	case PF_R8G8B8A8:
+		OutColors.SetNumUninitialized(Pixels.Num() / sizeof(FColor));
+		for (int32 Index = 0; Index < OutColors.Num(); ++Index)
+		{
+			const uint8* Texel = &Pixels[Index * 4];
+			OutColors[Index] = FColor(Texel[0], Texel[1], Texel[2], Texel[3]);
+		}
+		break;
+	case PF_FloatRGBA:
+	{
+		const FFloat16Color* Texels = reinterpret_cast<const FFloat16Color*>(Pixels.GetData());
+		OutColors.SetNumUninitialized(Pixels.Num() / sizeof(FFloat16Color));
+		for (int32 Index = 0; Index < OutColors.Num(); ++Index)
+		{
+			OutColors[Index] = FLinearColor(Texels[Index]).ToFColor(true);
+		}
+		break;
+	}
+	default:
+		checkNoEntry();
+	}
+}
+
+// Worker thread
+static bool EncodeFrame(const FGraphicToolsCaptureState& State, int32 FrameIndex, double CaptureSeconds, const TArray<uint8>& Pixels)
+{
+	if (State.FileFormat == EGraphicToolsCaptureFileFormat::Raw)
+	{
+		return State.RawWriter->AppendFrame(Pixels.GetData(), State.Size.X * State.BytesPerPixel, FrameIndex, CaptureSeconds);
+	}
+
+	TArray<FColor> Colors;
+	ConvertToColors(State.Format, Pixels, Colors);
+
+	if (State.FileFormat == EGraphicToolsCaptureFileFormat::Bitmap)
+	{
+		const FString Path = FString::Printf(TEXT("%s_%06d.bmp"), *State.PathPrefix, FrameIndex);
+		return FFileHelper::CreateBitmap(*Path, State.Size.X, State.Size.Y, Colors.GetData());
+	}
+
+	TSharedPtr<IImageWrapper> ImageWrapper = State.ImageWrapperModule->CreateImageWrapper(EImageFormat::PNG);
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(Colors.GetData(), Colors.Num() * sizeof(FColor), State.Size.X, State.Size.Y, ERGBFormat::BGRA, 8))
+	{
+		return false;
+	}
+
+	const FString Path = FString::Printf(TEXT("%s_%06d.png"), *State.PathPrefix, FrameIndex);
+	return FFileHelper::SaveArrayToFile(ImageWrapper->GetCompressed(), *Path);
+}
+
+static void Capture_RenderThread(FRHICommandListImmediate& RHICmdList, FGraphicToolsCaptureState& State, FTextureRenderTargetResource* Resource, int32 FrameIndex, double CaptureSeconds)
+{
+	check(IsInRenderingThread());
+
+	FRHITexture2D* Source = Resource->GetRenderTargetTexture();
+	if (Source == nullptr || Source->GetSizeXY() != State.Size || Source->GetFormat() != State.Format)
+	{
+		// the target was resized or recreated since recording started
+		State.Failed.Increment();
+		State.NumBusyReadbacks.Decrement();
+		return;
+	}
+
+	const int32 SlotIndex = State.Slots.IndexOfByPredicate([](const FGraphicToolsCaptureState::FSlot& Slot) { return Slot.FrameIndex == INDEX_NONE; });
+	check(SlotIndex != INDEX_NONE);
+
+	FGraphicToolsCaptureState::FSlot& Slot = State.Slots[SlotIndex];
+	if (!Slot.Readback.IsValid())
+	{
+		Slot.Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("GraphicTools.Capture"));
+	}
+
+	RHICmdList.Transition(FRHITransitionInfo(Source, ERHIAccess::Unknown, ERHIAccess::CopySrc));
+	Slot.Readback->EnqueueCopy(RHICmdList, Source);
+	RHICmdList.Transition(FRHITransitionInfo(Source, ERHIAccess::CopySrc, ERHIAccess::SRVMask));
+
+	Slot.FrameIndex = FrameIndex;
+	Slot.CaptureSeconds = CaptureSeconds;
+	State.InFlight.Add(SlotIndex);
+}
+
+static void Poll_RenderThread(FRHICommandListImmediate& RHICmdList, const TSharedRef<FGraphicToolsCaptureState, ESPMode::ThreadSafe>& StateRef)
+{
+	check(IsInRenderingThread());
+
+	FGraphicToolsCaptureState& State = *StateRef;
+
+	// readbacks complete in submission order, stop at the first one that isn't there yet
+	while (State.InFlight.Num() > 0)
+	{
+		FGraphicToolsCaptureState::FSlot& Slot = State.Slots[State.InFlight[0]];
+		if (!Slot.Readback->IsReady())
+		{
+			break;
+		}
+
+		const bool bRoom = State.NumEncoding.GetValue() < State.NumEncoders && State.PendingBytes.GetValue() + State.FrameCost <= State.EncodeBudget;
+		if (!bRoom && State.Backpressure == EGraphicToolsCaptureBackpressure::Throttle)
+		{
+			// the frame waits in its readback buffer, which holds back the next capture
+			break;
+		}
+
+		if (bRoom)
+		{
+			TArray<uint8> Pixels;
+			Pixels.SetNumUninitialized(State.FrameBytes);
+
+			void* Data = nullptr;
+			int32 RowPitchInPixels = 0;
+			Slot.Readback->LockTexture(RHICmdList, Data, RowPitchInPixels);
+			const int32 RowBytes = State.Size.X * State.BytesPerPixel;
+			for (int32 Row = 0; Row < State.Size.Y; ++Row)
+			{
+				FMemory::Memcpy(Pixels.GetData() + Row * RowBytes, static_cast<const uint8*>(Data) + Row * RowPitchInPixels * State.BytesPerPixel, RowBytes);
+			}
+			Slot.Readback->Unlock();
+
+			const int64 InUse = State.PendingBytes.Add(State.FrameCost) + State.FrameCost + State.ReadbackBytes;
+			State.PeakBytes.Set(FMath::Max(State.PeakBytes.GetValue(), InUse));
+			State.NumEncoding.Increment();
+
+			AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [StateRef, FrameIndex = Slot.FrameIndex, CaptureSeconds = Slot.CaptureSeconds, Pixels = MoveTemp(Pixels)]()
+			{
+				FGraphicToolsCaptureState& State = *StateRef;
+				if (EncodeFrame(State, FrameIndex, CaptureSeconds, Pixels))
+				{
+					State.Written.Increment();
+				}
+				else
+				{
+					UE_LOG(LogGraphicToolsCapture, Warning, TEXT("Failed to write frame %d to %s"), FrameIndex, *State.PathPrefix);
+					State.Failed.Increment();
+				}
+				State.PendingBytes.Subtract(State.FrameCost);
+				State.NumEncoding.Decrement();
+			});
+		}
+		else
+		{
+			State.DroppedOverBudget.Increment();
+		}
+
+		Slot.FrameIndex = INDEX_NONE;
+		State.InFlight.RemoveAt(0);
+		State.NumBusyReadbacks.Decrement();
+	}
+}
+
+FGraphicToolsCaptureRecorder::FGraphicToolsCaptureRecorder(UTextureRenderTarget2D* InTarget, const FGraphicToolsCaptureSettings& InSettings)
+	: Target(InTarget)
+	, Settings(InSettings)
+	, State(MakeShared<FGraphicToolsCaptureState, ESPMode::ThreadSafe>())
+{
+}
+
+FGraphicToolsCaptureRecorder::~FGraphicToolsCaptureRecorder()
+{
+	Stop();
+	if (CanDispatchGPUWork() && !IsEngineExitRequested())
+	{
+		Flush();
+	}
+}
+
+bool FGraphicToolsCaptureRecorder::Start()
+{
+	check(IsInGameThread());
+
+	if (bRecording)
+	{
+		return true;
+	}
+
+	if (!CanDispatchGPUWork() || Target == nullptr)
+	{
+		return false;
+	}
+
+	// the first start fixes the frame layout, later ones carry on numbering
+	if (State->Slots.Num() == 0)
+	{
+		const EPixelFormat Format = Target->GetFormat();
+		if (!IsSupportedCaptureFormat(Format, Settings.FileFormat))
+		{
+			UE_LOG(LogGraphicToolsCapture, Warning, TEXT("Can't record %s, %s isn't supported"), *Target->GetName(), GPixelFormats[Format].Name);
+			return false;
+		}
+
+		State->Size = FIntPoint(Target->SizeX, Target->SizeY);
+		State->Format = Format;
+		State->BytesPerPixel = GPixelFormats[Format].BlockBytes;
+		State->FrameBytes = (int64)State->Size.X * State->Size.Y * State->BytesPerPixel;
+		State->FrameCost = State->FrameBytes;
+		if (Settings.FileFormat != EGraphicToolsCaptureFileFormat::Raw)
+		{
+			State->FrameCost += (int64)State->Size.X * State->Size.Y * sizeof(FColor);
+		}
+
+		// leave room for at least one frame to be encoded
+		const int64 MaxReadbacks = (Settings.MemoryBudgetBytes - State->FrameCost) / State->FrameBytes;
+		if (MaxReadbacks < 1)
+		{
+			UE_LOG(LogGraphicToolsCapture, Warning, TEXT("Can't record %s, a %.1f MB budget doesn't hold one %dx%d frame"),
+				*Target->GetName(), Settings.MemoryBudgetBytes / (1024.0f * 1024.0f), State->Size.X, State->Size.Y);
+			return false;
+		}
+		const int32 NumReadbacks = (int32)FMath::Clamp<int64>(Settings.NumReadbackBuffers, 1, MaxReadbacks);
+
+		State->ReadbackBytes = NumReadbacks * State->FrameBytes;
+		State->EncodeBudget = Settings.MemoryBudgetBytes - State->ReadbackBytes;
+		State->NumEncoders = FMath::Max(Settings.NumEncoders, 1);
+		State->Backpressure = Settings.Backpressure;
+		State->FileFormat = Settings.FileFormat;
+
+		const FString Directory = Settings.Directory.IsEmpty() ? FPaths::ScreenShotDir() / TEXT("Captures") : Settings.Directory;
+		IFileManager::Get().MakeDirectory(*Directory, true);
+		State->PathPrefix = Directory / Settings.BaseName;
+		State->ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+		if (Settings.FileFormat == EGraphicToolsCaptureFileFormat::Raw)
+		{
+			State->RawWriter = MakeUnique<FGraphicToolsRawCaptureWriter>();
+			if (!State->RawWriter->Open(State->PathPrefix + TEXT(".gtcap"), GraphicToolsRawCapture::FromPixelFormat(Format), State->Size.X, State->Size.Y, FMath::Max(Settings.RawFrameCapacity, 1)))
+			{
+				State->RawWriter.Reset();
+				return false;
+			}
+		}
+
+		State->Slots.SetNum(NumReadbacks);
+	}
+
+	UE_LOG(LogGraphicToolsCapture, Log, TEXT("Recording %s every %d frames to %s, %d readback buffers, %.1f MB budget"),
+		*Target->GetName(), FMath::Max(Settings.FrameInterval, 1), *State->PathPrefix, State->Slots.Num(), Settings.MemoryBudgetBytes / (1024.0f * 1024.0f));
+
+	bRecording = true;
+	bCaptureHeldBack = false;
+	TicksSinceCapture = 0;
+	return true;
+}
+
+void FGraphicToolsCaptureRecorder::Stop()
+{
+	bRecording = false;
+	bCaptureHeldBack = false;
+}
+
+void FGraphicToolsCaptureRecorder::Flush()
+{
+	check(IsInGameThread());
+
+	while (State->NumBusyReadbacks.GetValue() > 0 || State->NumEncoding.GetValue() > 0)
+	{
+		if (State->NumBusyReadbacks.GetValue() > 0)
+		{
+			Poll();
+		}
+		FlushRenderingCommands();
+		FPlatformProcess::Sleep(0.001f);
+	}
+}
+
+FGraphicToolsCaptureStats FGraphicToolsCaptureRecorder::GetStats() const
+{
+	FGraphicToolsCaptureStats Stats;
+	Stats.Captured = State->Captured.GetValue();
+	Stats.Written = State->Written.GetValue();
+	Stats.Failed = State->Failed.GetValue();
+	Stats.DroppedNoReadback = State->DroppedNoReadback.GetValue();
+	Stats.DroppedOverBudget = State->DroppedOverBudget.GetValue();
+	Stats.Throttled = State->Throttled.GetValue();
+	Stats.PeakBytes = State->PeakBytes.GetValue();
+	return Stats;
+}
+
+void FGraphicToolsCaptureRecorder::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(Target);
+}
+
+void FGraphicToolsCaptureRecorder::Tick(float DeltaTime)
+{
+	if (bRecording && (bCaptureHeldBack || ++TicksSinceCapture >= Settings.FrameInterval))
+	{
+		TicksSinceCapture = 0;
+
+		FTextureRenderTargetResource* Resource = Target != nullptr ? Target->GameThread_GetRenderTargetResource() : nullptr;
+		if (Resource != nullptr && State->NumBusyReadbacks.GetValue() < State->Slots.Num())
+		{
+			State->NumBusyReadbacks.Increment();
+			State->Captured.Increment();
+			bCaptureHeldBack = false;
+
+			// goes out at once, after the queued jobs drawing the target
+			FGraphicToolsGPUJob Job;
+			Job.Name = TEXT("Capture");
+			Job.Priority = EGraphicToolsGPUJobPriority::High;
+			Job.Objects.Add(Target);
+			Job.Work = [State = State, Resource, FrameIndex = NextFrameIndex++, CaptureSeconds = FPlatformTime::Seconds()](FRHICommandListImmediate& RHICmdList)
+			{
+				Capture_RenderThread(RHICmdList, *State, Resource, FrameIndex, CaptureSeconds);
+			};
+			FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+		}
+		else if (Settings.Backpressure == EGraphicToolsCaptureBackpressure::Throttle)
+		{
+			bCaptureHeldBack = true;
+			State->Throttled.Increment();
+		}
+		else
+		{
+			State->DroppedNoReadback.Increment();
+		}
+	}
+
+	if (State->NumBusyReadbacks.GetValue() > 0)
+	{
+		Poll();
+	}
+}
+
+void FGraphicToolsCaptureRecorder::Poll()
+{
+	ENQUEUE_RENDER_COMMAND(PollGraphicToolsCapture)
+	(
+		[State = State](FRHICommandListImmediate& RHICmdList)
+		{
+			Poll_RenderThread(RHICmdList, State);
+		}
+	);
+}
+
+// Deleted by GraphicTools.Capture.Stop, a recording still running at exit is left to the OS
+static FGraphicToolsCaptureRecorder* GConsoleRecorder = nullptr;
+
+static void StartCapture(const TArray<FString>& Args)
+{
+	if (Args.Num() == 0)
+	{
+		UE_LOG(LogGraphicToolsCapture, Display, TEXT("Usage: GraphicTools.Capture.Start <RenderTargetPath> [FrameInterval=1] [png|bmp|raw] [BudgetMB=256] [drop|throttle]"));
+		return;
+	}
+
+	UTextureRenderTarget2D* Target = LoadObject<UTextureRenderTarget2D>(nullptr, *Args[0]);
+	if (Target == nullptr)
+	{
+		UE_LOG(LogGraphicToolsCapture, Warning, TEXT("No render target at %s"), *Args[0]);
+		return;
+	}
+
+	FGraphicToolsCaptureSettings Settings;
+	Settings.BaseName = Target->GetName();
+	Settings.FrameInterval = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1;
+	Settings.FileFormat = EGraphicToolsCaptureFileFormat::PNG;
+	if (Args.Num() > 2 && Args[2] == TEXT("bmp"))
+	{
+		Settings.FileFormat = EGraphicToolsCaptureFileFormat::Bitmap;
+	}
+	else if (Args.Num() > 2 && Args[2] == TEXT("raw"))
+	{
+		Settings.FileFormat = EGraphicToolsCaptureFileFormat::Raw;
+	}
+	Settings.MemoryBudgetBytes = Args.Num() > 3 ? FMath::Max<int64>(FCString::Atoi64(*Args[3]), 1) * 1024 * 1024 : Settings.MemoryBudgetBytes;
+	Settings.Backpressure = Args.Num() > 4 && Args[4] == TEXT("throttle") ? EGraphicToolsCaptureBackpressure::Throttle : EGraphicToolsCaptureBackpressure::Drop;
+
+	// deleting the previous recorder writes out what it still holds
+	delete GConsoleRecorder;
+	GConsoleRecorder = new FGraphicToolsCaptureRecorder(Target, Settings);
+	if (!GConsoleRecorder->Start())
+	{
+		delete GConsoleRecorder;
+		GConsoleRecorder = nullptr;
+	}
+}
+
+static void StopCapture()
+{
+	if (GConsoleRecorder == nullptr)
+	{
+		return;
+	}
+
+	GConsoleRecorder->Stop();
+	GConsoleRecorder->Flush();
+
+	const FGraphicToolsCaptureStats Stats = GConsoleRecorder->GetStats();
+	UE_LOG(LogGraphicToolsCapture, Display, TEXT("Captured %d frames, wrote %d, failed %d, dropped %d without a readback buffer and %d over budget, throttled %d ticks, peak %.1f MB"),
+		Stats.Captured, Stats.Written, Stats.Failed, Stats.DroppedNoReadback, Stats.DroppedOverBudget, Stats.Throttled, Stats.PeakBytes / (1024.0f * 1024.0f));
+
+	delete GConsoleRecorder;
+	GConsoleRecorder = nullptr;
+}
+
+static FAutoConsoleCommand GStartCaptureCommand(
+	TEXT("GraphicTools.Capture.Start"),
+	TEXT("Records a render target to numbered files, or one raw file, under Saved/Screenshots/Captures: GraphicTools.Capture.Start <RenderTargetPath> [FrameInterval=1] [png|bmp|raw] [BudgetMB=256] [drop|throttle]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&StartCapture)
+);
+
+static FAutoConsoleCommand GStopCaptureCommand(
+	TEXT("GraphicTools.Capture.Stop"),
+	TEXT("Stops the recording started with GraphicTools.Capture.Start, writes what is pending and logs the recorder's counters"),
+	FConsoleCommandDelegate::CreateStatic(&StopCapture)
+);
@@ -0,0 +1,156 @@
+#include "GraphicToolsGPUCompletion.h"
+#include "GraphicToolsBlueprintFunctionLib.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsGPUScheduler.h"
+
+#include "Async/Async.h"
+#include "RenderingThread.h"
+#include "Tickable.h"
+
+/** A fence the GPU hasn't passed yet, render thread only */
+struct FPendingCompletion
+{
+	FGPUFenceRHIRef Fence;
+	TFunction<void()> OnCompleted;
+};
+
+/**
+ * Polls the fences of pending completions once per frame while any are in flight and hands the passed ones to
+ * the game thread.
+ */
+class FGraphicToolsGPUCompletions : public FTickableGameObject
+{
+public:
+	static FGraphicToolsGPUCompletions& Get()
+	{
+		static FGraphicToolsGPUCompletions Instance;
+		return Instance;
+	}
+
+	/** Game thread, before the fence is enqueued */
+	void AddInFlight()
+	{
+		++NumInFlight;
+	}
+
+	void Add_RenderThread(FPendingCompletion&& Pending)
+	{
+		PendingCompletions.Add(MoveTemp(Pending));
+	}
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override
+	{
+		ENQUEUE_RENDER_COMMAND(PollGraphicToolsGPUCompletions)
+		(
+			[this](FRHICommandListImmediate& RHICmdList)
+			{
+				Poll_RenderThread();
+			}
+		);
+	}
+
+	virtual bool IsTickable() const override { return NumInFlight > 0; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FGraphicToolsGPUCompletions, STATGROUP_Tickables); }
+	// End of FTickableGameObject interface
+
+private:
+	FGraphicToolsGPUCompletions()
+		: NumInFlight(0)
+	{
+	}
+
+	void Poll_RenderThread()
+	{
+		check(IsInRenderingThread());
+
+		// the GPU passes fences in the order they were written, stop at the first one it hasn't
+		int32 NumPassed = 0;
+		while (NumPassed < PendingCompletions.Num() && PendingCompletions[NumPassed].Fence->Poll())
+		{
+			AsyncTask(ENamedThreads::GameThread, [this, OnCompleted = MoveTemp(PendingCompletions[NumPassed].OnCompleted)]()
+			{
+				--NumInFlight;
+				OnCompleted();
+			});
+
+			++NumPassed;
+		}
+
+		PendingCompletions.RemoveAt(0, NumPassed);
+	}
+
+	/** Oldest first */
+	TArray<FPendingCompletion> PendingCompletions;
+
+	/** Game thread */
+	int32 NumInFlight;
+};
+
+void FGraphicToolsGPUCompletion::Notify(TFunction<void()>&& OnCompleted)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork())
+	{
+		AsyncTask(ENamedThreads::GameThread, MoveTemp(OnCompleted));
+		return;
+	}
+
+	FGraphicToolsGPUCompletions::Get().AddInFlight();
+
+	// jobs the scheduler deferred are part of the work enqueued so far, the fence goes in after them
+	FGraphicToolsGPUScheduler::CallWhenSubmitted([OnCompleted = MoveTemp(OnCompleted)]() mutable
+	{
+		ENQUEUE_RENDER_COMMAND(GraphicToolsGPUCompletionFence)
+		(
+			[OnCompleted = MoveTemp(OnCompleted)](FRHICommandListImmediate& RHICmdList) mutable
+			{
+				FPendingCompletion Pending;
+				Pending.Fence = RHICreateGPUFence(TEXT("GraphicTools.Completion"));
+				Pending.OnCompleted = MoveTemp(OnCompleted);
+				RHICmdList.WriteGPUFence(Pending.Fence);
+				FGraphicToolsGPUCompletions::Get().Add_RenderThread(MoveTemp(Pending));
+			}
+		);
+	});
+}
+
+UGraphicToolsGPUAsyncAction* UGraphicToolsGPUAsyncAction::DrawCheckerBoardAsync(const UObject* WorldContextObject, UTextureRenderTarget2D* OutputRenderTarget, EGraphicToolsOutputFormat Format)
+{
+	return Create<UGraphicToolsGPUAsyncAction>(WorldContextObject, [WorldContextObject, OutputRenderTarget, Format]()
+	{
+		UGraphicToolsBlueprintLibrary::DrawCheckerBoard(WorldContextObject, OutputRenderTarget, Format);
+	});
+}
+
+void UGraphicToolsGPUAsyncAction::Activate()
+{
+	check(IsInGameThread());
+
+	TWeakObjectPtr<UGraphicToolsGPUAsyncAction> WeakThis(this);
+	auto OnEnqueued = [WeakThis]()
+	{
+		FGraphicToolsGPUCompletion::Notify([WeakThis]()
+		{
+			if (UGraphicToolsGPUAsyncAction* Action = WeakThis.Get())
+			{
+				Action->OnCompleted.Broadcast();
+				Action->SetReadyToDestroy();
+			}
+		});
+	};
+
+	// Activate runs straight after the factory, the objects Work captured are still those it was given
+	TFunction<void(TFunction<void()>&&)> ActivatedWork = MoveTemp(Work);
+	if (ActivatedWork)
+	{
+		ActivatedWork(OnEnqueued);
+	}
+	else
+	{
+		OnEnqueued();
+	}
+}
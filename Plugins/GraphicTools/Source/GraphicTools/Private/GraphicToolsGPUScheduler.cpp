@@ -0,0 +1,462 @@
+#include "GraphicToolsGPUScheduler.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+
+#include "Algo/Reverse.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "RenderingThread.h"
+#include "Tickable.h"
+#include "UObject/UObjectGlobals.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsScheduler, Log, All);
+
+static TAutoConsoleVariable<float> CVarGraphicToolsSchedulerBudgetMs(
+	TEXT("GraphicTools.Scheduler.BudgetMs"),
+	2.0f,
+	TEXT("GPU milliseconds a frame the scheduled jobs of GraphicTools and ShaderTestPlugin may take. High priority and overdue jobs run regardless"),
+	ECVF_Default);
+
+// What a job is assumed to cost before anything of its kind was measured
+static const float UnmeasuredJobMs = 0.5f;
+
+// Weight of the newest measurement in the estimate of its kind
+static const float EstimateBlend = 0.2f;
+
+/** A job waiting for a frame with room for it, game thread only */
+struct FQueuedGPUJob
+{
+	FGraphicToolsGPUJob Job;
+	uint64 Sequence = 0;
+	uint64 DeadlineFrame = 0;
+};
+
+/** The timestamps around a job the GPU hasn't passed yet, render thread only */
+struct FGPUJobMeasurement
+{
+	FName Name;
+	FRenderQueryRHIRef Begin;
+	FRenderQueryRHIRef End;
+};
+
+class FGraphicToolsGPUJobQueue : public FTickableGameObject
+{
+public:
+	static FGraphicToolsGPUJobQueue& Get()
+	{
+		static FGraphicToolsGPUJobQueue Instance;
+		return Instance;
+	}
+
+	void Submit(FGraphicToolsGPUJob&& Job)
+	{
+		++NumSubmitted;
+
+		if (Job.CoalesceKey != FObjectKey())
+		{
+			Job.Objects.AddUnique(Job.CoalesceKey);
+		}
+
+		const int32 CoalesceIndex = FindCoalesceIndex(Job);
+
+		if (Job.Priority == EGraphicToolsGPUJobPriority::High)
+		{
+			// the queued job overwriting the same object would only be drawn over
+			if (CoalesceIndex != INDEX_NONE)
+			{
+				Queue.RemoveAt(CoalesceIndex);
+				++NumCoalesced;
+			}
+
+			// the queued jobs it shares objects with go out ahead of it
+			TArray<int32> Group;
+			FindDependencies(Job, Queue.Num(), Group);
+
+			TArray<FGraphicToolsGPUJob> Jobs;
+			TakeJobs(Group, Jobs);
+			Jobs.Add(MoveTemp(Job));
+			Enqueue(MoveTemp(Jobs));
+			return;
+		}
+
+		const uint64 DeadlineFrame = GFrameCounter + FMath::Max(Job.MaxDelayFrames, 0);
+
+		if (CoalesceIndex != INDEX_NONE)
+		{
+			// the newer work wins, it keeps the older one's place and the more urgent of the two schedules
+			FQueuedGPUJob& Queued = Queue[CoalesceIndex];
+			Queued.Job.Name = Job.Name;
+			Queued.Job.Work = MoveTemp(Job.Work);
+			Queued.Job.Objects = MoveTemp(Job.Objects);
+			Queued.Job.Priority = FMath::Max(Queued.Job.Priority, Job.Priority);
+			Queued.DeadlineFrame = FMath::Min(Queued.DeadlineFrame, DeadlineFrame);
+			++NumCoalesced;
+			return;
+		}
+
+		FQueuedGPUJob Queued;
+		Queued.Job = MoveTemp(Job);
+		Queued.Sequence = NextSequence++;
+		Queued.DeadlineFrame = DeadlineFrame;
+		Queue.Add(MoveTemp(Queued));
+	}
+
+	void CallWhenSubmitted(TFunction<void()>&& Callback)
+	{
+		if (Queue.Num() == 0)
+		{
+			Callback();
+			return;
+		}
+		Waiters.Add(MakeTuple(NextSequence - 1, MoveTemp(Callback)));
+	}
+
+	/** Enqueues what fits in this frame's budget, or everything */
+	void Dispatch(bool bEverything)
+	{
+		float RemainingMs = CVarGraphicToolsSchedulerBudgetMs.GetValueOnGameThread();
+		TArray<FGraphicToolsGPUJob> Jobs;
+
+		// overdue and high priority jobs, then normal ones, then low ones in what is left. A normal job larger than
+		// the whole budget still goes out alone rather than never
+		for (int32 Pass = 0; Pass < 3; ++Pass)
+		{
+			for (int32 Index = 0; Index < Queue.Num();)
+			{
+				const FQueuedGPUJob& Queued = Queue[Index];
+				const bool bOverdue = GFrameCounter >= Queued.DeadlineFrame;
+
+				bool bRun = false;
+				switch (Pass)
+				{
+				case 0:
+					bRun = bEverything || bOverdue || Queued.Job.Priority == EGraphicToolsGPUJobPriority::High;
+					NumOverdue += !bEverything && bOverdue && Queued.Job.Priority != EGraphicToolsGPUJobPriority::High ? 1 : 0;
+					break;
+				case 1:
+					bRun = Queued.Job.Priority == EGraphicToolsGPUJobPriority::Normal;
+					break;
+				default:
+					bRun = Queued.Job.Priority == EGraphicToolsGPUJobPriority::Low;
+					break;
+				}
+
+				if (!bRun)
+				{
+					++Index;
+					continue;
+				}
+
+				// the earlier jobs it shares objects with, of any priority, go out with it and count against the budget
+				TArray<int32> Group;
+				FindDependencies(Queued.Job, Index, Group);
+				Group.Add(Index);
+
+				float CostMs = 0.0f;
+				for (const int32 Member : Group)
+				{
+					CostMs += GetEstimateMs(Queue[Member].Job.Name);
+				}
+
+				if (Pass > 0 && CostMs > RemainingMs && (Pass == 2 || Jobs.Num() > 0))
+				{
+					++Index;
+					continue;
+				}
+
+				RemainingMs -= CostMs;
+				TakeJobs(Group, Jobs);
+				Index -= Group.Num() - 1;
+			}
+		}
+
+		NumDeferrals += Queue.Num();
+		if (Jobs.Num() > 0)
+		{
+			Enqueue(MoveTemp(Jobs));
+		}
+
+		// the waiters whose jobs are all out
+		const uint64 OldestQueued = Queue.Num() > 0 ? Queue[0].Sequence : MAX_uint64;
+		for (int32 Index = 0; Index < Waiters.Num();)
+		{
+			if (Waiters[Index].Key < OldestQueued)
+			{
+				TFunction<void()> Callback = MoveTemp(Waiters[Index].Value);
+				Waiters.RemoveAt(Index);
+				Callback();
+			}
+			else
+			{
+				++Index;
+			}
+		}
+	}
+
+	void LogStats() const
+	{
+		UE_LOG(LogGraphicToolsScheduler, Display, TEXT("GPU scheduler, %.2f ms budget: %d queued, %d submitted, %d coalesced, %d deferrals, %d overdue"),
+			CVarGraphicToolsSchedulerBudgetMs.GetValueOnGameThread(), Queue.Num(), NumSubmitted, NumCoalesced, NumDeferrals, NumOverdue);
+		for (const TPair<FName, float>& Estimate : EstimatesMs)
+		{
+			UE_LOG(LogGraphicToolsScheduler, Display, TEXT("  %-24s %8.3f ms"), *Estimate.Key.ToString(), Estimate.Value);
+		}
+	}
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override
+	{
+		if (Queue.Num() > 0 || Waiters.Num() > 0)
+		{
+			Dispatch(false);
+		}
+
+		if (NumMeasuring.GetValue() > 0)
+		{
+			ENQUEUE_RENDER_COMMAND(PollGraphicToolsScheduler)
+			(
+				[this](FRHICommandListImmediate& RHICmdList)
+				{
+					Poll_RenderThread();
+				}
+			);
+		}
+	}
+
+	virtual bool IsTickable() const override { return Queue.Num() > 0 || Waiters.Num() > 0 || NumMeasuring.GetValue() > 0; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FGraphicToolsGPUJobQueue, STATGROUP_Tickables); }
+	// End of FTickableGameObject interface
+
+private:
+	FGraphicToolsGPUJobQueue()
+		: NextSequence(0)
+		, NumSubmitted(0)
+		, NumCoalesced(0)
+		, NumDeferrals(0)
+		, NumOverdue(0)
+	{
+		// queued jobs hold the resources of the render targets they draw, which garbage collection may release
+		FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddRaw(this, &FGraphicToolsGPUJobQueue::OnPreGarbageCollect);
+	}
+
+	void OnPreGarbageCollect()
+	{
+		if (Queue.Num() > 0)
+		{
+			Dispatch(true);
+		}
+	}
+
+	float GetEstimateMs(FName Name) const
+	{
+		const float* EstimateMs = EstimatesMs.Find(Name);
+		return EstimateMs != nullptr ? *EstimateMs : UnmeasuredJobMs;
+	}
+
+	static bool SharesObject(const FGraphicToolsGPUJob& Job, const TArray<FObjectKey, TInlineAllocator<4>>& Objects)
+	{
+		for (const FObjectKey& Object : Job.Objects)
+		{
+			if (Objects.Contains(Object))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** The queued job Job replaces: the last one with its key, unless a job queued after that one uses Job's objects */
+	int32 FindCoalesceIndex(const FGraphicToolsGPUJob& Job) const
+	{
+		if (Job.CoalesceKey == FObjectKey())
+		{
+			return INDEX_NONE;
+		}
+
+		for (int32 Index = Queue.Num() - 1; Index >= 0; --Index)
+		{
+			const FGraphicToolsGPUJob& Queued = Queue[Index].Job;
+			if (Queued.CoalesceKey == Job.CoalesceKey)
+			{
+				return Index;
+			}
+			if (SharesObject(Queued, Job.Objects))
+			{
+				return INDEX_NONE;
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	/**
+	 * Adds the indices of the jobs queued before End that share an object with Job, or with another of those jobs,
+	 * to OutIndices oldest first
+	 */
+	void FindDependencies(const FGraphicToolsGPUJob& Job, int32 End, TArray<int32>& OutIndices) const
+	{
+		TArray<FObjectKey, TInlineAllocator<4>> Objects = Job.Objects;
+		if (Objects.Num() == 0)
+		{
+			return;
+		}
+
+		const int32 NumIndices = OutIndices.Num();
+		for (int32 Index = End - 1; Index >= 0; --Index)
+		{
+			const FGraphicToolsGPUJob& Queued = Queue[Index].Job;
+			if (SharesObject(Queued, Objects))
+			{
+				OutIndices.Add(Index);
+				for (const FObjectKey& Object : Queued.Objects)
+				{
+					Objects.AddUnique(Object);
+				}
+			}
+		}
+		Algo::Reverse(OutIndices.GetData() + NumIndices, OutIndices.Num() - NumIndices);
+	}
+
+	/** Moves the queued jobs at Indices, oldest first, to the end of OutJobs */
+	void TakeJobs(const TArray<int32>& Indices, TArray<FGraphicToolsGPUJob>& OutJobs)
+	{
+		for (const int32 Index : Indices)
+		{
+			OutJobs.Add(MoveTemp(Queue[Index].Job));
+		}
+		for (int32 Member = Indices.Num() - 1; Member >= 0; --Member)
+		{
+			Queue.RemoveAt(Indices[Member]);
+		}
+	}
+
+	void Enqueue(TArray<FGraphicToolsGPUJob>&& Jobs)
+	{
+		if (GSupportsTimestampRenderQueries)
+		{
+			NumMeasuring.Add(Jobs.Num());
+		}
+
+		ENQUEUE_RENDER_COMMAND(GraphicToolsScheduledJobs)
+		(
+			[this, Jobs = MoveTemp(Jobs)](FRHICommandListImmediate& RHICmdList)
+			{
+				for (const FGraphicToolsGPUJob& Job : Jobs)
+				{
+					if (!GSupportsTimestampRenderQueries)
+					{
+						Job.Work(RHICmdList);
+						continue;
+					}
+
+					FGPUJobMeasurement Measurement;
+					Measurement.Name = Job.Name;
+					Measurement.Begin = RHICreateRenderQuery(RQT_AbsoluteTime);
+					Measurement.End = RHICreateRenderQuery(RQT_AbsoluteTime);
+
+					RHICmdList.EndRenderQuery(Measurement.Begin);
+					Job.Work(RHICmdList);
+					RHICmdList.EndRenderQuery(Measurement.End);
+
+					Measurements.Add(MoveTemp(Measurement));
+				}
+			}
+		);
+	}
+
+	void Poll_RenderThread()
+	{
+		check(IsInRenderingThread());
+
+		// the GPU runs the jobs in order, stop at the first one it hasn't finished
+		int32 NumMeasured = 0;
+		for (const FGPUJobMeasurement& Measurement : Measurements)
+		{
+			uint64 BeginMicroseconds = 0;
+			uint64 EndMicroseconds = 0;
+			if (!RHIGetRenderQueryResult(Measurement.End, EndMicroseconds, false) || !RHIGetRenderQueryResult(Measurement.Begin, BeginMicroseconds, false))
+			{
+				break;
+			}
+
+			const float Ms = (float)(EndMicroseconds - BeginMicroseconds) / 1000.0f;
+			AsyncTask(ENamedThreads::GameThread, [this, Name = Measurement.Name, Ms]()
+			{
+				float* EstimateMs = EstimatesMs.Find(Name);
+				if (EstimateMs != nullptr)
+				{
+					*EstimateMs = FMath::Lerp(*EstimateMs, Ms, EstimateBlend);
+				}
+				else
+				{
+					EstimatesMs.Add(Name, Ms);
+				}
+			});
+
+			++NumMeasured;
+		}
+
+		Measurements.RemoveAt(0, NumMeasured);
+		NumMeasuring.Subtract(NumMeasured);
+	}
+
+	/** Game thread, oldest first */
+	TArray<FQueuedGPUJob> Queue;
+	TArray<TTuple<uint64, TFunction<void()>>> Waiters;
+	TMap<FName, float> EstimatesMs;
+	uint64 NextSequence;
+
+	int32 NumSubmitted;
+	int32 NumCoalesced;
+	/** A job waiting one frame counts once */
+	int32 NumDeferrals;
+	int32 NumOverdue;
+
+	/** Render thread, oldest first */
+	TArray<FGPUJobMeasurement> Measurements;
+
+	FThreadSafeCounter NumMeasuring;
+};
+
+bool CanDispatchGPUWork()
+{
+	return FApp::CanEverRender() && !GUsingNullRHI;
+}
+
+void FGraphicToolsGPUScheduler::Submit(FGraphicToolsGPUJob&& Job)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || !Job.Work)
+	{
+		return;
+	}
+
+	FGraphicToolsGPUJobQueue::Get().Submit(MoveTemp(Job));
+}
+
+void FGraphicToolsGPUScheduler::CallWhenSubmitted(TFunction<void()>&& Callback)
+{
+	check(IsInGameThread());
+
+	FGraphicToolsGPUJobQueue::Get().CallWhenSubmitted(MoveTemp(Callback));
+}
+
+void FGraphicToolsGPUScheduler::Flush()
+{
+	check(IsInGameThread());
+
+	FGraphicToolsGPUJobQueue::Get().Dispatch(true);
+}
+
+static void LogSchedulerStats(const TArray<FString>& Args)
+{
+	FGraphicToolsGPUJobQueue::Get().LogStats();
+}
+
+static FAutoConsoleCommand GSchedulerStatsCommand(
+	TEXT("GraphicTools.Scheduler.Stats"),
+	TEXT("Logs the GPU scheduler's queue, counters and the cost it estimates for each kind of job: GraphicTools.Scheduler.Stats"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&LogSchedulerStats)
+);
@@ -0,0 +1,427 @@
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsTextureGraphPrivate.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "RenderingThread.h"
+#include "RenderTargetPool.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsBenchmark, Log, All);
+
+float TimeOnGPU(FRHICommandListImmediate& RHICmdList, int32 Iterations, TFunctionRef<void()> Work)
+{
+	Work();
+
+	FRenderQueryRHIRef BeginQuery = RHICreateRenderQuery(RQT_AbsoluteTime);
+	FRenderQueryRHIRef EndQuery = RHICreateRenderQuery(RQT_AbsoluteTime);
+
+	RHICmdList.EndRenderQuery(BeginQuery);
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		Work();
+	}
+	RHICmdList.EndRenderQuery(EndQuery);
+	RHICmdList.ImmediateFlush(EImmediateFlushType::FlushRHIThread);
+
+	uint64 BeginMicroseconds = 0;
+	uint64 EndMicroseconds = 0;
+	RHIGetRenderQueryResult(BeginQuery, BeginMicroseconds, true);
+	RHIGetRenderQueryResult(EndQuery, EndMicroseconds, true);
+
+	return (float)(EndMicroseconds - BeginMicroseconds) / 1000.0f / Iterations;
+}
+
+// Milliseconds per run of Work on the calling thread
+static float TimeOnCPU(int32 Iterations, TFunctionRef<void()> Work)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		Work();
+	}
+	return (float)((FPlatformTime::Seconds() - StartSeconds) * 1000.0 / Iterations);
+}
+
+// What post-processing a read back render target on the CPU costs, the operators' alternative until now
+static void ResizeOnCPU(const TArray<FLinearColor>& Source, int32 SourceSize, TArray<FLinearColor>& Destination, int32 DestinationSize)
+{
+	const float Scale = (float)SourceSize / DestinationSize;
+	for (int32 Y = 0; Y < DestinationSize; ++Y)
+	{
+		const float SourceY = FMath::Clamp((Y + 0.5f) * Scale - 0.5f, 0.0f, SourceSize - 1.0f);
+		const int32 Y0 = FMath::FloorToInt(SourceY);
+		const int32 Y1 = FMath::Min(Y0 + 1, SourceSize - 1);
+		const float AlphaY = SourceY - Y0;
+
+		for (int32 X = 0; X < DestinationSize; ++X)
+		{
+			const float SourceX = FMath::Clamp((X + 0.5f) * Scale - 0.5f, 0.0f, SourceSize - 1.0f);
+			const int32 X0 = FMath::FloorToInt(SourceX);
+			const int32 X1 = FMath::Min(X0 + 1, SourceSize - 1);
+			const float AlphaX = SourceX - X0;
+
+			const FLinearColor Top = FMath::Lerp(Source[Y0 * SourceSize + X0], Source[Y0 * SourceSize + X1], AlphaX);
+			const FLinearColor Bottom = FMath::Lerp(Source[Y1 * SourceSize + X0], Source[Y1 * SourceSize + X1], AlphaX);
+			Destination[Y * DestinationSize + X] = FMath::Lerp(Top, Bottom, AlphaY);
+		}
+	}
+}
+
+static void RunImageOperatorBenchmark(const TArray<FString>& Args)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork())
+	{
+		return;
+	}
+
+	const int32 Size = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2048, 64, 8192);
+	const int32 Iterations = FMath::Clamp(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 20, 1, 1000);
+	const int32 ResizedSize = Size * 3 / 4;
+
+	// the CPU references run here, a few iterations are plenty at these costs
+	const int32 CPUIterations = FMath::Min(Iterations, 3);
+
+	TArray<FLinearColor> Pixels;
+	Pixels.SetNumUninitialized(Size * Size);
+	FRandomStream Random(Size);
+	for (FLinearColor& Pixel : Pixels)
+	{
+		Pixel = FLinearColor(Random.GetFraction(), Random.GetFraction(), Random.GetFraction(), 1.0f);
+	}
+
+	TArray<FColor> Converted;
+	Converted.SetNumUninitialized(Pixels.Num());
+	const float CPUColorConvertMs = TimeOnCPU(CPUIterations, [&Pixels, &Converted]()
+	{
+		for (int32 Index = 0; Index < Pixels.Num(); ++Index)
+		{
+			Converted[Index] = Pixels[Index].ToFColor(true);
+		}
+	});
+
+	TArray<FLinearColor> Resized;
+	Resized.SetNumUninitialized(ResizedSize * ResizedSize);
+	const float CPUResizeMs = TimeOnCPU(CPUIterations, [&Pixels, &Resized, Size, ResizedSize]()
+	{
+		ResizeOnCPU(Pixels, Size, Resized, ResizedSize);
+	});
+
+	const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+	ENQUEUE_RENDER_COMMAND(GraphicToolsImageBenchmark)
+	(
+		[Size, Iterations, ResizedSize, CPUColorConvertMs, CPUResizeMs, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			if (!GSupportsTimestampRenderQueries)
+			{
+				UE_LOG(LogGraphicToolsBenchmark, Warning, TEXT("This RHI has no timestamp queries, nothing to measure with"));
+				return;
+			}
+
+			const uint16 NumMips = (uint16)(FMath::FloorLog2(Size) + 1);
+			const ETextureCreateFlags Flags = TexCreate_ShaderResource | TexCreate_UAV;
+
+			TRefCountPtr<IPooledRenderTarget> Source;
+			TRefCountPtr<IPooledRenderTarget> Destination;
+			TRefCountPtr<IPooledRenderTarget> Half;
+			TRefCountPtr<IPooledRenderTarget> Scaled;
+			GRenderTargetPool.FindFreeElement(RHICmdList, FPooledRenderTargetDesc::Create2DDesc(FIntPoint(Size, Size), PF_FloatRGBA, FClearValueBinding::None, TexCreate_None, Flags, false, NumMips), Source, TEXT("GraphicTools.BenchmarkSource"));
+			GRenderTargetPool.FindFreeElement(RHICmdList, FPooledRenderTargetDesc::Create2DDesc(FIntPoint(Size, Size), PF_FloatRGBA, FClearValueBinding::None, TexCreate_None, Flags, false, NumMips), Destination, TEXT("GraphicTools.BenchmarkDestination"));
+			GRenderTargetPool.FindFreeElement(RHICmdList, FPooledRenderTargetDesc::Create2DDesc(FIntPoint(Size / 2, Size / 2), PF_FloatRGBA, FClearValueBinding::None, TexCreate_None, Flags, false), Half, TEXT("GraphicTools.BenchmarkHalf"));
+			GRenderTargetPool.FindFreeElement(RHICmdList, FPooledRenderTargetDesc::Create2DDesc(FIntPoint(ResizedSize, ResizedSize), PF_FloatRGBA, FClearValueBinding::None, TexCreate_None, Flags, false), Scaled, TEXT("GraphicTools.BenchmarkScaled"));
+
+			RHICmdList.Transition(FRHITransitionInfo(Source->GetRenderTargetItem().UAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+			RHICmdList.ClearUAVFloat(Source->GetRenderTargetItem().UAV, FVector4(0.25f, 0.5f, 0.75f, 1.0f));
+
+			FRHITexture2D* SourceTexture = Source->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+			FRHITexture2D* DestinationTexture = Destination->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+			FRHITexture2D* HalfTexture = Half->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+			FRHITexture2D* ScaledTexture = Scaled->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+
+			auto Time = [&RHICmdList, FeatureLevel, Iterations](const FGraphicToolsImageOperation& Operation, FRHITexture2D* From, FRHITexture2D* To, bool bNaive)
+			{
+				return TimeOnGPU(RHICmdList, Iterations, [&]()
+				{
+					ExecuteImageOperation_RenderThread(RHICmdList, FeatureLevel, Operation, From, To, bNaive);
+				});
+			};
+
+			auto Report = [](const TCHAR* Name, const TCHAR* Reference, float OperatorMs, float ReferenceMs)
+			{
+				UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("  %-24s %8.3f ms   %-10s %8.3f ms   %6.1fx"),
+					Name, OperatorMs, Reference, ReferenceMs, OperatorMs > 0.0f ? ReferenceMs / OperatorMs : 0.0f);
+			};
+
+			UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("Image operators, %dx%d RGBA16F, %d iterations (operator vs reference, including the copy to the destination):"), Size, Size, Iterations);
+
+			FGraphicToolsImageOperation Operation;
+
+			Operation.Type = FGraphicToolsImageOperation::EType::Blur;
+			Operation.BlurKernel = EGraphicToolsBlurKernel::Gaussian;
+			for (const int32 Radius : { 4, 16 })
+			{
+				Operation.BlurRadius = Radius;
+				Report(*FString::Printf(TEXT("Gaussian blur r=%d"), Radius), TEXT("GPU 2D"), Time(Operation, SourceTexture, DestinationTexture, false), Time(Operation, SourceTexture, DestinationTexture, true));
+			}
+
+			Operation.Type = FGraphicToolsImageOperation::EType::Downsample;
+			Report(TEXT("Downsample 2x"), TEXT("GPU 4-tap"), Time(Operation, SourceTexture, HalfTexture, false), Time(Operation, SourceTexture, HalfTexture, true));
+
+			Operation.Type = FGraphicToolsImageOperation::EType::GenerateMips;
+			Report(*FString::Printf(TEXT("Mip chain (%d levels)"), NumMips), TEXT("GPU/level"), Time(Operation, DestinationTexture, DestinationTexture, false), Time(Operation, DestinationTexture, DestinationTexture, true));
+
+			Operation.Type = FGraphicToolsImageOperation::EType::ColorConvert;
+			Operation.ColorConversion = EGraphicToolsColorConversion::LinearToSRGB;
+			Report(TEXT("Linear to sRGB"), TEXT("CPU"), Time(Operation, SourceTexture, DestinationTexture, false), CPUColorConvertMs);
+
+			Operation.Type = FGraphicToolsImageOperation::EType::Resize;
+			Operation.ResizeFilter = EGraphicToolsResizeFilter::Bilinear;
+			Report(*FString::Printf(TEXT("Bilinear resize to %d"), ResizedSize), TEXT("CPU"), Time(Operation, SourceTexture, ScaledTexture, false), CPUResizeMs);
+		}
+	);
+}
+
+static FAutoConsoleCommand GBenchmarkImageOperatorsCommand(
+	TEXT("GraphicTools.Benchmark.ImageOperators"),
+	TEXT("Times the GraphicTools image operators against naive implementations: GraphicTools.Benchmark.ImageOperators [Size=2048] [Iterations=20]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunImageOperatorBenchmark)
+);
+
+static void RunTextureGraphBenchmark(const TArray<FString>& Args)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork())
+	{
+		return;
+	}
+
+	const int32 Size = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2048, 64, 8192);
+	const int32 Iterations = FMath::Clamp(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 20, 1, 1000);
+
+	// two tinted star fields mixed and graded, once on its own and once around a blur
+	FGraphicToolsTextureGraph Graph;
+	const FGraphicToolsTextureGraph::FNodeId Warm = Graph.AddMultiply(Graph.AddGenerator(1.0f), FLinearColor(1.0f, 0.6f, 0.4f));
+	const FGraphicToolsTextureGraph::FNodeId Cold = Graph.AddMultiply(Graph.AddGenerator(2.5f), FLinearColor(0.4f, 0.6f, 1.0f));
+	const FGraphicToolsTextureGraph::FNodeId Mixed = Graph.AddMultiply(Graph.AddBlend(Warm, Cold, 0.5f), FLinearColor(0.9f, 0.9f, 0.9f));
+	const FGraphicToolsTextureGraph::FNodeId Glow = Graph.AddMultiply(Graph.AddBlur(Mixed, 4), FLinearColor(1.2f, 1.2f, 1.2f));
+
+	struct FCase
+	{
+		const TCHAR* Name;
+		FGraphicToolsTextureGraphPlan Fused;
+		FGraphicToolsTextureGraphPlan Unfused;
+	};
+
+	TArray<FCase> Cases;
+	for (const TPair<const TCHAR*, FGraphicToolsTextureGraph::FNodeId>& Root : { MakeTuple(TEXT("Per-pixel"), Mixed), MakeTuple(TEXT("With blur"), Glow) })
+	{
+		FCase& Case = Cases.AddDefaulted_GetRef();
+		Case.Name = Root.Key;
+		Graph.Compile(Root.Value, true, Case.Fused);
+		Graph.Compile(Root.Value, false, Case.Unfused);
+	}
+
+	const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+	ENQUEUE_RENDER_COMMAND(GraphicToolsTextureGraphBenchmark)
+	(
+		[Size, Iterations, Cases = MoveTemp(Cases), FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			if (!GSupportsTimestampRenderQueries)
+			{
+				UE_LOG(LogGraphicToolsBenchmark, Warning, TEXT("This RHI has no timestamp queries, nothing to measure with"));
+				return;
+			}
+
+			TRefCountPtr<IPooledRenderTarget> Output;
+			GRenderTargetPool.FindFreeElement(RHICmdList, FPooledRenderTargetDesc::Create2DDesc(FIntPoint(Size, Size), PF_FloatRGBA, FClearValueBinding::None, TexCreate_None, TexCreate_ShaderResource | TexCreate_UAV, false), Output, TEXT("GraphicTools.BenchmarkGraphOutput"));
+			FRHITexture2D* OutputTexture = Output->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+
+			auto Time = [&RHICmdList, FeatureLevel, Iterations, OutputTexture](const FGraphicToolsTextureGraphPlan& Plan)
+			{
+				return TimeOnGPU(RHICmdList, Iterations, [&]()
+				{
+					ExecuteTextureGraphPlan_RenderThread(RHICmdList, FeatureLevel, Plan, TArrayView<FRHITexture2D* const>(), OutputTexture);
+				});
+			};
+
+			// every pass writes and reads back a full RGBA16F texture in the unfused graph
+			const float MegabytesPerPass = Size * Size * 8 * 2 / (1024.0f * 1024.0f);
+
+			UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("Texture graph, %dx%d RGBA16F, %d iterations (fused vs one pass per node):"), Size, Size, Iterations);
+			for (const FCase& Case : Cases)
+			{
+				const float FusedMs = Time(Case.Fused);
+				const float UnfusedMs = Time(Case.Unfused);
+				UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("  %-10s fused %2d passes %8.3f ms   unfused %2d passes %8.3f ms   %5.1fx, ~%.0f MB less traffic"),
+					Case.Name,
+					Case.Fused.Passes.Num(), FusedMs,
+					Case.Unfused.Passes.Num(), UnfusedMs,
+					FusedMs > 0.0f ? UnfusedMs / FusedMs : 0.0f,
+					(Case.Unfused.Passes.Num() - Case.Fused.Passes.Num()) * MegabytesPerPass);
+			}
+		}
+	);
+}
+
+static FAutoConsoleCommand GBenchmarkTextureGraphCommand(
+	TEXT("GraphicTools.Benchmark.TextureGraph"),
+	TEXT("Times a sample texture graph compiled with and without pass fusion: GraphicTools.Benchmark.TextureGraph [Size=2048] [Iterations=20]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunTextureGraphBenchmark)
+);
+
+static void RunBlockCompressionBenchmark(const TArray<FString>& Args)
+{
+	check(IsInGameThread());
+
+	const int32 Size = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1024, 64, 4096) & ~3;
+	const int32 Iterations = FMath::Clamp(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 10, 1, 1000);
+	const int32 CPUIterations = FMath::Min(Iterations, 3);
+
+	TArray<FLinearColor> Pixels;
+	MakeBlockCompressionTestImage(Size, Pixels);
+
+	static const EGraphicToolsBlockFormat Formats[] = { EGraphicToolsBlockFormat::BC1, EGraphicToolsBlockFormat::BC3, EGraphicToolsBlockFormat::BC5, EGraphicToolsBlockFormat::BC7 };
+	static const TCHAR* FormatNames[] = { TEXT("BC1"), TEXT("BC3"), TEXT("BC5"), TEXT("BC7") };
+
+	// uncompressed, as the render targets are baked today
+	const int64 FloatRGBABytes = (int64)Size * Size * 8;
+
+	UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("Block compression, %dx%d, CPU encoder with %d iterations (resident size vs %lld KB as RGBA16F):"), Size, Size, CPUIterations, FloatRGBABytes / 1024);
+	for (int32 FormatIndex = 0; FormatIndex < UE_ARRAY_COUNT(Formats); ++FormatIndex)
+	{
+		TArray<uint8> Blocks;
+		const float EncodeMs = TimeOnCPU(CPUIterations, [&Pixels, Size, &Blocks, FormatIndex]()
+		{
+			FGraphicToolsBlockCompression::EncodeBlocks(Pixels.GetData(), FIntPoint(Size, Size), Formats[FormatIndex], Blocks);
+		});
+		UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("  %-24s %8.3f ms %8.1f MPixel/s   PSNR %6.2f dB   %6lld KB %5.1fx smaller"),
+			*FString::Printf(TEXT("%s CPU"), FormatNames[FormatIndex]),
+			EncodeMs,
+			EncodeMs > 0.0f ? Size * Size / (EncodeMs * 1000.0f) : 0.0f,
+			FGraphicToolsBlockCompression::ComputePSNR(Pixels.GetData(), Blocks.GetData(), FIntPoint(Size, Size), Formats[FormatIndex]),
+			(int64)Blocks.Num() / 1024,
+			(float)FloatRGBABytes / Blocks.Num());
+	}
+
+	if (!CanDispatchGPUWork() || GMaxRHIFeatureLevel < ERHIFeatureLevel::SM5)
+	{
+		return;
+	}
+
+	const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+	ENQUEUE_RENDER_COMMAND(GraphicToolsBlockCompressionBenchmark)
+	(
+		[Size, Iterations, Pixels = MoveTemp(Pixels), FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			if (!GSupportsTimestampRenderQueries)
+			{
+				UE_LOG(LogGraphicToolsBenchmark, Warning, TEXT("This RHI has no timestamp queries, nothing to measure with"));
+				return;
+			}
+
+			TRefCountPtr<IPooledRenderTarget> Source = AllocateImageIntermediate(RHICmdList, FIntPoint(Size, Size), PF_A32B32G32R32F, 1, TEXT("GraphicTools.BenchmarkBlockSource"));
+			FRHITexture2D* SourceTexture = Source->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+			RHIUpdateTexture2D(SourceTexture, 0, FUpdateTextureRegion2D(0, 0, 0, 0, Size, Size), Size * sizeof(FLinearColor), reinterpret_cast<const uint8*>(Pixels.GetData()));
+
+			UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("Block compression, %dx%d, compute encoder with %d iterations:"), Size, Size, Iterations);
+			for (int32 FormatIndex = 0; FormatIndex < UE_ARRAY_COUNT(Formats); ++FormatIndex)
+			{
+				const EGraphicToolsBlockFormat Format = Formats[FormatIndex];
+				const float EncodeMs = TimeOnGPU(RHICmdList, Iterations, [&]()
+				{
+					CompressBlocks_RenderThread(RHICmdList, FeatureLevel, SourceTexture, Format);
+				});
+
+				// the quality of what the GPU wrote, decoded on the CPU
+				TRefCountPtr<IPooledRenderTarget> Blocks = CompressBlocks_RenderThread(RHICmdList, FeatureLevel, SourceTexture, Format);
+				TArray<uint8> BlockData;
+				ReadBackBlocks_RenderThread(RHICmdList, Blocks->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D(), Format, BlockData);
+
+				UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("  %-24s %8.3f ms %8.1f MPixel/s   PSNR %6.2f dB"),
+					*FString::Printf(TEXT("%s GPU"), FormatNames[FormatIndex]),
+					EncodeMs,
+					EncodeMs > 0.0f ? Size * Size / (EncodeMs * 1000.0f) : 0.0f,
+					FGraphicToolsBlockCompression::ComputePSNR(Pixels.GetData(), BlockData.GetData(), FIntPoint(Size, Size), Format));
+			}
+		}
+	);
+}
+
+static FAutoConsoleCommand GBenchmarkBlockCompressionCommand(
+	TEXT("GraphicTools.Benchmark.BlockCompression"),
+	TEXT("Times the BC1/BC3/BC5/BC7 encoders on the CPU and the GPU and reports their PSNR: GraphicTools.Benchmark.BlockCompression [Size=1024] [Iterations=10]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunBlockCompressionBenchmark)
+);
+
+static void RunOutputFormatBenchmark(const TArray<FString>& Args)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork())
+	{
+		return;
+	}
+
+	const int32 Size = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2048, 64, 8192);
+	const int32 Iterations = FMath::Clamp(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 20, 1, 1000);
+	const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+	ENQUEUE_RENDER_COMMAND(GraphicToolsOutputFormatBenchmark)
+	(
+		[Size, Iterations, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			if (!GSupportsTimestampRenderQueries)
+			{
+				UE_LOG(LogGraphicToolsBenchmark, Warning, TEXT("This RHI has no timestamp queries, nothing to measure with"));
+				return;
+			}
+
+			static const TCHAR* FormatNames[] = { TEXT("R8G8B8A8"), TEXT("R10G10B10A2"), TEXT("R11G11B10F"), TEXT("FloatRGBA") };
+			static_assert(UE_ARRAY_COUNT(FormatNames) == GraphicToolsNumOutputFormats, "Every output format is measured");
+
+			float FloatRGBAMs = 0.0f;
+			TArray<TPair<int32, float>> Timings;
+			for (int32 Index = 0; Index < GraphicToolsNumOutputFormats; ++Index)
+			{
+				const EPixelFormat PixelFormat = GetOutputPixelFormat((EGraphicToolsOutputFormat)Index);
+				TRefCountPtr<IPooledRenderTarget> Target;
+				GRenderTargetPool.FindFreeElement(RHICmdList, FPooledRenderTargetDesc::Create2DDesc(FIntPoint(Size, Size), PixelFormat, FClearValueBinding::None, TexCreate_None, TexCreate_ShaderResource | TexCreate_RenderTargetable, false), Target, TEXT("GraphicTools.BenchmarkOutputFormat"));
+				FRHITexture2D* TargetTexture = Target->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+
+				const float Ms = TimeOnGPU(RHICmdList, Iterations, [&]()
+				{
+					DrawCheckerBoard_RenderThread(RHICmdList, TargetTexture, FeatureLevel);
+				});
+				Timings.Add(MakeTuple(Index, Ms));
+				if ((EGraphicToolsOutputFormat)Index == EGraphicToolsOutputFormat::FloatRGBA)
+				{
+					FloatRGBAMs = Ms;
+				}
+			}
+
+			// the pass writes the intermediate, the copy reads it and writes the target
+			UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("CheckerBoard output formats, %dx%d, %d iterations (pass and copy, vs FloatRGBA):"), Size, Size, Iterations);
+			for (const TPair<int32, float>& Timing : Timings)
+			{
+				const int32 BytesPerPixel = GPixelFormats[GetOutputPixelFormat((EGraphicToolsOutputFormat)Timing.Key)].BlockBytes;
+				UE_LOG(LogGraphicToolsBenchmark, Display, TEXT("  %-24s %8.3f ms   %d bytes/pixel, %6.1f MB moved   %5.2fx"),
+					FormatNames[Timing.Key],
+					Timing.Value,
+					BytesPerPixel,
+					3.0f * Size * Size * BytesPerPixel / (1024.0f * 1024.0f),
+					Timing.Value > 0.0f ? FloatRGBAMs / Timing.Value : 0.0f);
+			}
+		}
+	);
+}
+
+static FAutoConsoleCommand GBenchmarkOutputFormatsCommand(
+	TEXT("GraphicTools.Benchmark.OutputFormats"),
+	TEXT("Times the CheckerBoard pass writing each output format: GraphicTools.Benchmark.OutputFormats [Size=2048] [Iterations=20]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunOutputFormatBenchmark)
+);
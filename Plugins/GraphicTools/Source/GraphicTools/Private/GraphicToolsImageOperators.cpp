@@ -0,0 +1,746 @@
+#include "GraphicToolsImageOperators.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsGPUScheduler.h"
+
+#include "Engine/TextureRenderTarget2D.h"
+#include "GlobalShader.h"
+#include "RenderTargetPool.h"
+#include "ShaderParameterUtils.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsImage, Log, All);
+
+/** Parameters every image operator shares: one source, one output and their sizes */
+class FGraphicToolsImageShader : public FGlobalShader
+{
+	DECLARE_TYPE_LAYOUT(FGraphicToolsImageShader, NonVirtual);
+public:
+
+	FGraphicToolsImageShader()
+	{
+	}
+
+	FGraphicToolsImageShader(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGlobalShader(Initializer)
+	{
+		SourceTexture.Bind(Initializer.ParameterMap, TEXT("SourceTexture"));
+		SourceSampler.Bind(Initializer.ParameterMap, TEXT("SourceSampler"));
+		SourceSize.Bind(Initializer.ParameterMap, TEXT("SourceSize"));
+		Output.Bind(Initializer.ParameterMap, TEXT("RWOutput"));
+		OutputSize.Bind(Initializer.ParameterMap, TEXT("OutputSize"));
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("BLUR_TILE_SIZE"), GraphicToolsBlurTileSize);
+		OutEnvironment.SetDefine(TEXT("MAX_BLUR_RADIUS"), FGraphicToolsImageBatch::MaxBlurRadius);
+		OutEnvironment.SetDefine(TEXT("MIPS_PER_DISPATCH"), GraphicToolsMipsPerDispatch);
+	}
+
+	void SetSource(FRHICommandList& RHICmdList, FRHITexture* Texture, FRHISamplerState* Sampler, FIntPoint Size)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetTextureParameter(RHICmdList, ShaderRHI, SourceTexture, SourceSampler, Sampler, Texture);
+		SetShaderValue(RHICmdList, ShaderRHI, SourceSize, Size);
+	}
+
+	void SetSource(FRHICommandList& RHICmdList, FRHIShaderResourceView* SRV, FRHISamplerState* Sampler, FIntPoint Size)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetSRVParameter(RHICmdList, ShaderRHI, SourceTexture, SRV);
+		SetSamplerParameter(RHICmdList, ShaderRHI, SourceSampler, Sampler);
+		SetShaderValue(RHICmdList, ShaderRHI, SourceSize, Size);
+	}
+
+	void SetOutput(FRHICommandList& RHICmdList, FRHIUnorderedAccessView* UAV, FIntPoint Size)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetUAVParameter(RHICmdList, ShaderRHI, Output, UAV);
+		SetShaderValue(RHICmdList, ShaderRHI, OutputSize, Size);
+	}
+
+	void UnsetOutput(FRHICommandList& RHICmdList)
+	{
+		SetUAVParameter(RHICmdList, RHICmdList.GetBoundComputeShader(), Output, nullptr);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, SourceTexture);
+	LAYOUT_FIELD(FShaderResourceParameter, SourceSampler);
+	LAYOUT_FIELD(FShaderParameter, SourceSize);
+	LAYOUT_FIELD(FShaderResourceParameter, Output);
+	LAYOUT_FIELD(FShaderParameter, OutputSize);
+};
+
+IMPLEMENT_TYPE_LAYOUT(FGraphicToolsImageShader);
+
+enum class EBlurPass : uint8
+{
+	Horizontal,
+	Vertical,
+	/** Full 2D kernel, the benchmark reference */
+	Naive,
+};
+
+template<EBlurPass Pass>
+class TBlurCS : public FGraphicToolsImageShader
+{
+	DECLARE_SHADER_TYPE(TBlurCS, Global);
+public:
+
+	TBlurCS()
+	{
+	}
+
+	TBlurCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsImageShader(Initializer)
+	{
+		BlurRadius.Bind(Initializer.ParameterMap, TEXT("BlurRadius"));
+		BlurSigma.Bind(Initializer.ParameterMap, TEXT("BlurSigma"));
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGraphicToolsImageShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("BLUR_HORIZONTAL"), Pass == EBlurPass::Horizontal ? 1 : 0);
+	}
+
+	void SetBlurParameters(FRHICommandList& RHICmdList, int32 Radius, float Sigma)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetShaderValue(RHICmdList, ShaderRHI, BlurRadius, Radius);
+		SetShaderValue(RHICmdList, ShaderRHI, BlurSigma, Sigma);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderParameter, BlurRadius);
+	LAYOUT_FIELD(FShaderParameter, BlurSigma);
+};
+
+class FDownsampleCS : public FGraphicToolsImageShader
+{
+	DECLARE_SHADER_TYPE(FDownsampleCS, Global);
+public:
+
+	FDownsampleCS()
+	{
+	}
+
+	FDownsampleCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsImageShader(Initializer)
+	{
+	}
+};
+
+class FNaiveDownsampleCS : public FGraphicToolsImageShader
+{
+	DECLARE_SHADER_TYPE(FNaiveDownsampleCS, Global);
+public:
+
+	FNaiveDownsampleCS()
+	{
+	}
+
+	FNaiveDownsampleCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsImageShader(Initializer)
+	{
+	}
+};
+
+class FGenerateMipsCS : public FGraphicToolsImageShader
+{
+	DECLARE_SHADER_TYPE(FGenerateMipsCS, Global);
+public:
+
+	FGenerateMipsCS()
+	{
+	}
+
+	FGenerateMipsCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsImageShader(Initializer)
+	{
+		for (int32 Index = 0; Index < GraphicToolsMipsPerDispatch; ++Index)
+		{
+			MipOutputs[Index].Bind(Initializer.ParameterMap, *FString::Printf(TEXT("RWMip%d"), Index + 1));
+		}
+		NumMips.Bind(Initializer.ParameterMap, TEXT("NumMips"));
+	}
+
+	void SetMipOutputs(FRHICommandList& RHICmdList, const FUnorderedAccessViewRHIRef* UAVs, int32 InNumMips)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		for (int32 Index = 0; Index < GraphicToolsMipsPerDispatch; ++Index)
+		{
+			SetUAVParameter(RHICmdList, ShaderRHI, MipOutputs[Index], UAVs[Index]);
+		}
+		SetShaderValue(RHICmdList, ShaderRHI, NumMips, (uint32)InNumMips);
+	}
+
+	void UnsetMipOutputs(FRHICommandList& RHICmdList)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		for (int32 Index = 0; Index < GraphicToolsMipsPerDispatch; ++Index)
+		{
+			SetUAVParameter(RHICmdList, ShaderRHI, MipOutputs[Index], nullptr);
+		}
+	}
+
+private:
+	LAYOUT_ARRAY(FShaderResourceParameter, MipOutputs, GraphicToolsMipsPerDispatch);
+	LAYOUT_FIELD(FShaderParameter, NumMips);
+};
+
+class FColorConvertCS : public FGraphicToolsImageShader
+{
+	DECLARE_SHADER_TYPE(FColorConvertCS, Global);
+public:
+
+	FColorConvertCS()
+	{
+	}
+
+	FColorConvertCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsImageShader(Initializer)
+	{
+		ColorConversion.Bind(Initializer.ParameterMap, TEXT("ColorConversion"));
+	}
+
+	void SetConversion(FRHICommandList& RHICmdList, EGraphicToolsColorConversion Conversion)
+	{
+		SetShaderValue(RHICmdList, RHICmdList.GetBoundComputeShader(), ColorConversion, (uint32)Conversion);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderParameter, ColorConversion);
+};
+
+class FResizeCS : public FGraphicToolsImageShader
+{
+	DECLARE_SHADER_TYPE(FResizeCS, Global);
+public:
+
+	FResizeCS()
+	{
+	}
+
+	FResizeCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsImageShader(Initializer)
+	{
+	}
+};
+
+IMPLEMENT_SHADER_TYPE(template<>, TBlurCS<EBlurPass::Horizontal>, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("BlurCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TBlurCS<EBlurPass::Vertical>, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("BlurCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TBlurCS<EBlurPass::Naive>, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("NaiveBlurCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FDownsampleCS, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("DownsampleCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FNaiveDownsampleCS, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("NaiveDownsampleCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FGenerateMipsCS, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("GenerateMipsCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FColorConvertCS, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("ColorConvertCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FResizeCS, TEXT("/Plugin/GraphicTools/Private/ImageOperators.usf"), TEXT("ResizeCS"), SF_Compute);
+
+static FIntPoint GetMipSize(FIntPoint Size, int32 Mip)
+{
+	return FIntPoint(FMath::Max(Size.X >> Mip, 1), FMath::Max(Size.Y >> Mip, 1));
+}
+
+static FIntVector GetGroupCount(FIntPoint Size, int32 GroupSize)
+{
+	return FIntVector(FMath::DivideAndRoundUp(Size.X, GroupSize), FMath::DivideAndRoundUp(Size.Y, GroupSize), 1);
+}
+
+// Render targets can't be bound for unordered access, so operators write into a pooled texture of the same
+// format and copy the result over. The pool hands the same textures back to every operation of a batch.
+TRefCountPtr<IPooledRenderTarget> AllocateImageIntermediate(FRHICommandListImmediate& RHICmdList, FIntPoint Size, EPixelFormat Format, uint16 NumMips, const TCHAR* DebugName)
+{
+	const FPooledRenderTargetDesc Desc = FPooledRenderTargetDesc::Create2DDesc(
+		Size,
+		Format,
+		FClearValueBinding::None,
+		TexCreate_None,
+		TexCreate_ShaderResource | TexCreate_UAV,
+		false,
+		NumMips);
+
+	TRefCountPtr<IPooledRenderTarget> Intermediate;
+	GRenderTargetPool.FindFreeElement(RHICmdList, Desc, Intermediate, DebugName);
+	return Intermediate;
+}
+
+EPixelFormat GetOutputPixelFormat(EGraphicToolsOutputFormat Format)
+{
+	switch (Format)
+	{
+	case EGraphicToolsOutputFormat::R8G8B8A8: return PF_R8G8B8A8;
+	case EGraphicToolsOutputFormat::R10G10B10A2: return PF_A2B10G10R10;
+	case EGraphicToolsOutputFormat::R11G11B10F: return PF_FloatR11G11B10;
+	case EGraphicToolsOutputFormat::FloatRGBA: return PF_FloatRGBA;
+	}
+	return PF_Unknown;
+}
+
+bool FindOutputFormat(EPixelFormat Format, EGraphicToolsOutputFormat& OutFormat)
+{
+	for (int32 Index = 0; Index < GraphicToolsNumOutputFormats; ++Index)
+	{
+		if (GetOutputPixelFormat((EGraphicToolsOutputFormat)Index) == Format)
+		{
+			OutFormat = (EGraphicToolsOutputFormat)Index;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool PrepareOutputRenderTarget(UTextureRenderTarget2D* Target, EGraphicToolsOutputFormat Format, const TCHAR* NodeName)
+{
+	const EPixelFormat PixelFormat = GetOutputPixelFormat(Format);
+	if (Target == nullptr || Target->GetFormat() == PixelFormat)
+	{
+		return Target != nullptr;
+	}
+
+	if (Target->IsAsset())
+	{
+		UE_LOG(LogGraphicToolsImage, Warning, TEXT("%s: %s is %s, set its format to %s or pass the format it has"),
+			NodeName, *Target->GetName(), GPixelFormats[Target->GetFormat()].Name, GPixelFormats[PixelFormat].Name);
+		return false;
+	}
+
+	// queued jobs still hold the resource this replaces
+	FGraphicToolsGPUScheduler::Flush();
+	Target->InitCustomFormat(Target->SizeX, Target->SizeY, PixelFormat, Target->bForceLinearGamma);
+	return true;
+}
+
+static void CopyToDestination(FRHICommandListImmediate& RHICmdList, FRHITexture2D* Intermediate, FRHITexture2D* Destination, const FRHICopyTextureInfo& CopyInfo = FRHICopyTextureInfo())
+{
+	RHICmdList.Transition({
+		FRHITransitionInfo(Intermediate, ERHIAccess::Unknown, ERHIAccess::CopySrc),
+		FRHITransitionInfo(Destination, ERHIAccess::Unknown, ERHIAccess::CopyDest)
+	});
+	RHICmdList.CopyTexture(Intermediate, Destination, CopyInfo);
+	RHICmdList.Transition(FRHITransitionInfo(Destination, ERHIAccess::CopyDest, ERHIAccess::SRVMask));
+}
+
+static void BeginImageDispatch(FRHICommandList& RHICmdList, FRHIComputeShader* ShaderRHI, FRHIUnorderedAccessView* OutputUAV)
+{
+	RHICmdList.Transition(FRHITransitionInfo(OutputUAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+	RHICmdList.SetComputeShader(ShaderRHI);
+}
+
+static void Blur_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FGlobalShaderMap* ShaderMap,
+	const FGraphicToolsImageOperation& Operation,
+	FRHITexture2D* Source,
+	FRHITexture2D* Destination,
+	bool bNaive
+)
+{
+	const FIntPoint Size = Destination->GetSizeXY();
+	const int32 Radius = FMath::Clamp(Operation.BlurRadius, 1, FGraphicToolsImageBatch::MaxBlurRadius);
+	const float Sigma = Operation.BlurKernel == EGraphicToolsBlurKernel::Box ? 0.0f : (Operation.BlurSigma > 0.0f ? Operation.BlurSigma : Radius * 0.5f);
+	FRHISamplerState* Sampler = TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+
+	TRefCountPtr<IPooledRenderTarget> Blurred = AllocateImageIntermediate(RHICmdList, Size, Destination->GetFormat(), 1, TEXT("GraphicTools.Blur"));
+	const FSceneRenderTargetItem& BlurredItem = Blurred->GetRenderTargetItem();
+
+	if (bNaive)
+	{
+		TShaderMapRef<TBlurCS<EBlurPass::Naive>> ComputeShader(ShaderMap);
+		BeginImageDispatch(RHICmdList, ComputeShader.GetComputeShader(), BlurredItem.UAV);
+		ComputeShader->SetSource(RHICmdList, Source, Sampler, Size);
+		ComputeShader->SetOutput(RHICmdList, BlurredItem.UAV, Size);
+		ComputeShader->SetBlurParameters(RHICmdList, Radius, Sigma);
+		const FIntVector GroupCount = GetGroupCount(Size, 8);
+		DispatchComputeShader(RHICmdList, ComputeShader, GroupCount.X, GroupCount.Y, 1);
+		ComputeShader->UnsetOutput(RHICmdList);
+	}
+	else
+	{
+		// horizontal into a second intermediate, vertical from there into the first
+		TRefCountPtr<IPooledRenderTarget> Horizontal = AllocateImageIntermediate(RHICmdList, Size, Destination->GetFormat(), 1, TEXT("GraphicTools.BlurHorizontal"));
+		const FSceneRenderTargetItem& HorizontalItem = Horizontal->GetRenderTargetItem();
+
+		TShaderMapRef<TBlurCS<EBlurPass::Horizontal>> HorizontalShader(ShaderMap);
+		BeginImageDispatch(RHICmdList, HorizontalShader.GetComputeShader(), HorizontalItem.UAV);
+		HorizontalShader->SetSource(RHICmdList, Source, Sampler, Size);
+		HorizontalShader->SetOutput(RHICmdList, HorizontalItem.UAV, Size);
+		HorizontalShader->SetBlurParameters(RHICmdList, Radius, Sigma);
+		DispatchComputeShader(RHICmdList, HorizontalShader, FMath::DivideAndRoundUp(Size.X, GraphicToolsBlurTileSize), Size.Y, 1);
+		HorizontalShader->UnsetOutput(RHICmdList);
+
+		RHICmdList.Transition(FRHITransitionInfo(HorizontalItem.UAV, ERHIAccess::UAVCompute, ERHIAccess::SRVCompute));
+
+		TShaderMapRef<TBlurCS<EBlurPass::Vertical>> VerticalShader(ShaderMap);
+		BeginImageDispatch(RHICmdList, VerticalShader.GetComputeShader(), BlurredItem.UAV);
+		VerticalShader->SetSource(RHICmdList, HorizontalItem.ShaderResourceTexture, Sampler, Size);
+		VerticalShader->SetOutput(RHICmdList, BlurredItem.UAV, Size);
+		VerticalShader->SetBlurParameters(RHICmdList, Radius, Sigma);
+		DispatchComputeShader(RHICmdList, VerticalShader, Size.X, FMath::DivideAndRoundUp(Size.Y, GraphicToolsBlurTileSize), 1);
+		VerticalShader->UnsetOutput(RHICmdList);
+	}
+
+	CopyToDestination(RHICmdList, BlurredItem.ShaderResourceTexture->GetTexture2D(), Destination);
+}
+
+static void Downsample_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FGlobalShaderMap* ShaderMap,
+	FRHITexture2D* Source,
+	FRHITexture2D* Destination,
+	bool bNaive
+)
+{
+	const FIntPoint SourceSize = Source->GetSizeXY();
+	const FIntPoint OutputSize = Destination->GetSizeXY();
+	FRHISamplerState* Sampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+
+	TRefCountPtr<IPooledRenderTarget> Downsampled = AllocateImageIntermediate(RHICmdList, OutputSize, Destination->GetFormat(), 1, TEXT("GraphicTools.Downsample"));
+	const FSceneRenderTargetItem& DownsampledItem = Downsampled->GetRenderTargetItem();
+	const FIntVector GroupCount = GetGroupCount(OutputSize, 8);
+
+	if (bNaive)
+	{
+		TShaderMapRef<FNaiveDownsampleCS> ComputeShader(ShaderMap);
+		BeginImageDispatch(RHICmdList, ComputeShader.GetComputeShader(), DownsampledItem.UAV);
+		ComputeShader->SetSource(RHICmdList, Source, Sampler, SourceSize);
+		ComputeShader->SetOutput(RHICmdList, DownsampledItem.UAV, OutputSize);
+		DispatchComputeShader(RHICmdList, ComputeShader, GroupCount.X, GroupCount.Y, 1);
+		ComputeShader->UnsetOutput(RHICmdList);
+	}
+	else
+	{
+		TShaderMapRef<FDownsampleCS> ComputeShader(ShaderMap);
+		BeginImageDispatch(RHICmdList, ComputeShader.GetComputeShader(), DownsampledItem.UAV);
+		ComputeShader->SetSource(RHICmdList, Source, Sampler, SourceSize);
+		ComputeShader->SetOutput(RHICmdList, DownsampledItem.UAV, OutputSize);
+		DispatchComputeShader(RHICmdList, ComputeShader, GroupCount.X, GroupCount.Y, 1);
+		ComputeShader->UnsetOutput(RHICmdList);
+	}
+
+	CopyToDestination(RHICmdList, DownsampledItem.ShaderResourceTexture->GetTexture2D(), Destination);
+}
+
+static void GenerateMips_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FGlobalShaderMap* ShaderMap,
+	FRHITexture2D* Target,
+	bool bNaive
+)
+{
+	const int32 NumMips = Target->GetNumMips();
+	if (NumMips < 2)
+	{
+		return;
+	}
+
+	const FIntPoint Size = Target->GetSizeXY();
+	FRHISamplerState* Sampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+
+	TRefCountPtr<IPooledRenderTarget> Chain = AllocateImageIntermediate(RHICmdList, Size, Target->GetFormat(), NumMips, TEXT("GraphicTools.MipChain"));
+	FRHITexture2D* ChainTexture = Chain->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+
+	// the top level is the input to everything below it
+	RHICmdList.Transition({
+		FRHITransitionInfo(Target, ERHIAccess::Unknown, ERHIAccess::CopySrc),
+		FRHITransitionInfo(ChainTexture, ERHIAccess::Unknown, ERHIAccess::CopyDest)
+	});
+	RHICmdList.CopyTexture(Target, ChainTexture, FRHICopyTextureInfo());
+	RHICmdList.Transition(FRHITransitionInfo(ChainTexture, ERHIAccess::CopyDest, ERHIAccess::SRVCompute));
+
+	if (bNaive)
+	{
+		// one dispatch per level, each waiting on the one before
+		TShaderMapRef<FDownsampleCS> ComputeShader(ShaderMap);
+		for (int32 Mip = 1; Mip < NumMips; ++Mip)
+		{
+			FShaderResourceViewRHIRef SourceMip = RHICreateShaderResourceView(ChainTexture, Mip - 1);
+			FUnorderedAccessViewRHIRef OutputMip = RHICreateUnorderedAccessView(ChainTexture, Mip);
+			const FIntPoint OutputSize = GetMipSize(Size, Mip);
+
+			BeginImageDispatch(RHICmdList, ComputeShader.GetComputeShader(), OutputMip);
+			ComputeShader->SetSource(RHICmdList, SourceMip, Sampler, GetMipSize(Size, Mip - 1));
+			ComputeShader->SetOutput(RHICmdList, OutputMip, OutputSize);
+			const FIntVector GroupCount = GetGroupCount(OutputSize, 8);
+			DispatchComputeShader(RHICmdList, ComputeShader, GroupCount.X, GroupCount.Y, 1);
+			ComputeShader->UnsetOutput(RHICmdList);
+
+			RHICmdList.Transition(FRHITransitionInfo(OutputMip, ERHIAccess::UAVCompute, ERHIAccess::SRVCompute));
+		}
+	}
+	else
+	{
+		// up to GraphicToolsMipsPerDispatch levels per dispatch, every group taking a 64x64 tile all the way down
+		TShaderMapRef<FGenerateMipsCS> ComputeShader(ShaderMap);
+		for (int32 BaseMip = 0; BaseMip < NumMips - 1; BaseMip += GraphicToolsMipsPerDispatch)
+		{
+			const int32 NumDispatchMips = FMath::Min(GraphicToolsMipsPerDispatch, NumMips - 1 - BaseMip);
+			const FIntPoint BaseSize = GetMipSize(Size, BaseMip);
+
+			FShaderResourceViewRHIRef BaseSRV = RHICreateShaderResourceView(ChainTexture, BaseMip);
+			FUnorderedAccessViewRHIRef MipUAVs[GraphicToolsMipsPerDispatch];
+			TArray<FRHITransitionInfo, TInlineAllocator<GraphicToolsMipsPerDispatch>> Transitions;
+			for (int32 Index = 0; Index < GraphicToolsMipsPerDispatch; ++Index)
+			{
+				// slots past the last level alias it, the shader never writes to them
+				MipUAVs[Index] = RHICreateUnorderedAccessView(ChainTexture, BaseMip + 1 + FMath::Min(Index, NumDispatchMips - 1));
+				if (Index < NumDispatchMips)
+				{
+					Transitions.Add(FRHITransitionInfo(MipUAVs[Index], ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+				}
+			}
+			RHICmdList.Transition(Transitions);
+
+			RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
+			ComputeShader->SetSource(RHICmdList, BaseSRV, Sampler, BaseSize);
+			ComputeShader->SetMipOutputs(RHICmdList, MipUAVs, NumDispatchMips);
+			const FIntVector GroupCount = GetGroupCount(BaseSize, 64);
+			DispatchComputeShader(RHICmdList, ComputeShader, GroupCount.X, GroupCount.Y, 1);
+			ComputeShader->UnsetMipOutputs(RHICmdList);
+
+			// the last level written is the base of the next dispatch
+			RHICmdList.Transition(FRHITransitionInfo(MipUAVs[NumDispatchMips - 1], ERHIAccess::UAVCompute, ERHIAccess::SRVCompute));
+		}
+	}
+
+	// the top level didn't change, only copy the levels below it back
+	FRHICopyTextureInfo CopyInfo;
+	CopyInfo.SourceMipIndex = 1;
+	CopyInfo.DestMipIndex = 1;
+	CopyInfo.NumMips = NumMips - 1;
+	CopyToDestination(RHICmdList, ChainTexture, Target, CopyInfo);
+}
+
+static void ColorConvert_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FGlobalShaderMap* ShaderMap,
+	EGraphicToolsColorConversion Conversion,
+	FRHITexture2D* Source,
+	FRHITexture2D* Destination
+)
+{
+	const FIntPoint Size = Destination->GetSizeXY();
+
+	TRefCountPtr<IPooledRenderTarget> Converted = AllocateImageIntermediate(RHICmdList, Size, Destination->GetFormat(), 1, TEXT("GraphicTools.ColorConvert"));
+	const FSceneRenderTargetItem& ConvertedItem = Converted->GetRenderTargetItem();
+
+	TShaderMapRef<FColorConvertCS> ComputeShader(ShaderMap);
+	BeginImageDispatch(RHICmdList, ComputeShader.GetComputeShader(), ConvertedItem.UAV);
+	ComputeShader->SetSource(RHICmdList, Source, TStaticSamplerState<SF_Point>::GetRHI(), Size);
+	ComputeShader->SetOutput(RHICmdList, ConvertedItem.UAV, Size);
+	ComputeShader->SetConversion(RHICmdList, Conversion);
+	const FIntVector GroupCount = GetGroupCount(Size, 8);
+	DispatchComputeShader(RHICmdList, ComputeShader, GroupCount.X, GroupCount.Y, 1);
+	ComputeShader->UnsetOutput(RHICmdList);
+
+	CopyToDestination(RHICmdList, ConvertedItem.ShaderResourceTexture->GetTexture2D(), Destination);
+}
+
+static void Resize_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FGlobalShaderMap* ShaderMap,
+	EGraphicToolsResizeFilter Filter,
+	FRHITexture2D* Source,
+	FRHITexture2D* Destination
+)
+{
+	const FIntPoint OutputSize = Destination->GetSizeXY();
+	FRHISamplerState* Sampler = Filter == EGraphicToolsResizeFilter::Point
+		? TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI()
+		: TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+
+	TRefCountPtr<IPooledRenderTarget> Resized = AllocateImageIntermediate(RHICmdList, OutputSize, Destination->GetFormat(), 1, TEXT("GraphicTools.Resize"));
+	const FSceneRenderTargetItem& ResizedItem = Resized->GetRenderTargetItem();
+
+	TShaderMapRef<FResizeCS> ComputeShader(ShaderMap);
+	BeginImageDispatch(RHICmdList, ComputeShader.GetComputeShader(), ResizedItem.UAV);
+	ComputeShader->SetSource(RHICmdList, Source, Sampler, Source->GetSizeXY());
+	ComputeShader->SetOutput(RHICmdList, ResizedItem.UAV, OutputSize);
+	const FIntVector GroupCount = GetGroupCount(OutputSize, 8);
+	DispatchComputeShader(RHICmdList, ComputeShader, GroupCount.X, GroupCount.Y, 1);
+	ComputeShader->UnsetOutput(RHICmdList);
+
+	CopyToDestination(RHICmdList, ResizedItem.ShaderResourceTexture->GetTexture2D(), Destination);
+}
+
+void ExecuteImageOperation_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FGraphicToolsImageOperation& Operation,
+	FRHITexture2D* Source,
+	FRHITexture2D* Destination,
+	bool bNaive
+)
+{
+	check(IsInRenderingThread());
+
+	if (Source == nullptr || Destination == nullptr)
+	{
+		return;
+	}
+
+	FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(FeatureLevel);
+	RHICmdList.Transition(FRHITransitionInfo(Source, ERHIAccess::Unknown, ERHIAccess::SRVCompute));
+
+	switch (Operation.Type)
+	{
+	case FGraphicToolsImageOperation::EType::Blur:
+		Blur_RenderThread(RHICmdList, ShaderMap, Operation, Source, Destination, bNaive);
+		break;
+	case FGraphicToolsImageOperation::EType::Downsample:
+		Downsample_RenderThread(RHICmdList, ShaderMap, Source, Destination, bNaive);
+		break;
+	case FGraphicToolsImageOperation::EType::GenerateMips:
+		GenerateMips_RenderThread(RHICmdList, ShaderMap, Destination, bNaive);
+		break;
+	case FGraphicToolsImageOperation::EType::ColorConvert:
+		ColorConvert_RenderThread(RHICmdList, ShaderMap, Operation.ColorConversion, Source, Destination);
+		break;
+	case FGraphicToolsImageOperation::EType::Resize:
+		Resize_RenderThread(RHICmdList, ShaderMap, Operation.ResizeFilter, Source, Destination);
+		break;
+	}
+}
+
+FGraphicToolsImageBatch::FGraphicToolsImageBatch(ERHIFeatureLevel::Type InFeatureLevel)
+	: FeatureLevel(InFeatureLevel)
+{
+}
+
+bool FGraphicToolsImageBatch::Blur(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsBlurKernel Kernel, int32 Radius, float Sigma)
+{
+	if (Source != nullptr && Destination != nullptr && (Source->SizeX != Destination->SizeX || Source->SizeY != Destination->SizeY))
+	{
+		UE_LOG(LogGraphicToolsImage, Warning, TEXT("Blur: %s and %s differ in size"), *Source->GetName(), *Destination->GetName());
+		return false;
+	}
+
+	if (Radius < 1 || Radius > MaxBlurRadius)
+	{
+		UE_LOG(LogGraphicToolsImage, Warning, TEXT("Blur: radius %d clamped to [1, %d]"), Radius, MaxBlurRadius);
+	}
+
+	FGraphicToolsImageOperation Operation;
+	Operation.Type = FGraphicToolsImageOperation::EType::Blur;
+	Operation.BlurKernel = Kernel;
+	Operation.BlurRadius = FMath::Clamp(Radius, 1, MaxBlurRadius);
+	Operation.BlurSigma = Sigma;
+	return Record(Operation, Source, Destination);
+}
+
+bool FGraphicToolsImageBatch::Downsample(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination)
+{
+	if (Source != nullptr && Destination != nullptr)
+	{
+		const FIntPoint Expected = GetMipSize(FIntPoint(Source->SizeX, Source->SizeY), 1);
+		if (Destination->SizeX != Expected.X || Destination->SizeY != Expected.Y)
+		{
+			UE_LOG(LogGraphicToolsImage, Warning, TEXT("Downsample: %s must be %dx%d to hold half of %s"), *Destination->GetName(), Expected.X, Expected.Y, *Source->GetName());
+			return false;
+		}
+	}
+
+	FGraphicToolsImageOperation Operation;
+	Operation.Type = FGraphicToolsImageOperation::EType::Downsample;
+	return Record(Operation, Source, Destination);
+}
+
+bool FGraphicToolsImageBatch::GenerateMips(UTextureRenderTarget2D* Target)
+{
+	if (Target != nullptr && !Target->bAutoGenerateMips)
+	{
+		UE_LOG(LogGraphicToolsImage, Warning, TEXT("GenerateMips: %s has no mips, enable Auto Generate Mips on it"), *Target->GetName());
+		return false;
+	}
+
+	FGraphicToolsImageOperation Operation;
+	Operation.Type = FGraphicToolsImageOperation::EType::GenerateMips;
+	return Record(Operation, Target, Target);
+}
+
+bool FGraphicToolsImageBatch::ConvertColorSpace(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsColorConversion Conversion)
+{
+	if (Source != nullptr && Destination != nullptr && (Source->SizeX != Destination->SizeX || Source->SizeY != Destination->SizeY))
+	{
+		UE_LOG(LogGraphicToolsImage, Warning, TEXT("ConvertColorSpace: %s and %s differ in size"), *Source->GetName(), *Destination->GetName());
+		return false;
+	}
+
+	FGraphicToolsImageOperation Operation;
+	Operation.Type = FGraphicToolsImageOperation::EType::ColorConvert;
+	Operation.ColorConversion = Conversion;
+	return Record(Operation, Source, Destination);
+}
+
+bool FGraphicToolsImageBatch::Resize(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsResizeFilter Filter)
+{
+	FGraphicToolsImageOperation Operation;
+	Operation.Type = FGraphicToolsImageOperation::EType::Resize;
+	Operation.ResizeFilter = Filter;
+	return Record(Operation, Source, Destination);
+}
+
+bool FGraphicToolsImageBatch::Record(const FGraphicToolsImageOperation& Operation, UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination)
+{
+	check(IsInGameThread());
+
+	if (Source == nullptr || Destination == nullptr)
+	{
+		UE_LOG(LogGraphicToolsImage, Warning, TEXT("Image operation dropped, source and destination render targets are required"));
+		return false;
+	}
+
+	FTextureRenderTargetResource* SourceResource = Source->GameThread_GetRenderTargetResource();
+	FTextureRenderTargetResource* DestinationResource = Destination->GameThread_GetRenderTargetResource();
+	if (SourceResource == nullptr || DestinationResource == nullptr)
+	{
+		UE_LOG(LogGraphicToolsImage, Warning, TEXT("Image operation dropped, %s or %s has no resource"), *Source->GetName(), *Destination->GetName());
+		return false;
+	}
+
+	Operations.Add(FRecordedOperation{ Operation, SourceResource, DestinationResource });
+	Objects.AddUnique(Source);
+	Objects.AddUnique(Destination);
+	return true;
+}
+
+void FGraphicToolsImageBatch::Submit()
+{
+	check(IsInGameThread());
+
+	if (Operations.Num() == 0 || !CanDispatchGPUWork())
+	{
+		Operations.Reset();
+		Objects.Reset();
+		return;
+	}
+
+	FGraphicToolsGPUJob Job;
+	Job.Name = TEXT("ImageBatch");
+	Job.Objects.Append(Objects);
+	Job.Work = [Operations = MoveTemp(Operations), FeatureLevel = FeatureLevel](FRHICommandListImmediate& RHICmdList)
+	{
+		SCOPED_DRAW_EVENT(RHICmdList, GraphicToolsImageBatch);
+
+		for (const FRecordedOperation& Recorded : Operations)
+		{
+			ExecuteImageOperation_RenderThread(
+				RHICmdList,
+				FeatureLevel,
+				Recorded.Operation,
+				Recorded.Source->GetRenderTargetTexture(),
+				Recorded.Destination->GetRenderTargetTexture()
+			);
+		}
+	};
+	FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+
+	Operations.Reset();
+	Objects.Reset();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphicToolsBlockCompression.h"
+#include "GraphicToolsGPUScheduler.h"
+#include "GraphicToolsImageOperators.h"
+#include "RHI.h"
+#include "Templates/RefCounting.h"
+
+struct IPooledRenderTarget;
+
+/** Texels along the blur axis handled by one group of the tiled blur */
+static const int32 GraphicToolsBlurTileSize = 128;
+
+/** Levels the mip chain shader writes per dispatch, bounded by the 8 UAVs a D3D11 compute shader may bind */
+static const int32 GraphicToolsMipsPerDispatch = 6;
+
+/**
+ * Runs one image operation from Source into Destination. bNaive selects the straightforward reference
+ * implementation the benchmark compares against, where there is one on the GPU.
+ */
+void ExecuteImageOperation_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FGraphicToolsImageOperation& Operation,
+	FRHITexture2D* Source,
+	FRHITexture2D* Destination,
+	bool bNaive = false
+);
+
+/** A texture from the render target pool that compute passes can write to and read back from */
+TRefCountPtr<IPooledRenderTarget> AllocateImageIntermediate(
+	FRHICommandListImmediate& RHICmdList,
+	FIntPoint Size,
+	EPixelFormat Format,
+	uint16 NumMips,
+	const TCHAR* DebugName
+);
+
+/**
+ * Encodes Source into 4x4 blocks of Format, one texel per block in a PF_R32G32_UINT (BC1) or
+ * PF_R32G32B32A32_UINT texture the size of Source / 4, ready to be copied into a compressed texture.
+ */
+TRefCountPtr<IPooledRenderTarget> CompressBlocks_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	FRHITexture2D* Source,
+	EGraphicToolsBlockFormat Format
+);
+
+/** Copies what CompressBlocks_RenderThread wrote back to the CPU, in the layout EncodeBlocks writes. Waits for the GPU */
+void ReadBackBlocks_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FRHITexture2D* Blocks,
+	EGraphicToolsBlockFormat Format,
+	TArray<uint8>& OutBlocks
+);
+
+/**
+ * Smooth gradients, hard checker edges, a little noise and an alpha falloff, what baked procedural output looks
+ * like. The image the block compression benchmark and tests encode, the same for a given Size
+ */
+void MakeBlockCompressionTestImage(int32 Size, TArray<FLinearColor>& OutPixels);
+
+/** Writes the CheckerBoard pattern into Target, in its format, which must be one FindOutputFormat knows */
+void DrawCheckerBoard_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FRHITexture2D* Target,
+	ERHIFeatureLevel::Type FeatureLevel
+);
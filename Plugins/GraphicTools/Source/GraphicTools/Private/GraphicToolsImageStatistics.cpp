@@ -0,0 +1,431 @@
+#include "GraphicToolsImageStatistics.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsGPUScheduler.h"
+
+#include "Async/Async.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "GlobalShader.h"
+#include "HAL/IConsoleManager.h"
+#include "RHIGPUReadback.h"
+#include "RHIUtilities.h"
+#include "ShaderParameterUtils.h"
+#include "Tickable.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsStatistics, Log, All);
+
+static const int32 StatisticsTileSize = 64;
+
+/** Parameters both reduction passes share */
+class FGraphicToolsStatisticsShader : public FGlobalShader
+{
+	DECLARE_TYPE_LAYOUT(FGraphicToolsStatisticsShader, NonVirtual);
+public:
+
+	FGraphicToolsStatisticsShader()
+	{
+	}
+
+	FGraphicToolsStatisticsShader(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGlobalShader(Initializer)
+	{
+		SourceTexture.Bind(Initializer.ParameterMap, TEXT("SourceTexture"));
+		SourceSize.Bind(Initializer.ParameterMap, TEXT("SourceSize"));
+		HistogramScale.Bind(Initializer.ParameterMap, TEXT("HistogramScale"));
+		Partials.Bind(Initializer.ParameterMap, TEXT("RWPartials"));
+		PartialsPerRow.Bind(Initializer.ParameterMap, TEXT("PartialsPerRow"));
+		NumPartials.Bind(Initializer.ParameterMap, TEXT("NumPartials"));
+		NumPixels.Bind(Initializer.ParameterMap, TEXT("NumPixels"));
+		Result.Bind(Initializer.ParameterMap, TEXT("RWResult"));
+	}
+
+	static bool ShouldCompileStatisticsPermutation(const FGlobalShaderPermutationParameters& Parameters, bool bWaveOps)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5) && (!bWaveOps || RHISupportsWaveOperations(Parameters.Platform));
+	}
+
+	static void ModifyStatisticsCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment, bool bWaveOps)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("NUM_HISTOGRAM_BINS"), FGraphicToolsImageStatisticsReduction::NumHistogramBins);
+		OutEnvironment.SetDefine(TEXT("USE_WAVE_OPS"), bWaveOps ? 1 : 0);
+		if (bWaveOps)
+		{
+			OutEnvironment.CompilerFlags.Add(CFLAG_WaveOperations);
+		}
+	}
+
+	void SetParameters(
+		FRHICommandList& RHICmdList,
+		FRHITexture* Source,
+		FIntPoint InSourceSize,
+		float InHistogramScale,
+		FRHIUnorderedAccessView* PartialsUAV,
+		FIntPoint NumTiles,
+		FRHIUnorderedAccessView* ResultUAV
+	)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetTextureParameter(RHICmdList, ShaderRHI, SourceTexture, Source);
+		SetShaderValue(RHICmdList, ShaderRHI, SourceSize, InSourceSize);
+		SetShaderValue(RHICmdList, ShaderRHI, HistogramScale, InHistogramScale);
+		SetUAVParameter(RHICmdList, ShaderRHI, Partials, PartialsUAV);
+		SetShaderValue(RHICmdList, ShaderRHI, PartialsPerRow, (uint32)NumTiles.X);
+		SetShaderValue(RHICmdList, ShaderRHI, NumPartials, (uint32)(NumTiles.X * NumTiles.Y));
+		SetShaderValue(RHICmdList, ShaderRHI, NumPixels, (uint32)(InSourceSize.X * InSourceSize.Y));
+		SetUAVParameter(RHICmdList, ShaderRHI, Result, ResultUAV);
+	}
+
+	void UnsetParameters(FRHICommandList& RHICmdList)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetUAVParameter(RHICmdList, ShaderRHI, Partials, nullptr);
+		SetUAVParameter(RHICmdList, ShaderRHI, Result, nullptr);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, SourceTexture);
+	LAYOUT_FIELD(FShaderParameter, SourceSize);
+	LAYOUT_FIELD(FShaderParameter, HistogramScale);
+	LAYOUT_FIELD(FShaderResourceParameter, Partials);
+	LAYOUT_FIELD(FShaderParameter, PartialsPerRow);
+	LAYOUT_FIELD(FShaderParameter, NumPartials);
+	LAYOUT_FIELD(FShaderParameter, NumPixels);
+	LAYOUT_FIELD(FShaderResourceParameter, Result);
+};
+
+IMPLEMENT_TYPE_LAYOUT(FGraphicToolsStatisticsShader);
+
+template<bool bWaveOps>
+class TStatisticsCS : public FGraphicToolsStatisticsShader
+{
+	DECLARE_SHADER_TYPE(TStatisticsCS, Global);
+public:
+
+	TStatisticsCS()
+	{
+	}
+
+	TStatisticsCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsStatisticsShader(Initializer)
+	{
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return ShouldCompileStatisticsPermutation(Parameters, bWaveOps);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		ModifyStatisticsCompilationEnvironment(Parameters, OutEnvironment, bWaveOps);
+	}
+};
+
+template<bool bWaveOps>
+class TStatisticsFinalizeCS : public FGraphicToolsStatisticsShader
+{
+	DECLARE_SHADER_TYPE(TStatisticsFinalizeCS, Global);
+public:
+
+	TStatisticsFinalizeCS()
+	{
+	}
+
+	TStatisticsFinalizeCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsStatisticsShader(Initializer)
+	{
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return ShouldCompileStatisticsPermutation(Parameters, bWaveOps);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		ModifyStatisticsCompilationEnvironment(Parameters, OutEnvironment, bWaveOps);
+	}
+};
+
+IMPLEMENT_SHADER_TYPE(template<>, TStatisticsCS<false>, TEXT("/Plugin/GraphicTools/Private/ImageStatistics.usf"), TEXT("StatisticsCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TStatisticsCS<true>, TEXT("/Plugin/GraphicTools/Private/ImageStatistics.usf"), TEXT("StatisticsCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TStatisticsFinalizeCS<false>, TEXT("/Plugin/GraphicTools/Private/ImageStatistics.usf"), TEXT("FinalizeCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(template<>, TStatisticsFinalizeCS<true>, TEXT("/Plugin/GraphicTools/Private/ImageStatistics.usf"), TEXT("FinalizeCS"), SF_Compute);
+
+/** A reduction whose result is on its way back from the GPU, render thread only */
+struct FPendingStatistics
+{
+	FRWBuffer Partials;
+	FRWBuffer Result;
+	TUniquePtr<FRHIGPUBufferReadback> Readback;
+	int32 NumPixels = 0;
+	float HistogramMax = 1.0f;
+	TFunction<void(const FGraphicToolsImageStatistics&)> OnComputed;
+};
+
+/**
+ * Polls the readbacks of queued reductions once per frame while any are in flight and hands finished
+ * results to their callbacks on the game thread.
+ */
+class FGraphicToolsStatisticsReadbacks : public FTickableGameObject
+{
+public:
+	static FGraphicToolsStatisticsReadbacks& Get()
+	{
+		static FGraphicToolsStatisticsReadbacks Instance;
+		return Instance;
+	}
+
+	/** Game thread, before the query is enqueued */
+	void AddInFlight()
+	{
+		++NumInFlight;
+	}
+
+	void Add_RenderThread(TUniquePtr<FPendingStatistics>&& Pending)
+	{
+		PendingQueries.Add(MoveTemp(Pending));
+	}
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override
+	{
+		ENQUEUE_RENDER_COMMAND(PollGraphicToolsStatistics)
+		(
+			[this](FRHICommandListImmediate& RHICmdList)
+			{
+				Poll_RenderThread();
+			}
+		);
+	}
+
+	virtual bool IsTickable() const override { return NumInFlight > 0; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FGraphicToolsStatisticsReadbacks, STATGROUP_Tickables); }
+	// End of FTickableGameObject interface
+
+private:
+	FGraphicToolsStatisticsReadbacks()
+		: NumInFlight(0)
+	{
+	}
+
+	void Poll_RenderThread()
+	{
+		check(IsInRenderingThread());
+
+		// readbacks complete in submission order, stop at the first one that isn't there yet
+		int32 NumReady = 0;
+		while (NumReady < PendingQueries.Num() && PendingQueries[NumReady]->Readback->IsReady())
+		{
+			FPendingStatistics& Pending = *PendingQueries[NumReady];
+
+			const uint32* Data = static_cast<const uint32*>(Pending.Readback->Lock(FGraphicToolsImageStatisticsReduction::ResultBytes));
+			FGraphicToolsImageStatistics Statistics = Decode(Data, Pending.NumPixels, Pending.HistogramMax);
+			Pending.Readback->Unlock();
+
+			AsyncTask(ENamedThreads::GameThread, [this, OnComputed = MoveTemp(Pending.OnComputed), Statistics = MoveTemp(Statistics)]()
+			{
+				--NumInFlight;
+				OnComputed(Statistics);
+			});
+
+			++NumReady;
+		}
+
+		PendingQueries.RemoveAt(0, NumReady);
+	}
+
+	static FGraphicToolsImageStatistics Decode(const uint32* Data, int32 NumPixels, float HistogramMax)
+	{
+		const float* Floats = reinterpret_cast<const float*>(Data);
+		const int32 NumBins = FGraphicToolsImageStatisticsReduction::NumHistogramBins;
+
+		FGraphicToolsImageStatistics Statistics;
+		Statistics.Min = FLinearColor(Floats[0], Floats[1], Floats[2]);
+		Statistics.MinLuminance = Floats[3];
+		Statistics.Max = FLinearColor(Floats[4], Floats[5], Floats[6]);
+		Statistics.MaxLuminance = Floats[7];
+		Statistics.Mean = FLinearColor(Floats[8], Floats[9], Floats[10]);
+		Statistics.MeanLuminance = Floats[11];
+
+		const uint32* Histograms = Data + 12;
+		TArray<int32>* Channels[] = { &Statistics.RedHistogram, &Statistics.GreenHistogram, &Statistics.BlueHistogram, &Statistics.LuminanceHistogram };
+		for (int32 Channel = 0; Channel < UE_ARRAY_COUNT(Channels); ++Channel)
+		{
+			Channels[Channel]->SetNumUninitialized(NumBins);
+			for (int32 Bin = 0; Bin < NumBins; ++Bin)
+			{
+				(*Channels[Channel])[Bin] = (int32)Histograms[Channel * NumBins + Bin];
+			}
+		}
+
+		Statistics.HistogramMax = HistogramMax;
+		Statistics.NumPixels = NumPixels;
+		return Statistics;
+	}
+
+	/** Oldest first */
+	TArray<TUniquePtr<FPendingStatistics>> PendingQueries;
+
+	/** Game thread */
+	int32 NumInFlight;
+};
+
+template<bool bWaveOps>
+static void DispatchStatistics_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FGlobalShaderMap* ShaderMap,
+	FRHITexture2D* Source,
+	float HistogramScale,
+	FPendingStatistics& Pending
+)
+{
+	const FIntPoint Size = Source->GetSizeXY();
+	const FIntPoint NumTiles(FMath::DivideAndRoundUp(Size.X, StatisticsTileSize), FMath::DivideAndRoundUp(Size.Y, StatisticsTileSize));
+
+	TShaderMapRef<TStatisticsCS<bWaveOps>> StatisticsShader(ShaderMap);
+	RHICmdList.SetComputeShader(StatisticsShader.GetComputeShader());
+	StatisticsShader->SetParameters(RHICmdList, Source, Size, HistogramScale, Pending.Partials.UAV, NumTiles, Pending.Result.UAV);
+	DispatchComputeShader(RHICmdList, StatisticsShader, NumTiles.X, NumTiles.Y, 1);
+	StatisticsShader->UnsetParameters(RHICmdList);
+
+	RHICmdList.Transition(FRHITransitionInfo(Pending.Partials.UAV, ERHIAccess::UAVCompute, ERHIAccess::UAVCompute));
+
+	TShaderMapRef<TStatisticsFinalizeCS<bWaveOps>> FinalizeShader(ShaderMap);
+	RHICmdList.SetComputeShader(FinalizeShader.GetComputeShader());
+	FinalizeShader->SetParameters(RHICmdList, Source, Size, HistogramScale, Pending.Partials.UAV, NumTiles, Pending.Result.UAV);
+	DispatchComputeShader(RHICmdList, FinalizeShader, 1, 1, 1);
+	FinalizeShader->UnsetParameters(RHICmdList);
+}
+
+static void ComputeStatistics_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FTextureRenderTargetResource* TextureRenderTargetResource,
+	ERHIFeatureLevel::Type FeatureLevel,
+	TUniquePtr<FPendingStatistics>&& Pending
+)
+{
+	check(IsInRenderingThread());
+
+	FRHITexture2D* Source = TextureRenderTargetResource->GetRenderTargetTexture();
+	const FIntPoint Size = Source->GetSizeXY();
+	const int32 NumTiles = FMath::DivideAndRoundUp(Size.X, StatisticsTileSize) * FMath::DivideAndRoundUp(Size.Y, StatisticsTileSize);
+
+	Pending->NumPixels = Size.X * Size.Y;
+	Pending->Partials.Initialize(TEXT("GraphicTools.StatisticsPartials"), sizeof(FVector4), NumTiles * 3, PF_A32B32G32R32F, ERHIAccess::UAVCompute);
+	Pending->Result.Initialize(TEXT("GraphicTools.Statistics"), sizeof(uint32), FGraphicToolsImageStatisticsReduction::ResultBytes / sizeof(uint32), PF_R32_UINT, ERHIAccess::UAVCompute);
+	Pending->Readback = MakeUnique<FRHIGPUBufferReadback>(TEXT("GraphicTools.Statistics"));
+
+	SCOPED_DRAW_EVENT(RHICmdList, GraphicToolsStatistics);
+
+	// the histograms are accumulated with atomics
+	RHICmdList.ClearUAVUint(Pending->Result.UAV, FUintVector4(0, 0, 0, 0));
+	RHICmdList.Transition(FRHITransitionInfo(Source, ERHIAccess::Unknown, ERHIAccess::SRVCompute));
+
+	const float HistogramScale = FGraphicToolsImageStatisticsReduction::NumHistogramBins / FMath::Max(Pending->HistogramMax, KINDA_SMALL_NUMBER);
+	FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(FeatureLevel);
+	if (GRHISupportsWaveOperations && RHISupportsWaveOperations(GShaderPlatformForFeatureLevel[FeatureLevel]))
+	{
+		DispatchStatistics_RenderThread<true>(RHICmdList, ShaderMap, Source, HistogramScale, *Pending);
+	}
+	else
+	{
+		DispatchStatistics_RenderThread<false>(RHICmdList, ShaderMap, Source, HistogramScale, *Pending);
+	}
+
+	RHICmdList.Transition(FRHITransitionInfo(Pending->Result.UAV, ERHIAccess::UAVCompute, ERHIAccess::CopySrc));
+	Pending->Readback->EnqueueCopy(RHICmdList, Pending->Result.Buffer, FGraphicToolsImageStatisticsReduction::ResultBytes);
+
+	FGraphicToolsStatisticsReadbacks::Get().Add_RenderThread(MoveTemp(Pending));
+}
+
+bool FGraphicToolsImageStatisticsReduction::Request(
+	UTextureRenderTarget2D* Target,
+	ERHIFeatureLevel::Type FeatureLevel,
+	float HistogramMax,
+	TFunction<void(const FGraphicToolsImageStatistics&)>&& OnComputed
+)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork() || Target == nullptr)
+	{
+		return false;
+	}
+
+	FTextureRenderTargetResource* TextureRenderTargetResource = Target->GameThread_GetRenderTargetResource();
+	if (TextureRenderTargetResource == nullptr)
+	{
+		return false;
+	}
+
+	TUniquePtr<FPendingStatistics> Pending = MakeUnique<FPendingStatistics>();
+	Pending->HistogramMax = HistogramMax;
+	Pending->OnComputed = MoveTemp(OnComputed);
+
+	FGraphicToolsStatisticsReadbacks::Get().AddInFlight();
+
+	// ordered after the jobs drawing the target, so it reads what they drew
+	FGraphicToolsGPUJob Job;
+	Job.Name = TEXT("Statistics");
+	Job.Objects.Add(Target);
+	Job.Work = [TextureRenderTargetResource, FeatureLevel, Pending = MoveTemp(Pending)](FRHICommandListImmediate& RHICmdList) mutable
+	{
+		ComputeStatistics_RenderThread(RHICmdList, TextureRenderTargetResource, FeatureLevel, MoveTemp(Pending));
+	};
+	FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+
+	return true;
+}
+
+static FString FormatHistogram(const TArray<int32>& Histogram)
+{
+	FString Result;
+	for (const int32 Count : Histogram)
+	{
+		Result += FString::Printf(TEXT("%d "), Count);
+	}
+	return Result;
+}
+
+static void PrintStatistics(const TArray<FString>& Args)
+{
+	if (Args.Num() == 0)
+	{
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("Usage: GraphicTools.Statistics.Print <RenderTargetPath> [HistogramMax=1]"));
+		return;
+	}
+
+	UTextureRenderTarget2D* Target = LoadObject<UTextureRenderTarget2D>(nullptr, *Args[0]);
+	if (Target == nullptr)
+	{
+		UE_LOG(LogGraphicToolsStatistics, Warning, TEXT("No render target at %s"), *Args[0]);
+		return;
+	}
+
+	const float HistogramMax = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 1.0f;
+	const FString Name = Target->GetName();
+	const double RequestSeconds = FPlatformTime::Seconds();
+
+	FGraphicToolsImageStatisticsReduction::Request(Target, GMaxRHIFeatureLevel, HistogramMax, [Name, RequestSeconds](const FGraphicToolsImageStatistics& Statistics)
+	{
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("%s: %d pixels, %d bytes read back after %.1f ms"),
+			*Name, Statistics.NumPixels, FGraphicToolsImageStatisticsReduction::ResultBytes, (FPlatformTime::Seconds() - RequestSeconds) * 1000.0);
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("  Min  %s  luminance %.4f"), *Statistics.Min.ToString(), Statistics.MinLuminance);
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("  Max  %s  luminance %.4f"), *Statistics.Max.ToString(), Statistics.MaxLuminance);
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("  Mean %s  luminance %.4f"), *Statistics.Mean.ToString(), Statistics.MeanLuminance);
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("  Histograms over [0, %.2f]:"), Statistics.HistogramMax);
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("    R %s"), *FormatHistogram(Statistics.RedHistogram));
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("    G %s"), *FormatHistogram(Statistics.GreenHistogram));
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("    B %s"), *FormatHistogram(Statistics.BlueHistogram));
+		UE_LOG(LogGraphicToolsStatistics, Display, TEXT("    L %s"), *FormatHistogram(Statistics.LuminanceHistogram));
+	});
+}
+
+static FAutoConsoleCommand GPrintStatisticsCommand(
+	TEXT("GraphicTools.Statistics.Print"),
+	TEXT("Reduces a render target on the GPU and logs its min, max, mean and histograms: GraphicTools.Statistics.Print <RenderTargetPath> [HistogramMax=1]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&PrintStatistics)
+);
@@ -0,0 +1,292 @@
+#include "GraphicToolsRawCapture.h"
+
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsRawCapture, Log, All);
+
+// Slots start on page boundaries so a tool can map a single frame, the file header takes the first page.
+static const uint64 RawCapturePageBytes = 4096;
+
+EGraphicToolsRawPixelFormat GraphicToolsRawCapture::FromPixelFormat(EPixelFormat Format)
+{
+	switch (Format)
+	{
+	case PF_B8G8R8A8: return EGraphicToolsRawPixelFormat::B8G8R8A8;
+	case PF_R8G8B8A8: return EGraphicToolsRawPixelFormat::R8G8B8A8;
+	case PF_A2B10G10R10: return EGraphicToolsRawPixelFormat::A2B10G10R10;
+	case PF_FloatRGBA: return EGraphicToolsRawPixelFormat::FloatRGBA;
+	case PF_A32B32G32R32F: return EGraphicToolsRawPixelFormat::A32B32G32R32F;
+	case PF_R32_FLOAT: return EGraphicToolsRawPixelFormat::R32Float;
+	case PF_G8: return EGraphicToolsRawPixelFormat::G8;
+	default: return EGraphicToolsRawPixelFormat::Unknown;
+	}
+}
+
+EPixelFormat GraphicToolsRawCapture::ToPixelFormat(EGraphicToolsRawPixelFormat Format)
+{
+	switch (Format)
+	{
+	case EGraphicToolsRawPixelFormat::B8G8R8A8: return PF_B8G8R8A8;
+	case EGraphicToolsRawPixelFormat::R8G8B8A8: return PF_R8G8B8A8;
+	case EGraphicToolsRawPixelFormat::A2B10G10R10: return PF_A2B10G10R10;
+	case EGraphicToolsRawPixelFormat::FloatRGBA: return PF_FloatRGBA;
+	case EGraphicToolsRawPixelFormat::A32B32G32R32F: return PF_A32B32G32R32F;
+	case EGraphicToolsRawPixelFormat::R32Float: return PF_R32_FLOAT;
+	case EGraphicToolsRawPixelFormat::G8: return PF_G8;
+	default: return PF_Unknown;
+	}
+}
+
+uint32 GraphicToolsRawCapture::GetBytesPerPixel(EGraphicToolsRawPixelFormat Format)
+{
+	switch (Format)
+	{
+	case EGraphicToolsRawPixelFormat::B8G8R8A8:
+	case EGraphicToolsRawPixelFormat::R8G8B8A8:
+	case EGraphicToolsRawPixelFormat::A2B10G10R10:
+	case EGraphicToolsRawPixelFormat::R32Float:
+		return 4;
+	case EGraphicToolsRawPixelFormat::FloatRGBA:
+		return 8;
+	case EGraphicToolsRawPixelFormat::A32B32G32R32F:
+		return 16;
+	case EGraphicToolsRawPixelFormat::G8:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+FGraphicToolsRawCaptureWriter::FGraphicToolsRawCaptureWriter()
+{
+}
+
+FGraphicToolsRawCaptureWriter::~FGraphicToolsRawCaptureWriter()
+{
+	Close();
+}
+
+bool FGraphicToolsRawCaptureWriter::Open(const FString& Path, EGraphicToolsRawPixelFormat Format, uint32 Width, uint32 Height, uint64 FrameCapacity)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	File.Reset();
+
+	const uint32 BytesPerPixel = GraphicToolsRawCapture::GetBytesPerPixel(Format);
+	if (BytesPerPixel == 0 || Width == 0 || Height == 0 || FrameCapacity == 0)
+	{
+		UE_LOG(LogGraphicToolsRawCapture, Warning, TEXT("Can't create %s: %ux%u, %llu frames of format %u"), *Path, Width, Height, FrameCapacity, (uint32)Format);
+		return false;
+	}
+
+	Header = FGraphicToolsRawCaptureFileHeader();
+	Header.HeaderBytes = RawCapturePageBytes;
+	Header.FrameHeaderBytes = sizeof(FGraphicToolsRawCaptureFrameHeader);
+	Header.FrameCapacity = FrameCapacity;
+	Header.PixelFormat = Format;
+	Header.BytesPerPixel = BytesPerPixel;
+	Header.Width = Width;
+	Header.Height = Height;
+	Header.RowPitch = Width * BytesPerPixel;
+	Header.FrameStride = Align(Header.FrameHeaderBytes + (uint64)Header.RowPitch * Height, RawCapturePageBytes);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+	File.Reset(PlatformFile.OpenWrite(*Path, false, true));
+	if (!File.IsValid())
+	{
+		UE_LOG(LogGraphicToolsRawCapture, Warning, TEXT("Can't open %s for writing"), *Path);
+		return false;
+	}
+
+	// size the file up front, appending then never grows it
+	const uint64 FileBytes = Header.HeaderBytes + Header.FrameStride * FrameCapacity;
+	const uint8 Zero = 0;
+	bool bWritten = File->Seek(FileBytes - 1) && File->Write(&Zero, 1);
+	bWritten = bWritten && File->Seek(0) && File->Write(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	if (!bWritten)
+	{
+		UE_LOG(LogGraphicToolsRawCapture, Warning, TEXT("Can't reserve %.1f MB for %s"), FileBytes / (1024.0 * 1024.0), *Path);
+		File.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FGraphicToolsRawCaptureWriter::Close()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (File.IsValid())
+	{
+		File->Flush();
+		File.Reset();
+	}
+}
+
+bool FGraphicToolsRawCaptureWriter::AppendFrame(const uint8* Pixels, uint32 SourcePitch, uint64 FrameIndex, double CaptureSeconds)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!File.IsValid() || Header.NumFrames >= Header.FrameCapacity || SourcePitch < Header.RowPitch)
+	{
+		return false;
+	}
+
+	FGraphicToolsRawCaptureFrameHeader FrameHeader;
+	FrameHeader.PixelFormat = Header.PixelFormat;
+	FrameHeader.Width = Header.Width;
+	FrameHeader.Height = Header.Height;
+	FrameHeader.RowPitch = Header.RowPitch;
+	FrameHeader.FrameIndex = FrameIndex;
+	FrameHeader.PixelOffset = Header.FrameHeaderBytes;
+	FrameHeader.CaptureSeconds = CaptureSeconds;
+	FrameHeader.WriteSeconds = FPlatformTime::Seconds();
+
+	bool bWritten = File->Seek(Header.HeaderBytes + Header.NumFrames * Header.FrameStride)
+		&& File->Write(reinterpret_cast<const uint8*>(&FrameHeader), sizeof(FrameHeader));
+
+	if (SourcePitch == Header.RowPitch)
+	{
+		bWritten = bWritten && File->Write(Pixels, (int64)Header.RowPitch * Header.Height);
+	}
+	else
+	{
+		for (uint32 Row = 0; Row < Header.Height && bWritten; ++Row)
+		{
+			bWritten = File->Write(Pixels + (uint64)Row * SourcePitch, Header.RowPitch);
+		}
+	}
+
+	// the count goes last, a reader never sees a slot before its pixels
+	++Header.NumFrames;
+	bWritten = bWritten
+		&& File->Seek(STRUCT_OFFSET(FGraphicToolsRawCaptureFileHeader, NumFrames))
+		&& File->Write(reinterpret_cast<const uint8*>(&Header.NumFrames), sizeof(Header.NumFrames));
+
+	return bWritten;
+}
+
+uint64 FGraphicToolsRawCaptureWriter::GetNumFrames() const
+{
+	FScopeLock Lock(const_cast<FCriticalSection*>(&CriticalSection));
+	return Header.NumFrames;
+}
+
+FGraphicToolsRawCaptureReader::FGraphicToolsRawCaptureReader()
+{
+}
+
+FGraphicToolsRawCaptureReader::~FGraphicToolsRawCaptureReader()
+{
+	Close();
+}
+
+bool FGraphicToolsRawCaptureReader::Open(const FString& Path)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	MappedFile.Reset(PlatformFile.OpenMapped(*Path));
+	if (MappedFile.IsValid())
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+		if (MappedRegion.IsValid())
+		{
+			Data = MappedRegion->GetMappedPtr();
+			DataSize = MappedRegion->GetMappedSize();
+		}
+	}
+
+	if (Data == nullptr)
+	{
+		MappedRegion.Reset();
+		MappedFile.Reset();
+		if (!FFileHelper::LoadFileToArray(LoadedFile, *Path))
+		{
+			UE_LOG(LogGraphicToolsRawCapture, Warning, TEXT("Can't read %s"), *Path);
+			return false;
+		}
+		Data = LoadedFile.GetData();
+		DataSize = LoadedFile.Num();
+	}
+
+	auto Fail = [this, &Path](const TCHAR* Reason)
+	{
+		UE_LOG(LogGraphicToolsRawCapture, Warning, TEXT("%s isn't a readable raw capture: %s"), *Path, Reason);
+		Close();
+		return false;
+	};
+
+	if (DataSize < sizeof(Header))
+	{
+		return Fail(TEXT("too short"));
+	}
+
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+	if (Header.Magic != FGraphicToolsRawCaptureFileHeader::ExpectedMagic)
+	{
+		return Fail(TEXT("bad magic"));
+	}
+	if (Header.Version != FGraphicToolsRawCaptureFileHeader::CurrentVersion)
+	{
+		return Fail(TEXT("unknown version"));
+	}
+	if (Header.HeaderBytes < sizeof(FGraphicToolsRawCaptureFileHeader) || Header.FrameHeaderBytes < sizeof(FGraphicToolsRawCaptureFrameHeader))
+	{
+		return Fail(TEXT("headers too small"));
+	}
+	if (Header.BytesPerPixel == 0 || Header.BytesPerPixel != GraphicToolsRawCapture::GetBytesPerPixel(Header.PixelFormat))
+	{
+		return Fail(TEXT("unknown pixel format"));
+	}
+	if ((uint64)Header.RowPitch < (uint64)Header.Width * Header.BytesPerPixel || Header.FrameStride < Header.FrameHeaderBytes + (uint64)Header.RowPitch * Header.Height)
+	{
+		return Fail(TEXT("frames don't fit their slots"));
+	}
+	if (Header.NumFrames > Header.FrameCapacity || Header.HeaderBytes + Header.NumFrames * Header.FrameStride > DataSize)
+	{
+		return Fail(TEXT("truncated"));
+	}
+
+	for (uint64 Frame = 0; Frame < Header.NumFrames; ++Frame)
+	{
+		const FGraphicToolsRawCaptureFrameHeader* FrameHeader = GetFrameHeader(Frame);
+		if (FrameHeader->PixelOffset < Header.FrameHeaderBytes || FrameHeader->PixelOffset + (uint64)FrameHeader->RowPitch * FrameHeader->Height > Header.FrameStride)
+		{
+			return Fail(TEXT("frame pixels outside their slot"));
+		}
+	}
+
+	return true;
+}
+
+void FGraphicToolsRawCaptureReader::Close()
+{
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+	Data = nullptr;
+	DataSize = 0;
+	Header = FGraphicToolsRawCaptureFileHeader();
+}
+
+const FGraphicToolsRawCaptureFrameHeader* FGraphicToolsRawCaptureReader::GetFrameHeader(uint64 Frame) const
+{
+	if (Data == nullptr || Frame >= Header.NumFrames)
+	{
+		return nullptr;
+	}
+	return reinterpret_cast<const FGraphicToolsRawCaptureFrameHeader*>(Data + Header.HeaderBytes + Frame * Header.FrameStride);
+}
+
+const uint8* FGraphicToolsRawCaptureReader::GetFramePixels(uint64 Frame) const
+{
+	const FGraphicToolsRawCaptureFrameHeader* FrameHeader = GetFrameHeader(Frame);
+	return FrameHeader != nullptr ? reinterpret_cast<const uint8*>(FrameHeader) + FrameHeader->PixelOffset : nullptr;
+}
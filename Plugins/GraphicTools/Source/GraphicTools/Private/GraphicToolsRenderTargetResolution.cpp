@@ -0,0 +1,351 @@
+#include "GraphicToolsRenderTargetResolution.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Tickable.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsRenderTargets, Log, All);
+
+static TAutoConsoleVariable<int32> CVarGraphicToolsRenderTargetsBudgetMB(
+	TEXT("GraphicTools.RenderTargets.BudgetMB"),
+	256,
+	TEXT("Megabytes the render targets sized by their screen coverage may take together, the largest are halved past it"),
+	ECVF_Default);
+
+// A surface not rendered for longer than this counts as off screen
+static const float RecentlyRenderedSeconds = 0.25f;
+
+// A target shrinks only to a size the surfaces fill no more than this much of
+static const float ShrinkFill = 0.75f;
+
+/** Game thread only */
+struct FManagedRenderTarget
+{
+	TWeakObjectPtr<UTextureRenderTarget2D> Target;
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> Surfaces;
+	FGraphicToolsScreenSizeSettings Settings;
+	TFunction<void(UTextureRenderTarget2D*)> OnResized;
+
+	/** The size it was registered at, level 0 */
+	FIntPoint FullSize = FIntPoint::ZeroValue;
+	int32 Level = 0;
+
+	/** Seconds a smaller level has fitted for */
+	float ShrinkSeconds = 0.0f;
+
+	/** Longest edge in texels the surfaces asked for last tick, INDEX_NONE without a view */
+	int32 NeededSize = INDEX_NONE;
+};
+
+/** Where the first local player looks from, for projecting bounds to pixels */
+struct FScreenSizeView
+{
+	FVector Location = FVector::ZeroVector;
+	float TanHalfFOV = 1.0f;
+	float ViewportWidth = 0.0f;
+};
+
+static FIntPoint GetLevelSize(FIntPoint FullSize, int32 Level)
+{
+	return FIntPoint(FMath::Max(FullSize.X >> Level, 1), FMath::Max(FullSize.Y >> Level, 1));
+}
+
+// The highest level whose longest edge still covers NeededSize, never below MinSize
+static int32 GetLevelFor(FIntPoint FullSize, float NeededSize, int32 MinSize)
+{
+	const int32 LongestEdge = FMath::Max(FullSize.X, FullSize.Y);
+	const float Needed = FMath::Max(NeededSize, (float)MinSize);
+
+	int32 Level = 0;
+	while ((LongestEdge >> (Level + 1)) >= Needed && (LongestEdge >> (Level + 1)) > 0)
+	{
+		++Level;
+	}
+	return Level;
+}
+
+static int64 GetTargetBytes(const UTextureRenderTarget2D* Target, FIntPoint Size)
+{
+	const int64 Bytes = (int64)Size.X * Size.Y * GPixelFormats[Target->GetFormat()].BlockBytes;
+	return Target->bAutoGenerateMips ? Bytes * 4 / 3 : Bytes;
+}
+
+static bool GetScreenSizeView(UWorld* World, FScreenSizeView& OutView)
+{
+	APlayerController* PlayerController = GEngine != nullptr ? GEngine->GetFirstLocalPlayerController(World) : nullptr;
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+	{
+		return false;
+	}
+
+	ULocalPlayer* LocalPlayer = PlayerController->GetLocalPlayer();
+	if (LocalPlayer == nullptr || LocalPlayer->ViewportClient == nullptr)
+	{
+		return false;
+	}
+
+	FVector2D ViewportSize;
+	LocalPlayer->ViewportClient->GetViewportSize(ViewportSize);
+
+	OutView.Location = PlayerController->PlayerCameraManager->GetCameraLocation();
+	OutView.TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(PlayerController->PlayerCameraManager->GetFOVAngle(), 1.0f, 170.0f) * 0.5f));
+	OutView.ViewportWidth = ViewportSize.X * LocalPlayer->Size.X;
+	return OutView.ViewportWidth > 0.0f;
+}
+
+class FGraphicToolsRenderTargetManager : public FTickableGameObject
+{
+public:
+	static FGraphicToolsRenderTargetManager& Get()
+	{
+		static FGraphicToolsRenderTargetManager Instance;
+		return Instance;
+	}
+
+	void Manage(UTextureRenderTarget2D* Target, UPrimitiveComponent* Surface, const FGraphicToolsScreenSizeSettings& Settings, TFunction<void(UTextureRenderTarget2D*)>&& OnResized)
+	{
+		FManagedRenderTarget* Managed = Find(Target);
+		if (Managed == nullptr)
+		{
+			Managed = &Entries.AddDefaulted_GetRef();
+			Managed->Target = Target;
+			Managed->FullSize = FIntPoint(Target->SizeX, Target->SizeY);
+		}
+
+		Managed->Surfaces.AddUnique(Surface);
+		Managed->Settings = Settings;
+		Managed->Settings.MinSize = FMath::Max(Settings.MinSize, 1);
+		Managed->OnResized = MoveTemp(OnResized);
+	}
+
+	void StopManaging(UTextureRenderTarget2D* Target)
+	{
+		Entries.RemoveAll([Target](const FManagedRenderTarget& Managed) { return Managed.Target.Get() == Target; });
+	}
+
+	int64 GetManagedBytes() const
+	{
+		int64 Bytes = 0;
+		for (const FManagedRenderTarget& Managed : Entries)
+		{
+			if (const UTextureRenderTarget2D* Target = Managed.Target.Get())
+			{
+				Bytes += GetTargetBytes(Target, FIntPoint(Target->SizeX, Target->SizeY));
+			}
+		}
+		return Bytes;
+	}
+
+	void LogStats() const
+	{
+		UE_LOG(LogGraphicToolsRenderTargets, Display, TEXT("%d render targets sized by screen coverage, %.1f of %d MB"),
+			Entries.Num(), GetManagedBytes() / (1024.0f * 1024.0f), CVarGraphicToolsRenderTargetsBudgetMB.GetValueOnGameThread());
+		for (const FManagedRenderTarget& Managed : Entries)
+		{
+			if (const UTextureRenderTarget2D* Target = Managed.Target.Get())
+			{
+				UE_LOG(LogGraphicToolsRenderTargets, Display, TEXT("  %-24s %5dx%-5d of %5dx%-5d needs %5d %8.2f MB"),
+					*Target->GetName(), Target->SizeX, Target->SizeY, Managed.FullSize.X, Managed.FullSize.Y, Managed.NeededSize,
+					GetTargetBytes(Target, FIntPoint(Target->SizeX, Target->SizeY)) / (1024.0f * 1024.0f));
+			}
+		}
+	}
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override
+	{
+		Entries.RemoveAll([](FManagedRenderTarget& Managed)
+		{
+			Managed.Surfaces.RemoveAll([](const TWeakObjectPtr<UPrimitiveComponent>& Surface) { return !Surface.IsValid(); });
+			return !Managed.Target.IsValid() || Managed.Surfaces.Num() == 0;
+		});
+
+		TMap<UWorld*, TOptional<FScreenSizeView>> Views;
+		TArray<int32> NewLevels;
+		NewLevels.Reserve(Entries.Num());
+
+		for (FManagedRenderTarget& Managed : Entries)
+		{
+			NewLevels.Add(GetLevelWithHysteresis(Managed, DeltaTime, Views));
+		}
+
+		// over budget the largest targets are halved first, whatever their surfaces asked for
+		const int64 BudgetBytes = (int64)FMath::Max(CVarGraphicToolsRenderTargetsBudgetMB.GetValueOnGameThread(), 0) * 1024 * 1024;
+		int64 TotalBytes = 0;
+		for (int32 Index = 0; Index < Entries.Num(); ++Index)
+		{
+			TotalBytes += GetTargetBytes(Entries[Index].Target.Get(), GetLevelSize(Entries[Index].FullSize, NewLevels[Index]));
+		}
+
+		while (TotalBytes > BudgetBytes)
+		{
+			int32 Largest = INDEX_NONE;
+			int64 LargestBytes = 0;
+			for (int32 Index = 0; Index < Entries.Num(); ++Index)
+			{
+				const FIntPoint Size = GetLevelSize(Entries[Index].FullSize, NewLevels[Index]);
+				const int64 Bytes = GetTargetBytes(Entries[Index].Target.Get(), Size);
+				if (FMath::Max(Size.X, Size.Y) / 2 >= Entries[Index].Settings.MinSize && Bytes > LargestBytes)
+				{
+					Largest = Index;
+					LargestBytes = Bytes;
+				}
+			}
+
+			if (Largest == INDEX_NONE)
+			{
+				break;
+			}
+
+			++NewLevels[Largest];
+			TotalBytes += GetTargetBytes(Entries[Largest].Target.Get(), GetLevelSize(Entries[Largest].FullSize, NewLevels[Largest])) - LargestBytes;
+		}
+
+		// shrinks before growths, so the memory in use never goes over what the budget pass settled on.
+		// The callbacks may manage other targets, they run once the entries are no longer walked
+		TArray<TPair<UTextureRenderTarget2D*, TFunction<void(UTextureRenderTarget2D*)>>> Resized;
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			for (int32 Index = 0; Index < Entries.Num(); ++Index)
+			{
+				FManagedRenderTarget& Managed = Entries[Index];
+				const bool bShrinks = NewLevels[Index] > Managed.Level;
+				if (NewLevels[Index] == Managed.Level || bShrinks != (Pass == 0))
+				{
+					continue;
+				}
+
+				Managed.Level = NewLevels[Index];
+				Managed.ShrinkSeconds = 0.0f;
+
+				const FIntPoint Size = GetLevelSize(Managed.FullSize, Managed.Level);
+				UTextureRenderTarget2D* Target = Managed.Target.Get();
+				Target->ResizeTarget(Size.X, Size.Y);
+				Resized.Add(MakeTuple(Target, Managed.OnResized));
+			}
+		}
+
+		for (TPair<UTextureRenderTarget2D*, TFunction<void(UTextureRenderTarget2D*)>>& Target : Resized)
+		{
+			if (Target.Value)
+			{
+				Target.Value(Target.Key);
+			}
+		}
+	}
+
+	virtual bool IsTickable() const override { return Entries.Num() > 0; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FGraphicToolsRenderTargetManager, STATGROUP_Tickables); }
+	// End of FTickableGameObject interface
+
+private:
+	FGraphicToolsRenderTargetManager()
+	{
+	}
+
+	FManagedRenderTarget* Find(const UTextureRenderTarget2D* Target)
+	{
+		return Entries.FindByPredicate([Target](const FManagedRenderTarget& Managed) { return Managed.Target.Get() == Target; });
+	}
+
+	/** The level the surfaces ask for, the current one while there is no view to measure them from */
+	int32 GetLevelWithHysteresis(FManagedRenderTarget& Managed, float DeltaTime, TMap<UWorld*, TOptional<FScreenSizeView>>& Views)
+	{
+		UWorld* World = Managed.Surfaces[0]->GetWorld();
+		TOptional<FScreenSizeView>* View = Views.Find(World);
+		if (View == nullptr)
+		{
+			FScreenSizeView NewView;
+			View = &Views.Add(World, GetScreenSizeView(World, NewView) ? TOptional<FScreenSizeView>(NewView) : TOptional<FScreenSizeView>());
+		}
+
+		if (!View->IsSet())
+		{
+			Managed.NeededSize = INDEX_NONE;
+			Managed.ShrinkSeconds = 0.0f;
+			return Managed.Level;
+		}
+
+		// the diameter of the largest bounds sphere in pixels, surfaces off screen need nothing
+		float NeededPixels = 0.0f;
+		for (const TWeakObjectPtr<UPrimitiveComponent>& Surface : Managed.Surfaces)
+		{
+			if (!Surface->WasRecentlyRendered(RecentlyRenderedSeconds))
+			{
+				continue;
+			}
+
+			const FBoxSphereBounds& Bounds = Surface->Bounds;
+			const float Distance = FMath::Max(FVector::Dist(Bounds.Origin, View->GetValue().Location), Bounds.SphereRadius);
+			const float Pixels = View->GetValue().ViewportWidth * Bounds.SphereRadius / (FMath::Max(Distance, 1.0f) * View->GetValue().TanHalfFOV);
+			NeededPixels = FMath::Max(NeededPixels, Pixels);
+		}
+
+		const float NeededSize = NeededPixels * FMath::Max(Managed.Settings.TexelsPerPixel, 0.0f);
+		Managed.NeededSize = FMath::CeilToInt(NeededSize);
+
+		const int32 GrowLevel = GetLevelFor(Managed.FullSize, NeededSize, Managed.Settings.MinSize);
+		if (GrowLevel < Managed.Level)
+		{
+			return GrowLevel;
+		}
+
+		const int32 ShrinkLevel = GetLevelFor(Managed.FullSize, NeededSize / ShrinkFill, Managed.Settings.MinSize);
+		if (ShrinkLevel <= Managed.Level)
+		{
+			Managed.ShrinkSeconds = 0.0f;
+			return Managed.Level;
+		}
+
+		Managed.ShrinkSeconds += DeltaTime;
+		return Managed.ShrinkSeconds >= Managed.Settings.ShrinkDelay ? ShrinkLevel : Managed.Level;
+	}
+
+	TArray<FManagedRenderTarget> Entries;
+};
+
+void FGraphicToolsRenderTargetResolution::Manage(UTextureRenderTarget2D* Target, UPrimitiveComponent* Surface, const FGraphicToolsScreenSizeSettings& Settings, TFunction<void(UTextureRenderTarget2D*)>&& OnResized)
+{
+	check(IsInGameThread());
+
+	if (Target == nullptr || Surface == nullptr)
+	{
+		return;
+	}
+
+	FGraphicToolsRenderTargetManager::Get().Manage(Target, Surface, Settings, MoveTemp(OnResized));
+}
+
+void FGraphicToolsRenderTargetResolution::StopManaging(UTextureRenderTarget2D* Target)
+{
+	check(IsInGameThread());
+
+	FGraphicToolsRenderTargetManager::Get().StopManaging(Target);
+}
+
+int64 FGraphicToolsRenderTargetResolution::GetManagedBytes()
+{
+	check(IsInGameThread());
+
+	return FGraphicToolsRenderTargetManager::Get().GetManagedBytes();
+}
+
+static void LogRenderTargetStats(const TArray<FString>& Args)
+{
+	FGraphicToolsRenderTargetManager::Get().LogStats();
+}
+
+static FAutoConsoleCommand GRenderTargetStatsCommand(
+	TEXT("GraphicTools.RenderTargets.Stats"),
+	TEXT("Logs the render targets sized by screen coverage, their sizes, what their surfaces need and the memory they take: GraphicTools.RenderTargets.Stats"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&LogRenderTargetStats)
+);
@@ -0,0 +1,530 @@
+#include "GraphicToolsTextureGraph.h"
+#include "GraphicToolsTextureGraphPrivate.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+#include "GraphicToolsGPUScheduler.h"
+
+#include "Engine/TextureRenderTarget2D.h"
+#include "GlobalShader.h"
+#include "RenderTargetPool.h"
+#include "ShaderParameterUtils.h"
+#include "ShaderPermutation.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsTextureGraph, Log, All);
+
+/** One fused pass, the permutation holds the source and the op of every stage */
+class FTextureGraphCS : public FGlobalShader
+{
+	DECLARE_SHADER_TYPE(FTextureGraphCS, Global);
+public:
+
+	class FGeneratorSourceDim : SHADER_PERMUTATION_BOOL("GENERATOR_SOURCE");
+	class FStage0Dim : SHADER_PERMUTATION_INT("STAGE0_OP", (int32)ETextureGraphStageOp::Num);
+	class FStage1Dim : SHADER_PERMUTATION_INT("STAGE1_OP", (int32)ETextureGraphStageOp::Num);
+	class FStage2Dim : SHADER_PERMUTATION_INT("STAGE2_OP", (int32)ETextureGraphStageOp::Num);
+	using FPermutationDomain = TShaderPermutationDomain<FGeneratorSourceDim, FStage0Dim, FStage1Dim, FStage2Dim>;
+
+	FTextureGraphCS()
+	{
+	}
+
+	FTextureGraphCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGlobalShader(Initializer)
+	{
+		SourceTexture.Bind(Initializer.ParameterMap, TEXT("SourceTexture"));
+		for (int32 Index = 0; Index < FGraphicToolsTextureGraph::MaxFusedStages; ++Index)
+		{
+			StageTextures[Index].Bind(Initializer.ParameterMap, *FString::Printf(TEXT("StageTexture%d"), Index));
+		}
+		GraphSampler.Bind(Initializer.ParameterMap, TEXT("GraphSampler"));
+		StageParameters.Bind(Initializer.ParameterMap, TEXT("StageParameters"));
+		GeneratorTime.Bind(Initializer.ParameterMap, TEXT("GeneratorTime"));
+		Output.Bind(Initializer.ParameterMap, TEXT("RWOutput"));
+		OutputSize.Bind(Initializer.ParameterMap, TEXT("OutputSize"));
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		// the compiler fills stages front to back, a stage after an empty one never exists
+		const FPermutationDomain PermutationVector(Parameters.PermutationId);
+		const bool bStage1Reachable = PermutationVector.Get<FStage0Dim>() != 0 || PermutationVector.Get<FStage1Dim>() == 0;
+		const bool bStage2Reachable = PermutationVector.Get<FStage1Dim>() != 0 || PermutationVector.Get<FStage2Dim>() == 0;
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5) && bStage1Reachable && bStage2Reachable;
+	}
+
+	static FPermutationDomain GetPermutation(const FTextureGraphPass& Pass)
+	{
+		FPermutationDomain PermutationVector;
+		PermutationVector.Set<FGeneratorSourceDim>(Pass.bGeneratorSource);
+		PermutationVector.Set<FStage0Dim>((int32)Pass.StageOps[0]);
+		PermutationVector.Set<FStage1Dim>((int32)Pass.StageOps[1]);
+		PermutationVector.Set<FStage2Dim>((int32)Pass.StageOps[2]);
+		return PermutationVector;
+	}
+
+	void SetParameters(FRHICommandList& RHICmdList, const FTextureGraphPass& Pass, FRHITexture* Source, FRHITexture* const* Stages)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		FRHISamplerState* Sampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+
+		// parameters the permutation compiled out aren't bound and these are no-ops
+		SetTextureParameter(RHICmdList, ShaderRHI, SourceTexture, Source);
+		for (int32 Index = 0; Index < FGraphicToolsTextureGraph::MaxFusedStages; ++Index)
+		{
+			SetTextureParameter(RHICmdList, ShaderRHI, StageTextures[Index], Stages[Index]);
+		}
+		SetSamplerParameter(RHICmdList, ShaderRHI, GraphSampler, Sampler);
+		SetShaderValueArray(RHICmdList, ShaderRHI, StageParameters, Pass.StageParameters, FGraphicToolsTextureGraph::MaxFusedStages);
+		SetShaderValue(RHICmdList, ShaderRHI, GeneratorTime, Pass.GeneratorTime);
+	}
+
+	void SetOutput(FRHICommandList& RHICmdList, FRHIUnorderedAccessView* UAV, FIntPoint Size)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetUAVParameter(RHICmdList, ShaderRHI, Output, UAV);
+		SetShaderValue(RHICmdList, ShaderRHI, OutputSize, Size);
+	}
+
+	void UnsetOutput(FRHICommandList& RHICmdList)
+	{
+		SetUAVParameter(RHICmdList, RHICmdList.GetBoundComputeShader(), Output, nullptr);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, SourceTexture);
+	LAYOUT_ARRAY(FShaderResourceParameter, StageTextures, FGraphicToolsTextureGraph::MaxFusedStages);
+	LAYOUT_FIELD(FShaderResourceParameter, GraphSampler);
+	LAYOUT_FIELD(FShaderParameter, StageParameters);
+	LAYOUT_FIELD(FShaderParameter, GeneratorTime);
+	LAYOUT_FIELD(FShaderResourceParameter, Output);
+	LAYOUT_FIELD(FShaderParameter, OutputSize);
+};
+
+IMPLEMENT_SHADER_TYPE(, FTextureGraphCS, TEXT("/Plugin/GraphicTools/Private/TextureGraph.usf"), TEXT("FusedCS"), SF_Compute);
+
+/** Turns the nodes below a root into passes, depth first so every pass comes after the passes it reads */
+class FTextureGraphCompiler
+{
+public:
+	FTextureGraphCompiler(const TArray<FGraphicToolsTextureGraph::FNode>& InNodes, bool bInFuse, FGraphicToolsTextureGraphPlan& InPlan)
+		: Nodes(InNodes)
+		, bFuse(bInFuse)
+		, Plan(InPlan)
+	{
+	}
+
+	bool Compile(FGraphicToolsTextureGraph::FNodeId Root)
+	{
+		CountUses(Root);
+		Plan.Result = Materialize(Root);
+
+		// the result is copied to the output after the last pass
+		if (!Plan.Result.bExternal)
+		{
+			Plan.IntermediateLastUse[Plan.Result.Index] = Plan.Passes.Num();
+		}
+		return bValid;
+	}
+
+private:
+	typedef FGraphicToolsTextureGraph::FNode FNode;
+	typedef FGraphicToolsTextureGraph::FNodeId FNodeId;
+
+	void CountUses(FNodeId Id)
+	{
+		int32& Uses = UseCounts.FindOrAdd(Id);
+		if (++Uses > 1)
+		{
+			return;
+		}
+
+		for (const FNodeId Input : Nodes[Id].Inputs)
+		{
+			if (Input != INDEX_NONE)
+			{
+				CountUses(Input);
+			}
+		}
+	}
+
+	// A node read by more than one other node is computed once into a texture rather than fused into each reader
+	bool CanFuse(FNodeId Id) const
+	{
+		return bFuse && UseCounts.FindRef(Id) <= 1;
+	}
+
+	FTextureGraphSlot Materialize(FNodeId Id)
+	{
+		if (const FTextureGraphSlot* Found = Materialized.Find(Id))
+		{
+			return *Found;
+		}
+
+		const FNode& Node = Nodes[Id];
+		FTextureGraphSlot Slot;
+
+		switch (Node.Type)
+		{
+		case FNode::EType::Texture:
+			Slot = AddExternal(Node.Texture);
+			break;
+		case FNode::EType::Blur:
+		{
+			FTextureGraphPass Pass;
+			Pass.Type = FTextureGraphPass::EType::Blur;
+			Pass.Input = Materialize(Node.Inputs[0]);
+			if (Pass.Input.bExternal)
+			{
+				// the blur wants its input at the output size, a texture may be any size
+				Pass.Input = Emit(SourcePass(Pass.Input));
+			}
+			Pass.BlurRadius = Node.BlurRadius;
+			Pass.BlurKernel = Node.BlurKernel;
+			Slot = Emit(MoveTemp(Pass));
+			break;
+		}
+		default:
+			Slot = Emit(BuildChain(Id));
+			break;
+		}
+
+		Materialized.Add(Id, Slot);
+		return Slot;
+	}
+
+	// The pass ending in node Id, pulling in as many of the per-pixel nodes above it as fit
+	FTextureGraphPass BuildChain(FNodeId Id)
+	{
+		const FNode& Node = Nodes[Id];
+
+		if (Node.Type == FNode::EType::Generator)
+		{
+			FTextureGraphPass Pass;
+			Pass.bGeneratorSource = true;
+			Pass.GeneratorTime = Node.Scalar;
+			return Pass;
+		}
+
+		const FNodeId Input = Node.Inputs[0];
+		const FNode::EType InputType = Nodes[Input].Type;
+		const bool bInputFusable = InputType == FNode::EType::Generator || InputType == FNode::EType::Multiply || InputType == FNode::EType::Blend;
+
+		FTextureGraphPass Pass = bInputFusable && CanFuse(Input) && !Materialized.Contains(Input) ? BuildChain(Input) : SourcePass(Materialize(Input));
+		if (Pass.NumStages == FGraphicToolsTextureGraph::MaxFusedStages)
+		{
+			Pass = SourcePass(Emit(MoveTemp(Pass)));
+		}
+
+		const int32 Stage = Pass.NumStages++;
+		if (Node.Type == FNode::EType::Multiply)
+		{
+			Pass.StageOps[Stage] = ETextureGraphStageOp::Multiply;
+			Pass.StageParameters[Stage] = FVector4(Node.Color.R, Node.Color.G, Node.Color.B, Node.Color.A);
+		}
+		else
+		{
+			Pass.StageOps[Stage] = ETextureGraphStageOp::Blend;
+			Pass.StageParameters[Stage] = FVector4(Node.Scalar, 0.0f, 0.0f, 0.0f);
+			Pass.StageTextures[Stage] = Materialize(Node.Inputs[1]);
+		}
+		return Pass;
+	}
+
+	static FTextureGraphPass SourcePass(const FTextureGraphSlot& Source)
+	{
+		FTextureGraphPass Pass;
+		Pass.Input = Source;
+		return Pass;
+	}
+
+	FTextureGraphSlot AddExternal(UTextureRenderTarget2D* Texture)
+	{
+		FTextureRenderTargetResource* Resource = Texture != nullptr ? Texture->GameThread_GetRenderTargetResource() : nullptr;
+		if (Resource == nullptr)
+		{
+			UE_LOG(LogGraphicToolsTextureGraph, Warning, TEXT("Texture node %s has no resource"), *GetNameSafe(Texture));
+			bValid = false;
+		}
+
+		FTextureGraphSlot Slot;
+		Slot.bExternal = true;
+		Slot.Index = Plan.ExternalResources.AddUnique(Resource);
+		Plan.ExternalObjects.AddUnique(Texture);
+		return Slot;
+	}
+
+	FTextureGraphSlot Emit(FTextureGraphPass&& Pass)
+	{
+		const int32 PassIndex = Plan.Passes.Num();
+
+		auto MarkRead = [this, PassIndex](const FTextureGraphSlot& Slot)
+		{
+			if (Slot.Index != INDEX_NONE && !Slot.bExternal)
+			{
+				Plan.IntermediateLastUse[Slot.Index] = PassIndex;
+			}
+		};
+
+		MarkRead(Pass.Input);
+		for (int32 Stage = 0; Stage < Pass.NumStages; ++Stage)
+		{
+			MarkRead(Pass.StageTextures[Stage]);
+		}
+
+		Pass.Output.bExternal = false;
+		Pass.Output.Index = Plan.IntermediateLastUse.Add(PassIndex);
+
+		const FTextureGraphSlot Output = Pass.Output;
+		Plan.Passes.Add(MoveTemp(Pass));
+		return Output;
+	}
+
+	const TArray<FNode>& Nodes;
+	const bool bFuse;
+	FGraphicToolsTextureGraphPlan& Plan;
+
+	TMap<FNodeId, int32> UseCounts;
+	TMap<FNodeId, FTextureGraphSlot> Materialized;
+	bool bValid = true;
+};
+
+static void ExecuteFusedPass_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	FGlobalShaderMap* ShaderMap,
+	const FTextureGraphPass& Pass,
+	TFunctionRef<FRHITexture2D*(const FTextureGraphSlot&)> Resolve,
+	const FSceneRenderTargetItem& OutputItem
+)
+{
+	FRHITexture* Source = Pass.bGeneratorSource ? nullptr : Resolve(Pass.Input);
+	FRHITexture* Stages[FGraphicToolsTextureGraph::MaxFusedStages] = {};
+	for (int32 Stage = 0; Stage < Pass.NumStages; ++Stage)
+	{
+		if (Pass.StageOps[Stage] == ETextureGraphStageOp::Blend)
+		{
+			Stages[Stage] = Resolve(Pass.StageTextures[Stage]);
+		}
+	}
+
+	if (Source != nullptr)
+	{
+		RHICmdList.Transition(FRHITransitionInfo(Source, ERHIAccess::Unknown, ERHIAccess::SRVCompute));
+	}
+	for (FRHITexture* Stage : Stages)
+	{
+		if (Stage != nullptr)
+		{
+			RHICmdList.Transition(FRHITransitionInfo(Stage, ERHIAccess::Unknown, ERHIAccess::SRVCompute));
+		}
+	}
+
+	const FIntPoint Size = OutputItem.ShaderResourceTexture->GetTexture2D()->GetSizeXY();
+
+	TShaderMapRef<FTextureGraphCS> ComputeShader(ShaderMap, FTextureGraphCS::GetPermutation(Pass));
+	RHICmdList.Transition(FRHITransitionInfo(OutputItem.UAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+	RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
+	ComputeShader->SetParameters(RHICmdList, Pass, Source, Stages);
+	ComputeShader->SetOutput(RHICmdList, OutputItem.UAV, Size);
+	DispatchComputeShader(RHICmdList, ComputeShader, FMath::DivideAndRoundUp(Size.X, 8), FMath::DivideAndRoundUp(Size.Y, 8), 1);
+	ComputeShader->UnsetOutput(RHICmdList);
+}
+
+void ExecuteTextureGraphPlan_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FGraphicToolsTextureGraphPlan& Plan,
+	TArrayView<FRHITexture2D* const> ExternalTextures,
+	FRHITexture2D* Output
+)
+{
+	check(IsInRenderingThread());
+
+	if (Output == nullptr || ExternalTextures.Num() != Plan.ExternalResources.Num() || ExternalTextures.Contains(nullptr))
+	{
+		return;
+	}
+
+	FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(FeatureLevel);
+	const FIntPoint Size = Output->GetSizeXY();
+
+	TArray<TRefCountPtr<IPooledRenderTarget>, TInlineAllocator<8>> Intermediates;
+	Intermediates.SetNum(Plan.IntermediateLastUse.Num());
+
+	auto Resolve = [&Intermediates, ExternalTextures](const FTextureGraphSlot& Slot) -> FRHITexture2D*
+	{
+		return Slot.bExternal ? ExternalTextures[Slot.Index] : Intermediates[Slot.Index]->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+	};
+
+	for (int32 PassIndex = 0; PassIndex < Plan.Passes.Num(); ++PassIndex)
+	{
+		const FTextureGraphPass& Pass = Plan.Passes[PassIndex];
+
+		TRefCountPtr<IPooledRenderTarget>& Written = Intermediates[Pass.Output.Index];
+		Written = AllocateImageIntermediate(RHICmdList, Size, Output->GetFormat(), 1, TEXT("GraphicTools.TextureGraph"));
+
+		if (Pass.Type == FTextureGraphPass::EType::Blur)
+		{
+			FGraphicToolsImageOperation Operation;
+			Operation.Type = FGraphicToolsImageOperation::EType::Blur;
+			Operation.BlurKernel = Pass.BlurKernel;
+			Operation.BlurRadius = Pass.BlurRadius;
+			ExecuteImageOperation_RenderThread(RHICmdList, FeatureLevel, Operation, Resolve(Pass.Input), Resolve(Pass.Output));
+		}
+		else
+		{
+			ExecuteFusedPass_RenderThread(RHICmdList, ShaderMap, Pass, Resolve, Written->GetRenderTargetItem());
+		}
+
+		for (int32 Index = 0; Index < Intermediates.Num(); ++Index)
+		{
+			if (Plan.IntermediateLastUse[Index] == PassIndex)
+			{
+				Intermediates[Index].SafeRelease();
+			}
+		}
+	}
+
+	FRHITexture2D* Result = Resolve(Plan.Result);
+	if (Result != Output && (Result->GetSizeXY() != Size || Result->GetFormat() != Output->GetFormat()))
+	{
+		// a graph that is just a texture node has no pass to bring it to the output's size and format
+		FGraphicToolsImageOperation Operation;
+		Operation.Type = FGraphicToolsImageOperation::EType::Resize;
+		Operation.ResizeFilter = EGraphicToolsResizeFilter::Bilinear;
+		ExecuteImageOperation_RenderThread(RHICmdList, FeatureLevel, Operation, Result, Output);
+	}
+	else if (Result != Output)
+	{
+		RHICmdList.Transition({
+			FRHITransitionInfo(Result, ERHIAccess::Unknown, ERHIAccess::CopySrc),
+			FRHITransitionInfo(Output, ERHIAccess::Unknown, ERHIAccess::CopyDest)
+		});
+		RHICmdList.CopyTexture(Result, Output, FRHICopyTextureInfo());
+		RHICmdList.Transition(FRHITransitionInfo(Output, ERHIAccess::CopyDest, ERHIAccess::SRVMask));
+	}
+}
+
+FGraphicToolsTextureGraph::FNodeId FGraphicToolsTextureGraph::AddNode(const FNode& Node, const TCHAR* What)
+{
+	for (const FNodeId Input : Node.Inputs)
+	{
+		if (Input != INDEX_NONE && !Nodes.IsValidIndex(Input))
+		{
+			UE_LOG(LogGraphicToolsTextureGraph, Warning, TEXT("%s: input %d isn't a node of this graph"), What, Input);
+			return INDEX_NONE;
+		}
+	}
+	return Nodes.Add(Node);
+}
+
+FGraphicToolsTextureGraph::FNodeId FGraphicToolsTextureGraph::AddTexture(UTextureRenderTarget2D* Texture)
+{
+	if (Texture == nullptr)
+	{
+		UE_LOG(LogGraphicToolsTextureGraph, Warning, TEXT("AddTexture: no texture"));
+		return INDEX_NONE;
+	}
+
+	FNode Node;
+	Node.Type = FNode::EType::Texture;
+	Node.Texture = Texture;
+	return AddNode(Node, TEXT("AddTexture"));
+}
+
+FGraphicToolsTextureGraph::FNodeId FGraphicToolsTextureGraph::AddGenerator(float Time)
+{
+	FNode Node;
+	Node.Type = FNode::EType::Generator;
+	Node.Scalar = Time;
+	return AddNode(Node, TEXT("AddGenerator"));
+}
+
+FGraphicToolsTextureGraph::FNodeId FGraphicToolsTextureGraph::AddMultiply(FNodeId Input, const FLinearColor& Color)
+{
+	FNode Node;
+	Node.Type = FNode::EType::Multiply;
+	Node.Inputs[0] = Input;
+	Node.Color = Color;
+	return Input == INDEX_NONE ? INDEX_NONE : AddNode(Node, TEXT("AddMultiply"));
+}
+
+FGraphicToolsTextureGraph::FNodeId FGraphicToolsTextureGraph::AddBlend(FNodeId Base, FNodeId Layer, float Alpha)
+{
+	FNode Node;
+	Node.Type = FNode::EType::Blend;
+	Node.Inputs[0] = Base;
+	Node.Inputs[1] = Layer;
+	Node.Scalar = Alpha;
+	return Base == INDEX_NONE || Layer == INDEX_NONE ? INDEX_NONE : AddNode(Node, TEXT("AddBlend"));
+}
+
+FGraphicToolsTextureGraph::FNodeId FGraphicToolsTextureGraph::AddBlur(FNodeId Input, int32 Radius, EGraphicToolsBlurKernel Kernel)
+{
+	if (Radius < 1 || Radius > FGraphicToolsImageBatch::MaxBlurRadius)
+	{
+		UE_LOG(LogGraphicToolsTextureGraph, Warning, TEXT("AddBlur: radius %d clamped to [1, %d]"), Radius, FGraphicToolsImageBatch::MaxBlurRadius);
+	}
+
+	FNode Node;
+	Node.Type = FNode::EType::Blur;
+	Node.Inputs[0] = Input;
+	Node.BlurRadius = FMath::Clamp(Radius, 1, FGraphicToolsImageBatch::MaxBlurRadius);
+	Node.BlurKernel = Kernel;
+	return Input == INDEX_NONE ? INDEX_NONE : AddNode(Node, TEXT("AddBlur"));
+}
+
+bool FGraphicToolsTextureGraph::Compile(FNodeId Root, bool bFuse, FGraphicToolsTextureGraphPlan& OutPlan) const
+{
+	check(IsInGameThread());
+
+	OutPlan = FGraphicToolsTextureGraphPlan();
+	if (!Nodes.IsValidIndex(Root))
+	{
+		UE_LOG(LogGraphicToolsTextureGraph, Warning, TEXT("Compile: root %d isn't a node of this graph"), Root);
+		return false;
+	}
+
+	FTextureGraphCompiler Compiler(Nodes, bFuse, OutPlan);
+	return Compiler.Compile(Root);
+}
+
+int32 FGraphicToolsTextureGraph::Execute(UTextureRenderTarget2D* Output, FNodeId Root, ERHIFeatureLevel::Type FeatureLevel, bool bFuse) const
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork())
+	{
+		return 0;
+	}
+
+	FTextureRenderTargetResource* OutputResource = Output != nullptr ? Output->GameThread_GetRenderTargetResource() : nullptr;
+	if (OutputResource == nullptr)
+	{
+		UE_LOG(LogGraphicToolsTextureGraph, Warning, TEXT("Execute: output %s has no resource"), *GetNameSafe(Output));
+		return 0;
+	}
+
+	FGraphicToolsTextureGraphPlan Plan;
+	if (!Compile(Root, bFuse, Plan))
+	{
+		return 0;
+	}
+
+	const int32 NumPasses = Plan.Passes.Num();
+
+	FGraphicToolsGPUJob Job;
+	Job.Name = TEXT("TextureGraph");
+	Job.Objects.Append(Plan.ExternalObjects);
+	Job.Objects.AddUnique(Output);
+	Job.Work = [Plan = MoveTemp(Plan), OutputResource, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+	{
+		TArray<FRHITexture2D*, TInlineAllocator<8>> ExternalTextures;
+		for (FTextureRenderTargetResource* Resource : Plan.ExternalResources)
+		{
+			ExternalTextures.Add(Resource->GetRenderTargetTexture());
+		}
+		ExecuteTextureGraphPlan_RenderThread(RHICmdList, FeatureLevel, Plan, ExternalTextures, OutputResource->GetRenderTargetTexture());
+	};
+	FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+
+	return NumPasses;
+}
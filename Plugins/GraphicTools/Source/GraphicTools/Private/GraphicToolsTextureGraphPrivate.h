@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphicToolsTextureGraph.h"
+#include "RHI.h"
+#include "UObject/ObjectKey.h"
+
+class FTextureRenderTargetResource;
+
+/** Matches STAGE_OP_* in TextureGraph.usf */
+enum class ETextureGraphStageOp : uint8
+{
+	None,
+	Multiply,
+	Blend,
+	Num,
+};
+
+/** Where a pass reads from or writes to: a texture from the graph or one of the plan's intermediates */
+struct FTextureGraphSlot
+{
+	bool bExternal = false;
+	int32 Index = INDEX_NONE;
+};
+
+struct FTextureGraphPass
+{
+	enum class EType : uint8
+	{
+		/** A source (generator or texture) followed by up to MaxFusedStages per-pixel stages, one dispatch */
+		Fused,
+		Blur,
+	};
+
+	EType Type = EType::Fused;
+
+	bool bGeneratorSource = false;
+	float GeneratorTime = 0.0f;
+
+	/** The fused source when it isn't the generator, the input of a blur */
+	FTextureGraphSlot Input;
+
+	int32 NumStages = 0;
+	ETextureGraphStageOp StageOps[FGraphicToolsTextureGraph::MaxFusedStages] = {};
+	FVector4 StageParameters[FGraphicToolsTextureGraph::MaxFusedStages];
+	FTextureGraphSlot StageTextures[FGraphicToolsTextureGraph::MaxFusedStages];
+
+	int32 BlurRadius = 0;
+	EGraphicToolsBlurKernel BlurKernel = EGraphicToolsBlurKernel::Gaussian;
+
+	/** Always an intermediate */
+	FTextureGraphSlot Output;
+};
+
+/** A compiled graph, everything the render thread needs to run it */
+struct FGraphicToolsTextureGraphPlan
+{
+	TArray<FTextureGraphPass> Passes;
+
+	/** Resolved by the caller on the render thread, external slots index into these */
+	TArray<FTextureRenderTargetResource*> ExternalResources;
+
+	/** The textures behind ExternalResources, game thread only */
+	TArray<FObjectKey> ExternalObjects;
+
+	/** For each intermediate, the last pass reading it, after which it goes back to the pool */
+	TArray<int32> IntermediateLastUse;
+
+	FTextureGraphSlot Result;
+};
+
+/**
+ * Runs Plan and copies its result into Output. Intermediates are allocated at Output's size and format as
+ * passes first write them and released after their last reader, so a chain of passes ping-pongs between two.
+ */
+void ExecuteTextureGraphPlan_RenderThread(
+	FRHICommandListImmediate& RHICmdList,
+	ERHIFeatureLevel::Type FeatureLevel,
+	const FGraphicToolsTextureGraphPlan& Plan,
+	TArrayView<FRHITexture2D* const> ExternalTextures,
+	FRHITexture2D* Output
+);
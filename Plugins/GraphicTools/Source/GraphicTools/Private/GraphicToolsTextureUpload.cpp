@@ -0,0 +1,368 @@
+#include "GraphicToolsTextureUpload.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+
+#include "Containers/Queue.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "RenderingThread.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGraphicToolsUpload, Log, All);
+
+/** The ring of staging buffers, shared between the uploader, its producer thread and the render thread */
+struct FGraphicToolsUploadStaging
+{
+	enum EBufferState : int32
+	{
+		Free,
+		Writing,
+		/** Written, waiting for the next tick or the render thread */
+		Queued,
+	};
+
+	struct FBuffer
+	{
+		TArray<uint8> Data;
+		TArray<FIntRect> DirtyRegions;
+		volatile int32 State = Free;
+	};
+
+	FIntPoint Size = FIntPoint::ZeroValue;
+	int32 BytesPerPixel = 0;
+	int32 Pitch = 0;
+
+	/** Allocated once, never resized */
+	TArray<FBuffer> Buffers;
+
+	/** Written buffers in the order they were finished */
+	TQueue<int32, EQueueMode::Mpsc> Written;
+
+	FThreadSafeCounter64 UploadedBytes;
+	FThreadSafeCounter UploadedFrames;
+	FThreadSafeCounter DroppedFrames;
+
+	void Release(int32 Buffer)
+	{
+		FPlatformAtomics::InterlockedExchange(&Buffers[Buffer].State, Free);
+	}
+};
+
+// Copies the given regions of a staging buffer into the top mip of Target. The regions are addressed the same
+// way in both, so each one starts at its own offset into the buffer.
+static int64 UploadRegions_RenderThread(FRHITexture2D* Target, const uint8* Data, int32 Pitch, int32 BytesPerPixel, TArrayView<const FIntRect> Regions)
+{
+	int64 Bytes = 0;
+	for (const FIntRect& Rect : Regions)
+	{
+		const FUpdateTextureRegion2D Region(Rect.Min.X, Rect.Min.Y, Rect.Min.X, Rect.Min.Y, Rect.Width(), Rect.Height());
+		RHIUpdateTexture2D(Target, 0, Region, Pitch, Data + Region.SrcY * Pitch + Region.SrcX * BytesPerPixel);
+		Bytes += (int64)Region.Width * Region.Height * BytesPerPixel;
+	}
+	return Bytes;
+}
+
+class FGraphicToolsTextureUploader::FProducerRunnable : public FRunnable
+{
+public:
+	FProducerRunnable(FGraphicToolsTextureUploader& InUploader, FProducer&& InProducer, float MaxFramesPerSecond)
+		: Uploader(InUploader)
+		, Producer(MoveTemp(InProducer))
+		, FrameSeconds(MaxFramesPerSecond > 0.0f ? 1.0 / MaxFramesPerSecond : 0.0)
+	{
+	}
+
+	// FRunnable interface
+	virtual uint32 Run() override
+	{
+		TArray<FIntRect> DirtyRegions;
+
+		while (!bStopping)
+		{
+			const double FrameStartSeconds = FPlatformTime::Seconds();
+
+			const int32 Buffer = Uploader.BeginWrite();
+			if (Buffer != INDEX_NONE)
+			{
+				DirtyRegions.Reset();
+				if (Producer(Uploader.GetStagingData(Buffer), Uploader.GetStagingPitch(), DirtyRegions))
+				{
+					for (const FIntRect& Region : DirtyRegions)
+					{
+						Uploader.MarkDirty(Buffer, Region);
+					}
+					Uploader.EndWrite(Buffer);
+				}
+				else
+				{
+					Uploader.Staging->Release(Buffer);
+				}
+			}
+
+			const double RemainingSeconds = FrameSeconds - (FPlatformTime::Seconds() - FrameStartSeconds);
+			FPlatformProcess::Sleep(RemainingSeconds > 0.0 ? (float)RemainingSeconds : 0.0f);
+		}
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping = true;
+	}
+	// End of FRunnable interface
+
+private:
+	FGraphicToolsTextureUploader& Uploader;
+	FProducer Producer;
+	const double FrameSeconds;
+	FThreadSafeBool bStopping;
+};
+
+FGraphicToolsTextureUploader::FGraphicToolsTextureUploader(FIntPoint Size, EPixelFormat Format, int32 NumStagingBuffers)
+	: Staging(MakeShared<FGraphicToolsUploadStaging, ESPMode::ThreadSafe>())
+{
+	check(IsInGameThread());
+
+	const FPixelFormatInfo& FormatInfo = GPixelFormats[Format];
+	if (FormatInfo.BlockSizeX != 1 || FormatInfo.BlockSizeY != 1 || FormatInfo.BlockBytes == 0)
+	{
+		UE_LOG(LogGraphicToolsUpload, Warning, TEXT("%s isn't an uncompressed format, nothing will be uploaded"), FormatInfo.Name);
+		return;
+	}
+
+	Staging->Size = FIntPoint(FMath::Max(Size.X, 1), FMath::Max(Size.Y, 1));
+	Staging->BytesPerPixel = FormatInfo.BlockBytes;
+	Staging->Pitch = Staging->Size.X * Staging->BytesPerPixel;
+
+	Staging->Buffers.SetNum(FMath::Max(NumStagingBuffers, 1));
+	for (FGraphicToolsUploadStaging::FBuffer& Buffer : Staging->Buffers)
+	{
+		Buffer.Data.SetNumUninitialized(Staging->Pitch * Staging->Size.Y);
+	}
+
+	Texture = UTexture2D::CreateTransient(Staging->Size.X, Staging->Size.Y, Format);
+	if (Texture != nullptr)
+	{
+		Texture->NeverStream = true;
+		Texture->UpdateResource();
+	}
+}
+
+FGraphicToolsTextureUploader::~FGraphicToolsTextureUploader()
+{
+	StopProducer();
+}
+
+int32 FGraphicToolsTextureUploader::BeginWrite()
+{
+	for (int32 Index = 0; Index < Staging->Buffers.Num(); ++Index)
+	{
+		if (FPlatformAtomics::InterlockedCompareExchange(&Staging->Buffers[Index].State, FGraphicToolsUploadStaging::Writing, FGraphicToolsUploadStaging::Free) == FGraphicToolsUploadStaging::Free)
+		{
+			Staging->Buffers[Index].DirtyRegions.Reset();
+			return Index;
+		}
+	}
+
+	Staging->DroppedFrames.Increment();
+	return INDEX_NONE;
+}
+
+uint8* FGraphicToolsTextureUploader::GetStagingData(int32 Buffer) const
+{
+	return Staging->Buffers.IsValidIndex(Buffer) ? Staging->Buffers[Buffer].Data.GetData() : nullptr;
+}
+
+int32 FGraphicToolsTextureUploader::GetStagingPitch() const
+{
+	return Staging->Pitch;
+}
+
+void FGraphicToolsTextureUploader::MarkDirty(int32 Buffer, const FIntRect& Region)
+{
+	check(Staging->Buffers.IsValidIndex(Buffer) && Staging->Buffers[Buffer].State == FGraphicToolsUploadStaging::Writing);
+
+	FIntRect Clipped = Region;
+	Clipped.Clip(FIntRect(FIntPoint::ZeroValue, Staging->Size));
+	if (Clipped.Area() > 0)
+	{
+		Staging->Buffers[Buffer].DirtyRegions.Add(Clipped);
+	}
+}
+
+void FGraphicToolsTextureUploader::EndWrite(int32 Buffer)
+{
+	check(Staging->Buffers.IsValidIndex(Buffer) && Staging->Buffers[Buffer].State == FGraphicToolsUploadStaging::Writing);
+
+	FPlatformAtomics::InterlockedExchange(&Staging->Buffers[Buffer].State, FGraphicToolsUploadStaging::Queued);
+	Staging->Written.Enqueue(Buffer);
+}
+
+void FGraphicToolsTextureUploader::Tick(float DeltaTime)
+{
+	int32 Buffer = INDEX_NONE;
+	while (Staging->Written.Dequeue(Buffer))
+	{
+		FTextureResource* Resource = Texture != nullptr && CanDispatchGPUWork() ? Texture->Resource : nullptr;
+		if (Resource == nullptr)
+		{
+			Staging->Release(Buffer);
+			continue;
+		}
+
+		// goes out at once, after the queued jobs reading the texture, so they don't see this frame's pixels
+		FGraphicToolsGPUJob Job;
+		Job.Name = TEXT("TextureUpload");
+		Job.Priority = EGraphicToolsGPUJobPriority::High;
+		Job.Objects.Add(Texture);
+		Job.Work = [Staging = Staging, Resource, Buffer](FRHICommandListImmediate& RHICmdList)
+		{
+			FGraphicToolsUploadStaging::FBuffer& Written = Staging->Buffers[Buffer];
+			FRHITexture2D* Target = Resource->TextureRHI.IsValid() ? Resource->TextureRHI->GetTexture2D() : nullptr;
+			if (Target != nullptr)
+			{
+				const FIntRect WholeTexture(FIntPoint::ZeroValue, Staging->Size);
+				const TArrayView<const FIntRect> Regions = Written.DirtyRegions.Num() > 0 ? TArrayView<const FIntRect>(Written.DirtyRegions) : TArrayView<const FIntRect>(&WholeTexture, 1);
+				Staging->UploadedBytes.Add(UploadRegions_RenderThread(Target, Written.Data.GetData(), Staging->Pitch, Staging->BytesPerPixel, Regions));
+				Staging->UploadedFrames.Increment();
+			}
+			Staging->Release(Buffer);
+		};
+		FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+	}
+}
+
+void FGraphicToolsTextureUploader::StartProducer(FProducer&& Producer, float MaxFramesPerSecond)
+{
+	check(IsInGameThread());
+
+	StopProducer();
+
+	if (!FPlatformProcess::SupportsMultithreading())
+	{
+		UE_LOG(LogGraphicToolsUpload, Warning, TEXT("No threads on this platform, the producer won't run"));
+		return;
+	}
+
+	ProducerRunnable = MakeUnique<FProducerRunnable>(*this, MoveTemp(Producer), MaxFramesPerSecond);
+	ProducerThread.Reset(FRunnableThread::Create(ProducerRunnable.Get(), TEXT("GraphicToolsTextureUpload"), 0, TPri_BelowNormal));
+}
+
+void FGraphicToolsTextureUploader::StopProducer()
+{
+	if (ProducerThread.IsValid())
+	{
+		ProducerThread->Kill(true);
+		ProducerThread.Reset();
+	}
+	ProducerRunnable.Reset();
+}
+
+int64 FGraphicToolsTextureUploader::GetUploadedBytes() const
+{
+	return Staging->UploadedBytes.GetValue();
+}
+
+int32 FGraphicToolsTextureUploader::GetNumUploadedFrames() const
+{
+	return Staging->UploadedFrames.GetValue();
+}
+
+int32 FGraphicToolsTextureUploader::GetNumDroppedFrames() const
+{
+	return Staging->DroppedFrames.GetValue();
+}
+
+void FGraphicToolsTextureUploader::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(Texture);
+}
+
+// Megabytes per second Upload moves into the texture, waiting for the GPU at both ends
+static double MeasureUploadRate(FRHICommandListImmediate& RHICmdList, int32 Iterations, int64 BytesPerIteration, TFunctionRef<void()> Upload)
+{
+	Upload();
+	RHICmdList.BlockUntilGPUIdle();
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		Upload();
+	}
+	RHICmdList.BlockUntilGPUIdle();
+	const double Seconds = FPlatformTime::Seconds() - StartSeconds;
+
+	return Seconds > 0.0 ? BytesPerIteration * Iterations / (Seconds * 1024.0 * 1024.0) : 0.0;
+}
+
+static void RunTextureUploadBenchmark(const TArray<FString>& Args)
+{
+	check(IsInGameThread());
+
+	if (!CanDispatchGPUWork())
+	{
+		return;
+	}
+
+	const int32 Iterations = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 30, 1, 1000);
+
+	ENQUEUE_RENDER_COMMAND(GraphicToolsTextureUploadBenchmark)
+	(
+		[Iterations](FRHICommandListImmediate& RHICmdList)
+		{
+			const int32 BytesPerPixel = GPixelFormats[PF_B8G8R8A8].BlockBytes;
+
+			UE_LOG(LogGraphicToolsUpload, Display, TEXT("Texture upload, BGRA8, %d iterations:"), Iterations);
+
+			for (const FIntPoint Size : { FIntPoint(1920, 1080), FIntPoint(3840, 2160) })
+			{
+				const int32 Pitch = Size.X * BytesPerPixel;
+				TArray<uint8> Pixels;
+				Pixels.SetNumUninitialized(Pitch * Size.Y);
+				for (int32 Index = 0; Index < Pixels.Num(); ++Index)
+				{
+					Pixels[Index] = (uint8)(Index * 7);
+				}
+
+				FRHIResourceCreateInfo CreateInfo(TEXT("GraphicTools.BenchmarkUpload"));
+				FTexture2DRHIRef Persistent = RHICreateTexture2D(Size.X, Size.Y, PF_B8G8R8A8, 1, 1, TexCreate_ShaderResource, ERHIAccess::SRVMask, CreateInfo);
+
+				const FIntRect WholeTexture(FIntPoint::ZeroValue, Size);
+				const FIntRect Band(0, Size.Y / 2, Size.X, Size.Y / 2 + Size.Y / 8);
+				const int64 WholeBytes = (int64)Pitch * Size.Y;
+				const int64 BandBytes = (int64)Pitch * Band.Height();
+
+				const double WholeRate = MeasureUploadRate(RHICmdList, Iterations, WholeBytes, [&]()
+				{
+					UploadRegions_RenderThread(Persistent, Pixels.GetData(), Pitch, BytesPerPixel, TArrayView<const FIntRect>(&WholeTexture, 1));
+				});
+
+				const double BandRate = MeasureUploadRate(RHICmdList, Iterations, BandBytes, [&]()
+				{
+					UploadRegions_RenderThread(Persistent, Pixels.GetData(), Pitch, BytesPerPixel, TArrayView<const FIntRect>(&Band, 1));
+				});
+
+				// what UpdateResource() after writing the bulk data amounts to: a new texture every frame
+				const double RecreateRate = MeasureUploadRate(RHICmdList, Iterations, WholeBytes, [&]()
+				{
+					FTexture2DRHIRef Recreated = RHICreateTexture2D(Size.X, Size.Y, PF_B8G8R8A8, 1, 1, TexCreate_ShaderResource, ERHIAccess::SRVMask, CreateInfo);
+					UploadRegions_RenderThread(Recreated, Pixels.GetData(), Pitch, BytesPerPixel, TArrayView<const FIntRect>(&WholeTexture, 1));
+				});
+
+				UE_LOG(LogGraphicToolsUpload, Display, TEXT("  %dx%d  whole %8.1f MB/s (%5.2f ms)   1/8 dirty %8.1f MB/s (%5.2f ms)   recreated %8.1f MB/s (%5.2f ms)"),
+					Size.X, Size.Y,
+					WholeRate, WholeRate > 0.0 ? WholeBytes / (WholeRate * 1024.0 * 1024.0) * 1000.0 : 0.0,
+					BandRate, BandRate > 0.0 ? BandBytes / (BandRate * 1024.0 * 1024.0) * 1000.0 : 0.0,
+					RecreateRate, RecreateRate > 0.0 ? WholeBytes / (RecreateRate * 1024.0 * 1024.0) * 1000.0 : 0.0);
+			}
+		}
+	);
+}
+
+static FAutoConsoleCommand GBenchmarkTextureUploadCommand(
+	TEXT("GraphicTools.Benchmark.TextureUpload"),
+	TEXT("Measures CPU to GPU texture upload throughput at 1080p and 4K: GraphicTools.Benchmark.TextureUpload [Iterations=30]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunTextureUploadBenchmark)
+);
@@ -0,0 +1,535 @@
+#include "GraphicToolsTracers.h"
+#include "GraphicToolsGPUScheduler.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+
+#include "CommonRenderResources.h"
+#include "Engine/World.h"
+#include "GlobalShader.h"
+#include "PipelineStateCache.h"
+#include "PostProcess/PostProcessing.h"
+#include "RenderGraphBuilder.h"
+#include "RHIUtilities.h"
+#include "SceneRendering.h"
+#include "SceneViewExtension.h"
+#include "ShaderParameterUtils.h"
+
+static const int32 TracerThreadsPerGroup = 64;
+
+/** A frame longer than this many substeps is simulated in slow motion rather than stall the GPU */
+static const int32 TracerMaxSubsteps = 16;
+
+/** What one frame of the spawn and simulation passes is given, render thread */
+struct FTracerDispatch
+{
+	FRHIUnorderedAccessView* TracerState = nullptr;
+	FRHIShaderResourceView* Spawns = nullptr;
+	int32 NumSpawns = 0;
+	int32 FirstSpawnSlot = 0;
+	FRHIShaderResourceView* CollisionBoxes = nullptr;
+	int32 NumCollisionBoxes = 0;
+	float DeltaTime = 0.0f;
+	int32 NumSubsteps = 1;
+};
+
+/** Parameters the spawn and simulation passes share */
+class FGraphicToolsTracerShader : public FGlobalShader
+{
+	DECLARE_TYPE_LAYOUT(FGraphicToolsTracerShader, NonVirtual);
+public:
+
+	FGraphicToolsTracerShader()
+	{
+	}
+
+	FGraphicToolsTracerShader(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGlobalShader(Initializer)
+	{
+		TracerState.Bind(Initializer.ParameterMap, TEXT("RWTracerState"));
+		MaxTracers.Bind(Initializer.ParameterMap, TEXT("MaxTracers"));
+		Lifetime.Bind(Initializer.ParameterMap, TEXT("Lifetime"));
+		Spawns.Bind(Initializer.ParameterMap, TEXT("Spawns"));
+		NumSpawns.Bind(Initializer.ParameterMap, TEXT("NumSpawns"));
+		FirstSpawnSlot.Bind(Initializer.ParameterMap, TEXT("FirstSpawnSlot"));
+		DeltaTime.Bind(Initializer.ParameterMap, TEXT("DeltaTime"));
+		NumSubsteps.Bind(Initializer.ParameterMap, TEXT("NumSubsteps"));
+		Gravity.Bind(Initializer.ParameterMap, TEXT("Gravity"));
+		Bounciness.Bind(Initializer.ParameterMap, TEXT("Bounciness"));
+		Friction.Bind(Initializer.ParameterMap, TEXT("Friction"));
+		BounceStopSpeed.Bind(Initializer.ParameterMap, TEXT("BounceStopSpeed"));
+		CollisionBoxes.Bind(Initializer.ParameterMap, TEXT("CollisionBoxes"));
+		NumCollisionBoxes.Bind(Initializer.ParameterMap, TEXT("NumCollisionBoxes"));
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	void SetParameters(FRHICommandList& RHICmdList, const FGraphicToolsTracerSettings& Settings, const FTracerDispatch& Dispatch)
+	{
+		FRHIComputeShader* ShaderRHI = RHICmdList.GetBoundComputeShader();
+		SetUAVParameter(RHICmdList, ShaderRHI, TracerState, Dispatch.TracerState);
+		SetShaderValue(RHICmdList, ShaderRHI, MaxTracers, (uint32)Settings.MaxTracers);
+		SetShaderValue(RHICmdList, ShaderRHI, Lifetime, Settings.Lifetime);
+		SetSRVParameter(RHICmdList, ShaderRHI, Spawns, Dispatch.Spawns);
+		SetShaderValue(RHICmdList, ShaderRHI, NumSpawns, (uint32)Dispatch.NumSpawns);
+		SetShaderValue(RHICmdList, ShaderRHI, FirstSpawnSlot, (uint32)Dispatch.FirstSpawnSlot);
+		SetShaderValue(RHICmdList, ShaderRHI, DeltaTime, Dispatch.DeltaTime);
+		SetShaderValue(RHICmdList, ShaderRHI, NumSubsteps, (uint32)Dispatch.NumSubsteps);
+		SetShaderValue(RHICmdList, ShaderRHI, Gravity, Settings.Gravity);
+		SetShaderValue(RHICmdList, ShaderRHI, Bounciness, Settings.Bounciness);
+		SetShaderValue(RHICmdList, ShaderRHI, Friction, Settings.Friction);
+		SetShaderValue(RHICmdList, ShaderRHI, BounceStopSpeed, Settings.BounceStopSpeed);
+		SetSRVParameter(RHICmdList, ShaderRHI, CollisionBoxes, Dispatch.CollisionBoxes);
+		SetShaderValue(RHICmdList, ShaderRHI, NumCollisionBoxes, (uint32)Dispatch.NumCollisionBoxes);
+	}
+
+	void UnsetParameters(FRHICommandList& RHICmdList)
+	{
+		SetUAVParameter(RHICmdList, RHICmdList.GetBoundComputeShader(), TracerState, nullptr);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, TracerState);
+	LAYOUT_FIELD(FShaderParameter, MaxTracers);
+	LAYOUT_FIELD(FShaderParameter, Lifetime);
+	LAYOUT_FIELD(FShaderResourceParameter, Spawns);
+	LAYOUT_FIELD(FShaderParameter, NumSpawns);
+	LAYOUT_FIELD(FShaderParameter, FirstSpawnSlot);
+	LAYOUT_FIELD(FShaderParameter, DeltaTime);
+	LAYOUT_FIELD(FShaderParameter, NumSubsteps);
+	LAYOUT_FIELD(FShaderParameter, Gravity);
+	LAYOUT_FIELD(FShaderParameter, Bounciness);
+	LAYOUT_FIELD(FShaderParameter, Friction);
+	LAYOUT_FIELD(FShaderParameter, BounceStopSpeed);
+	LAYOUT_FIELD(FShaderResourceParameter, CollisionBoxes);
+	LAYOUT_FIELD(FShaderParameter, NumCollisionBoxes);
+};
+
+IMPLEMENT_TYPE_LAYOUT(FGraphicToolsTracerShader);
+
+class FTracerSpawnCS : public FGraphicToolsTracerShader
+{
+	DECLARE_SHADER_TYPE(FTracerSpawnCS, Global);
+public:
+
+	FTracerSpawnCS()
+	{
+	}
+
+	FTracerSpawnCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsTracerShader(Initializer)
+	{
+	}
+};
+
+class FTracerSimulateCS : public FGraphicToolsTracerShader
+{
+	DECLARE_SHADER_TYPE(FTracerSimulateCS, Global);
+public:
+
+	FTracerSimulateCS()
+	{
+	}
+
+	FTracerSimulateCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGraphicToolsTracerShader(Initializer)
+	{
+	}
+};
+
+class FTracerVS : public FGlobalShader
+{
+	DECLARE_SHADER_TYPE(FTracerVS, Global);
+public:
+
+	FTracerVS()
+	{
+	}
+
+	FTracerVS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGlobalShader(Initializer)
+	{
+		TracerState.Bind(Initializer.ParameterMap, TEXT("TracerState"));
+		Lifetime.Bind(Initializer.ParameterMap, TEXT("Lifetime"));
+		Radius.Bind(Initializer.ParameterMap, TEXT("Radius"));
+		TracerViewProjection.Bind(Initializer.ParameterMap, TEXT("TracerViewProjection"));
+		CameraOrigin.Bind(Initializer.ParameterMap, TEXT("CameraOrigin"));
+		StreakSeconds.Bind(Initializer.ParameterMap, TEXT("StreakSeconds"));
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	void SetParameters(FRHICommandList& RHICmdList, FRHIVertexShader* ShaderRHI, FRHIShaderResourceView* InTracerState, const FViewInfo& View, const FGraphicToolsTracerSettings& Settings)
+	{
+		SetSRVParameter(RHICmdList, ShaderRHI, TracerState, InTracerState);
+		SetShaderValue(RHICmdList, ShaderRHI, Lifetime, Settings.Lifetime);
+		SetShaderValue(RHICmdList, ShaderRHI, Radius, Settings.Radius);
+		SetShaderValue(RHICmdList, ShaderRHI, TracerViewProjection, View.ViewMatrices.GetViewProjectionMatrix());
+		SetShaderValue(RHICmdList, ShaderRHI, CameraOrigin, View.ViewMatrices.GetViewOrigin());
+		SetShaderValue(RHICmdList, ShaderRHI, StreakSeconds, Settings.StreakSeconds);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, TracerState);
+	LAYOUT_FIELD(FShaderParameter, Lifetime);
+	LAYOUT_FIELD(FShaderParameter, Radius);
+	LAYOUT_FIELD(FShaderParameter, TracerViewProjection);
+	LAYOUT_FIELD(FShaderParameter, CameraOrigin);
+	LAYOUT_FIELD(FShaderParameter, StreakSeconds);
+};
+
+class FTracerPS : public FGlobalShader
+{
+	DECLARE_SHADER_TYPE(FTracerPS, Global);
+public:
+
+	FTracerPS()
+	{
+	}
+
+	FTracerPS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+		: FGlobalShader(Initializer)
+	{
+		TracerColor.Bind(Initializer.ParameterMap, TEXT("TracerColor"));
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+
+	void SetParameters(FRHICommandList& RHICmdList, FRHIPixelShader* ShaderRHI, const FLinearColor& Color)
+	{
+		SetShaderValue(RHICmdList, ShaderRHI, TracerColor, Color);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderParameter, TracerColor);
+};
+
+IMPLEMENT_SHADER_TYPE(, FTracerSpawnCS, TEXT("/Plugin/GraphicTools/Private/Tracers.usf"), TEXT("SpawnCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FTracerSimulateCS, TEXT("/Plugin/GraphicTools/Private/Tracers.usf"), TEXT("SimulateCS"), SF_Compute);
+IMPLEMENT_SHADER_TYPE(, FTracerVS, TEXT("/Plugin/GraphicTools/Private/Tracers.usf"), TEXT("MainVS"), SF_Vertex);
+IMPLEMENT_SHADER_TYPE(, FTracerPS, TEXT("/Plugin/GraphicTools/Private/Tracers.usf"), TEXT("MainPS"), SF_Pixel);
+
+/** A Buffer<float4> holding Values, at least one element long so there is something to bind */
+static FShaderResourceViewRHIRef CreateFloat4Buffer(const TArray<FVector4>& Values, EBufferUsageFlags Usage)
+{
+	const uint32 NumBytes = sizeof(FVector4) * FMath::Max(Values.Num(), 1);
+
+	FRHIResourceCreateInfo CreateInfo;
+	FVertexBufferRHIRef Buffer = RHICreateVertexBuffer(NumBytes, Usage | BUF_ShaderResource, CreateInfo);
+	void* Data = RHILockVertexBuffer(Buffer, 0, NumBytes, RLM_WriteOnly);
+	FMemory::Memzero(Data, NumBytes);
+	FMemory::Memcpy(Data, Values.GetData(), Values.Num() * sizeof(FVector4));
+	RHIUnlockVertexBuffer(Buffer);
+
+	return RHICreateShaderResourceView(Buffer, sizeof(FVector4), PF_A32B32G32R32F);
+}
+
+BEGIN_SHADER_PARAMETER_STRUCT(FGraphicToolsTracerPassParameters, )
+	RENDER_TARGET_BINDING_SLOTS()
+END_SHADER_PARAMETER_STRUCT()
+
+/**
+ * Owns the tracers' GPU state and draws them into the scene color of the views of one scene, just before post
+ * processing so they bloom like any other emissive. Everything past construction is render thread only.
+ */
+class FGraphicToolsTracerExtension : public FSceneViewExtensionBase
+{
+public:
+	FGraphicToolsTracerExtension(const FAutoRegister& AutoRegister, FSceneInterface* InScene, const FGraphicToolsTracerSettings& InSettings)
+		: FSceneViewExtensionBase(AutoRegister)
+		, Scene(InScene)
+		, Settings(InSettings)
+		, NumCollisionBoxes(0)
+		, bLive(false)
+	{
+	}
+
+	void SetCollisionBoxes_RenderThread(const TArray<FVector4>& Boxes)
+	{
+		NumCollisionBoxes = Boxes.Num() / 2;
+		CollisionBoxes = CreateFloat4Buffer(Boxes, BUF_Static);
+	}
+
+	void Simulate_RenderThread(FRHICommandListImmediate& RHICmdList, const TArray<FVector4>& Spawns, int32 FirstSpawnSlot, float DeltaTime, int32 NumSubsteps, bool bInLive)
+	{
+		check(IsInRenderingThread());
+
+		bLive = bInLive;
+		if (!bLive)
+		{
+			return;
+		}
+
+		SCOPED_DRAW_EVENT(RHICmdList, GraphicToolsTracers);
+
+		if (!TracerState.UAV.IsValid())
+		{
+			// every slot starts out free
+			TracerState.Initialize(TEXT("GraphicTools.Tracers"), sizeof(FVector4), Settings.MaxTracers * 2, PF_A32B32G32R32F, ERHIAccess::UAVCompute);
+			RHICmdList.ClearUAVFloat(TracerState.UAV, FVector4(0.0f, 0.0f, 0.0f, -1.0f));
+		}
+		else
+		{
+			RHICmdList.Transition(FRHITransitionInfo(TracerState.UAV, ERHIAccess::SRVMask, ERHIAccess::UAVCompute));
+		}
+
+		if (!CollisionBoxes.IsValid())
+		{
+			CollisionBoxes = CreateFloat4Buffer(TArray<FVector4>(), BUF_Static);
+		}
+
+		FTracerDispatch Dispatch;
+		Dispatch.TracerState = TracerState.UAV;
+		Dispatch.CollisionBoxes = CollisionBoxes;
+		Dispatch.NumCollisionBoxes = NumCollisionBoxes;
+		Dispatch.DeltaTime = DeltaTime;
+		Dispatch.NumSubsteps = NumSubsteps;
+
+		FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(Scene->GetFeatureLevel());
+
+		FShaderResourceViewRHIRef SpawnsSRV;
+		if (Spawns.Num() > 0)
+		{
+			SpawnsSRV = CreateFloat4Buffer(Spawns, BUF_Volatile);
+			Dispatch.Spawns = SpawnsSRV;
+			Dispatch.NumSpawns = Spawns.Num() / 2;
+			Dispatch.FirstSpawnSlot = FirstSpawnSlot;
+
+			TShaderMapRef<FTracerSpawnCS> SpawnShader(ShaderMap);
+			RHICmdList.SetComputeShader(SpawnShader.GetComputeShader());
+			SpawnShader->SetParameters(RHICmdList, Settings, Dispatch);
+			DispatchComputeShader(RHICmdList, SpawnShader, FMath::DivideAndRoundUp(Dispatch.NumSpawns, TracerThreadsPerGroup), 1, 1);
+			SpawnShader->UnsetParameters(RHICmdList);
+
+			RHICmdList.Transition(FRHITransitionInfo(TracerState.UAV, ERHIAccess::UAVCompute, ERHIAccess::UAVCompute));
+		}
+
+		TShaderMapRef<FTracerSimulateCS> SimulateShader(ShaderMap);
+		RHICmdList.SetComputeShader(SimulateShader.GetComputeShader());
+		SimulateShader->SetParameters(RHICmdList, Settings, Dispatch);
+		DispatchComputeShader(RHICmdList, SimulateShader, FMath::DivideAndRoundUp(Settings.MaxTracers, TracerThreadsPerGroup), 1, 1);
+		SimulateShader->UnsetParameters(RHICmdList);
+
+		RHICmdList.Transition(FRHITransitionInfo(TracerState.UAV, ERHIAccess::UAVCompute, ERHIAccess::SRVMask));
+	}
+
+	void Release_RenderThread()
+	{
+		bLive = false;
+		TracerState.Release();
+		CollisionBoxes.SafeRelease();
+	}
+
+	// ISceneViewExtension interface
+	virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {}
+	virtual void PreRenderViewFamily_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneViewFamily& InViewFamily) override {}
+	virtual void PreRenderView_RenderThread(FRHICommandListImmediate& RHICmdList, FSceneView& InView) override {}
+
+	virtual void PrePostProcessPass_RenderThread(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessingInputs& Inputs) override
+	{
+		if (!bLive || View.Family->Scene != Scene || View.GetFeatureLevel() < ERHIFeatureLevel::SM5)
+		{
+			return;
+		}
+
+		const FViewInfo& ViewInfo = static_cast<const FViewInfo&>(View);
+		const FSceneTextureUniformParameters* SceneTextures = Inputs.SceneTextures->GetParameters();
+
+		// depth tested but not written, tracers don't hide each other
+		FGraphicToolsTracerPassParameters* PassParameters = GraphBuilder.AllocParameters<FGraphicToolsTracerPassParameters>();
+		PassParameters->RenderTargets[0] = FRenderTargetBinding(SceneTextures->SceneColorTexture, ERenderTargetLoadAction::ELoad);
+		PassParameters->RenderTargets.DepthStencil = FDepthStencilBinding(
+			SceneTextures->SceneDepthTexture,
+			ERenderTargetLoadAction::ELoad,
+			ERenderTargetLoadAction::ELoad,
+			FExclusiveDepthStencil::DepthRead_StencilNop
+		);
+
+		GraphBuilder.AddPass(
+			RDG_EVENT_NAME("GraphicToolsTracers"),
+			PassParameters,
+			ERDGPassFlags::Raster,
+			[this, &ViewInfo](FRHICommandListImmediate& RHICmdList)
+			{
+				Draw_RenderThread(RHICmdList, ViewInfo);
+			}
+		);
+	}
+	// End of ISceneViewExtension interface
+
+private:
+	void Draw_RenderThread(FRHICommandListImmediate& RHICmdList, const FViewInfo& View)
+	{
+		RHICmdList.SetViewport(View.ViewRect.Min.X, View.ViewRect.Min.Y, 0.0f, View.ViewRect.Max.X, View.ViewRect.Max.Y, 1.0f);
+
+		FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(View.GetFeatureLevel());
+		TShaderMapRef<FTracerVS> VertexShader(ShaderMap);
+		TShaderMapRef<FTracerPS> PixelShader(ShaderMap);
+
+		FGraphicsPipelineStateInitializer GraphicsPSOInit;
+		RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+		GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_DepthNearOrEqual>::GetRHI();
+		GraphicsPSOInit.BlendState = TStaticBlendState<CW_RGB, BO_Add, BF_One, BF_One>::GetRHI();
+		GraphicsPSOInit.RasterizerState = TStaticRasterizerState<FM_Solid, CM_None>::GetRHI();
+		GraphicsPSOInit.PrimitiveType = PT_TriangleStrip;
+		GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GEmptyVertexDeclaration.VertexDeclarationRHI;
+		GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+		GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+		SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit);
+
+		VertexShader->SetParameters(RHICmdList, VertexShader.GetVertexShader(), TracerState.SRV, View, Settings);
+		PixelShader->SetParameters(RHICmdList, PixelShader.GetPixelShader(), Settings.Color * View.PreExposure);
+
+		// a quad per slot, the vertex shader collapses free ones
+		RHICmdList.DrawPrimitive(0, 2, Settings.MaxTracers);
+	}
+
+	/** Only compared against, it may be gone once the system is released */
+	FSceneInterface* Scene;
+
+	const FGraphicToolsTracerSettings Settings;
+
+	FRWBuffer TracerState;
+
+	FShaderResourceViewRHIRef CollisionBoxes;
+	int32 NumCollisionBoxes;
+
+	/** Whether any tracer may be alive, nothing is simulated or drawn while none is */
+	bool bLive;
+};
+
+static FGraphicToolsTracerSettings ClampTracerSettings(const FGraphicToolsTracerSettings& InSettings)
+{
+	FGraphicToolsTracerSettings Settings = InSettings;
+	Settings.MaxTracers = FMath::Max(Settings.MaxTracers, 1);
+	Settings.Lifetime = FMath::Max(Settings.Lifetime, KINDA_SMALL_NUMBER);
+	Settings.MaxSubstepTime = FMath::Max(Settings.MaxSubstepTime, KINDA_SMALL_NUMBER);
+	return Settings;
+}
+
+FGraphicToolsTracers::FGraphicToolsTracers(UWorld* World, const FGraphicToolsTracerSettings& InSettings)
+	: Settings(ClampTracerSettings(InSettings))
+	, Extension(FSceneViewExtensions::NewExtension<FGraphicToolsTracerExtension>(World->Scene, Settings))
+	, NextSlot(0)
+	, Time(0.0)
+	, bSimulating(false)
+{
+}
+
+FGraphicToolsTracers::~FGraphicToolsTracers()
+{
+	ENQUEUE_RENDER_COMMAND(ReleaseGraphicToolsTracers)
+	(
+		[Extension = Extension](FRHICommandListImmediate& RHICmdList)
+		{
+			Extension->Release_RenderThread();
+		}
+	);
+}
+
+void FGraphicToolsTracers::Spawn(const FVector& Location, const FVector& Velocity)
+{
+	PendingSpawns.Add(FVector4(Location, 0.0f));
+	PendingSpawns.Add(FVector4(Velocity, 0.0f));
+}
+
+void FGraphicToolsTracers::SetCollisionBoxes(const TArray<FBox>& Boxes)
+{
+	if (!CanDispatchGPUWork())
+	{
+		return;
+	}
+
+	// grown by the radius, the shader sweeps the tracer's center
+	const FVector Extent(Settings.Radius);
+	const int32 NumBoxes = FMath::Min(Boxes.Num(), GraphicToolsMaxTracerCollisionBoxes);
+
+	TArray<FVector4> MinMax;
+	MinMax.Reserve(NumBoxes * 2);
+	for (int32 Index = 0; Index < NumBoxes; ++Index)
+	{
+		const FBox Box = Boxes[Index].ExpandBy(Extent);
+		MinMax.Add(FVector4(Box.Min, 0.0f));
+		MinMax.Add(FVector4(Box.Max, 0.0f));
+	}
+
+	ENQUEUE_RENDER_COMMAND(SetGraphicToolsTracerCollision)
+	(
+		[Extension = Extension, MinMax = MoveTemp(MinMax)](FRHICommandListImmediate& RHICmdList)
+		{
+			Extension->SetCollisionBoxes_RenderThread(MinMax);
+		}
+	);
+}
+
+void FGraphicToolsTracers::Tick(float DeltaTime)
+{
+	Time += DeltaTime;
+
+	int32 NumSpawns = PendingSpawns.Num() / 2;
+	if (NumSpawns > Settings.MaxTracers)
+	{
+		// the oldest would be overwritten in the same frame anyway
+		PendingSpawns.RemoveAt(0, (NumSpawns - Settings.MaxTracers) * 2);
+		NumSpawns = Settings.MaxTracers;
+	}
+
+	if (NumSpawns > 0)
+	{
+		RecentSpawns.Emplace(Time, NumSpawns);
+	}
+	while (RecentSpawns.Num() > 0 && RecentSpawns[0].Key + Settings.Lifetime < Time)
+	{
+		RecentSpawns.RemoveAt(0);
+	}
+
+	if (!CanDispatchGPUWork())
+	{
+		PendingSpawns.Reset();
+		return;
+	}
+
+	// one more frame after the last tracer dies tells the render thread to stop drawing
+	const bool bLive = RecentSpawns.Num() > 0;
+	if (!bLive && !bSimulating)
+	{
+		return;
+	}
+	bSimulating = bLive;
+
+	const int32 FirstSpawnSlot = NextSlot;
+	NextSlot = (NextSlot + NumSpawns) % Settings.MaxTracers;
+
+	const int32 NumSubsteps = FMath::Clamp(FMath::CeilToInt(DeltaTime / Settings.MaxSubstepTime), 1, TracerMaxSubsteps);
+
+	// every frame depends on the last, so it goes out at once rather than waiting on the budget
+	FGraphicToolsGPUJob Job;
+	Job.Name = TEXT("Tracers");
+	Job.Priority = EGraphicToolsGPUJobPriority::High;
+	Job.Work = [Extension = Extension, Spawns = MoveTemp(PendingSpawns), FirstSpawnSlot, DeltaTime, NumSubsteps, bLive](FRHICommandListImmediate& RHICmdList)
+	{
+		Extension->Simulate_RenderThread(RHICmdList, Spawns, FirstSpawnSlot, DeltaTime, NumSubsteps, bLive);
+	};
+	FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+
+	PendingSpawns.Reset();
+}
+
+int32 FGraphicToolsTracers::GetNumLive() const
+{
+	int32 NumLive = 0;
+	for (const TPair<double, int32>& Spawned : RecentSpawns)
+	{
+		NumLive += Spawned.Value;
+	}
+	return FMath::Min(NumLive, Settings.MaxTracers);
+}
@@ -0,0 +1,127 @@
+#include "GraphicToolsBlockCompression.h"
+#include "GraphicToolsImageOperatorsPrivate.h"
+
+#include "Misc/AutomationTest.h"
+#include "RenderingThread.h"
+#include "RenderTargetPool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGraphicToolsBlockCompressionTest, "GraphicTools.BlockCompression.QualityAndSpeed",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Encodes the benchmark image with every format on the CPU and, where there is one, the GPU. Each must reach its
+// PSNR floor and the two encoders must agree, the compute shader being a port of the CPU encoder. Timings are
+// logged, GraphicTools.Benchmark.BlockCompression measures them at larger sizes.
+bool FGraphicToolsBlockCompressionTest::RunTest(const FString& Parameters)
+{
+	struct FFormatCase
+	{
+		EGraphicToolsBlockFormat Format;
+		const TCHAR* Name;
+		double MinPSNR;
+	};
+
+	// well under what the encoders reach on this image, a drop below is a regression rather than noise
+	const FFormatCase Cases[] =
+	{
+		{ EGraphicToolsBlockFormat::BC1, TEXT("BC1"), 30.0 },
+		{ EGraphicToolsBlockFormat::BC3, TEXT("BC3"), 30.0 },
+		{ EGraphicToolsBlockFormat::BC5, TEXT("BC5"), 34.0 },
+		{ EGraphicToolsBlockFormat::BC7, TEXT("BC7"), 34.0 },
+	};
+
+	// blocks the GPU may encode differently from the CPU, where float rounding tips an endpoint over a step
+	const float MaxMismatchedBlockFraction = 0.01f;
+	const double MaxPSNRDifference = 0.1;
+
+	const int32 Size = 256;
+	const FIntPoint ImageSize(Size, Size);
+	TArray<FLinearColor> Pixels;
+	MakeBlockCompressionTestImage(Size, Pixels);
+
+	TArray<TArray<uint8>> CPUBlocks;
+	TArray<double> CPUPSNR;
+	for (const FFormatCase& Case : Cases)
+	{
+		TArray<uint8>& Blocks = CPUBlocks.AddDefaulted_GetRef();
+		const double StartSeconds = FPlatformTime::Seconds();
+		FGraphicToolsBlockCompression::EncodeBlocks(Pixels.GetData(), ImageSize, Case.Format, Blocks);
+		const double EncodeMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+		const double PSNR = FGraphicToolsBlockCompression::ComputePSNR(Pixels.GetData(), Blocks.GetData(), ImageSize, Case.Format);
+		CPUPSNR.Add(PSNR);
+
+		AddInfo(FString::Printf(TEXT("%s CPU: %.3f ms, PSNR %.2f dB"), Case.Name, EncodeMs, PSNR));
+		TestEqual(*FString::Printf(TEXT("%s CPU size"), Case.Name), Blocks.Num(), (Size / 4) * (Size / 4) * FGraphicToolsBlockCompression::GetBlockBytes(Case.Format));
+		TestTrue(*FString::Printf(TEXT("%s CPU PSNR %.2f dB reaches %.0f dB"), Case.Name, PSNR, Case.MinPSNR), PSNR >= Case.MinPSNR);
+	}
+
+	if (!CanDispatchGPUWork() || GMaxRHIFeatureLevel < ERHIFeatureLevel::SM5)
+	{
+		AddInfo(TEXT("No compute capable GPU, only the CPU encoder was tested"));
+		return true;
+	}
+
+	// the render thread fills these in, the game thread waits for it below
+	TArray<TArray<uint8>> GPUBlocks;
+	TArray<float> GPUMs;
+	GPUBlocks.SetNum(UE_ARRAY_COUNT(Cases));
+	GPUMs.SetNumZeroed(UE_ARRAY_COUNT(Cases));
+
+	const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+	ENQUEUE_RENDER_COMMAND(GraphicToolsBlockCompressionTest)
+	(
+		[&Cases, &Pixels, &GPUBlocks, &GPUMs, Size, FeatureLevel](FRHICommandListImmediate& RHICmdList)
+		{
+			TRefCountPtr<IPooledRenderTarget> Source = AllocateImageIntermediate(RHICmdList, FIntPoint(Size, Size), PF_A32B32G32R32F, 1, TEXT("GraphicTools.TestBlockSource"));
+			FRHITexture2D* SourceTexture = Source->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D();
+			RHIUpdateTexture2D(SourceTexture, 0, FUpdateTextureRegion2D(0, 0, 0, 0, Size, Size), Size * sizeof(FLinearColor), reinterpret_cast<const uint8*>(Pixels.GetData()));
+
+			for (int32 CaseIndex = 0; CaseIndex < UE_ARRAY_COUNT(Cases); ++CaseIndex)
+			{
+				const EGraphicToolsBlockFormat Format = Cases[CaseIndex].Format;
+				if (GSupportsTimestampRenderQueries)
+				{
+					GPUMs[CaseIndex] = TimeOnGPU(RHICmdList, 4, [&]()
+					{
+						CompressBlocks_RenderThread(RHICmdList, FeatureLevel, SourceTexture, Format);
+					});
+				}
+
+				TRefCountPtr<IPooledRenderTarget> Blocks = CompressBlocks_RenderThread(RHICmdList, FeatureLevel, SourceTexture, Format);
+				ReadBackBlocks_RenderThread(RHICmdList, Blocks->GetRenderTargetItem().ShaderResourceTexture->GetTexture2D(), Format, GPUBlocks[CaseIndex]);
+			}
+		}
+	);
+	FlushRenderingCommands();
+
+	for (int32 CaseIndex = 0; CaseIndex < UE_ARRAY_COUNT(Cases); ++CaseIndex)
+	{
+		const FFormatCase& Case = Cases[CaseIndex];
+		const TArray<uint8>& Blocks = GPUBlocks[CaseIndex];
+		if (!TestEqual(*FString::Printf(TEXT("%s GPU size"), Case.Name), Blocks.Num(), CPUBlocks[CaseIndex].Num()))
+		{
+			continue;
+		}
+
+		const double PSNR = FGraphicToolsBlockCompression::ComputePSNR(Pixels.GetData(), Blocks.GetData(), ImageSize, Case.Format);
+		AddInfo(FString::Printf(TEXT("%s GPU: %.3f ms, PSNR %.2f dB"), Case.Name, GPUMs[CaseIndex], PSNR));
+		TestTrue(*FString::Printf(TEXT("%s GPU PSNR %.2f dB reaches %.0f dB"), Case.Name, PSNR, Case.MinPSNR), PSNR >= Case.MinPSNR);
+		TestTrue(*FString::Printf(TEXT("%s GPU PSNR %.2f dB matches the CPU's %.2f dB"), Case.Name, PSNR, CPUPSNR[CaseIndex]), FMath::Abs(PSNR - CPUPSNR[CaseIndex]) <= MaxPSNRDifference);
+
+		const int32 BlockBytes = FGraphicToolsBlockCompression::GetBlockBytes(Case.Format);
+		const int32 NumBlocks = Blocks.Num() / BlockBytes;
+		int32 NumMismatchedBlocks = 0;
+		for (int32 Block = 0; Block < NumBlocks; ++Block)
+		{
+			NumMismatchedBlocks += FMemory::Memcmp(Blocks.GetData() + Block * BlockBytes, CPUBlocks[CaseIndex].GetData() + Block * BlockBytes, BlockBytes) != 0 ? 1 : 0;
+		}
+		TestTrue(*FString::Printf(TEXT("%s GPU encodes %d of %d blocks like the CPU"), Case.Name, NumBlocks - NumMismatchedBlocks, NumBlocks),
+			NumMismatchedBlocks <= FMath::FloorToInt(NumBlocks * MaxMismatchedBlockFraction));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
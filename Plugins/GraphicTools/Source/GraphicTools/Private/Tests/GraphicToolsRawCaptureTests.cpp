@@ -0,0 +1,103 @@
+#include "GraphicToolsRawCapture.h"
+
+#include "HAL/FileManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGraphicToolsRawCaptureRoundTripTest, "GraphicTools.Capture.RawRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Writes a few frames of random texels in every format, with a padded source pitch for odd frames, and checks
+// the reader hands back exactly the same bytes and headers.
+bool FGraphicToolsRawCaptureRoundTripTest::RunTest(const FString& Parameters)
+{
+	const EGraphicToolsRawPixelFormat Formats[] =
+	{
+		EGraphicToolsRawPixelFormat::B8G8R8A8,
+		EGraphicToolsRawPixelFormat::R8G8B8A8,
+		EGraphicToolsRawPixelFormat::A2B10G10R10,
+		EGraphicToolsRawPixelFormat::FloatRGBA,
+		EGraphicToolsRawPixelFormat::A32B32G32R32F,
+		EGraphicToolsRawPixelFormat::R32Float,
+		EGraphicToolsRawPixelFormat::G8,
+	};
+
+	const uint32 Width = 37;
+	const uint32 Height = 19;
+	const uint32 NumFrames = 3;
+	const FString Path = FPaths::AutomationTransientDir() / TEXT("GraphicToolsRawRoundTrip.gtcap");
+
+	for (const EGraphicToolsRawPixelFormat Format : Formats)
+	{
+		const FString FormatName = GPixelFormats[GraphicToolsRawCapture::ToPixelFormat(Format)].Name;
+		TestEqual(*FString::Printf(TEXT("%s maps back from its EPixelFormat"), *FormatName), (int32)GraphicToolsRawCapture::FromPixelFormat(GraphicToolsRawCapture::ToPixelFormat(Format)), (int32)Format);
+
+		const uint32 RowBytes = Width * GraphicToolsRawCapture::GetBytesPerPixel(Format);
+		if (!TestTrue(*FString::Printf(TEXT("%s has a size"), *FormatName), RowBytes > 0))
+		{
+			continue;
+		}
+
+		FRandomStream Random((int32)Format);
+		TArray<TArray<uint8>> Frames;
+		{
+			FGraphicToolsRawCaptureWriter Writer;
+			if (!TestTrue(*FString::Printf(TEXT("%s opens for writing"), *FormatName), Writer.Open(Path, Format, Width, Height, NumFrames + 1)))
+			{
+				continue;
+			}
+
+			for (uint32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				const uint32 SourcePitch = RowBytes + (Frame % 2) * 16;
+				TArray<uint8>& Pixels = Frames.AddDefaulted_GetRef();
+				Pixels.SetNumUninitialized(SourcePitch * Height);
+				for (uint8& Byte : Pixels)
+				{
+					Byte = (uint8)Random.RandHelper(256);
+				}
+
+				TestTrue(*FString::Printf(TEXT("%s appends frame %u"), *FormatName, Frame), Writer.AppendFrame(Pixels.GetData(), SourcePitch, Frame * 10, Frame * 0.5));
+			}
+		}
+
+		FGraphicToolsRawCaptureReader Reader;
+		if (!TestTrue(*FString::Printf(TEXT("%s opens for reading"), *FormatName), Reader.Open(Path)))
+		{
+			continue;
+		}
+
+		TestEqual(*FString::Printf(TEXT("%s frame count"), *FormatName), Reader.GetNumFrames(), (uint64)NumFrames);
+		TestEqual(*FString::Printf(TEXT("%s file pixel format"), *FormatName), (int32)Reader.GetHeader().PixelFormat, (int32)Format);
+		TestEqual(*FString::Printf(TEXT("%s width"), *FormatName), (int32)Reader.GetHeader().Width, (int32)Width);
+		TestEqual(*FString::Printf(TEXT("%s height"), *FormatName), (int32)Reader.GetHeader().Height, (int32)Height);
+
+		for (uint32 Frame = 0; Frame < FMath::Min<uint64>(NumFrames, Reader.GetNumFrames()); ++Frame)
+		{
+			const FGraphicToolsRawCaptureFrameHeader* FrameHeader = Reader.GetFrameHeader(Frame);
+			TestEqual(*FString::Printf(TEXT("%s frame %u index"), *FormatName, Frame), FrameHeader->FrameIndex, (uint64)Frame * 10);
+			TestEqual(*FString::Printf(TEXT("%s frame %u capture time"), *FormatName, Frame), FrameHeader->CaptureSeconds, Frame * 0.5);
+			if (!TestEqual(*FString::Printf(TEXT("%s frame %u row pitch"), *FormatName, Frame), (int32)FrameHeader->RowPitch, (int32)RowBytes))
+			{
+				continue;
+			}
+
+			const uint32 SourcePitch = RowBytes + (Frame % 2) * 16;
+			const uint8* Pixels = Reader.GetFramePixels(Frame);
+			int32 NumMismatchedRows = 0;
+			for (uint32 Row = 0; Row < Height; ++Row)
+			{
+				NumMismatchedRows += FMemory::Memcmp(Pixels + Row * FrameHeader->RowPitch, Frames[Frame].GetData() + Row * SourcePitch, RowBytes) != 0 ? 1 : 0;
+			}
+			TestEqual(*FString::Printf(TEXT("%s frame %u mismatched rows"), *FormatName, Frame), NumMismatchedRows, 0);
+		}
+	}
+
+	IFileManager::Get().Delete(*Path);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
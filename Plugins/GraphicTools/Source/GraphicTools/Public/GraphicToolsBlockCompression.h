@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "RHIDefinitions.h"
+#include "GraphicToolsBlockCompression.generated.h"
+
+class UTexture2D;
+class UTextureRenderTarget2D;
+
+UENUM(BlueprintType)
+enum class EGraphicToolsBlockFormat : uint8
+{
+	/** RGB, 4 bits per pixel */
+	BC1,
+	/** RGBA, 8 bits per pixel */
+	BC3,
+	/** Two linear channels, red and green, 8 bits per pixel. For normals and masks */
+	BC5,
+	/** RGBA, 8 bits per pixel, the best quality of the four */
+	BC7,
+};
+
+/**
+ * Bakes render targets into block compressed textures at runtime. A compute shader encodes one 4x4 block per
+ * thread into a texture with one texel per block, which is then copied into the compressed texture without
+ * leaving the GPU. Where there is no compute the target is read back and encoded on the CPU, and CompressPixels
+ * encodes pixels that never were on the GPU, for processes running without one.
+ *
+ * The encoders favor speed: endpoints come from the block's bounding box and BC7 always uses mode 6, which
+ * still beats BC3 on smooth content. Colors are stored as sRGB, BC5 as linear. Sizes must be multiples of 4
+ * and only the first mip is written. GraphicTools.Benchmark.BlockCompression reports quality and speed, the
+ * GraphicTools.BlockCompression.QualityAndSpeed automation test holds the quality to a floor.
+ */
+class GRAPHICTOOLS_API FGraphicToolsBlockCompression
+{
+public:
+	static EPixelFormat GetPixelFormat(EGraphicToolsBlockFormat Format);
+
+	/** 8 for BC1, 16 for the others */
+	static int32 GetBlockBytes(EGraphicToolsBlockFormat Format);
+
+	/** The texture is created at once and filled a few frames later on the render thread. nullptr without a GPU */
+	static UTexture2D* CompressRenderTarget(UTextureRenderTarget2D* Source, EGraphicToolsBlockFormat Format, ERHIFeatureLevel::Type FeatureLevel);
+
+	/** Encodes on the CPU before returning, works with or without a GPU. Pixels are linear, Size.X * Size.Y of them */
+	static UTexture2D* CompressPixels(const TArray<FLinearColor>& Pixels, FIntPoint Size, EGraphicToolsBlockFormat Format);
+
+	/** The CPU encoder, the compute shader's encoders ported line by line. Blocks in rows, GetBlockBytes each */
+	static void EncodeBlocks(const FLinearColor* Pixels, FIntPoint Size, EGraphicToolsBlockFormat Format, TArray<uint8>& OutBlocks);
+
+	/** Decodes what EncodeBlocks writes into the values stored, so sRGB for colors. BC7 decodes mode 6 only */
+	static void DecodeBlocks(const uint8* Blocks, FIntPoint Size, EGraphicToolsBlockFormat Format, TArray<FLinearColor>& OutPixels);
+
+	/** Peak signal to noise ratio of Blocks against the linear Reference, in dB over the channels Format stores */
+	static double ComputePSNR(const FLinearColor* Reference, const uint8* Blocks, FIntPoint Size, EGraphicToolsBlockFormat Format);
+};
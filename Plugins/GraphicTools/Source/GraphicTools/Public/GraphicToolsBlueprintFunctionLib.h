@@ -3,6 +3,10 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "GraphicToolsBlockCompression.h"
+#include "GraphicToolsImageOperators.h"
+#include "GraphicToolsImageStatistics.h"
+#include "GraphicToolsRenderTargetResolution.h"
 #include "GraphicToolsBlueprintFunctionLib.generated.h"
 
 UCLASS(MinimalAPI, meta = (ScriptName = "GraphicTools"))
@@ -15,10 +19,99 @@ public:
 	{
 	}
 
+	/**
+	 * Format is what the pass writes. A render target created at runtime is recreated in it, an asset in another
+	 * format is left alone and nothing is drawn. The pattern is in [0, 1], so the 4 byte formats halve the
+	 * bandwidth and memory of FloatRGBA.
+	 */
 	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
 	static void DrawCheckerBoard(
 		const UObject* WorldContextObject,
-		class UTextureRenderTarget2D* OutputRenderTarget
+		class UTextureRenderTarget2D* OutputRenderTarget,
+		EGraphicToolsOutputFormat Format = EGraphicToolsOutputFormat::FloatRGBA
 	);
+
+	/** Separable blur, Source and Destination must be the same size and may be the same render target. Sigma <= 0 picks Radius / 2 */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
+	static void BlurRenderTarget(
+		const UObject* WorldContextObject,
+		class UTextureRenderTarget2D* Source,
+		class UTextureRenderTarget2D* Destination,
+		EGraphicToolsBlurKernel Kernel = EGraphicToolsBlurKernel::Gaussian,
+		int32 Radius = 4,
+		float Sigma = 0.0f
+	);
+
+	/** 2x2 box downsample, Destination must be half the size of Source */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
+	static void DownsampleRenderTarget(
+		const UObject* WorldContextObject,
+		class UTextureRenderTarget2D* Source,
+		class UTextureRenderTarget2D* Destination
+	);
+
+	/** Rebuilds the mip chain of a render target created with Auto Generate Mips */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
+	static void GenerateRenderTargetMips(
+		const UObject* WorldContextObject,
+		class UTextureRenderTarget2D* Target
+	);
+
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
+	static void ConvertRenderTargetColorSpace(
+		const UObject* WorldContextObject,
+		class UTextureRenderTarget2D* Source,
+		class UTextureRenderTarget2D* Destination,
+		EGraphicToolsColorConversion Conversion
+	);
+
+	/** Resamples Source to whatever size Destination is */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
+	static void ResizeRenderTarget(
+		const UObject* WorldContextObject,
+		class UTextureRenderTarget2D* Source,
+		class UTextureRenderTarget2D* Destination,
+		EGraphicToolsResizeFilter Filter = EGraphicToolsResizeFilter::Bilinear
+	);
+
+	/**
+	 * Reduces Target to its min, max, mean and histograms on the GPU. Only the statistics are read back,
+	 * OnComputed fires a few frames later. Histograms span [0, HistogramMax].
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
+	static void ComputeRenderTargetStatistics(
+		const UObject* WorldContextObject,
+		class UTextureRenderTarget2D* Target,
+		float HistogramMax,
+		FOnGraphicToolsStatisticsComputed OnComputed
+	);
+
+	/**
+	 * Bakes Source into a new block compressed texture, 16x (BC1) or 8x (the others) smaller than RGBA16F.
+	 * The texture is filled on the GPU a few frames later. Source's size must be a multiple of 4.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (WorldContext = "WorldContextObject"))
+	static class UTexture2D* CompressRenderTarget(
+		const UObject* WorldContextObject,
+		class UTextureRenderTarget2D* Source,
+		EGraphicToolsBlockFormat Format = EGraphicToolsBlockFormat::BC7
+	);
+
+	/**
+	 * Resizes Target with the on-screen size of Surface, and of the other surfaces it was managed with, between
+	 * its current size and MinSize. OnResized fires after each resize, the contents are undefined then and it is
+	 * where Target is drawn again. See FGraphicToolsRenderTargetResolution.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools")
+	static void ManageRenderTargetResolution(
+		class UTextureRenderTarget2D* Target,
+		class UPrimitiveComponent* Surface,
+		FGraphicToolsScreenSizeSettings Settings,
+		FOnGraphicToolsRenderTargetResized OnResized
+	);
+
+	/** Target keeps the size it has */
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools")
+	static void StopManagingRenderTargetResolution(class UTextureRenderTarget2D* Target);
 };
 
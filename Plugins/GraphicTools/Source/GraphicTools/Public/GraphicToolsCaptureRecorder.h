@@ -0,0 +1,123 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "UObject/GCObject.h"
+
+class UTextureRenderTarget2D;
+struct FGraphicToolsCaptureState;
+
+enum class EGraphicToolsCaptureFileFormat : uint8
+{
+	PNG,
+	Bitmap,
+	/** Every frame in one preallocated <Directory>/<BaseName>.gtcap, see FGraphicToolsRawCaptureReader */
+	Raw,
+};
+
+/** What the recorder does when frames come in faster than they are written */
+enum class EGraphicToolsCaptureBackpressure : uint8
+{
+	/** Keeps the capture cadence, frames that don't fit are dropped and counted */
+	Drop,
+	/** Keeps every frame it captures, later captures are held back until there is room */
+	Throttle,
+};
+
+struct FGraphicToolsCaptureSettings
+{
+	/** Files are named <Directory>/<BaseName>_<Frame>.<ext>, frames numbered from 0. Empty is Saved/Screenshots/Captures */
+	FString Directory;
+	FString BaseName = TEXT("Capture");
+	EGraphicToolsCaptureFileFormat FileFormat = EGraphicToolsCaptureFileFormat::PNG;
+
+	/** Frames a Raw file has room for, it is sized for all of them when recording starts */
+	int32 RawFrameCapacity = 600;
+
+	/** Capture every Nth tick */
+	int32 FrameInterval = 1;
+
+	/** Copies from the GPU in flight at once */
+	int32 NumReadbackBuffers = 3;
+
+	/** Frames encoded in parallel on worker threads */
+	int32 NumEncoders = 2;
+
+	/** Readback buffers plus frames waiting to be encoded never take more than this */
+	int64 MemoryBudgetBytes = 256 * 1024 * 1024;
+
+	EGraphicToolsCaptureBackpressure Backpressure = EGraphicToolsCaptureBackpressure::Drop;
+};
+
+struct FGraphicToolsCaptureStats
+{
+	int32 Captured = 0;
+	int32 Written = 0;
+	int32 Failed = 0;
+	/** Captures skipped because every readback buffer was busy */
+	int32 DroppedNoReadback = 0;
+	/** Frames read back but dropped because the encoders or the memory budget were full */
+	int32 DroppedOverBudget = 0;
+	/** Ticks a capture was held back, Throttle only */
+	int32 Throttled = 0;
+	int64 PeakBytes = 0;
+};
+
+/**
+ * Records a render target to numbered image files while it runs. Every FrameInterval ticks the target is
+ * copied into one of a fixed ring of GPU readback buffers, after the jobs FGraphicToolsGPUScheduler still holds for
+ * it. Finished copies are taken off the GPU in order and
+ * handed to worker threads that encode and write them, so neither the game nor the render thread waits on the
+ * GPU or the disk. Pixel data in flight stays within MemoryBudgetBytes; what happens beyond that is up to
+ * Backpressure and shows in the stats.
+ *
+ * B8G8R8A8, R8G8B8A8 and FloatRGBA targets can be written as images, float targets as sRGB. Raw files store
+ * the texels untouched and take any format GraphicToolsRawCapture::FromPixelFormat knows.
+ * GraphicTools.Capture.Start and GraphicTools.Capture.Stop record from the console.
+ */
+class GRAPHICTOOLS_API FGraphicToolsCaptureRecorder : public FGCObject, public FTickableGameObject
+{
+public:
+	FGraphicToolsCaptureRecorder(UTextureRenderTarget2D* InTarget, const FGraphicToolsCaptureSettings& InSettings);
+
+	/** Stops and writes out everything already captured */
+	virtual ~FGraphicToolsCaptureRecorder();
+
+	/** Returns false if the target can't be recorded with these settings */
+	bool Start();
+
+	/** Stops capturing, frames already captured are still written */
+	void Stop();
+
+	bool IsRecording() const { return bRecording; }
+
+	/** Blocks until every captured frame has been written or dropped */
+	void Flush();
+
+	FGraphicToolsCaptureStats GetStats() const;
+
+	// FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FGraphicToolsCaptureRecorder"); }
+	// End of FGCObject interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FGraphicToolsCaptureRecorder, STATGROUP_Tickables); }
+	// End of FTickableGameObject interface
+
+private:
+	void Poll();
+
+	UTextureRenderTarget2D* Target;
+	FGraphicToolsCaptureSettings Settings;
+
+	/** Shared with the render thread and the encoders, which may outlive the recorder */
+	TSharedRef<FGraphicToolsCaptureState, ESPMode::ThreadSafe> State;
+
+	bool bRecording = false;
+	bool bCaptureHeldBack = false;
+	int32 TicksSinceCapture = 0;
+	int32 NextFrameIndex = 0;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphicToolsImageOperators.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "GraphicToolsGPUCompletion.generated.h"
+
+class UTextureRenderTarget2D;
+
+/**
+ * Tells the game thread when the GPU is done with work that was enqueued. Notify writes a GPU fence after
+ * every render command enqueued so far, and after the jobs FGraphicToolsGPUScheduler still holds once they are
+ * out. The fences are polled once per frame and OnCompleted runs on the game thread a frame or two after the GPU
+ * passes its fence. Nothing ever waits, on either thread.
+ */
+class GRAPHICTOOLS_API FGraphicToolsGPUCompletion
+{
+public:
+	/** Game thread. Without a GPU OnCompleted still runs, on the next tick */
+	static void Notify(TFunction<void()>&& OnCompleted);
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FGraphicToolsGPUWorkCompleted);
+
+/**
+ * Async versions of the fire-and-forget nodes: the node returns at once and OnCompleted fires once the GPU has
+ * finished the work, so it can be chained across frames without FlushRenderingCommands or a fixed delay.
+ * Other modules add nodes by subclassing and creating their actions with Create.
+ */
+UCLASS()
+class GRAPHICTOOLS_API UGraphicToolsGPUAsyncAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintAssignable)
+	FGraphicToolsGPUWorkCompleted OnCompleted;
+
+	UFUNCTION(BlueprintCallable, Category = "SLSGraphicTools", meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"))
+	static UGraphicToolsGPUAsyncAction* DrawCheckerBoardAsync(
+		const UObject* WorldContextObject,
+		UTextureRenderTarget2D* OutputRenderTarget,
+		EGraphicToolsOutputFormat Format = EGraphicToolsOutputFormat::FloatRGBA
+	);
+
+	/** Work runs on the game thread when the node activates and enqueues the render commands to wait for */
+	template<typename ActionType>
+	static ActionType* Create(const UObject* WorldContextObject, TFunction<void()>&& Work)
+	{
+		return CreateSpanningFrames<ActionType>(WorldContextObject, [Work = MoveTemp(Work)](TFunction<void()>&& OnEnqueued)
+		{
+			Work();
+			OnEnqueued();
+		});
+	}
+
+	/** For work enqueued over several frames, Work calls OnEnqueued on the game thread once the last of it is */
+	template<typename ActionType>
+	static ActionType* CreateSpanningFrames(const UObject* WorldContextObject, TFunction<void(TFunction<void()>&& OnEnqueued)>&& Work)
+	{
+		ActionType* Action = NewObject<ActionType>();
+		Action->Work = MoveTemp(Work);
+		Action->RegisterWithGameInstance(WorldContextObject);
+		return Action;
+	}
+
+	// UBlueprintAsyncActionBase interface
+	virtual void Activate() override;
+	// End of UBlueprintAsyncActionBase interface
+
+private:
+	TFunction<void(TFunction<void()>&&)> Work;
+};
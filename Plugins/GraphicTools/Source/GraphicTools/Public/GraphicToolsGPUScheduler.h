@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "GraphicToolsGPUScheduler.generated.h"
+
+class FRHICommandListImmediate;
+
+/** False on dedicated servers and -nullrhi processes, which have no GPU to dispatch to; every entry point no-ops there */
+GRAPHICTOOLS_API bool CanDispatchGPUWork();
+
+/**
+ * Render thread. Times Work over Iterations runs with GPU timestamps, after one untimed run to warm the pool and
+ * shader cache, and waits for the GPU to finish. Returns milliseconds per run, for benchmarks only.
+ */
+GRAPHICTOOLS_API float TimeOnGPU(FRHICommandListImmediate& RHICmdList, int32 Iterations, TFunctionRef<void()> Work);
+
+UENUM(BlueprintType)
+enum class EGraphicToolsGPUJobPriority : uint8
+{
+	/** Procedural work that waits for a frame with headroom left once the normal jobs are in */
+	Low,
+	/** Runs within the frame budget, in submission order */
+	Normal,
+	/** Enqueued at once, outside the budget */
+	High,
+};
+
+/** A unit of render thread work for FGraphicToolsGPUScheduler */
+struct FGraphicToolsGPUJob
+{
+	/** The kind of work, jobs of a kind share one estimate of their GPU cost */
+	FName Name;
+
+	TUniqueFunction<void(FRHICommandListImmediate&)> Work;
+
+	EGraphicToolsGPUJobPriority Priority = EGraphicToolsGPUJobPriority::Normal;
+
+	/** Frames the job may be deferred for, after them it runs whatever the budget */
+	int32 MaxDelayFrames = 8;
+
+	/**
+	 * The objects the job reads or writes, such as its source textures and render targets. Jobs sharing one run in
+	 * the order they were submitted whatever their priorities: a job going out takes the earlier ones along.
+	 */
+	TArray<FObjectKey, TInlineAllocator<4>> Objects;
+
+	/**
+	 * The object the job overwrites in full without reading it, when set, and one of its objects. The last job queued with the same key
+	 * is replaced where it stands when no job queued after it uses the new job's objects, so a burst of calls
+	 * drawing the same render target costs one pass.
+	 */
+	FObjectKey CoalesceKey;
+};
+
+/**
+ * Spreads the GPU work of both plugins' nodes over frames. Jobs queue on the game thread and once a frame the
+ * scheduler enqueues as many as fit in GraphicTools.Scheduler.BudgetMs: jobs past their deadline and high
+ * priority ones first, then normal ones, then low ones while there is headroom left. What a job costs is
+ * measured with GPU timestamps around its work and averaged per job name, without waiting on the GPU.
+ *
+ * Jobs of the same priority run in the order they were submitted, and so do jobs sharing an object whatever
+ * their priorities. Jobs capture render target resources, so everything queued goes out before garbage
+ * collection, and code recreating a render target's resource calls Flush first.
+ * GraphicTools.Scheduler.Stats logs the queue and the estimates.
+ */
+class GRAPHICTOOLS_API FGraphicToolsGPUScheduler
+{
+public:
+	/** Game thread */
+	static void Submit(FGraphicToolsGPUJob&& Job);
+
+	/** Game thread. Callback runs once every job submitted so far is enqueued on the render thread, at once if none is queued */
+	static void CallWhenSubmitted(TFunction<void()>&& Callback);
+
+	/** Game thread. Enqueues every queued job now, for callers about to wait on the render thread */
+	static void Flush();
+};
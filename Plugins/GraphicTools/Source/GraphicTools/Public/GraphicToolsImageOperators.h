@@ -0,0 +1,144 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "RHIDefinitions.h"
+#include "UObject/ObjectKey.h"
+#include "GraphicToolsImageOperators.generated.h"
+
+class FTextureRenderTargetResource;
+class UTextureRenderTarget2D;
+
+UENUM(BlueprintType)
+enum class EGraphicToolsBlurKernel : uint8
+{
+	Gaussian,
+	Box,
+};
+
+UENUM(BlueprintType)
+enum class EGraphicToolsColorConversion : uint8
+{
+	LinearToSRGB,
+	SRGBToLinear,
+	RGBToYCoCg,
+	YCoCgToRGB,
+	RGBToHSV,
+	HSVToRGB,
+	/** Rec. 709 luminance in all three channels */
+	Luminance,
+};
+
+UENUM(BlueprintType)
+enum class EGraphicToolsResizeFilter : uint8
+{
+	Point,
+	Bilinear,
+};
+
+/** What the generator passes write, each through a typed UAV of its own */
+UENUM(BlueprintType)
+enum class EGraphicToolsOutputFormat : uint8
+{
+	/** 4 bytes per pixel, [0, 1] */
+	R8G8B8A8,
+	/** 4 bytes per pixel, [0, 1] with 10 bits per color and 2 bits of alpha */
+	R10G10B10A2,
+	/** 4 bytes per pixel, positive floats and no alpha */
+	R11G11B10F,
+	/** 8 bytes per pixel */
+	FloatRGBA,
+};
+
+/** Values of EGraphicToolsOutputFormat, the generator passes have a typed UAV permutation for each */
+static const int32 GraphicToolsNumOutputFormats = 4;
+
+/** The pixel format a pass writing Format allocates, /Plugin/GraphicTools/Private/OutputFormat.ush declares its UAV */
+GRAPHICTOOLS_API EPixelFormat GetOutputPixelFormat(EGraphicToolsOutputFormat Format);
+
+/** The output format that writes Format, false if the generator passes can't write it */
+GRAPHICTOOLS_API bool FindOutputFormat(EPixelFormat Format, EGraphicToolsOutputFormat& OutFormat);
+
+/**
+ * Whether a pass writing Format can draw into Target. A render target created at runtime is switched to the
+ * format, keeping its gamma; an asset is never rewritten, one in another format is rejected with a warning.
+ */
+GRAPHICTOOLS_API bool PrepareOutputRenderTarget(UTextureRenderTarget2D* Target, EGraphicToolsOutputFormat Format, const TCHAR* NodeName);
+
+/** What a single image operation does, independent of the textures it runs on */
+struct FGraphicToolsImageOperation
+{
+	enum class EType : uint8
+	{
+		Blur,
+		Downsample,
+		GenerateMips,
+		ColorConvert,
+		Resize,
+	};
+
+	EType Type = EType::Blur;
+	EGraphicToolsBlurKernel BlurKernel = EGraphicToolsBlurKernel::Gaussian;
+	int32 BlurRadius = 0;
+	float BlurSigma = 0.0f;
+	EGraphicToolsColorConversion ColorConversion = EGraphicToolsColorConversion::LinearToSRGB;
+	EGraphicToolsResizeFilter ResizeFilter = EGraphicToolsResizeFilter::Bilinear;
+};
+
+/**
+ * Compute image operators on render targets. Operations are recorded on the game thread and all run in order
+ * from a single render command on Submit, sharing intermediate textures from the render target pool:
+ *
+ *   FGraphicToolsImageBatch Batch(FeatureLevel);
+ *   Batch.Downsample(Scene, Half);
+ *   Batch.Blur(Half, Half, EGraphicToolsBlurKernel::Gaussian, 8);
+ *   Batch.GenerateMips(Half);
+ *   Batch.Submit();
+ *
+ * Invalid operations are logged and dropped when recorded. GraphicTools.Benchmark.ImageOperators compares the
+ * operators against naive implementations.
+ */
+class GRAPHICTOOLS_API FGraphicToolsImageBatch
+{
+public:
+	/** Widest blur radius the shared memory tile has room for */
+	static const int32 MaxBlurRadius = 32;
+
+	explicit FGraphicToolsImageBatch(ERHIFeatureLevel::Type InFeatureLevel);
+
+	/** Separable blur, Source and Destination must be the same size and may be the same target. Sigma <= 0 picks Radius / 2 */
+	bool Blur(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsBlurKernel Kernel, int32 Radius, float Sigma = 0.0f);
+
+	/** 2x2 box downsample, Destination must be half the size of Source (rounded down, at least 1) */
+	bool Downsample(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination);
+
+	/** Rebuilds the whole mip chain of Target from its top level, Target must have been created with mips */
+	bool GenerateMips(UTextureRenderTarget2D* Target);
+
+	/** Source and Destination must be the same size and may be the same target */
+	bool ConvertColorSpace(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsColorConversion Conversion);
+
+	/** Resamples Source to whatever size Destination is */
+	bool Resize(UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination, EGraphicToolsResizeFilter Filter);
+
+	/** Enqueues everything recorded so far in a single render command and empties the batch */
+	void Submit();
+
+	int32 Num() const { return Operations.Num(); }
+
+private:
+	struct FRecordedOperation
+	{
+		FGraphicToolsImageOperation Operation;
+		FTextureRenderTargetResource* Source;
+		FTextureRenderTargetResource* Destination;
+	};
+
+	bool Record(const FGraphicToolsImageOperation& Operation, UTextureRenderTarget2D* Source, UTextureRenderTarget2D* Destination);
+
+	ERHIFeatureLevel::Type FeatureLevel;
+	TArray<FRecordedOperation> Operations;
+
+	/** The render targets the recorded operations read and write, which order the batch against other jobs */
+	TArray<FObjectKey> Objects;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHIDefinitions.h"
+#include "GraphicToolsImageStatistics.generated.h"
+
+class UTextureRenderTarget2D;
+
+/** Statistics of a render target's RGB channels, reduced on the GPU */
+USTRUCT(BlueprintType)
+struct FGraphicToolsImageStatistics
+{
+	GENERATED_BODY()
+
+	/** Per channel minimum, alpha isn't reduced and is always 1 */
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	FLinearColor Min = FLinearColor::Black;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	FLinearColor Max = FLinearColor::Black;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	FLinearColor Mean = FLinearColor::Black;
+
+	/** Rec. 709 luminance */
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	float MinLuminance = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	float MaxLuminance = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	float MeanLuminance = 0.0f;
+
+	/** Pixel counts over [0, HistogramMax], values past either end land in the first or last bin */
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	TArray<int32> RedHistogram;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	TArray<int32> GreenHistogram;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	TArray<int32> BlueHistogram;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	TArray<int32> LuminanceHistogram;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	float HistogramMax = 1.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "SLSGraphicTools")
+	int32 NumPixels = 0;
+};
+
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnGraphicToolsStatisticsComputed, const FGraphicToolsImageStatistics&, Statistics);
+
+/**
+ * Reduces a render target to its statistics on the GPU: one pass of 64x64 tiles (wave intrinsics where the
+ * platform has them, a shared memory tree otherwise) and one pass folding the tiles together. Only the result,
+ * a few hundred bytes, is read back, asynchronously, and handed to the callback on the game thread a few
+ * frames later.
+ */
+class GRAPHICTOOLS_API FGraphicToolsImageStatisticsReduction
+{
+public:
+	static const int32 NumHistogramBins = 32;
+
+	/** Bytes read back per query */
+	static const int32 ResultBytes = (12 + 4 * NumHistogramBins) * sizeof(uint32);
+
+	/** Returns false if nothing was queued, OnComputed is never called then */
+	static bool Request(
+		UTextureRenderTarget2D* Target,
+		ERHIFeatureLevel::Type FeatureLevel,
+		float HistogramMax,
+		TFunction<void(const FGraphicToolsImageStatistics&)>&& OnComputed
+	);
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/** Pixel formats as stored in a raw capture, numbered independently of EPixelFormat so files outlive engine versions */
+enum class EGraphicToolsRawPixelFormat : uint32
+{
+	Unknown = 0,
+	B8G8R8A8 = 1,
+	R8G8B8A8 = 2,
+	A2B10G10R10 = 3,
+	/** RGBA, 16 bit float per channel */
+	FloatRGBA = 4,
+	/** RGBA, 32 bit float per channel */
+	A32B32G32R32F = 5,
+	R32Float = 6,
+	G8 = 7,
+};
+
+/**
+ * A raw capture file is one of these followed by FrameCapacity slots of FrameStride bytes each, all
+ * preallocated when the file is created. Slot N starts at HeaderBytes + N * FrameStride with a frame header
+ * and the frame's pixels follow at PixelOffset from there, Height rows of RowPitch bytes with no padding.
+ * Everything is little endian and the layout is fixed, so tools can map the file and index frames directly.
+ */
+struct FGraphicToolsRawCaptureFileHeader
+{
+	static const uint32 ExpectedMagic = 0x43525447; // "GTRC"
+	static const uint32 CurrentVersion = 1;
+
+	uint32 Magic = ExpectedMagic;
+	uint32 Version = CurrentVersion;
+	uint32 HeaderBytes = 0;
+	uint32 FrameHeaderBytes = 0;
+	uint64 FrameStride = 0;
+	uint64 FrameCapacity = 0;
+
+	/** Slots written so far, updated after every frame */
+	uint64 NumFrames = 0;
+
+	EGraphicToolsRawPixelFormat PixelFormat = EGraphicToolsRawPixelFormat::Unknown;
+	uint32 BytesPerPixel = 0;
+	uint32 Width = 0;
+	uint32 Height = 0;
+	uint32 RowPitch = 0;
+	uint32 Reserved = 0;
+};
+
+struct FGraphicToolsRawCaptureFrameHeader
+{
+	EGraphicToolsRawPixelFormat PixelFormat = EGraphicToolsRawPixelFormat::Unknown;
+	uint32 Width = 0;
+	uint32 Height = 0;
+	uint32 RowPitch = 0;
+
+	/** The frame's number in the recording, slots fill in the order frames finish so the two may differ */
+	uint64 FrameIndex = 0;
+
+	/** From the start of the slot */
+	uint64 PixelOffset = 0;
+
+	/** FPlatformTime::Seconds() when the frame was captured and when it was written */
+	double CaptureSeconds = 0.0;
+	double WriteSeconds = 0.0;
+
+	uint64 Reserved[2] = {};
+};
+
+static_assert(sizeof(FGraphicToolsRawCaptureFileHeader) == 64, "The raw capture file header is part of the file format");
+static_assert(sizeof(FGraphicToolsRawCaptureFrameHeader) == 64, "The raw capture frame header is part of the file format");
+
+namespace GraphicToolsRawCapture
+{
+	/** Unknown when Format can't be stored */
+	GRAPHICTOOLS_API EGraphicToolsRawPixelFormat FromPixelFormat(EPixelFormat Format);
+	GRAPHICTOOLS_API EPixelFormat ToPixelFormat(EGraphicToolsRawPixelFormat Format);
+	GRAPHICTOOLS_API uint32 GetBytesPerPixel(EGraphicToolsRawPixelFormat Format);
+}
+
+/** Appends frames to a raw capture file. Thread safe, frames may be appended from several threads at once */
+class GRAPHICTOOLS_API FGraphicToolsRawCaptureWriter
+{
+public:
+	FGraphicToolsRawCaptureWriter();
+	~FGraphicToolsRawCaptureWriter();
+
+	/** Creates or replaces the file at Path and reserves room for FrameCapacity frames */
+	bool Open(const FString& Path, EGraphicToolsRawPixelFormat Format, uint32 Width, uint32 Height, uint64 FrameCapacity);
+	void Close();
+
+	bool IsOpen() const { return File.IsValid(); }
+
+	/** Copies Height rows of SourcePitch bytes into the next free slot, returns false once the file is full */
+	bool AppendFrame(const uint8* Pixels, uint32 SourcePitch, uint64 FrameIndex, double CaptureSeconds);
+
+	uint64 GetNumFrames() const;
+	const FGraphicToolsRawCaptureFileHeader& GetHeader() const { return Header; }
+
+private:
+	FCriticalSection CriticalSection;
+	TUniquePtr<IFileHandle> File;
+	FGraphicToolsRawCaptureFileHeader Header;
+};
+
+/** Reads a raw capture file through a memory mapping where the platform has one, frames are never copied */
+class GRAPHICTOOLS_API FGraphicToolsRawCaptureReader
+{
+public:
+	FGraphicToolsRawCaptureReader();
+	~FGraphicToolsRawCaptureReader();
+
+	/** Validates the headers, returns false and logs why if the file isn't a readable capture */
+	bool Open(const FString& Path);
+	void Close();
+
+	const FGraphicToolsRawCaptureFileHeader& GetHeader() const { return Header; }
+	uint64 GetNumFrames() const { return Header.NumFrames; }
+
+	/** nullptr past NumFrames, pointers stay valid until the reader is closed */
+	const FGraphicToolsRawCaptureFrameHeader* GetFrameHeader(uint64 Frame) const;
+	const uint8* GetFramePixels(uint64 Frame) const;
+
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** The whole file, only where it can't be mapped */
+	TArray64<uint8> LoadedFile;
+
+	const uint8* Data = nullptr;
+	uint64 DataSize = 0;
+	FGraphicToolsRawCaptureFileHeader Header;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphicToolsRenderTargetResolution.generated.h"
+
+class UPrimitiveComponent;
+class UTextureRenderTarget2D;
+
+/** How a managed render target follows the size its surfaces take on screen */
+USTRUCT(BlueprintType)
+struct FGraphicToolsScreenSizeSettings
+{
+	GENERATED_BODY()
+
+	/** Texels the target gets per screen pixel its largest surface spans, raise it for textures tiled across a surface */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "SLSGraphicTools")
+	float TexelsPerPixel = 1.0f;
+
+	/** Longest edge the target is ever shrunk to, also its size while none of its surfaces is rendered */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "SLSGraphicTools")
+	int32 MinSize = 32;
+
+	/** Seconds a target has to fit a smaller size before it shrinks. It grows as soon as it is too small */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "SLSGraphicTools")
+	float ShrinkDelay = 1.0f;
+};
+
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnGraphicToolsRenderTargetResized, UTextureRenderTarget2D*, Target);
+
+/**
+ * Sizes render targets by how large the surfaces showing them are on screen. A target's size when it is first
+ * registered is its largest, it only ever takes that size halved some number of times, so a power-of-two asset
+ * stays power of two. Once a frame the bounds of each target's surfaces are projected into the first local
+ * player's view and the target is given the smallest of those sizes that covers the largest of them. Targets
+ * whose surfaces weren't rendered recently drop to MinSize.
+ *
+ * Targets grow at once and shrink only when the smaller size has fitted with a quarter to spare for
+ * ShrinkDelay seconds, so a surface hovering around a boundary doesn't reallocate every frame. When all the
+ * managed targets together would take more than GraphicTools.RenderTargets.BudgetMB the largest are halved
+ * until they fit. A resized target's contents are undefined, OnResized is where it is drawn again.
+ * GraphicTools.RenderTargets.Stats logs the managed targets.
+ *
+ * Targets and surfaces are held weakly, a target is dropped once it or all of its surfaces are gone.
+ */
+class GRAPHICTOOLS_API FGraphicToolsRenderTargetResolution
+{
+public:
+	/** Game thread. Registering a target again adds Surface to it and replaces its settings and callback */
+	static void Manage(
+		UTextureRenderTarget2D* Target,
+		UPrimitiveComponent* Surface,
+		const FGraphicToolsScreenSizeSettings& Settings,
+		TFunction<void(UTextureRenderTarget2D*)>&& OnResized
+	);
+
+	/** Game thread. Leaves the target at its current size */
+	static void StopManaging(UTextureRenderTarget2D* Target);
+
+	/** Bytes the managed targets take at their current sizes */
+	static int64 GetManagedBytes();
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphicToolsImageOperators.h"
+#include "RHIDefinitions.h"
+
+class UTextureRenderTarget2D;
+struct FGraphicToolsTextureGraphPlan;
+
+/**
+ * A procedural texture built from a small graph of nodes and evaluated on the GPU:
+ *
+ *   FGraphicToolsTextureGraph Graph;
+ *   const FGraphicToolsTextureGraph::FNodeId Stars = Graph.AddGenerator(Time);
+ *   const FGraphicToolsTextureGraph::FNodeId Tinted = Graph.AddMultiply(Stars, FLinearColor(1.0f, 0.5f, 0.5f));
+ *   const FGraphicToolsTextureGraph::FNodeId Mixed = Graph.AddBlend(Tinted, Graph.AddTexture(Overlay), 0.25f);
+ *   Graph.Execute(Output, Graph.AddBlur(Mixed, 4), FeatureLevel);
+ *
+ * Execute compiles the graph into passes. Chains of per-pixel nodes (generator, multiply, blend) are fused into
+ * a single compute pass, a permutation of TextureGraph.usf specialised for the chain, so nothing is written to
+ * memory between them. Blur reads its neighbours and always starts a new pass, as does a node whose result is
+ * used more than once. Nodes can only take nodes added before them as inputs, so a graph is never cyclic.
+ * GraphicTools.Benchmark.TextureGraph compares fused against one pass per node.
+ */
+class GRAPHICTOOLS_API FGraphicToolsTextureGraph
+{
+public:
+	typedef int32 FNodeId;
+
+	/** Per-pixel stages a fused pass applies after its source */
+	static const int32 MaxFusedStages = 3;
+
+	/** Samples a render target, stretched to the output size */
+	FNodeId AddTexture(UTextureRenderTarget2D* Texture);
+
+	/** The star field of the CheckerBoard shader */
+	FNodeId AddGenerator(float Time = 1.0f);
+
+	FNodeId AddMultiply(FNodeId Input, const FLinearColor& Color);
+
+	/** Lerps from Base towards Layer by Alpha */
+	FNodeId AddBlend(FNodeId Base, FNodeId Layer, float Alpha);
+
+	FNodeId AddBlur(FNodeId Input, int32 Radius, EGraphicToolsBlurKernel Kernel = EGraphicToolsBlurKernel::Gaussian);
+
+	/** Enqueues the passes computing Root into Output, returns how many there are or 0 if nothing was queued */
+	int32 Execute(UTextureRenderTarget2D* Output, FNodeId Root, ERHIFeatureLevel::Type FeatureLevel, bool bFuse = true) const;
+
+	/** Compiles the nodes Root depends on into passes without running them */
+	bool Compile(FNodeId Root, bool bFuse, FGraphicToolsTextureGraphPlan& OutPlan) const;
+
+	int32 Num() const { return Nodes.Num(); }
+
+	void Reset() { Nodes.Reset(); }
+
+private:
+	friend class FTextureGraphCompiler;
+
+	struct FNode
+	{
+		enum class EType : uint8
+		{
+			Texture,
+			Generator,
+			Multiply,
+			Blend,
+			Blur,
+		};
+
+		EType Type = EType::Generator;
+		FNodeId Inputs[2] = { INDEX_NONE, INDEX_NONE };
+		UTextureRenderTarget2D* Texture = nullptr;
+		FLinearColor Color = FLinearColor::White;
+		float Scalar = 0.0f;
+		int32 BlurRadius = 0;
+		EGraphicToolsBlurKernel BlurKernel = EGraphicToolsBlurKernel::Gaussian;
+	};
+
+	FNodeId AddNode(const FNode& Node, const TCHAR* What);
+
+	TArray<FNode> Nodes;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "Tickable.h"
+#include "UObject/GCObject.h"
+
+class FRunnableThread;
+class UTexture2D;
+struct FGraphicToolsUploadStaging;
+
+/**
+ * Streams CPU generated pixels (camera feeds, video, simulation output) into a persistent UTexture2D. Frames
+ * are written into one of a fixed ring of staging buffers and copied into the existing RHI texture with
+ * RHIUpdateTexture2D, only the regions marked dirty, so nothing is allocated or recreated per frame:
+ *
+ *   FGraphicToolsTextureUploader Uploader(FIntPoint(1920, 1080));
+ *   const int32 Buffer = Uploader.BeginWrite();
+ *   if (Buffer != INDEX_NONE)
+ *   {
+ *       FillPixels(Uploader.GetStagingData(Buffer), Uploader.GetStagingPitch());
+ *       Uploader.MarkDirty(Buffer, FIntRect(0, 0, 1920, 64));
+ *       Uploader.EndWrite(Buffer);
+ *   }
+ *
+ * BeginWrite, MarkDirty and EndWrite may be called from any thread, which is what StartProducer does from a
+ * thread of its own. Written buffers are handed to the render thread in order on the next tick, after the jobs
+ * FGraphicToolsGPUScheduler still holds for the texture. When the
+ * producer runs ahead of the GPU BeginWrite finds no free buffer and the frame is dropped, never queued.
+ * GraphicTools.Benchmark.TextureUpload measures the throughput against recreating the texture.
+ */
+class GRAPHICTOOLS_API FGraphicToolsTextureUploader : public FGCObject, public FTickableGameObject
+{
+public:
+	/** Fills a staging buffer, returns false to skip the frame. Regions left empty upload the whole texture */
+	typedef TFunction<bool(uint8* Data, int32 Pitch, TArray<FIntRect>& DirtyRegions)> FProducer;
+
+	explicit FGraphicToolsTextureUploader(FIntPoint Size, EPixelFormat Format = PF_B8G8R8A8, int32 NumStagingBuffers = 3);
+	virtual ~FGraphicToolsTextureUploader();
+
+	UTexture2D* GetTexture() const { return Texture; }
+
+	/** A free staging buffer, or INDEX_NONE when every buffer is queued or uploading */
+	int32 BeginWrite();
+
+	/** Tightly packed rows of Size.X texels, the previous contents of the buffer are undefined */
+	uint8* GetStagingData(int32 Buffer) const;
+	int32 GetStagingPitch() const;
+
+	/** Limits the upload of Buffer to the marked regions, clipped to the texture. Nothing marked uploads all of it */
+	void MarkDirty(int32 Buffer, const FIntRect& Region);
+
+	/** Queues Buffer for upload on the next tick */
+	void EndWrite(int32 Buffer);
+
+	/** Calls Producer in a loop on a worker thread, at most MaxFramesPerSecond times a second */
+	void StartProducer(FProducer&& Producer, float MaxFramesPerSecond = 60.0f);
+	void StopProducer();
+
+	/** Bytes copied into the texture so far */
+	int64 GetUploadedBytes() const;
+
+	/** Frames written, and frames that found no free staging buffer */
+	int32 GetNumUploadedFrames() const;
+	int32 GetNumDroppedFrames() const;
+
+	// FGCObject interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FGraphicToolsTextureUploader"); }
+	// End of FGCObject interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FGraphicToolsTextureUploader, STATGROUP_Tickables); }
+	// End of FTickableGameObject interface
+
+private:
+	UTexture2D* Texture = nullptr;
+
+	/** Shared with the render commands, which may outlive the uploader */
+	TSharedRef<FGraphicToolsUploadStaging, ESPMode::ThreadSafe> Staging;
+
+	class FProducerRunnable;
+	TUniquePtr<FProducerRunnable> ProducerRunnable;
+	TUniquePtr<FRunnableThread> ProducerThread;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FGraphicToolsTracerExtension;
+class UWorld;
+
+/** Boxes a tracer system collides with, the simulation tests every tracer against each of them */
+static const int32 GraphicToolsMaxTracerCollisionBoxes = 256;
+
+/** Defaults match a bouncing UProjectileMovementComponent with the 3000 uu/s of the template projectile */
+struct FGraphicToolsTracerSettings
+{
+	/** Slots on the GPU, spawning into a full system reuses the oldest */
+	int32 MaxTracers = 32768;
+
+	/** Seconds a tracer lives */
+	float Lifetime = 3.0f;
+
+	/** Acceleration in uu/s per second, the world's gravity */
+	FVector Gravity = FVector(0.0f, 0.0f, -980.0f);
+
+	/** Bounciness, Friction and the speed below which a bounce stops the tracer, as UProjectileMovementComponent */
+	float Bounciness = 0.6f;
+	float Friction = 0.2f;
+	float BounceStopSpeed = 5.0f;
+
+	/** Longest step of the simulation in seconds, a longer frame takes several */
+	float MaxSubstepTime = 0.05f;
+
+	/** Half the width of a streak and the distance it is kept from surfaces */
+	float Radius = 2.0f;
+
+	/** A streak trails its tracer by the distance it covers in this many seconds */
+	float StreakSeconds = 0.02f;
+
+	/** Additive HDR color at the head of a streak, it fades along the streak and over the tracer's lifetime */
+	FLinearColor Color = FLinearColor(40.0f, 12.0f, 2.0f);
+};
+
+/**
+ * Cosmetic projectiles simulated and drawn entirely on the GPU, for tens of thousands of tracers where an actor
+ * each would cost a component tick and a collision query. A compute pass integrates every tracer each frame
+ * with the projectile movement's gravity and bounce response, colliding against a set of world-space boxes
+ * instead of the physics scene, and the render pass draws them as velocity-aligned streaks additively into the
+ * scene color of the world's views, depth tested against the scene. Nothing comes back to the CPU, tracers
+ * neither hit nor notify anything.
+ *
+ * The simulation is a high priority FGraphicToolsGPUScheduler job named Tracers. Once no tracer
+ * can be alive any more both passes are skipped.
+ */
+class GRAPHICTOOLS_API FGraphicToolsTracers
+{
+public:
+	/** Game thread. Draws into the views of World's scene */
+	FGraphicToolsTracers(UWorld* World, const FGraphicToolsTracerSettings& InSettings);
+	~FGraphicToolsTracers();
+
+	/** Game thread. The tracer starts simulating on the next Tick */
+	void Spawn(const FVector& Location, const FVector& Velocity);
+
+	/** Game thread. Replaces the boxes tracers bounce off, only the first GraphicToolsMaxTracerCollisionBoxes are kept */
+	void SetCollisionBoxes(const TArray<FBox>& Boxes);
+
+	/** Game thread, once a frame. Spawns what was queued and advances the simulation by DeltaTime */
+	void Tick(float DeltaTime);
+
+	/** Tracers spawned recently enough to be alive, some may have been replaced by newer ones */
+	int32 GetNumLive() const;
+
+	const FGraphicToolsTracerSettings& GetSettings() const { return Settings; }
+
+private:
+	FGraphicToolsTracerSettings Settings;
+
+	TSharedRef<FGraphicToolsTracerExtension, ESPMode::ThreadSafe> Extension;
+
+	/** Location then velocity of each tracer spawned since the last tick */
+	TArray<FVector4> PendingSpawns;
+
+	/** Slot the next spawned tracer takes */
+	int32 NextSlot;
+
+	/** Game time of each tick that spawned tracers, oldest first, and how many it spawned */
+	TArray<TPair<double, int32>> RecentSpawns;
+
+	double Time;
+
+	/** Whether the last tick had the GPU simulate */
+	bool bSimulating;
+};
@@ -4,18 +4,33 @@
  
 #include "Engine/TextureRenderTarget2D.h"  
 #include "Engine/World.h"  
+#include "Materials/MaterialInstanceDynamic.h"
 #include "GlobalShader.h"  
 #include "PipelineStateCache.h"  
 #include "RHIStaticStates.h"  
 #include "SceneUtils.h"  
 #include "SceneInterface.h"  
 #include "ShaderParameterUtils.h"  
+#include "ShaderPermutation.h"
 #include "Logging/MessageLog.h"  
 #include "Internationalization/Internationalization.h"  
 #include "StaticBoundShaderState.h"  
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeBool.h"
+#include "RHIGPUReadback.h"
+#include "RHIUtilities.h"
+#include "RenderTargetPool.h"
+#include "Tickable.h"
+#include "UObject/GCObject.h"
+#include "GraphicToolsGPUScheduler.h"
  
 #define LOCTEXT_NAMESPACE "TestShader"  
 
+DEFINE_LOG_CATEGORY_STATIC(LogShaderTestBenchmark, Log, All);
+
 BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FMyUniformStructData, )
 SHADER_PARAMETER(FVector4, ColorOne)
 SHADER_PARAMETER(FVector4, ColorTwo)
@@ -126,10 +141,126 @@ private:
     LAYOUT_FIELD(FShaderResourceParameter, TestTextureSampler, /*MYMODULE_API*/); 
 };  
 
+// MainPS for up to four render targets at once, see MainMRTPS in MySimpleShader.usf
+class FShaderTestMRTPS : public FMyShaderTest
+{
+    DECLARE_SHADER_TYPE(FShaderTestMRTPS, Global, /*MYMODULE_API*/);
+
+public:
+    FShaderTestMRTPS() {}
+
+    FShaderTestMRTPS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+        : FMyShaderTest(Initializer)
+    {
+        TestTextureVal.Bind(Initializer.ParameterMap, TEXT("MyTexture"));
+        TestTextureSampler.Bind(Initializer.ParameterMap, TEXT("MyTextureSampler"));
+        MRTTints.Bind(Initializer.ParameterMap, TEXT("MRTTints"));
+    }
+
+    static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    {
+        return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+    }
+
+    /** Tints[i] goes to render target i, slots past the bound targets are written nowhere */
+    void SetParameters(
+        FRHICommandListImmediate& RHICmdList,
+        FRHIPixelShader* ShaderRHI,
+        FRHITexture* MyTexture,
+        const TArray<FLinearColor>& Tints)
+    {
+        SetTextureParameter(
+            RHICmdList,
+            ShaderRHI,
+            TestTextureVal,
+            TestTextureSampler,
+            TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI(),
+            MyTexture);
+
+        FLinearColor AllTints[4] = { FLinearColor::Black, FLinearColor::Black, FLinearColor::Black, FLinearColor::Black };
+        for (int32 Index = 0; Index < FMath::Min(Tints.Num(), 4); ++Index)
+        {
+            AllTints[Index] = Tints[Index];
+        }
+        SetShaderValueArray(RHICmdList, ShaderRHI, MRTTints, AllTints, 4);
+    }
+
+private:
+    LAYOUT_FIELD(FShaderResourceParameter, TestTextureVal);
+    LAYOUT_FIELD(FShaderResourceParameter, TestTextureSampler);
+    LAYOUT_FIELD(FShaderParameter, MRTTints);
+};
+
+// MainPS as a compute shader writing through a UAV, see BlitCS in MySimpleShader.usf
+class FShaderTestBlitCS : public FGlobalShader
+{
+    DECLARE_SHADER_TYPE(FShaderTestBlitCS, Global, /*MYMODULE_API*/)
+public:
+    static constexpr int32 GroupSize = 8;
+
+    FShaderTestBlitCS()
+    {
+    }
+    FShaderTestBlitCS(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+        : FGlobalShader(Initializer)
+    {
+        BlitOutput.Bind(Initializer.ParameterMap, TEXT("RWBlitOutput"));
+        BlitSize.Bind(Initializer.ParameterMap, TEXT("BlitSize"));
+        TestTextureVal.Bind(Initializer.ParameterMap, TEXT("MyTexture"));
+        TestTextureSampler.Bind(Initializer.ParameterMap, TEXT("MyTextureSampler"));
+    }
+
+    static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    {
+        return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+    }
+
+    void SetParameters(
+        FRHICommandList& RHICmdList,
+        FRHIUnorderedAccessView* OutputUAV,
+        FIntPoint InBlitSize,
+        FRHITexture* MyTexture,
+        const FMyShaderStructData& ShaderStructData)
+    {
+        FRHIComputeShader* ComputeShaderRHI = RHICmdList.GetBoundComputeShader();
+        RHICmdList.SetUAVParameter(ComputeShaderRHI, BlitOutput.GetUAVIndex(), OutputUAV);
+        SetShaderValue(RHICmdList, ComputeShaderRHI, BlitSize, InBlitSize);
+        SetTextureParameter(
+            RHICmdList,
+            ComputeShaderRHI,
+            TestTextureVal,
+            TestTextureSampler,
+            TStaticSamplerState<SF_Trilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI(),
+            MyTexture);
+
+        FMyUniformStructData UniformData;
+        UniformData.ColorOne = ShaderStructData.ColorOne;
+        UniformData.ColorTwo = ShaderStructData.ColorTwo;
+        UniformData.ColorThree = ShaderStructData.ColorThree;
+        UniformData.ColorFour = ShaderStructData.ColorFour;
+        UniformData.ColorIndex = ShaderStructData.ColorIndex;
+
+        SetUniformBufferParameterImmediate(RHICmdList, ComputeShaderRHI, GetUniformBufferParameter<FMyUniformStructData>(), UniformData);
+    }
+
+    void UnsetParameters(FRHICommandList& RHICmdList)
+    {
+        BlitOutput.UnsetUAV(RHICmdList, RHICmdList.GetBoundComputeShader());
+    }
+private:
+    LAYOUT_FIELD(FRWShaderParameter, BlitOutput);
+    LAYOUT_FIELD(FShaderParameter, BlitSize);
+    LAYOUT_FIELD(FShaderResourceParameter, TestTextureVal);
+    LAYOUT_FIELD(FShaderResourceParameter, TestTextureSampler);
+};
+
 class FMyComputeShader : public FGlobalShader
 {
     DECLARE_SHADER_TYPE(FMyComputeShader, Global, /*MYMODULE_API*/)
 public:
+    class FOutputFormatDim : SHADER_PERMUTATION_INT("OUTPUT_FORMAT", GraphicToolsNumOutputFormats);
+    using FPermutationDomain = TShaderPermutationDomain<FOutputFormatDim>;
+
     FMyComputeShader()
     {
     }
@@ -137,6 +268,8 @@ public:
         : FGlobalShader(Initializer)
     {
         OutputSurface.Bind(Initializer.ParameterMap, TEXT("RWOutputSurface"));
+        TileOffset.Bind(Initializer.ParameterMap, TEXT("TileOffset"));
+        ImageSize.Bind(Initializer.ParameterMap, TEXT("ImageSize"));
     }
 
     static bool ShouldCache(EShaderPlatform Platform)
@@ -147,7 +280,9 @@ public:
     void SetParameters(
         FRHICommandList& RHICmdList,
         FUnorderedAccessViewRHIRef& OutputSurfaceUAV,
-        FMyShaderStructData& ShaderStructData)
+        const FMyShaderStructData& ShaderStructData,
+        FIntPoint InTileOffset,
+        FIntPoint InImageSize)
     {
         FRHIComputeShader* ComputeShaderRHI = RHICmdList.GetBoundComputeShader();
         if (OutputSurface.IsBound())
@@ -156,6 +291,8 @@ public:
         }
 		// RHICmdList.Transition(FRHITransitionInfo(OutputSurfaceUAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
 		// OutputSurface.SetTexture(RHICmdList, ComputeShaderRHI, InOutputSurfaceValue, OutputSurfaceUAV);
+        SetShaderValue(RHICmdList, ComputeShaderRHI, TileOffset, InTileOffset);
+        SetShaderValue(RHICmdList, ComputeShaderRHI, ImageSize, FVector2D(InImageSize));
 
         FMyUniformStructData UniformData;
         UniformData.ColorOne = ShaderStructData.ColorOne;
@@ -178,11 +315,125 @@ public:
     }
 private:
     LAYOUT_FIELD(FRWShaderParameter, OutputSurface);
+    LAYOUT_FIELD(FShaderParameter, TileOffset);
+    LAYOUT_FIELD(FShaderParameter, ImageSize);
+};
+
+/** What the passes of FMyAdaptiveComputeShader share, InitAdaptiveResources allocates them for an image size */
+struct FMyAdaptiveResources
+{
+    FIntPoint ImageSize;
+    FIntPoint NumTiles;
+    float VarianceThreshold = 0.0f;
+    FUnorderedAccessViewRHIRef OutputUAV;
+    FTexture2DRHIRef CoarseGrid;
+    FUnorderedAccessViewRHIRef CoarseGridUAV;
+    FRWBuffer TileList;
+    FRWBuffer TileCount;
+    FRWBuffer RefineArgs;
+};
+
+// MainCS shading only the tiles with detail in full, see AdaptiveCS in MySimpleShader.usf
+class FMyAdaptiveComputeShader : public FGlobalShader
+{
+    DECLARE_SHADER_TYPE(FMyAdaptiveComputeShader, Global, /*MYMODULE_API*/)
+public:
+    enum class EPass : int32
+    {
+        Coarse,
+        Interpolate,
+        Classify,
+        Args,
+        Refine,
+        Num
+    };
+
+    // ADAPTIVE_TILE_SIZE
+    static constexpr int32 TileSize = 8;
+
+    class FPassDim : SHADER_PERMUTATION_INT("ADAPTIVE_PASS", (int32)EPass::Num);
+    using FPermutationDomain = TShaderPermutationDomain<FPassDim, FMyComputeShader::FOutputFormatDim>;
+
+    FMyAdaptiveComputeShader()
+    {
+    }
+    FMyAdaptiveComputeShader(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+        : FGlobalShader(Initializer)
+    {
+        OutputSurface.Bind(Initializer.ParameterMap, TEXT("RWOutputSurface"));
+        ImageSize.Bind(Initializer.ParameterMap, TEXT("ImageSize"));
+        NumTiles.Bind(Initializer.ParameterMap, TEXT("NumTiles"));
+        VarianceThreshold.Bind(Initializer.ParameterMap, TEXT("VarianceThreshold"));
+        CoarseGrid.Bind(Initializer.ParameterMap, TEXT("CoarseGrid"));
+        TileList.Bind(Initializer.ParameterMap, TEXT("TileList"));
+        TileCount.Bind(Initializer.ParameterMap, TEXT("TileCount"));
+        RefineArgs.Bind(Initializer.ParameterMap, TEXT("RefineArgs"));
+    }
+
+    static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    {
+        // only the passes writing the image need every output format
+        const FPermutationDomain PermutationVector(Parameters.PermutationId);
+        const EPass Pass = (EPass)PermutationVector.Get<FPassDim>();
+        const bool bWritesOutput = Pass == EPass::Interpolate || Pass == EPass::Refine;
+        return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5)
+            && (bWritesOutput || PermutationVector.Get<FMyComputeShader::FOutputFormatDim>() == 0);
+    }
+
+    void SetParameters(
+        FRHICommandList& RHICmdList,
+        const FMyAdaptiveResources& Resources,
+        const FMyShaderStructData& ShaderStructData)
+    {
+        FRHIComputeShader* ComputeShaderRHI = RHICmdList.GetBoundComputeShader();
+        if (OutputSurface.IsBound())
+        {
+            RHICmdList.SetUAVParameter(ComputeShaderRHI, OutputSurface.GetUAVIndex(), Resources.OutputUAV);
+        }
+        SetShaderValue(RHICmdList, ComputeShaderRHI, ImageSize, FVector2D(Resources.ImageSize));
+        SetShaderValue(RHICmdList, ComputeShaderRHI, NumTiles, Resources.NumTiles);
+        SetShaderValue(RHICmdList, ComputeShaderRHI, VarianceThreshold, Resources.VarianceThreshold);
+        CoarseGrid.SetTexture(RHICmdList, ComputeShaderRHI, Resources.CoarseGrid, Resources.CoarseGridUAV);
+        TileList.SetBuffer(RHICmdList, ComputeShaderRHI, Resources.TileList);
+        TileCount.SetBuffer(RHICmdList, ComputeShaderRHI, Resources.TileCount);
+        RefineArgs.SetBuffer(RHICmdList, ComputeShaderRHI, Resources.RefineArgs);
+
+        FMyUniformStructData UniformData;
+        UniformData.ColorOne = ShaderStructData.ColorOne;
+        UniformData.ColorTwo = ShaderStructData.ColorTwo;
+        UniformData.ColorThree = ShaderStructData.ColorThree;
+        UniformData.ColorFour = ShaderStructData.ColorFour;
+        UniformData.ColorIndex = ShaderStructData.ColorIndex;
+
+        SetUniformBufferParameterImmediate(RHICmdList, ComputeShaderRHI, GetUniformBufferParameter<FMyUniformStructData>(), UniformData);
+    }
+
+    void UnsetParameters(FRHICommandList& RHICmdList)
+    {
+        FRHIComputeShader* ComputeShaderRHI = RHICmdList.GetBoundComputeShader();
+        OutputSurface.UnsetUAV(RHICmdList, ComputeShaderRHI);
+        CoarseGrid.UnsetUAV(RHICmdList, ComputeShaderRHI);
+        TileList.UnsetUAV(RHICmdList, ComputeShaderRHI);
+        TileCount.UnsetUAV(RHICmdList, ComputeShaderRHI);
+        RefineArgs.UnsetUAV(RHICmdList, ComputeShaderRHI);
+    }
+private:
+    LAYOUT_FIELD(FRWShaderParameter, OutputSurface);
+    LAYOUT_FIELD(FShaderParameter, ImageSize);
+    LAYOUT_FIELD(FShaderParameter, NumTiles);
+    LAYOUT_FIELD(FShaderParameter, VarianceThreshold);
+    LAYOUT_FIELD(FRWShaderParameter, CoarseGrid);
+    LAYOUT_FIELD(FRWShaderParameter, TileList);
+    LAYOUT_FIELD(FRWShaderParameter, TileCount);
+    LAYOUT_FIELD(FRWShaderParameter, RefineArgs);
 };
  
 IMPLEMENT_SHADER_TYPE(, FShaderTestVS, TEXT("/Plugin/ShadertestPlugin/Private/MySimpleShader.usf"), TEXT("MainVS"), SF_Vertex)  
 IMPLEMENT_SHADER_TYPE(, FShaderTestPS, TEXT("/Plugin/ShadertestPlugin/Private/MySimpleShader.usf"), TEXT("MainPS"), SF_Pixel)  
+IMPLEMENT_SHADER_TYPE(, FShaderTestMRTPS, TEXT("/Plugin/ShadertestPlugin/Private/MySimpleShader.usf"), TEXT("MainMRTPS"), SF_Pixel)
+IMPLEMENT_SHADER_TYPE(, FShaderTestBlitCS, TEXT("/Plugin/ShadertestPlugin/Private/MySimpleShader.usf"), TEXT("BlitCS"), SF_Compute)
 IMPLEMENT_SHADER_TYPE(, FMyComputeShader, TEXT("/Plugin/ShadertestPlugin/Private/MySimpleShader.usf"), TEXT("MainCS"), SF_Compute)  
+IMPLEMENT_SHADER_TYPE(, FMyAdaptiveComputeShader, TEXT("/Plugin/ShadertestPlugin/Private/MySimpleShader.usf"), TEXT("AdaptiveCS"), SF_Compute)
 
 struct FMyTextureVertex
 {
@@ -214,12 +465,15 @@ static void UseComputeShader_RenderThread(
     FRHICommandListImmediate& RHICmdList,
     FTextureRenderTargetResource* OutputRenderTargetResource,
     FMyShaderStructData ShaderStructData,
-    ERHIFeatureLevel::Type FeatureLevel
+    ERHIFeatureLevel::Type FeatureLevel,
+    EGraphicToolsOutputFormat OutputFormat
 )
 {
     check(IsInRenderingThread());
 
-    TShaderMapRef<FMyComputeShader> ComputeShader(GetGlobalShaderMap(FeatureLevel));
+    FMyComputeShader::FPermutationDomain PermutationVector;
+    PermutationVector.Set<FMyComputeShader::FOutputFormatDim>((int32)OutputFormat);
+    TShaderMapRef<FMyComputeShader> ComputeShader(GetGlobalShaderMap(FeatureLevel), PermutationVector);
     RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
 
     FTexture2DRHIRef RenderTargetTexture = OutputRenderTargetResource->GetRenderTargetTexture();
@@ -231,10 +485,11 @@ static void UseComputeShader_RenderThread(
 
     FRHIResourceCreateInfo CreateInfo;
 
+    // the render target is in the same format, the copy below can't convert
     FTexture2DRHIRef GSurfaceTexture2D = RHICreateTexture2D(
         SizeX,
         SizeY,
-        PF_FloatRGBA,
+        GetOutputPixelFormat(OutputFormat),
         1,
         1,
         TexCreate_ShaderResource | TexCreate_UAV,
@@ -242,159 +497,1190 @@ static void UseComputeShader_RenderThread(
     );
 
     FUnorderedAccessViewRHIRef GSurfaceTextureUAV = RHICreateUnorderedAccessView(GSurfaceTexture2D);
-    ComputeShader->SetParameters(RHICmdList, GSurfaceTextureUAV, ShaderStructData);
+    ComputeShader->SetParameters(RHICmdList, GSurfaceTextureUAV, ShaderStructData, FIntPoint::ZeroValue, FIntPoint(SizeX, SizeY));
     RHICmdList.DispatchComputeShader(GroupSizeX, GroupSizeY, 1);
     ComputeShader->UnsetParameters(RHICmdList);
 
     FRHICopyTextureInfo CopyInfo;
     RHICmdList.CopyTexture(GSurfaceTexture2D, RenderTargetTexture, CopyInfo);
 }
- 
-static void DrawTestShaderRenderTarget_RenderThread(  
-    FRHICommandListImmediate& RHICmdList,   
-    FTextureRenderTargetResource* OutputRenderTargetResource,  
-    ERHIFeatureLevel::Type FeatureLevel,  
-    FName TextureRenderTargetName,  
-    const FLinearColor& MyColor,  
-    FRHITexture* MyTexture,
-    const FMyShaderStructData& ShaderStructData
-)  
-{  
-    check(IsInRenderingThread());  
- 
-#if WANTS_DRAW_MESH_EVENTS  
-    FString EventName;  
-    TextureRenderTargetName.ToString(EventName);  
-    SCOPED_DRAW_EVENTF(RHICmdList, SceneCapture, TEXT("ShaderTest %s"), *EventName);  
-#else  
-    SCOPED_DRAW_EVENT(RHICmdList, DrawUVDisplacementToRenderTarget_RenderThread);  
-#endif  
- 
-    FRHITexture2D* RenderTargetTexture = OutputRenderTargetResource->GetRenderTargetTexture();
-
-    RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::SRVMask, ERHIAccess::RTV));
-    FRHIRenderPassInfo RenderPassInfo(RenderTargetTexture, ERenderTargetActions::DontLoad_Store, OutputRenderTargetResource->TextureRHI);
-
-    RHICmdList.BeginRenderPass(RenderPassInfo, TEXT("MyShaderTest"));
-    {
-        // TODO: Rendering Codes
-        // ӿ  
-        FIntPoint DrawTargetResolution(OutputRenderTargetResource->GetSizeX(), OutputRenderTargetResource->GetSizeY());  
-        // RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);  
-
-        FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);  
-        TShaderMapRef<FShaderTestVS> VertexShader(GlobalShaderMap);  
-        TShaderMapRef<FShaderTestPS> PixelShader(GlobalShaderMap);  
 
-        FMyTextureVertexDeclaration VertexDec;
-        VertexDec.InitRHI();
+static void InitAdaptiveResources(FMyAdaptiveResources& Resources, FIntPoint ImageSize, float VarianceThreshold)
+{
+    const int32 TileSize = FMyAdaptiveComputeShader::TileSize;
+    Resources.ImageSize = ImageSize;
+    Resources.NumTiles = FIntPoint(FMath::DivideAndRoundUp(ImageSize.X, TileSize), FMath::DivideAndRoundUp(ImageSize.Y, TileSize));
+    Resources.VarianceThreshold = VarianceThreshold;
 
-        // Set the graphic pipeline state.  
-        FGraphicsPipelineStateInitializer GraphicsPSOInit;  
-        RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);  
-        GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();  
-        GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();  
-        GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();  
-        GraphicsPSOInit.PrimitiveType = PT_TriangleStrip;  
+    FRHIResourceCreateInfo CreateInfo;
+    Resources.CoarseGrid = RHICreateTexture2D(
+        Resources.NumTiles.X + 1,
+        Resources.NumTiles.Y + 1,
+        PF_A32B32G32R32F,
+        1,
+        1,
+        TexCreate_ShaderResource | TexCreate_UAV,
+        CreateInfo
+    );
+    Resources.CoarseGridUAV = RHICreateUnorderedAccessView(Resources.CoarseGrid);
 
-        // Bind the Texture 
-        GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = VertexDec.VertexDeclarationRHI;
+    Resources.TileList.Initialize(sizeof(uint32), Resources.NumTiles.X * Resources.NumTiles.Y, PF_R32_UINT, BUF_Static, TEXT("ShaderTest.AdaptiveTileList"));
+    Resources.TileCount.Initialize(sizeof(uint32), 1, PF_R32_UINT, BUF_Static, TEXT("ShaderTest.AdaptiveTileCount"));
+    Resources.RefineArgs.Initialize(sizeof(uint32), 3, PF_R32_UINT, BUF_Static | BUF_DrawIndirect, TEXT("ShaderTest.AdaptiveRefineArgs"));
+}
 
-        GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
-        GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
-        SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit);  
+/**
+ * The adaptive pass resources of the sizes drawn most recently, so a draw only allocates when its size is new.
+ * Only touched on the render thread.
+ */
+class FMyAdaptiveResourceCache : public FRenderResource
+{
+public:
+    static const int32 MaxSizes = 4;
 
-        RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);  
-        PixelShader->SetParameters(RHICmdList, PixelShader.GetPixelShader(), MyColor, MyTexture, ShaderStructData);  
-       
-        FRHIResourceCreateInfo CreateInfo;
-        FVertexBufferRHIRef VertexBufferRHI = RHICreateVertexBuffer(sizeof(FMyTextureVertex) * 4, BUF_Volatile, CreateInfo);
-        FMyTextureVertex* Data = reinterpret_cast<FMyTextureVertex*>(RHILockVertexBuffer(VertexBufferRHI, 0, sizeof(FMyTextureVertex) * 4, RLM_WriteOnly));
-        
-        Data[0].Position = FVector4(-1.0f, 1.0f, 0, 1.0f);
-        Data[1].Position = FVector4(1.0f, 1.0f, 0, 1.0f);
-        Data[2].Position = FVector4(-1.0f, -1.0f, 0, 1.0f);
-        Data[3].Position = FVector4(1.0f, -1.0f, 0, 1.0f);
-        Data[0].UV = FVector2D(0.0f, 0.0f);
-        Data[1].UV = FVector2D(1.0f, 0.0f);
-        Data[2].UV = FVector2D(0.0f, 1.0f);
-        Data[3].UV = FVector2D(1.0f, 1.0f);
+    /** The resources for ImageSize, the least recently drawn size is dropped when there are too many */
+    const FMyAdaptiveResources& Find(FIntPoint ImageSize)
+    {
+        check(IsInRenderingThread());
 
-        RHIUnlockVertexBuffer(VertexBufferRHI);
-        
-        RHICmdList.SetStreamSource(0, VertexBufferRHI, 0);
-        RHICmdList.DrawPrimitive(0, 2, 1);
+        const int32 Index = Entries.IndexOfByPredicate([ImageSize](const FMyAdaptiveResources& Entry) { return Entry.ImageSize == ImageSize; });
+        if (Index != INDEX_NONE)
+        {
+            // most recently drawn last
+            FMyAdaptiveResources Entry = Entries[Index];
+            Entries.RemoveAt(Index, 1, false);
+            Entries.Add(Entry);
+        }
+        else
+        {
+            if (Entries.Num() == MaxSizes)
+            {
+                Entries.RemoveAt(0, 1, false);
+            }
+            FMyAdaptiveResources& Entry = Entries.AddDefaulted_GetRef();
+            InitAdaptiveResources(Entry, ImageSize, 0.0f);
+        }
+        return Entries.Last();
     }
-    
-    RHICmdList.EndRenderPass();
-}  
- 
-void UTestShaderBlueprintLibrary::DrawTestShaderRenderTarget(  
-    UTextureRenderTarget2D* OutputRenderTarget,   
-    AActor* Ac,  
-    FLinearColor MyColor,
-    UTexture* MyTexture,
-    FMyShaderStructData ShaderStructData
-)  
-{  
-    check(IsInGameThread());  
- 
-    if (!OutputRenderTarget)  
-    {  
-        return;  
-    }  
 
-    if (!MyTexture)
+    virtual void ReleaseRHI() override
     {
-        UE_LOG(LogTemp, Warning, TEXT("The Texture is Missing. Custom shader failed."));
-        return;
+        Entries.Empty();
     }
- 
-    FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();  
-    FTextureReferenceRHIRef MyTextureReferenceRHI = MyTexture->TextureReference.TextureReferenceRHI;
-    FRHITexture* MyTextureRHI = MyTextureReferenceRHI->GetTextureReference()->GetReferencedTexture();
-    UWorld* World = Ac->GetWorld();  
-    ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();  
-    FName TextureRenderTargetName = OutputRenderTarget->GetFName();  
-    ENQUEUE_RENDER_COMMAND(CaptureCommand)(  
-        [TextureRenderTargetResource, FeatureLevel, MyColor, TextureRenderTargetName, MyTextureRHI, ShaderStructData](FRHICommandListImmediate& RHICmdList)  
-        {  
-            DrawTestShaderRenderTarget_RenderThread(RHICmdList, TextureRenderTargetResource, FeatureLevel, TextureRenderTargetName, MyColor, MyTextureRHI, ShaderStructData);  
-        }  
-    );  
- 
+
+private:
+    TArray<FMyAdaptiveResources, TInlineAllocator<MaxSizes>> Entries;
+};
+
+static TGlobalResource<FMyAdaptiveResourceCache> GAdaptiveResourceCache;
+
+static TShaderMapRef<FMyAdaptiveComputeShader> SetAdaptivePass(
+    FRHICommandList& RHICmdList,
+    FMyAdaptiveComputeShader::EPass Pass,
+    const FMyAdaptiveResources& Resources,
+    const FMyShaderStructData& ShaderStructData,
+    ERHIFeatureLevel::Type FeatureLevel,
+    EGraphicToolsOutputFormat OutputFormat
+)
+{
+    const bool bWritesOutput = Pass == FMyAdaptiveComputeShader::EPass::Interpolate || Pass == FMyAdaptiveComputeShader::EPass::Refine;
+
+    FMyAdaptiveComputeShader::FPermutationDomain PermutationVector;
+    PermutationVector.Set<FMyAdaptiveComputeShader::FPassDim>((int32)Pass);
+    PermutationVector.Set<FMyComputeShader::FOutputFormatDim>(bWritesOutput ? (int32)OutputFormat : 0);
+    TShaderMapRef<FMyAdaptiveComputeShader> ComputeShader(GetGlobalShaderMap(FeatureLevel), PermutationVector);
+    RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
+    ComputeShader->SetParameters(RHICmdList, Resources, ShaderStructData);
+    return ComputeShader;
 }
 
-static void TextureWriting_RenderingThread(
+// The adaptive passes into Resources.OutputUAV, Surface is the texture it views
+static void DispatchAdaptiveComputeShader_RenderThread(
     FRHICommandListImmediate& RHICmdList,
+    FRHITexture2D* Surface,
+    const FMyAdaptiveResources& Resources,
+    const FMyShaderStructData& ShaderStructData,
     ERHIFeatureLevel::Type FeatureLevel,
-    UTexture2D* MyTexture
+    EGraphicToolsOutputFormat OutputFormat
 )
 {
     check(IsInRenderingThread());
 
-    if (MyTexture == nullptr)
-    {
-        return;
-    }
-    
-    FTextureReferenceRHIRef MyTextureRHI = MyTexture->TextureReference.TextureReferenceRHI;
-    FRHITexture2D* MyTexRef2D = MyTextureRHI->GetTextureReference()->GetReferencedTexture()->GetTexture2D();
+    using EPass = FMyAdaptiveComputeShader::EPass;
+    const int32 TileSize = FMyAdaptiveComputeShader::TileSize;
 
+    RHICmdList.Transition(FRHITransitionInfo(Surface, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+    RHICmdList.Transition(FRHITransitionInfo(Resources.CoarseGrid, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+    RHICmdList.Transition(FRHITransitionInfo(Resources.TileList.UAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+    RHICmdList.Transition(FRHITransitionInfo(Resources.TileCount.UAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+    RHICmdList.Transition(FRHITransitionInfo(Resources.RefineArgs.UAV, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+    RHICmdList.ClearUAVUint(Resources.TileCount.UAV, FUintVector4(0, 0, 0, 0));
 
-    TArray<FColor> BitMap;
-    uint32 DestStride = 0;
+    TShaderMapRef<FMyAdaptiveComputeShader> Coarse = SetAdaptivePass(RHICmdList, EPass::Coarse, Resources, ShaderStructData, FeatureLevel, OutputFormat);
+    RHICmdList.DispatchComputeShader(FMath::DivideAndRoundUp(Resources.NumTiles.X + 1, TileSize), FMath::DivideAndRoundUp(Resources.NumTiles.Y + 1, TileSize), 1);
+    Coarse->UnsetParameters(RHICmdList);
+    RHICmdList.Transition(FRHITransitionInfo(Resources.CoarseGrid, ERHIAccess::UAVCompute, ERHIAccess::SRVCompute));
 
-    uint8* MyTextureData = (uint8*)RHICmdList.LockTexture2D(MyTexRef2D, 0, EResourceLockMode::RLM_ReadOnly, DestStride, false);
+    TShaderMapRef<FMyAdaptiveComputeShader> Interpolate = SetAdaptivePass(RHICmdList, EPass::Interpolate, Resources, ShaderStructData, FeatureLevel, OutputFormat);
+    RHICmdList.DispatchComputeShader(FMath::DivideAndRoundUp(Resources.ImageSize.X, TileSize), FMath::DivideAndRoundUp(Resources.ImageSize.Y, TileSize), 1);
+    Interpolate->UnsetParameters(RHICmdList);
+    RHICmdList.Transition(FRHITransitionInfo(Resources.TileCount.UAV, ERHIAccess::UAVCompute, ERHIAccess::UAVCompute));
 
-    for (uint32 Row = 0; Row < MyTexRef2D->GetSizeY(); ++Row)
-	{
-		for (uint32 Col = 0; Col < MyTexRef2D->GetSizeX(); ++Col)
-		{
-            uint32 EncodedPixel = *(uint32*)(MyTextureData + Col * sizeof(uint32) + Row * DestStride);
-            uint8 R = (EncodedPixel & 0x000000FF);
-            uint8 G = (EncodedPixel & 0x0000FF00) >> 8;
-            uint8 B = (EncodedPixel & 0x00FF0000) >> 16;
+    TShaderMapRef<FMyAdaptiveComputeShader> Classify = SetAdaptivePass(RHICmdList, EPass::Classify, Resources, ShaderStructData, FeatureLevel, OutputFormat);
+    RHICmdList.DispatchComputeShader(FMath::DivideAndRoundUp(Resources.NumTiles.X, TileSize), FMath::DivideAndRoundUp(Resources.NumTiles.Y, TileSize), 1);
+    Classify->UnsetParameters(RHICmdList);
+    RHICmdList.Transition(FRHITransitionInfo(Resources.TileCount.UAV, ERHIAccess::UAVCompute, ERHIAccess::UAVCompute));
+    RHICmdList.Transition(FRHITransitionInfo(Resources.TileList.UAV, ERHIAccess::UAVCompute, ERHIAccess::UAVCompute));
+
+    TShaderMapRef<FMyAdaptiveComputeShader> Args = SetAdaptivePass(RHICmdList, EPass::Args, Resources, ShaderStructData, FeatureLevel, OutputFormat);
+    RHICmdList.DispatchComputeShader(1, 1, 1);
+    Args->UnsetParameters(RHICmdList);
+    RHICmdList.Transition(FRHITransitionInfo(Resources.RefineArgs.Buffer, ERHIAccess::UAVCompute, ERHIAccess::IndirectArgs));
+    RHICmdList.Transition(FRHITransitionInfo(Surface, ERHIAccess::UAVCompute, ERHIAccess::UAVCompute));
+
+    // the CPU never learns how many tiles were refined, the GPU reads the group count from RefineArgs
+    TShaderMapRef<FMyAdaptiveComputeShader> Refine = SetAdaptivePass(RHICmdList, EPass::Refine, Resources, ShaderStructData, FeatureLevel, OutputFormat);
+    RHICmdList.DispatchIndirectComputeShader(Resources.RefineArgs.Buffer, 0);
+    Refine->UnsetParameters(RHICmdList);
+}
+
+static void UseAdaptiveComputeShader_RenderThread(
+    FRHICommandListImmediate& RHICmdList,
+    FTextureRenderTargetResource* OutputRenderTargetResource,
+    FMyShaderStructData ShaderStructData,
+    ERHIFeatureLevel::Type FeatureLevel,
+    EGraphicToolsOutputFormat OutputFormat,
+    float VarianceThreshold
+)
+{
+    check(IsInRenderingThread());
+
+    FTexture2DRHIRef RenderTargetTexture = OutputRenderTargetResource->GetRenderTargetTexture();
+    const FIntPoint Size(OutputRenderTargetResource->GetSizeX(), OutputRenderTargetResource->GetSizeY());
+
+    TRefCountPtr<IPooledRenderTarget> PooledSurface;
+    GRenderTargetPool.FindFreeElement(
+        RHICmdList,
+        FPooledRenderTargetDesc::Create2DDesc(Size, GetOutputPixelFormat(OutputFormat), FClearValueBinding::None, TexCreate_None, TexCreate_ShaderResource | TexCreate_UAV, false),
+        PooledSurface,
+        TEXT("ShaderTest.AdaptiveSurface")
+    );
+    const FSceneRenderTargetItem& SurfaceItem = PooledSurface->GetRenderTargetItem();
+    FTexture2DRHIRef Surface = SurfaceItem.ShaderResourceTexture->GetTexture2D();
+
+    // the coarse grid, tile list and arguments are rewritten in full by every draw, so the cached ones are reused as they are
+    FMyAdaptiveResources Resources = GAdaptiveResourceCache.Find(Size);
+    Resources.VarianceThreshold = VarianceThreshold;
+    Resources.OutputUAV = SurfaceItem.UAV;
+    DispatchAdaptiveComputeShader_RenderThread(RHICmdList, Surface, Resources, ShaderStructData, FeatureLevel, OutputFormat);
+
+    RHICmdList.Transition(FRHITransitionInfo(Surface, ERHIAccess::UAVCompute, ERHIAccess::CopySrc));
+    FRHICopyTextureInfo CopyInfo;
+    RHICmdList.CopyTexture(Surface, RenderTargetTexture, CopyInfo);
+}
+
+/**
+ * One DrawComputeShaderResultTiled in progress. The image is generated a tile at a time into one tile sized
+ * texture, so the transient memory is a tile whatever the image size and no single dispatch runs long enough
+ * to trip the GPU timeout. Each tile is copied to its place in the render target, if there is one, and read
+ * back and written to disk if there is an export directory, so an exported image never exists in full anywhere.
+ * Tiles go out in rows, at most TilesPerFrame a frame and, when exporting, never more than MaxTileExports
+ * between the GPU and the disk.
+ */
+struct FMyTiledGenerationState
+{
+    static constexpr int32 MaxTileExports = 3;
+
+    struct FTileExport
+    {
+        TUniquePtr<FRHIGPUTextureReadback> Readback;
+        FIntPoint Tile;
+        FIntPoint Size;
+    };
+
+    // set on the game thread before the first tile
+    FIntPoint ImageSize;
+    int32 TileSize = 0;
+    FIntPoint NumTiles;
+    int32 TilesPerFrame = 0;
+    FString ExportDirectory;
+    EGraphicToolsOutputFormat OutputFormat = EGraphicToolsOutputFormat::FloatRGBA;
+    FMyShaderStructData ShaderStructData;
+    ERHIFeatureLevel::Type FeatureLevel = ERHIFeatureLevel::SM5;
+    // null when the tiles only go to disk
+    FTextureRenderTargetResource* Target = nullptr;
+
+    // render thread
+    FTexture2DRHIRef TileTexture;
+    FUnorderedAccessViewRHIRef TileUAV;
+    int32 NextTile = 0;
+    TArray<FTileExport> InFlight;
+    TArray<TUniquePtr<FRHIGPUTextureReadback>> FreeReadbacks;
+
+    // every tile is generated and read back, written by the render thread
+    FThreadSafeBool bAllTilesDone;
+    FThreadSafeCounter NumWriting;
+};
+
+static void GenerateTile_RenderThread(FRHICommandListImmediate& RHICmdList, FMyTiledGenerationState& State, FIntPoint Tile)
+{
+    check(IsInRenderingThread());
+
+    const FIntPoint Origin = Tile * State.TileSize;
+    const FIntPoint Size(FMath::Min(State.TileSize, State.ImageSize.X - Origin.X), FMath::Min(State.TileSize, State.ImageSize.Y - Origin.Y));
+
+    FMyComputeShader::FPermutationDomain PermutationVector;
+    PermutationVector.Set<FMyComputeShader::FOutputFormatDim>((int32)State.OutputFormat);
+    TShaderMapRef<FMyComputeShader> ComputeShader(GetGlobalShaderMap(State.FeatureLevel), PermutationVector);
+    RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
+
+    // the previous tile may still be copying out of the tile texture
+    RHICmdList.Transition(FRHITransitionInfo(State.TileTexture, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+    ComputeShader->SetParameters(RHICmdList, State.TileUAV, State.ShaderStructData, Origin, State.ImageSize);
+    RHICmdList.DispatchComputeShader(FMath::DivideAndRoundUp(Size.X, 32), FMath::DivideAndRoundUp(Size.Y, 32), 1);
+    ComputeShader->UnsetParameters(RHICmdList);
+    RHICmdList.Transition(FRHITransitionInfo(State.TileTexture, ERHIAccess::UAVCompute, ERHIAccess::CopySrc));
+
+    FRHITexture2D* TargetTexture = State.Target != nullptr ? State.Target->GetRenderTargetTexture() : nullptr;
+    // a target resized or reformatted since the generation started keeps what it has
+    if (TargetTexture != nullptr && TargetTexture->GetSizeXY() == State.ImageSize && TargetTexture->GetFormat() == State.TileTexture->GetFormat())
+    {
+        FRHICopyTextureInfo CopyInfo;
+        CopyInfo.Size = FIntVector(Size.X, Size.Y, 1);
+        CopyInfo.DestPosition = FIntVector(Origin.X, Origin.Y, 0);
+        RHICmdList.Transition(FRHITransitionInfo(TargetTexture, ERHIAccess::Unknown, ERHIAccess::CopyDest));
+        RHICmdList.CopyTexture(State.TileTexture, TargetTexture, CopyInfo);
+        RHICmdList.Transition(FRHITransitionInfo(TargetTexture, ERHIAccess::CopyDest, ERHIAccess::SRVMask));
+    }
+
+    if (!State.ExportDirectory.IsEmpty())
+    {
+        FMyTiledGenerationState::FTileExport Export;
+        Export.Readback = State.FreeReadbacks.Num() > 0 ? State.FreeReadbacks.Pop() : MakeUnique<FRHIGPUTextureReadback>(TEXT("ShaderTest.Tile"));
+        Export.Tile = Tile;
+        Export.Size = Size;
+        Export.Readback->EnqueueCopy(RHICmdList, State.TileTexture);
+        State.InFlight.Add(MoveTemp(Export));
+    }
+}
+
+static void ExportTiles_RenderThread(FRHICommandListImmediate& RHICmdList, const TSharedRef<FMyTiledGenerationState, ESPMode::ThreadSafe>& StateRef)
+{
+    check(IsInRenderingThread());
+
+    FMyTiledGenerationState& State = *StateRef;
+
+    // readbacks complete in submission order, stop at the first one that isn't there yet
+    while (State.InFlight.Num() > 0 && State.InFlight[0].Readback->IsReady())
+    {
+        FMyTiledGenerationState::FTileExport& Export = State.InFlight[0];
+
+        TArray<FColor> Pixels;
+        Pixels.SetNumUninitialized(Export.Size.X * Export.Size.Y);
+
+        void* Data = nullptr;
+        int32 RowPitchInPixels = 0;
+        Export.Readback->LockTexture(RHICmdList, Data, RowPitchInPixels);
+        for (int32 Row = 0; Row < Export.Size.Y; ++Row)
+        {
+            FColor* Dest = Pixels.GetData() + Row * Export.Size.X;
+            if (State.OutputFormat == EGraphicToolsOutputFormat::R8G8B8A8)
+            {
+                const uint8* Source = static_cast<const uint8*>(Data) + Row * RowPitchInPixels * 4;
+                for (int32 Col = 0; Col < Export.Size.X; ++Col)
+                {
+                    Dest[Col] = FColor(Source[Col * 4], Source[Col * 4 + 1], Source[Col * 4 + 2], Source[Col * 4 + 3]);
+                }
+            }
+            else
+            {
+                const FFloat16Color* Source = static_cast<const FFloat16Color*>(Data) + Row * RowPitchInPixels;
+                for (int32 Col = 0; Col < Export.Size.X; ++Col)
+                {
+                    Dest[Col] = FLinearColor(Source[Col]).ToFColor(false);
+                }
+            }
+        }
+        Export.Readback->Unlock();
+
+        State.NumWriting.Increment();
+        AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [StateRef, Tile = Export.Tile, Size = Export.Size, Pixels = MoveTemp(Pixels)]()
+        {
+            const FString FileName = StateRef->ExportDirectory / FString::Printf(TEXT("Tile_%d_%d.bmp"), Tile.X, Tile.Y);
+            if (!FFileHelper::CreateBitmap(*FileName, Size.X, Size.Y, Pixels.GetData()))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Failed to write %s"), *FileName);
+            }
+            StateRef->NumWriting.Decrement();
+        });
+
+        State.FreeReadbacks.Add(MoveTemp(Export.Readback));
+        State.InFlight.RemoveAt(0);
+    }
+}
+
+static void GenerateTiles_RenderThread(FRHICommandListImmediate& RHICmdList, const TSharedRef<FMyTiledGenerationState, ESPMode::ThreadSafe>& StateRef)
+{
+    check(IsInRenderingThread());
+
+    FMyTiledGenerationState& State = *StateRef;
+    const bool bExport = !State.ExportDirectory.IsEmpty();
+    const int32 NumTiles = State.NumTiles.X * State.NumTiles.Y;
+
+    if (bExport)
+    {
+        ExportTiles_RenderThread(RHICmdList, StateRef);
+    }
+
+    if (State.NextTile < NumTiles && !State.TileTexture.IsValid())
+    {
+        FRHIResourceCreateInfo CreateInfo;
+        State.TileTexture = RHICreateTexture2D(
+            State.TileSize,
+            State.TileSize,
+            GetOutputPixelFormat(State.OutputFormat),
+            1,
+            1,
+            TexCreate_ShaderResource | TexCreate_UAV,
+            CreateInfo
+        );
+        State.TileUAV = RHICreateUnorderedAccessView(State.TileTexture);
+    }
+
+    int32 NumToGenerate = State.TilesPerFrame > 0 ? State.TilesPerFrame : NumTiles;
+    while (NumToGenerate > 0 && State.NextTile < NumTiles
+        && (!bExport || State.InFlight.Num() + State.NumWriting.GetValue() < FMyTiledGenerationState::MaxTileExports))
+    {
+        GenerateTile_RenderThread(RHICmdList, State, FIntPoint(State.NextTile % State.NumTiles.X, State.NextTile / State.NumTiles.X));
+        ++State.NextTile;
+        --NumToGenerate;
+    }
+
+    if (State.NextTile == NumTiles)
+    {
+        // the commands of the last tile hold on to the texture until the GPU is done with it
+        State.TileUAV.SafeRelease();
+        State.TileTexture.SafeRelease();
+
+        if (State.InFlight.Num() == 0)
+        {
+            State.FreeReadbacks.Empty();
+            State.bAllTilesDone = true;
+        }
+    }
+}
+
+/** Drives a tiled generation from the game thread, one render command a frame until every tile is done */
+class FMyTiledGeneration : public FTickableGameObject, public FGCObject
+{
+public:
+    FMyTiledGeneration(UTextureRenderTarget2D* InTarget, const TSharedRef<FMyTiledGenerationState, ESPMode::ThreadSafe>& InState, TFunction<void()>&& InOnFinished)
+        : Target(InTarget)
+        , State(InState)
+        , OnFinished(MoveTemp(InOnFinished))
+        , bFinished(false)
+        , bJobQueued(false)
+    {
+    }
+
+    static void Start(UTextureRenderTarget2D* Target, const TSharedRef<FMyTiledGenerationState, ESPMode::ThreadSafe>& State, TFunction<void()>&& OnFinished)
+    {
+        check(IsInGameThread());
+
+        // the first tiles go out this frame, like the untiled node's
+        TUniquePtr<FMyTiledGeneration>& Generation = GetActive().Add_GetRef(MakeUnique<FMyTiledGeneration>(Target, State, MoveTemp(OnFinished)));
+        Generation->EnqueueTiles();
+    }
+
+    // FTickableGameObject interface
+    virtual void Tick(float DeltaTime) override
+    {
+        // one batch waits in the scheduler at a time, or a run of frames without headroom would let several go
+        // out together and break TilesPerFrame
+        if (bJobQueued)
+        {
+            return;
+        }
+
+        if (!State->bAllTilesDone || State->NumWriting.GetValue() > 0)
+        {
+            EnqueueTiles();
+            return;
+        }
+
+        bFinished = true;
+        TFunction<void()> Finished = MoveTemp(OnFinished);
+        if (Finished)
+        {
+            Finished();
+        }
+
+        // not from inside its own Tick
+        AsyncTask(ENamedThreads::GameThread, [this]()
+        {
+            GetActive().RemoveAll([this](const TUniquePtr<FMyTiledGeneration>& Generation) { return Generation.Get() == this; });
+        });
+    }
+
+    virtual bool IsTickable() const override { return !bFinished; }
+    virtual bool IsTickableWhenPaused() const override { return true; }
+    virtual bool IsTickableInEditor() const override { return true; }
+    virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FMyTiledGeneration, STATGROUP_Tickables); }
+    // End of FTickableGameObject interface
+
+    // FGCObject interface
+    virtual void AddReferencedObjects(FReferenceCollector& Collector) override
+    {
+        Collector.AddReferencedObject(Target);
+    }
+    virtual FString GetReferencerName() const override { return TEXT("FMyTiledGeneration"); }
+    // End of FGCObject interface
+
+private:
+    static TArray<TUniquePtr<FMyTiledGeneration>>& GetActive()
+    {
+        static TArray<TUniquePtr<FMyTiledGeneration>> Active;
+        return Active;
+    }
+
+    void EnqueueTiles()
+    {
+        // procedural work, it waits for frames with headroom and each batch picks up from the next tile
+        FGraphicToolsGPUJob Job;
+        Job.Name = TEXT("ShaderTest.Tiles");
+        Job.Priority = EGraphicToolsGPUJobPriority::Low;
+        if (Target != nullptr)
+        {
+            Job.Objects.Add(Target);
+        }
+        Job.Work = [State = State](FRHICommandListImmediate& RHICmdList)
+        {
+            GenerateTiles_RenderThread(RHICmdList, State);
+        };
+        FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+
+        // Tick doesn't finish, and so doesn't destroy this, while the callback is pending
+        bJobQueued = true;
+        FGraphicToolsGPUScheduler::CallWhenSubmitted([this]()
+        {
+            bJobQueued = false;
+        });
+    }
+
+    // kept alive while its resource is written to, null when the tiles only go to disk
+    UTextureRenderTarget2D* Target;
+    TSharedRef<FMyTiledGenerationState, ESPMode::ThreadSafe> State;
+    TFunction<void()> OnFinished;
+    bool bFinished;
+    bool bJobQueued;
+};
+ 
+static void DrawTestShaderRaster_RenderThread(  
+    FRHICommandListImmediate& RHICmdList,   
+    FRHITexture2D* RenderTargetTexture,
+    FRHITexture* ResolveTexture,
+    ERHIFeatureLevel::Type FeatureLevel,  
+    const FLinearColor& MyColor,  
+    FRHITexture* MyTexture,
+    const FMyShaderStructData& ShaderStructData
+)  
+{  
+    check(IsInRenderingThread());  
+ 
+    RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::SRVMask, ERHIAccess::RTV));
+    FRHIRenderPassInfo RenderPassInfo(RenderTargetTexture, ERenderTargetActions::DontLoad_Store, ResolveTexture);
+
+    RHICmdList.BeginRenderPass(RenderPassInfo, TEXT("MyShaderTest"));
+    {
+        // TODO: Rendering Codes
+        // ӿ  
+        FIntPoint DrawTargetResolution = RenderTargetTexture->GetSizeXY();  
+        // RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);  
+
+        FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);  
+        TShaderMapRef<FShaderTestVS> VertexShader(GlobalShaderMap);  
+        TShaderMapRef<FShaderTestPS> PixelShader(GlobalShaderMap);  
+
+        FMyTextureVertexDeclaration VertexDec;
+        VertexDec.InitRHI();
+
+        // Set the graphic pipeline state.  
+        FGraphicsPipelineStateInitializer GraphicsPSOInit;  
+        RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);  
+        GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();  
+        GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();  
+        GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();  
+        GraphicsPSOInit.PrimitiveType = PT_TriangleStrip;  
+
+        // Bind the Texture 
+        GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = VertexDec.VertexDeclarationRHI;
+
+        GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+        GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+        SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit);  
+
+        RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);  
+        PixelShader->SetParameters(RHICmdList, PixelShader.GetPixelShader(), MyColor, MyTexture, ShaderStructData);  
+       
+        FRHIResourceCreateInfo CreateInfo;
+        FVertexBufferRHIRef VertexBufferRHI = RHICreateVertexBuffer(sizeof(FMyTextureVertex) * 4, BUF_Volatile, CreateInfo);
+        FMyTextureVertex* Data = reinterpret_cast<FMyTextureVertex*>(RHILockVertexBuffer(VertexBufferRHI, 0, sizeof(FMyTextureVertex) * 4, RLM_WriteOnly));
+        
+        Data[0].Position = FVector4(-1.0f, 1.0f, 0, 1.0f);
+        Data[1].Position = FVector4(1.0f, 1.0f, 0, 1.0f);
+        Data[2].Position = FVector4(-1.0f, -1.0f, 0, 1.0f);
+        Data[3].Position = FVector4(1.0f, -1.0f, 0, 1.0f);
+        Data[0].UV = FVector2D(0.0f, 0.0f);
+        Data[1].UV = FVector2D(1.0f, 0.0f);
+        Data[2].UV = FVector2D(0.0f, 1.0f);
+        Data[3].UV = FVector2D(1.0f, 1.0f);
+
+        RHIUnlockVertexBuffer(VertexBufferRHI);
+        
+        RHICmdList.SetStreamSource(0, VertexBufferRHI, 0);
+        RHICmdList.DrawPrimitive(0, 2, 1);
+    }
+    
+    RHICmdList.EndRenderPass();
+    RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::RTV, ERHIAccess::SRVMask));
+}  
+ 
+/**
+ * The UAVs of the render targets drawn by compute most recently, so a target drawn every frame doesn't create
+ * one per draw. Entries hold their texture, which keeps its address from being reused for another, and one whose
+ * texture nothing else holds any more is dropped. Only touched on the render thread.
+ */
+class FMyRenderTargetUAVCache : public FRenderResource
+{
+public:
+    static const int32 MaxTargets = 8;
+
+    FRHIUnorderedAccessView* Find(FRHITexture2D* Texture)
+    {
+        check(IsInRenderingThread());
+
+        Entries.RemoveAll([](const FEntry& Entry) { return Entry.Texture->GetRefCount() == 1; });
+
+        const int32 Index = Entries.IndexOfByPredicate([Texture](const FEntry& Entry) { return Entry.Texture == Texture; });
+        if (Index != INDEX_NONE)
+        {
+            // most recently drawn last
+            FEntry Entry = Entries[Index];
+            Entries.RemoveAt(Index, 1, false);
+            Entries.Add(Entry);
+        }
+        else
+        {
+            if (Entries.Num() == MaxTargets)
+            {
+                Entries.RemoveAt(0, 1, false);
+            }
+            Entries.Add({ Texture, RHICreateUnorderedAccessView(Texture) });
+        }
+        return Entries.Last().UAV;
+    }
+
+    virtual void ReleaseRHI() override
+    {
+        Entries.Empty();
+    }
+
+private:
+    struct FEntry
+    {
+        FTexture2DRHIRef Texture;
+        FUnorderedAccessViewRHIRef UAV;
+    };
+
+    TArray<FEntry, TInlineAllocator<MaxTargets>> Entries;
+};
+
+static TGlobalResource<FMyRenderTargetUAVCache> GRenderTargetUAVCache;
+
+static void DrawTestShaderCompute_RenderThread(
+    FRHICommandListImmediate& RHICmdList,
+    FRHITexture2D* RenderTargetTexture,
+    FRHIUnorderedAccessView* RenderTargetUAV,
+    ERHIFeatureLevel::Type FeatureLevel,
+    FRHITexture* MyTexture,
+    const FMyShaderStructData& ShaderStructData
+)
+{
+    check(IsInRenderingThread());
+
+    const FIntPoint Size = RenderTargetTexture->GetSizeXY();
+    TShaderMapRef<FShaderTestBlitCS> ComputeShader(GetGlobalShaderMap(FeatureLevel));
+
+    RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::SRVMask, ERHIAccess::UAVCompute));
+    RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
+    ComputeShader->SetParameters(RHICmdList, RenderTargetUAV, Size, MyTexture, ShaderStructData);
+    RHICmdList.DispatchComputeShader(FMath::DivideAndRoundUp(Size.X, FShaderTestBlitCS::GroupSize), FMath::DivideAndRoundUp(Size.Y, FShaderTestBlitCS::GroupSize), 1);
+    ComputeShader->UnsetParameters(RHICmdList);
+    RHICmdList.Transition(FRHITransitionInfo(RenderTargetTexture, ERHIAccess::UAVCompute, ERHIAccess::SRVMask));
+}
+
+// Compute writes straight into targets created with UAV access, no render pass or vertex buffer. It samples the top
+// mip where raster samples trilinearly, Auto only takes it when the two draw the same pixels
+static void DrawTestShaderRenderTarget_RenderThread(
+    FRHICommandListImmediate& RHICmdList,
+    FTextureRenderTargetResource* OutputRenderTargetResource,
+    ERHIFeatureLevel::Type FeatureLevel,
+    FName TextureRenderTargetName,
+    const FLinearColor& MyColor,
+    FRHITexture* MyTexture,
+    const FMyShaderStructData& ShaderStructData,
+    EMyShaderDrawPath DrawPath
+)
+{
+    check(IsInRenderingThread());
+
+#if WANTS_DRAW_MESH_EVENTS  
+    FString EventName;  
+    TextureRenderTargetName.ToString(EventName);  
+    SCOPED_DRAW_EVENTF(RHICmdList, SceneCapture, TEXT("ShaderTest %s"), *EventName);  
+#else  
+    SCOPED_DRAW_EVENT(RHICmdList, DrawUVDisplacementToRenderTarget_RenderThread);  
+#endif  
+
+    FRHITexture2D* RenderTargetTexture = OutputRenderTargetResource->GetRenderTargetTexture();
+    const bool bCanCompute = EnumHasAnyFlags(RenderTargetTexture->GetFlags(), TexCreate_UAV) && FeatureLevel >= ERHIFeatureLevel::SM5;
+    const bool bSameAsRaster = MyTexture->GetNumMips() == 1
+        || (MyTexture->GetSizeXYZ().X == RenderTargetTexture->GetSizeX() && MyTexture->GetSizeXYZ().Y == RenderTargetTexture->GetSizeY());
+    if (bCanCompute && (DrawPath == EMyShaderDrawPath::Compute || (DrawPath == EMyShaderDrawPath::Auto && bSameAsRaster)))
+    {
+        FRHIUnorderedAccessView* RenderTargetUAV = GRenderTargetUAVCache.Find(RenderTargetTexture);
+        DrawTestShaderCompute_RenderThread(RHICmdList, RenderTargetTexture, RenderTargetUAV, FeatureLevel, MyTexture, ShaderStructData);
+    }
+    else
+    {
+        DrawTestShaderRaster_RenderThread(RHICmdList, RenderTargetTexture, OutputRenderTargetResource->TextureRHI, FeatureLevel, MyColor, MyTexture, ShaderStructData);
+    }
+}
+
+void UTestShaderBlueprintLibrary::DrawTestShaderRenderTarget(  
+    UTextureRenderTarget2D* OutputRenderTarget,   
+    AActor* Ac,  
+    FLinearColor MyColor,
+    UTexture* MyTexture,
+    FMyShaderStructData ShaderStructData,
+    EMyShaderDrawPath DrawPath
+)  
+{  
+    check(IsInGameThread());  
+ 
+    if (!OutputRenderTarget || !CanDispatchGPUWork())  
+    {  
+        return;  
+    }  
+
+    if (!MyTexture)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("The Texture is Missing. Custom shader failed."));
+        return;
+    }
+ 
+    FTextureRenderTargetResource* TextureRenderTargetResource = OutputRenderTarget->GameThread_GetRenderTargetResource();  
+    FTextureReferenceRHIRef MyTextureReferenceRHI = MyTexture->TextureReference.TextureReferenceRHI;
+    UWorld* World = Ac->GetWorld();  
+    ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();  
+    FName TextureRenderTargetName = OutputRenderTarget->GetFName();  
+
+    // the job may run frames later, the texture is resolved through its reference when it does. A target drawn
+    // from itself depends on what was drawn before, so it isn't coalesced
+    FGraphicToolsGPUJob Job;
+    Job.Name = TEXT("ShaderTest.Draw");
+    Job.Objects.Add(MyTexture);
+    Job.Objects.AddUnique(OutputRenderTarget);
+    Job.CoalesceKey = MyTexture != OutputRenderTarget ? FObjectKey(OutputRenderTarget) : FObjectKey();
+    Job.Work = [TextureRenderTargetResource, FeatureLevel, MyColor, TextureRenderTargetName, MyTextureReferenceRHI, ShaderStructData, DrawPath](FRHICommandListImmediate& RHICmdList)
+    {
+        FRHITexture* MyTextureRHI = MyTextureReferenceRHI->GetTextureReference()->GetReferencedTexture();
+        DrawTestShaderRenderTarget_RenderThread(RHICmdList, TextureRenderTargetResource, FeatureLevel, TextureRenderTargetName, MyColor, MyTextureRHI, ShaderStructData, DrawPath);
+    };
+    FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+ 
+}
+
+// The ColorIndex variants MainMRTPS writes, one a bound render target
+static const int32 NumShaderVariants = 4;
+
+static void DrawTestShaderVariants_RenderThread(
+    FRHICommandListImmediate& RHICmdList,
+    const TArray<FTextureRenderTargetResource*>& TargetResources,
+    const TArray<FLinearColor>& Tints,
+    ERHIFeatureLevel::Type FeatureLevel,
+    FRHITexture* MyTexture
+)
+{
+    check(IsInRenderingThread());
+    check(TargetResources.Num() == Tints.Num() && TargetResources.Num() <= NumShaderVariants);
+
+    SCOPED_DRAW_EVENTF(RHICmdList, ShaderTestVariants, TEXT("ShaderTest Variants %d"), TargetResources.Num());
+
+    FRHITexture* RenderTargets[NumShaderVariants] = {};
+    for (int32 Index = 0; Index < TargetResources.Num(); ++Index)
+    {
+        RenderTargets[Index] = TargetResources[Index]->GetRenderTargetTexture();
+        RHICmdList.Transition(FRHITransitionInfo(RenderTargets[Index], ERHIAccess::SRVMask, ERHIAccess::RTV));
+    }
+
+    FRHIRenderPassInfo RenderPassInfo(TargetResources.Num(), RenderTargets, ERenderTargetActions::DontLoad_Store);
+    RHICmdList.BeginRenderPass(RenderPassInfo, TEXT("MyShaderTestVariants"));
+    {
+        const FIntPoint DrawTargetResolution = RenderTargets[0]->GetSizeXY();
+
+        FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+        TShaderMapRef<FShaderTestVS> VertexShader(GlobalShaderMap);
+        TShaderMapRef<FShaderTestMRTPS> PixelShader(GlobalShaderMap);
+
+        FMyTextureVertexDeclaration VertexDec;
+        VertexDec.InitRHI();
+
+        FGraphicsPipelineStateInitializer GraphicsPSOInit;
+        RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+        GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+        GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+        GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+        GraphicsPSOInit.PrimitiveType = PT_TriangleStrip;
+        GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = VertexDec.VertexDeclarationRHI;
+        GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+        GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+        SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit);
+
+        RHICmdList.SetViewport(0, 0, 0.0f, DrawTargetResolution.X, DrawTargetResolution.Y, 1.0f);
+        PixelShader->SetParameters(RHICmdList, PixelShader.GetPixelShader(), MyTexture, Tints);
+
+        FRHIResourceCreateInfo CreateInfo;
+        FVertexBufferRHIRef VertexBufferRHI = RHICreateVertexBuffer(sizeof(FMyTextureVertex) * 4, BUF_Volatile, CreateInfo);
+        FMyTextureVertex* Data = reinterpret_cast<FMyTextureVertex*>(RHILockVertexBuffer(VertexBufferRHI, 0, sizeof(FMyTextureVertex) * 4, RLM_WriteOnly));
+
+        Data[0].Position = FVector4(-1.0f, 1.0f, 0, 1.0f);
+        Data[1].Position = FVector4(1.0f, 1.0f, 0, 1.0f);
+        Data[2].Position = FVector4(-1.0f, -1.0f, 0, 1.0f);
+        Data[3].Position = FVector4(1.0f, -1.0f, 0, 1.0f);
+        Data[0].UV = FVector2D(0.0f, 0.0f);
+        Data[1].UV = FVector2D(1.0f, 0.0f);
+        Data[2].UV = FVector2D(0.0f, 1.0f);
+        Data[3].UV = FVector2D(1.0f, 1.0f);
+
+        RHIUnlockVertexBuffer(VertexBufferRHI);
+
+        RHICmdList.SetStreamSource(0, VertexBufferRHI, 0);
+        RHICmdList.DrawPrimitive(0, 2, 1);
+    }
+    RHICmdList.EndRenderPass();
+
+    for (int32 Index = 0; Index < TargetResources.Num(); ++Index)
+    {
+        RHICmdList.Transition(FRHITransitionInfo(RenderTargets[Index], ERHIAccess::RTV, ERHIAccess::SRVMask));
+    }
+}
+
+void UTestShaderBlueprintLibrary::DrawTestShaderVariants(
+    UTextureRenderTarget2D* VariantOne,
+    UTextureRenderTarget2D* VariantTwo,
+    UTextureRenderTarget2D* VariantThree,
+    UTextureRenderTarget2D* VariantFour,
+    AActor* Ac,
+    UTexture* MyTexture,
+    FMyShaderStructData ShaderStructData
+)
+{
+    check(IsInGameThread());
+
+    if (Ac == nullptr || !CanDispatchGPUWork())
+    {
+        return;
+    }
+
+    if (!MyTexture)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("The Texture is Missing. Custom shader failed."));
+        return;
+    }
+
+    // the targets given, packed into the first render target slots, each with the tint of its variant
+    UTextureRenderTarget2D* const Variants[NumShaderVariants] = { VariantOne, VariantTwo, VariantThree, VariantFour };
+    const FLinearColor VariantTints[NumShaderVariants] = { ShaderStructData.ColorOne, ShaderStructData.ColorTwo, ShaderStructData.ColorThree, ShaderStructData.ColorFour };
+
+    TArray<FTextureRenderTargetResource*> TargetResources;
+    TArray<FLinearColor> Tints;
+    const UTextureRenderTarget2D* First = nullptr;
+    for (int32 Index = 0; Index < NumShaderVariants; ++Index)
+    {
+        if (Variants[Index] == nullptr)
+        {
+            continue;
+        }
+
+        First = First != nullptr ? First : Variants[Index];
+        if (Variants[Index]->SizeX != First->SizeX || Variants[Index]->SizeY != First->SizeY)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("The variant render targets differ in size. Custom shader failed."));
+            return;
+        }
+
+        // one texture bound to two render target slots is undefined
+        for (int32 Other = 0; Other < Index; ++Other)
+        {
+            if (Variants[Other] == Variants[Index])
+            {
+                UE_LOG(LogTemp, Warning, TEXT("A render target is given for more than one variant. Custom shader failed."));
+                return;
+            }
+        }
+
+        TargetResources.Add(Variants[Index]->GameThread_GetRenderTargetResource());
+        Tints.Add(VariantTints[Index]);
+    }
+
+    if (TargetResources.Num() == 0)
+    {
+        return;
+    }
+
+    ERHIFeatureLevel::Type FeatureLevel = Ac->GetWorld()->Scene->GetFeatureLevel();
+    FTextureReferenceRHIRef MyTextureReferenceRHI = MyTexture->TextureReference.TextureReferenceRHI;
+
+    // not coalesced, a queued job drawing another set of targets may share one with this
+    FGraphicToolsGPUJob Job;
+    Job.Name = TEXT("ShaderTest.Variants");
+    Job.Objects.Add(MyTexture);
+    for (UTextureRenderTarget2D* Variant : Variants)
+    {
+        if (Variant != nullptr)
+        {
+            Job.Objects.AddUnique(Variant);
+        }
+    }
+    Job.Work = [TargetResources = MoveTemp(TargetResources), Tints = MoveTemp(Tints), FeatureLevel, MyTextureReferenceRHI](FRHICommandListImmediate& RHICmdList)
+    {
+        FRHITexture* MyTextureRHI = MyTextureReferenceRHI->GetTextureReference()->GetReferencedTexture();
+        DrawTestShaderVariants_RenderThread(RHICmdList, TargetResources, Tints, FeatureLevel, MyTextureRHI);
+    };
+    FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+}
+
+// Texels around each atlas entry, filled by stretching its edges
+static const int32 AtlasPadding = 1;
+
+/** One entry of an atlas page pass, Rect includes the padding */
+struct FMyAtlasDraw
+{
+    FIntRect Rect;
+    FLinearColor MyColor;
+    FTextureReferenceRHIRef MyTexture;
+    FMyShaderStructData ShaderStructData;
+};
+
+// DrawTestShaderRenderTarget_RenderThread for every entry in one pass over the page, a viewport each
+static void DrawAtlasEntries_RenderThread(
+    FRHICommandListImmediate& RHICmdList,
+    FTextureRenderTargetResource* PageResource,
+    ERHIFeatureLevel::Type FeatureLevel,
+    const TArray<FMyAtlasDraw>& Draws
+)
+{
+    check(IsInRenderingThread());
+
+    SCOPED_DRAW_EVENTF(RHICmdList, ShaderTestAtlas, TEXT("ShaderTest Atlas %d entries"), Draws.Num());
+
+    // every entry's quad in one buffer, the UVs reach past [0, 1] into the padding where the clamped sampler repeats the edge
+    FRHIResourceCreateInfo CreateInfo;
+    FVertexBufferRHIRef VertexBufferRHI = RHICreateVertexBuffer(sizeof(FMyTextureVertex) * 4 * Draws.Num(), BUF_Volatile, CreateInfo);
+    FMyTextureVertex* Data = reinterpret_cast<FMyTextureVertex*>(RHILockVertexBuffer(VertexBufferRHI, 0, sizeof(FMyTextureVertex) * 4 * Draws.Num(), RLM_WriteOnly));
+    for (const FMyAtlasDraw& Draw : Draws)
+    {
+        const FVector2D InnerSize(Draw.Rect.Width() - 2 * AtlasPadding, Draw.Rect.Height() - 2 * AtlasPadding);
+        const FVector2D UVMin(-AtlasPadding / InnerSize.X, -AtlasPadding / InnerSize.Y);
+        const FVector2D UVMax(1.0f + AtlasPadding / InnerSize.X, 1.0f + AtlasPadding / InnerSize.Y);
+
+        Data[0].Position = FVector4(-1.0f, 1.0f, 0, 1.0f);
+        Data[1].Position = FVector4(1.0f, 1.0f, 0, 1.0f);
+        Data[2].Position = FVector4(-1.0f, -1.0f, 0, 1.0f);
+        Data[3].Position = FVector4(1.0f, -1.0f, 0, 1.0f);
+        Data[0].UV = FVector2D(UVMin.X, UVMin.Y);
+        Data[1].UV = FVector2D(UVMax.X, UVMin.Y);
+        Data[2].UV = FVector2D(UVMin.X, UVMax.Y);
+        Data[3].UV = FVector2D(UVMax.X, UVMax.Y);
+        Data += 4;
+    }
+    RHIUnlockVertexBuffer(VertexBufferRHI);
+
+    FRHITexture2D* PageTexture = PageResource->GetRenderTargetTexture();
+
+    // the entries not drawn this time keep their contents
+    RHICmdList.Transition(FRHITransitionInfo(PageTexture, ERHIAccess::SRVMask, ERHIAccess::RTV));
+    FRHIRenderPassInfo RenderPassInfo(PageTexture, ERenderTargetActions::Load_Store);
+
+    RHICmdList.BeginRenderPass(RenderPassInfo, TEXT("MyShaderTestAtlas"));
+    {
+        FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(FeatureLevel);
+        TShaderMapRef<FShaderTestVS> VertexShader(GlobalShaderMap);
+        TShaderMapRef<FShaderTestPS> PixelShader(GlobalShaderMap);
+
+        FMyTextureVertexDeclaration VertexDec;
+        VertexDec.InitRHI();
+
+        FGraphicsPipelineStateInitializer GraphicsPSOInit;
+        RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+        GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+        GraphicsPSOInit.BlendState = TStaticBlendState<>::GetRHI();
+        GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+        GraphicsPSOInit.PrimitiveType = PT_TriangleStrip;
+        GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = VertexDec.VertexDeclarationRHI;
+        GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+        GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+        SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit);
+
+        RHICmdList.SetStreamSource(0, VertexBufferRHI, 0);
+
+        for (int32 Index = 0; Index < Draws.Num(); ++Index)
+        {
+            const FMyAtlasDraw& Draw = Draws[Index];
+            FRHITexture* MyTextureRHI = Draw.MyTexture->GetTextureReference()->GetReferencedTexture();
+
+            RHICmdList.SetViewport(Draw.Rect.Min.X, Draw.Rect.Min.Y, 0.0f, Draw.Rect.Max.X, Draw.Rect.Max.Y, 1.0f);
+            PixelShader->SetParameters(RHICmdList, PixelShader.GetPixelShader(), Draw.MyColor, MyTextureRHI, Draw.ShaderStructData);
+            RHICmdList.DrawPrimitive(Index * 4, 2, 1);
+        }
+    }
+    RHICmdList.EndRenderPass();
+
+    RHICmdList.Transition(FRHITransitionInfo(PageTexture, ERHIAccess::RTV, ERHIAccess::SRVMask));
+}
+
+UMyShaderAtlas* UMyShaderAtlas::CreateShaderAtlas(int32 PageSize, EGraphicToolsOutputFormat Format)
+{
+    check(IsInGameThread());
+
+    UMyShaderAtlas* Atlas = NewObject<UMyShaderAtlas>();
+    Atlas->PageSize = FMath::Clamp(PageSize, 256, (int32)GetMax2DTextureDimension());
+    Atlas->Format = Format;
+    return Atlas;
+}
+
+bool UMyShaderAtlas::AllocateOnPage(int32 PageIndex, FIntPoint PaddedSize, FIntRect& OutRect)
+{
+    TArray<FShelf>& PageShelves = Shelves[PageIndex];
+
+    // a shelf at most a quarter taller than the entry, so small entries don't waste the height of large ones
+    for (FShelf& Shelf : PageShelves)
+    {
+        if (Shelf.Height >= PaddedSize.Y && Shelf.Height <= PaddedSize.Y + PaddedSize.Y / 4 && Shelf.NextX + PaddedSize.X <= PageSize)
+        {
+            OutRect = FIntRect(FIntPoint(Shelf.NextX, Shelf.Y), FIntPoint(Shelf.NextX, Shelf.Y) + PaddedSize);
+            Shelf.NextX += PaddedSize.X;
+            return true;
+        }
+    }
+
+    const int32 NextY = PageShelves.Num() > 0 ? PageShelves.Last().Y + PageShelves.Last().Height : 0;
+    if (NextY + PaddedSize.Y > PageSize)
+    {
+        return false;
+    }
+
+    FShelf& Shelf = PageShelves.AddDefaulted_GetRef();
+    Shelf.Y = NextY;
+    Shelf.Height = PaddedSize.Y;
+    Shelf.NextX = PaddedSize.X;
+    OutRect = FIntRect(FIntPoint(0, NextY), FIntPoint(0, NextY) + PaddedSize);
+    return true;
+}
+
+FMyShaderAtlasEntry UMyShaderAtlas::MakeEntry(int32 Id, const FSlot& Slot) const
+{
+    const FIntRect Inner(Slot.Rect.Min + FIntPoint(AtlasPadding), Slot.Rect.Max - FIntPoint(AtlasPadding));
+
+    FMyShaderAtlasEntry Entry;
+    Entry.Id = Id;
+    Entry.Texture = Pages[Slot.Page];
+    Entry.Size = Inner.Size();
+    Entry.UVScaleBias = FLinearColor(
+        (float)Inner.Width() / PageSize,
+        (float)Inner.Height() / PageSize,
+        (float)Inner.Min.X / PageSize,
+        (float)Inner.Min.Y / PageSize);
+    return Entry;
+}
+
+FMyShaderAtlasEntry UMyShaderAtlas::Allocate(FIntPoint Size)
+{
+    check(IsInGameThread());
+
+    const FIntPoint PaddedSize = Size + FIntPoint(2 * AtlasPadding);
+    if (Size.X <= 0 || Size.Y <= 0 || PaddedSize.X > PageSize || PaddedSize.Y > PageSize)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("An atlas entry of %dx%d doesn't fit on pages of %d. Allocation failed."), Size.X, Size.Y, PageSize);
+        return FMyShaderAtlasEntry();
+    }
+
+    FSlot Slot;
+    const int32 FreeIndex = FreeSlots.IndexOfByPredicate([PaddedSize](const FSlot& Free) { return Free.Rect.Size() == PaddedSize; });
+    if (FreeIndex != INDEX_NONE)
+    {
+        Slot = FreeSlots[FreeIndex];
+        FreeSlots.RemoveAtSwap(FreeIndex);
+    }
+    else
+    {
+        int32 PageIndex = 0;
+        while (PageIndex < Pages.Num() && !AllocateOnPage(PageIndex, PaddedSize, Slot.Rect))
+        {
+            ++PageIndex;
+        }
+
+        if (PageIndex == Pages.Num())
+        {
+            UTextureRenderTarget2D* Page = NewObject<UTextureRenderTarget2D>(this);
+            Page->ClearColor = FLinearColor::Transparent;
+            Page->InitCustomFormat(PageSize, PageSize, GetOutputPixelFormat(Format), true);
+            Pages.Add(Page);
+            Shelves.AddDefaulted();
+            verify(AllocateOnPage(PageIndex, PaddedSize, Slot.Rect));
+        }
+        Slot.Page = PageIndex;
+    }
+
+    const int32 Id = NextId++;
+    Slots.Add(Id, Slot);
+    return MakeEntry(Id, Slot);
+}
+
+void UMyShaderAtlas::Free(const FMyShaderAtlasEntry& Entry)
+{
+    check(IsInGameThread());
+
+    FSlot Slot;
+    if (!Slots.RemoveAndCopyValue(Entry.Id, Slot))
+    {
+        return;
+    }
+
+    if (TArray<FPendingDraw>* Draws = PendingDraws.Find(Slot.Page))
+    {
+        Draws->RemoveAll([&Slot](const FPendingDraw& Draw) { return Draw.Rect == Slot.Rect; });
+    }
+    FreeSlots.Add(Slot);
+}
+
+void UMyShaderAtlas::DrawEntry(const FMyShaderAtlasEntry& Entry, FLinearColor MyColor, UTexture* MyTexture, FMyShaderStructData ShaderStructData)
+{
+    check(IsInGameThread());
+
+    const FSlot* Slot = Slots.Find(Entry.Id);
+    if (Slot == nullptr || !CanDispatchGPUWork())
+    {
+        return;
+    }
+
+    if (!MyTexture)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("The Texture is Missing. Custom shader failed."));
+        return;
+    }
+
+    // drawing an entry twice before the tick keeps the last one
+    TArray<FPendingDraw>& Draws = PendingDraws.FindOrAdd(Slot->Page);
+    FPendingDraw* Draw = Draws.FindByPredicate([Slot](const FPendingDraw& Pending) { return Pending.Rect == Slot->Rect; });
+    if (Draw == nullptr)
+    {
+        Draw = &Draws.AddDefaulted_GetRef();
+        Draw->Rect = Slot->Rect;
+    }
+    Draw->MyColor = MyColor;
+    Draw->MyTexture = MyTexture;
+    Draw->ShaderStructData = ShaderStructData;
+}
+
+void UMyShaderAtlas::ApplyEntryToMaterial(const FMyShaderAtlasEntry& Entry, UMaterialInstanceDynamic* Material, FName TextureParameter, FName ScaleBiasParameter)
+{
+    if (Material == nullptr || Entry.Texture == nullptr)
+    {
+        return;
+    }
+
+    Material->SetTextureParameterValue(TextureParameter, Entry.Texture);
+    Material->SetVectorParameterValue(ScaleBiasParameter, Entry.UVScaleBias);
+}
+
+void UMyShaderAtlas::Tick(float DeltaTime)
+{
+    const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+    for (TPair<int32, TArray<FPendingDraw>>& Page : PendingDraws)
+    {
+        TArray<FMyAtlasDraw> Draws;
+        Draws.Reserve(Page.Value.Num());
+        for (const FPendingDraw& Pending : Page.Value)
+        {
+            if (UTexture* MyTexture = Pending.MyTexture.Get())
+            {
+                FMyAtlasDraw& Draw = Draws.AddDefaulted_GetRef();
+                Draw.Rect = Pending.Rect;
+                Draw.MyColor = Pending.MyColor;
+                Draw.MyTexture = MyTexture->TextureReference.TextureReferenceRHI;
+                Draw.ShaderStructData = Pending.ShaderStructData;
+            }
+        }
+
+        if (Draws.Num() == 0)
+        {
+            continue;
+        }
+
+        // not coalesced by page, a job still queued from an earlier tick holds other entries
+        FGraphicToolsGPUJob Job;
+        Job.Name = TEXT("ShaderTest.Atlas");
+        Job.Objects.Add(Pages[Page.Key]);
+        for (const FPendingDraw& Pending : Page.Value)
+        {
+            if (UTexture* MyTexture = Pending.MyTexture.Get())
+            {
+                Job.Objects.AddUnique(MyTexture);
+            }
+        }
+        Job.Work = [PageResource = Pages[Page.Key]->GameThread_GetRenderTargetResource(), FeatureLevel, Draws = MoveTemp(Draws)](FRHICommandListImmediate& RHICmdList)
+        {
+            DrawAtlasEntries_RenderThread(RHICmdList, PageResource, FeatureLevel, Draws);
+        };
+        FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+    }
+
+    PendingDraws.Reset();
+}
+
+static void TextureWriting_RenderingThread(
+    FRHICommandListImmediate& RHICmdList,
+    ERHIFeatureLevel::Type FeatureLevel,
+    UTexture2D* MyTexture
+)
+{
+    check(IsInRenderingThread());
+
+    if (MyTexture == nullptr)
+    {
+        return;
+    }
+    
+    FTextureReferenceRHIRef MyTextureRHI = MyTexture->TextureReference.TextureReferenceRHI;
+    FRHITexture2D* MyTexRef2D = MyTextureRHI->GetTextureReference()->GetReferencedTexture()->GetTexture2D();
+
+
+    TArray<FColor> BitMap;
+    uint32 DestStride = 0;
+
+    uint8* MyTextureData = (uint8*)RHICmdList.LockTexture2D(MyTexRef2D, 0, EResourceLockMode::RLM_ReadOnly, DestStride, false);
+
+    for (uint32 Row = 0; Row < MyTexRef2D->GetSizeY(); ++Row)
+	{
+		for (uint32 Col = 0; Col < MyTexRef2D->GetSizeX(); ++Col)
+		{
+            uint32 EncodedPixel = *(uint32*)(MyTextureData + Col * sizeof(uint32) + Row * DestStride);
+            uint8 R = (EncodedPixel & 0x000000FF);
+            uint8 G = (EncodedPixel & 0x0000FF00) >> 8;
+            uint8 B = (EncodedPixel & 0x00FF0000) >> 16;
             uint8 A = (EncodedPixel & 0xFF000000) >> 24;
 			BitMap.Add(FColor(R, G, B, A));
 		}
@@ -424,7 +1710,7 @@ void UTestShaderBlueprintLibrary::TextureWriting(UTexture2D* TextureToBeWritten,
 {
     check(IsInGameThread());
 
-    if (TextureToBeWritten == nullptr || SelfRef == nullptr)
+    if (TextureToBeWritten == nullptr || SelfRef == nullptr || !CanDispatchGPUWork())
     {
         return;
     }
@@ -472,12 +1758,64 @@ void UTestShaderBlueprintLibrary::TextureWriting(UTexture2D* TextureToBeWritten,
 void UTestShaderBlueprintLibrary::DrawComputeShaderResult(
     UTextureRenderTarget2D* ComputedRenderTarget,
     AActor* Ac,
-    FMyShaderStructData ShaderStructData
+    FMyShaderStructData ShaderStructData,
+    EGraphicToolsOutputFormat OutputFormat,
+    EGraphicToolsGPUJobPriority Priority
+)
+{
+    check(IsInGameThread());
+
+    if (Ac == nullptr || ComputedRenderTarget == nullptr || !CanDispatchGPUWork())
+    {
+        return;
+    }
+
+    if (!PrepareOutputRenderTarget(ComputedRenderTarget, OutputFormat, TEXT("DrawComputeShaderResult")))
+    {
+        return;
+    }
+
+    UWorld* World = Ac->GetWorld();
+    ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();
+
+    FTextureRenderTargetResource* TextureRenderTargetResource = ComputedRenderTarget->GameThread_GetRenderTargetResource();
+
+    FGraphicToolsGPUJob Job;
+    Job.Name = TEXT("ShaderTest.Compute");
+    Job.Priority = Priority;
+    Job.CoalesceKey = FObjectKey(ComputedRenderTarget);
+    Job.Work = [TextureRenderTargetResource, ShaderStructData, FeatureLevel, OutputFormat](FRHICommandListImmediate& RHICmdList)
+    {
+        UseComputeShader_RenderThread
+        (
+            RHICmdList,
+            TextureRenderTargetResource,
+            ShaderStructData,
+            FeatureLevel,
+            OutputFormat
+        );
+    };
+    FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+
+}
+
+void UTestShaderBlueprintLibrary::DrawComputeShaderResultAdaptive(
+    UTextureRenderTarget2D* ComputedRenderTarget,
+    AActor* Ac,
+    FMyShaderStructData ShaderStructData,
+    float VarianceThreshold,
+    EGraphicToolsOutputFormat OutputFormat,
+    EGraphicToolsGPUJobPriority Priority
 )
 {
     check(IsInGameThread());
 
-    if (Ac == nullptr || ComputedRenderTarget == nullptr)
+    if (Ac == nullptr || ComputedRenderTarget == nullptr || !CanDispatchGPUWork())
+    {
+        return;
+    }
+
+    if (!PrepareOutputRenderTarget(ComputedRenderTarget, OutputFormat, TEXT("DrawComputeShaderResultAdaptive")))
     {
         return;
     }
@@ -487,19 +1825,371 @@ void UTestShaderBlueprintLibrary::DrawComputeShaderResult(
 
     FTextureRenderTargetResource* TextureRenderTargetResource = ComputedRenderTarget->GameThread_GetRenderTargetResource();
 
-    ENQUEUE_RENDER_COMMAND(CaptureCommand)(
-        [TextureRenderTargetResource, ShaderStructData, FeatureLevel](FRHICommandListImmediate& RHICmdList)
-        {
-            UseComputeShader_RenderThread
-            (
-                RHICmdList,
-                TextureRenderTargetResource,
-                ShaderStructData,
-				FeatureLevel
-			);
-	}
-	);
+    FGraphicToolsGPUJob Job;
+    Job.Name = TEXT("ShaderTest.Adaptive");
+    Job.Priority = Priority;
+    Job.CoalesceKey = FObjectKey(ComputedRenderTarget);
+    Job.Work = [TextureRenderTargetResource, ShaderStructData, FeatureLevel, OutputFormat, VarianceThreshold](FRHICommandListImmediate& RHICmdList)
+    {
+        UseAdaptiveComputeShader_RenderThread(RHICmdList, TextureRenderTargetResource, ShaderStructData, FeatureLevel, OutputFormat, VarianceThreshold);
+    };
+    FGraphicToolsGPUScheduler::Submit(MoveTemp(Job));
+}
 
+void UTestShaderBlueprintLibrary::DrawComputeShaderResultTiled(
+    UTextureRenderTarget2D* ComputedRenderTarget,
+    AActor* Ac,
+    FMyShaderStructData ShaderStructData,
+    FMyTiledGenerationSettings Settings,
+    EGraphicToolsOutputFormat OutputFormat
+)
+{
+    DrawComputeShaderResultTiledWithCallback(ComputedRenderTarget, Ac, ShaderStructData, Settings, OutputFormat, nullptr);
+}
+
+void UTestShaderBlueprintLibrary::DrawComputeShaderResultTiledWithCallback(
+    UTextureRenderTarget2D* ComputedRenderTarget,
+    AActor* Ac,
+    const FMyShaderStructData& ShaderStructData,
+    const FMyTiledGenerationSettings& Settings,
+    EGraphicToolsOutputFormat OutputFormat,
+    TFunction<void()>&& OnFinished
+)
+{
+    check(IsInGameThread());
+
+    // OnFinished runs whatever happens, the async node waits on it
+    const bool bExport = !Settings.ExportDirectory.IsEmpty();
+    const FIntPoint ImageSize = ComputedRenderTarget != nullptr ? FIntPoint(ComputedRenderTarget->SizeX, ComputedRenderTarget->SizeY) : Settings.ImageSize;
+    if (Ac == nullptr || (ComputedRenderTarget == nullptr && !bExport) || ImageSize.X <= 0 || ImageSize.Y <= 0 || !CanDispatchGPUWork())
+    {
+        if (OnFinished)
+        {
+            OnFinished();
+        }
+        return;
+    }
+
+    if (bExport && OutputFormat != EGraphicToolsOutputFormat::R8G8B8A8 && OutputFormat != EGraphicToolsOutputFormat::FloatRGBA)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Tiles are only exported from R8G8B8A8 or FloatRGBA. Tiled generation failed."));
+        if (OnFinished)
+        {
+            OnFinished();
+        }
+        return;
+    }
+
+    if (ComputedRenderTarget != nullptr && !PrepareOutputRenderTarget(ComputedRenderTarget, OutputFormat, TEXT("DrawComputeShaderResultTiled")))
+    {
+        if (OnFinished)
+        {
+            OnFinished();
+        }
+        return;
+    }
+
+    TSharedRef<FMyTiledGenerationState, ESPMode::ThreadSafe> State = MakeShared<FMyTiledGenerationState, ESPMode::ThreadSafe>();
+    State->ImageSize = ImageSize;
+    // at least one thread group, and no larger than the image
+    State->TileSize = FMath::Min(FMath::Max(Settings.TileSize, 32), FMath::Max(ImageSize.X, ImageSize.Y));
+    State->NumTiles = FIntPoint(FMath::DivideAndRoundUp(ImageSize.X, State->TileSize), FMath::DivideAndRoundUp(ImageSize.Y, State->TileSize));
+    State->TilesPerFrame = Settings.TilesPerFrame;
+    State->OutputFormat = OutputFormat;
+    State->ShaderStructData = ShaderStructData;
+    State->FeatureLevel = Ac->GetWorld()->Scene->GetFeatureLevel();
+    State->Target = ComputedRenderTarget != nullptr ? ComputedRenderTarget->GameThread_GetRenderTargetResource() : nullptr;
+
+    if (bExport)
+    {
+        // relative directories are under Saved
+        State->ExportDirectory = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir(), Settings.ExportDirectory);
+        IFileManager::Get().MakeDirectory(*State->ExportDirectory, true);
+    }
+
+    FMyTiledGeneration::Start(ComputedRenderTarget, State, MoveTemp(OnFinished));
+}
+ 
+UTestShaderAsyncAction* UTestShaderAsyncAction::DrawTestShaderRenderTargetAsync(
+    UTextureRenderTarget2D* OutputRenderTarget,
+    AActor* Ac,
+    FLinearColor MyColor,
+    UTexture* MyTexture,
+    FMyShaderStructData ShaderStructData
+)
+{
+    return Create<UTestShaderAsyncAction>(Ac, [OutputRenderTarget, Ac, MyColor, MyTexture, ShaderStructData]()
+    {
+        UTestShaderBlueprintLibrary::DrawTestShaderRenderTarget(OutputRenderTarget, Ac, MyColor, MyTexture, ShaderStructData);
+    });
+}
+
+UTestShaderAsyncAction* UTestShaderAsyncAction::TextureWritingAsync(UTexture2D* TextureToBeWritten, AActor* SelfRef)
+{
+    return Create<UTestShaderAsyncAction>(SelfRef, [TextureToBeWritten, SelfRef]()
+    {
+        UTestShaderBlueprintLibrary::TextureWriting(TextureToBeWritten, SelfRef);
+    });
+}
+
+UTestShaderAsyncAction* UTestShaderAsyncAction::DrawComputeShaderResultAsync(
+    UTextureRenderTarget2D* ComputedRenderTarget,
+    AActor* Ac,
+    FMyShaderStructData ShaderStructData,
+    EGraphicToolsOutputFormat OutputFormat
+)
+{
+    return Create<UTestShaderAsyncAction>(Ac, [ComputedRenderTarget, Ac, ShaderStructData, OutputFormat]()
+    {
+        UTestShaderBlueprintLibrary::DrawComputeShaderResult(ComputedRenderTarget, Ac, ShaderStructData, OutputFormat);
+    });
+}
+ 
+UTestShaderAsyncAction* UTestShaderAsyncAction::DrawComputeShaderResultAdaptiveAsync(
+    UTextureRenderTarget2D* ComputedRenderTarget,
+    AActor* Ac,
+    FMyShaderStructData ShaderStructData,
+    float VarianceThreshold,
+    EGraphicToolsOutputFormat OutputFormat
+)
+{
+    return Create<UTestShaderAsyncAction>(Ac, [ComputedRenderTarget, Ac, ShaderStructData, VarianceThreshold, OutputFormat]()
+    {
+        UTestShaderBlueprintLibrary::DrawComputeShaderResultAdaptive(ComputedRenderTarget, Ac, ShaderStructData, VarianceThreshold, OutputFormat);
+    });
 }
+
+UTestShaderAsyncAction* UTestShaderAsyncAction::DrawComputeShaderResultTiledAsync(
+    UTextureRenderTarget2D* ComputedRenderTarget,
+    AActor* Ac,
+    FMyShaderStructData ShaderStructData,
+    FMyTiledGenerationSettings Settings,
+    EGraphicToolsOutputFormat OutputFormat
+)
+{
+    return CreateSpanningFrames<UTestShaderAsyncAction>(Ac, [ComputedRenderTarget, Ac, ShaderStructData, Settings, OutputFormat](TFunction<void()>&& OnEnqueued)
+    {
+        UTestShaderBlueprintLibrary::DrawComputeShaderResultTiledWithCallback(ComputedRenderTarget, Ac, ShaderStructData, Settings, OutputFormat, MoveTemp(OnEnqueued));
+    });
+}
+
+static void ReadSurface_RenderThread(FRHICommandListImmediate& RHICmdList, FRHITexture2D* Surface, TArray<FLinearColor>& OutPixels)
+{
+    RHICmdList.Transition(FRHITransitionInfo(Surface, ERHIAccess::Unknown, ERHIAccess::CopySrc));
+    FRHIGPUTextureReadback Readback(TEXT("ShaderTest.BenchmarkSurface"));
+    Readback.EnqueueCopy(RHICmdList, Surface);
+    RHICmdList.BlockUntilGPUIdle();
+
+    const FIntPoint Size = Surface->GetSizeXY();
+    OutPixels.SetNumUninitialized(Size.X * Size.Y);
+
+    void* Data = nullptr;
+    int32 RowPitchInPixels = 0;
+    Readback.LockTexture(RHICmdList, Data, RowPitchInPixels);
+    for (int32 Row = 0; Row < Size.Y; ++Row)
+    {
+        const FFloat16Color* Source = static_cast<const FFloat16Color*>(Data) + Row * RowPitchInPixels;
+        for (int32 Col = 0; Col < Size.X; ++Col)
+        {
+            OutPixels[Row * Size.X + Col] = FLinearColor(Source[Col]);
+        }
+    }
+    Readback.Unlock();
+}
+
+static void RunAdaptiveBenchmark(const TArray<FString>& Args)
+{
+    check(IsInGameThread());
+
+    if (!CanDispatchGPUWork() || GMaxRHIFeatureLevel < ERHIFeatureLevel::SM5)
+    {
+        return;
+    }
+
+    const int32 Size = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2048, 64, 8192);
+    const float VarianceThreshold = FMath::Max(Args.Num() > 1 ? FCString::Atof(*Args[1]) : 0.0005f, 0.0f);
+    const int32 Iterations = FMath::Clamp(Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 10, 1, 1000);
+    const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+    // ColorOne.r is the fractal's time
+    FMyShaderStructData ShaderStructData;
+    ShaderStructData.ColorOne = FLinearColor(10.0f, 0.0f, 0.0f, 1.0f);
+    ShaderStructData.ColorTwo = FLinearColor::White;
+    ShaderStructData.ColorThree = FLinearColor::White;
+    ShaderStructData.ColorFour = FLinearColor::White;
+    ShaderStructData.ColorIndex = 0;
+
+    ENQUEUE_RENDER_COMMAND(ShaderTestAdaptiveBenchmark)(
+        [Size, VarianceThreshold, Iterations, FeatureLevel, ShaderStructData](FRHICommandListImmediate& RHICmdList)
+        {
+            if (!GSupportsTimestampRenderQueries)
+            {
+                UE_LOG(LogShaderTestBenchmark, Warning, TEXT("This RHI has no timestamp queries, nothing to measure with"));
+                return;
+            }
+
+            FRHIResourceCreateInfo CreateInfo;
+            FTexture2DRHIRef FullSurface = RHICreateTexture2D(Size, Size, PF_FloatRGBA, 1, 1, TexCreate_ShaderResource | TexCreate_UAV, CreateInfo);
+            FTexture2DRHIRef AdaptiveSurface = RHICreateTexture2D(Size, Size, PF_FloatRGBA, 1, 1, TexCreate_ShaderResource | TexCreate_UAV, CreateInfo);
+            FUnorderedAccessViewRHIRef FullUAV = RHICreateUnorderedAccessView(FullSurface);
+
+            FMyComputeShader::FPermutationDomain PermutationVector;
+            PermutationVector.Set<FMyComputeShader::FOutputFormatDim>((int32)EGraphicToolsOutputFormat::FloatRGBA);
+            TShaderMapRef<FMyComputeShader> ComputeShader(GetGlobalShaderMap(FeatureLevel), PermutationVector);
+
+            const float FullMs = TimeOnGPU(RHICmdList, Iterations, [&]()
+            {
+                RHICmdList.Transition(FRHITransitionInfo(FullSurface, ERHIAccess::Unknown, ERHIAccess::UAVCompute));
+                RHICmdList.SetComputeShader(ComputeShader.GetComputeShader());
+                ComputeShader->SetParameters(RHICmdList, FullUAV, ShaderStructData, FIntPoint::ZeroValue, FIntPoint(Size, Size));
+                RHICmdList.DispatchComputeShader(FMath::DivideAndRoundUp(Size, 32), FMath::DivideAndRoundUp(Size, 32), 1);
+                ComputeShader->UnsetParameters(RHICmdList);
+            });
+
+            FMyAdaptiveResources Resources;
+            InitAdaptiveResources(Resources, FIntPoint(Size, Size), VarianceThreshold);
+            Resources.OutputUAV = RHICreateUnorderedAccessView(AdaptiveSurface);
+
+            const float AdaptiveMs = TimeOnGPU(RHICmdList, Iterations, [&]()
+            {
+                DispatchAdaptiveComputeShader_RenderThread(RHICmdList, AdaptiveSurface, Resources, ShaderStructData, FeatureLevel, EGraphicToolsOutputFormat::FloatRGBA);
+            });
+
+            // how much of the image was shaded in full, only the benchmark reads this back
+            RHICmdList.Transition(FRHITransitionInfo(Resources.TileCount.Buffer, ERHIAccess::Unknown, ERHIAccess::CopySrc));
+            FRHIGPUBufferReadback CountReadback(TEXT("ShaderTest.BenchmarkTileCount"));
+            CountReadback.EnqueueCopy(RHICmdList, Resources.TileCount.Buffer, sizeof(uint32));
+
+            TArray<FLinearColor> FullPixels;
+            TArray<FLinearColor> AdaptivePixels;
+            ReadSurface_RenderThread(RHICmdList, FullSurface, FullPixels);
+            ReadSurface_RenderThread(RHICmdList, AdaptiveSurface, AdaptivePixels);
+
+            const uint32 NumRefined = *static_cast<const uint32*>(CountReadback.Lock(sizeof(uint32)));
+            CountReadback.Unlock();
+
+            double SquaredError = 0.0;
+            float MaxError = 0.0f;
+            for (int32 Index = 0; Index < FullPixels.Num(); ++Index)
+            {
+                const FLinearColor Difference = AdaptivePixels[Index] - FullPixels[Index];
+                SquaredError += Difference.R * Difference.R + Difference.G * Difference.G + Difference.B * Difference.B;
+                MaxError = FMath::Max3(MaxError, FMath::Abs(Difference.R), FMath::Max(FMath::Abs(Difference.G), FMath::Abs(Difference.B)));
+            }
+            const double MeanSquaredError = SquaredError / (3.0 * FullPixels.Num());
+            const double PSNR = MeanSquaredError > 0.0 ? 10.0 * FMath::LogX(10.0, 1.0 / MeanSquaredError) : 99.0;
+
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("Adaptive fractal, %dx%d, threshold %g, %d iterations:"), Size, Size, VarianceThreshold, Iterations);
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("  %-24s %8.3f ms"), TEXT("Full"), FullMs);
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("  %-24s %8.3f ms   %5.2fx   %5.1f%% of %d tiles refined"),
+                TEXT("Adaptive"),
+                AdaptiveMs,
+                AdaptiveMs > 0.0f ? FullMs / AdaptiveMs : 0.0f,
+                100.0f * NumRefined / (Resources.NumTiles.X * Resources.NumTiles.Y),
+                Resources.NumTiles.X * Resources.NumTiles.Y);
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("  %-24s PSNR %6.2f dB   max error %.4f"), TEXT("Adaptive vs full"), PSNR, MaxError);
+        }
+    );
+}
+
+static FAutoConsoleCommand GBenchmarkAdaptiveCommand(
+    TEXT("ShaderTest.Benchmark.Adaptive"),
+    TEXT("Times the fractal shaded in full and adaptively and reports the difference: ShaderTest.Benchmark.Adaptive [Size=2048] [Threshold=0.0005] [Iterations=10]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunAdaptiveBenchmark)
+);
+
+static void RunBlitBenchmark(const TArray<FString>& Args)
+{
+    check(IsInGameThread());
+
+    if (!CanDispatchGPUWork() || GMaxRHIFeatureLevel < ERHIFeatureLevel::SM5)
+    {
+        return;
+    }
+
+    const int32 Size = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 256, 16, 8192);
+    const int32 NumTargets = FMath::Clamp(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 64, 1, 1024);
+    const int32 Iterations = FMath::Clamp(Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 20, 1, 1000);
+    const ERHIFeatureLevel::Type FeatureLevel = GMaxRHIFeatureLevel;
+
+    FMyShaderStructData ShaderStructData;
+    ShaderStructData.ColorOne = FLinearColor(0.5f, 0.75f, 1.0f, 1.0f);
+    ShaderStructData.ColorTwo = FLinearColor::White;
+    ShaderStructData.ColorThree = FLinearColor::White;
+    ShaderStructData.ColorFour = FLinearColor::White;
+    ShaderStructData.ColorIndex = 0;
+
+    ENQUEUE_RENDER_COMMAND(ShaderTestBlitBenchmark)(
+        [Size, NumTargets, Iterations, FeatureLevel, ShaderStructData](FRHICommandListImmediate& RHICmdList)
+        {
+            if (!GSupportsTimestampRenderQueries)
+            {
+                UE_LOG(LogShaderTestBenchmark, Warning, TEXT("This RHI has no timestamp queries, nothing to measure with"));
+                return;
+            }
+
+            // a gradient, so both paths have something to sample
+            const int32 SourceSize = 256;
+            FRHIResourceCreateInfo CreateInfo;
+            FTexture2DRHIRef Source = RHICreateTexture2D(SourceSize, SourceSize, PF_B8G8R8A8, 1, 1, TexCreate_ShaderResource, CreateInfo);
+            TArray<FColor> SourcePixels;
+            SourcePixels.SetNumUninitialized(SourceSize * SourceSize);
+            for (int32 Index = 0; Index < SourcePixels.Num(); ++Index)
+            {
+                SourcePixels[Index] = FColor(Index % SourceSize, Index / SourceSize, 128, 255);
+            }
+            RHIUpdateTexture2D(Source, 0, FUpdateTextureRegion2D(0, 0, 0, 0, SourceSize, SourceSize), SourceSize * sizeof(FColor), reinterpret_cast<const uint8*>(SourcePixels.GetData()));
+
+            TArray<FTexture2DRHIRef> RasterTargets;
+            TArray<FTexture2DRHIRef> ComputeTargets;
+            TArray<FUnorderedAccessViewRHIRef> ComputeUAVs;
+            for (int32 Index = 0; Index < NumTargets; ++Index)
+            {
+                RasterTargets.Add(RHICreateTexture2D(Size, Size, PF_FloatRGBA, 1, 1, TexCreate_RenderTargetable | TexCreate_ShaderResource, CreateInfo));
+                ComputeTargets.Add(RHICreateTexture2D(Size, Size, PF_FloatRGBA, 1, 1, TexCreate_ShaderResource | TexCreate_UAV, CreateInfo));
+                ComputeUAVs.Add(RHICreateUnorderedAccessView(ComputeTargets.Last()));
+            }
+
+            const float RasterMs = TimeOnGPU(RHICmdList, Iterations, [&]()
+            {
+                for (const FTexture2DRHIRef& Target : RasterTargets)
+                {
+                    DrawTestShaderRaster_RenderThread(RHICmdList, Target, Target, FeatureLevel, FLinearColor::White, Source, ShaderStructData);
+                }
+            });
+
+            const float ComputeMs = TimeOnGPU(RHICmdList, Iterations, [&]()
+            {
+                for (int32 Index = 0; Index < NumTargets; ++Index)
+                {
+                    DrawTestShaderCompute_RenderThread(RHICmdList, ComputeTargets[Index], ComputeUAVs[Index], FeatureLevel, Source, ShaderStructData);
+                }
+            });
+
+            TArray<FLinearColor> RasterPixels;
+            TArray<FLinearColor> ComputePixels;
+            ReadSurface_RenderThread(RHICmdList, RasterTargets[0], RasterPixels);
+            ReadSurface_RenderThread(RHICmdList, ComputeTargets[0], ComputePixels);
+
+            float MaxError = 0.0f;
+            for (int32 Index = 0; Index < RasterPixels.Num(); ++Index)
+            {
+                const FLinearColor Difference = ComputePixels[Index] - RasterPixels[Index];
+                MaxError = FMath::Max3(MaxError, FMath::Abs(Difference.R), FMath::Max(FMath::Abs(Difference.G), FMath::Abs(Difference.B)));
+            }
+
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("DrawTestShaderRenderTarget, %d targets of %dx%d, %d iterations:"), NumTargets, Size, Size, Iterations);
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("  %-24s %8.3f ms"), TEXT("Raster"), RasterMs);
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("  %-24s %8.3f ms   %5.2fx"), TEXT("Compute"), ComputeMs, ComputeMs > 0.0f ? RasterMs / ComputeMs : 0.0f);
+            UE_LOG(LogShaderTestBenchmark, Display, TEXT("  %-24s max error %.4f"), TEXT("Compute vs raster"), MaxError);
+        }
+    );
+}
+
+static FAutoConsoleCommand GBenchmarkBlitCommand(
+    TEXT("ShaderTest.Benchmark.Blit"),
+    TEXT("Times DrawTestShaderRenderTarget's raster and compute paths over many small targets and compares their output: ShaderTest.Benchmark.Blit [Size=256] [Count=64] [Iterations=20]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunBlitBenchmark)
+);
  
 #undef LOCTEXT_NAMESPACE  
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include "CoreMinimal.h"
 #include "UObject/ObjectMacros.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "GraphicToolsGPUCompletion.h"
+#include "GraphicToolsGPUScheduler.h"
+#include "GraphicToolsImageOperators.h"
+#include "Tickable.h"
 #include "MyShaderTest.generated.h"
 
 USTRUCT(BlueprintType)
@@ -22,26 +26,279 @@ struct FMyShaderStructData
 	int32 ColorIndex;
 };
 
+/** How DrawTestShaderRenderTarget runs the shader */
+UENUM(BlueprintType)
+enum class EMyShaderDrawPath : uint8
+{
+	/**
+	 * Compute for render targets created with Can Create UAV when it draws the same pixels as raster, which is when
+	 * the texture has a single mip or the target's size. Raster otherwise
+	 */
+	Auto,
+	/** Samples the texture trilinearly in a pixel shader */
+	Raster,
+	/**
+	 * A compute pass writing through a UAV, no render pass or vertex buffer. Samples the texture's top mip only, so a
+	 * target smaller than the texture comes out aliased. Falls back to raster without a UAV
+	 */
+	Compute,
+};
+
+/** How DrawComputeShaderResultTiled splits the image, see FMyTiledGenerationState in MyShaderTest.cpp */
+USTRUCT(BlueprintType)
+struct FMyTiledGenerationSettings
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Edge of the square tiles in pixels, the transient memory is one tile of it whatever the image size */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = ShaderData)
+	int32 TileSize = 2048;
+
+	/** Tiles dispatched per frame, 0 for all of them in the frame the node runs. Exports also wait for the disk */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = ShaderData)
+	int32 TilesPerFrame = 0;
+
+	/** When set, every tile is read back and written to <ExportDirectory>/Tile_<X>_<Y>.bmp, relative to Saved. R8G8B8A8 and FloatRGBA only */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = ShaderData)
+	FString ExportDirectory;
+
+	/** Size of the image when there is no render target, the tiles then only go to disk */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = ShaderData)
+	FIntPoint ImageSize = FIntPoint(16384, 16384);
+};
+
 UCLASS(MinimalAPI, meta = (ScriptName = "TestShaderLibrary"))
 class UTestShaderBlueprintLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_UCLASS_BODY()
 
+	/** ShaderTest.Benchmark.Blit compares the raster and compute paths */
 	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (WorldContext = "WorldContextObject"))
 	static void DrawTestShaderRenderTarget(
 		class UTextureRenderTarget2D* OutputRenderTarget, 
 		AActor* Ac, 
 		FLinearColor MyColor, 
 		UTexture* MyTexture, 
+		FMyShaderStructData ShaderStructData,
+		EMyShaderDrawPath DrawPath = EMyShaderDrawPath::Raster);
+
+	/**
+	 * The four ColorIndex variants of DrawTestShaderRenderTarget in one draw, MyTexture is fetched once for all of
+	 * them: VariantOne gets ColorOne and so on. Any of the targets may be null, the others must be distinct and the same size.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (WorldContext = "WorldContextObject"))
+	static void DrawTestShaderVariants(
+		class UTextureRenderTarget2D* VariantOne,
+		class UTextureRenderTarget2D* VariantTwo,
+		class UTextureRenderTarget2D* VariantThree,
+		class UTextureRenderTarget2D* VariantFour,
+		AActor* Ac,
+		UTexture* MyTexture,
 		FMyShaderStructData ShaderStructData);
 	
 	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (WorldContext = "WorldContextObject"))
 	static void TextureWriting(UTexture2D* TextureToBeWritten, AActor* SelfRef);
 
+	/** Low priority results wait for frames with GPU time to spare, see FGraphicToolsGPUScheduler */
 	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (WorldContext = "WorldContextObject"))
 	static void DrawComputeShaderResult(
 		class UTextureRenderTarget2D* ComputedRenderTarget, 
 		AActor* Ac,
-		FMyShaderStructData ShaderStructData
+		FMyShaderStructData ShaderStructData,
+		EGraphicToolsOutputFormat OutputFormat = EGraphicToolsOutputFormat::FloatRGBA,
+		EGraphicToolsGPUJobPriority Priority = EGraphicToolsGPUJobPriority::Normal
+		);
+
+	/**
+	 * DrawComputeShaderResult shading in full only the 8x8 tiles whose luminance varies more than VarianceThreshold,
+	 * the rest is interpolated from their corners. ShaderTest.Benchmark.Adaptive reports the speedup and the error.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (WorldContext = "WorldContextObject"))
+	static void DrawComputeShaderResultAdaptive(
+		class UTextureRenderTarget2D* ComputedRenderTarget,
+		AActor* Ac,
+		FMyShaderStructData ShaderStructData,
+		float VarianceThreshold = 0.0005f,
+		EGraphicToolsOutputFormat OutputFormat = EGraphicToolsOutputFormat::FloatRGBA,
+		EGraphicToolsGPUJobPriority Priority = EGraphicToolsGPUJobPriority::Normal
+		);
+
+	/**
+	 * DrawComputeShaderResult for images too large to generate in one go, tile by tile over as many frames as the
+	 * settings ask for. ComputedRenderTarget may be null when the tiles are exported.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (WorldContext = "WorldContextObject"))
+	static void DrawComputeShaderResultTiled(
+		class UTextureRenderTarget2D* ComputedRenderTarget,
+		AActor* Ac,
+		FMyShaderStructData ShaderStructData,
+		FMyTiledGenerationSettings Settings,
+		EGraphicToolsOutputFormat OutputFormat = EGraphicToolsOutputFormat::FloatRGBA
+		);
+
+	/** OnFinished runs on the game thread once the last tile is enqueued and, when exporting, on disk */
+	static void DrawComputeShaderResultTiledWithCallback(
+		class UTextureRenderTarget2D* ComputedRenderTarget,
+		AActor* Ac,
+		const FMyShaderStructData& ShaderStructData,
+		const FMyTiledGenerationSettings& Settings,
+		EGraphicToolsOutputFormat OutputFormat,
+		TFunction<void()>&& OnFinished
+		);
+};
+
+/** Async versions of the nodes above, OnCompleted fires once the GPU has finished what they enqueued */
+UCLASS()
+class UTestShaderAsyncAction : public UGraphicToolsGPUAsyncAction
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (BlueprintInternalUseOnly = "true"))
+	static UTestShaderAsyncAction* DrawTestShaderRenderTargetAsync(
+		class UTextureRenderTarget2D* OutputRenderTarget,
+		AActor* Ac,
+		FLinearColor MyColor,
+		UTexture* MyTexture,
+		FMyShaderStructData ShaderStructData);
+
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (BlueprintInternalUseOnly = "true"))
+	static UTestShaderAsyncAction* TextureWritingAsync(UTexture2D* TextureToBeWritten, AActor* SelfRef);
+
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (BlueprintInternalUseOnly = "true"))
+	static UTestShaderAsyncAction* DrawComputeShaderResultAsync(
+		class UTextureRenderTarget2D* ComputedRenderTarget,
+		AActor* Ac,
+		FMyShaderStructData ShaderStructData,
+		EGraphicToolsOutputFormat OutputFormat = EGraphicToolsOutputFormat::FloatRGBA
 		);
+
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (BlueprintInternalUseOnly = "true"))
+	static UTestShaderAsyncAction* DrawComputeShaderResultAdaptiveAsync(
+		class UTextureRenderTarget2D* ComputedRenderTarget,
+		AActor* Ac,
+		FMyShaderStructData ShaderStructData,
+		float VarianceThreshold = 0.0005f,
+		EGraphicToolsOutputFormat OutputFormat = EGraphicToolsOutputFormat::FloatRGBA
+		);
+
+	/** OnCompleted fires once every tile is in the render target and on disk */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin", meta = (BlueprintInternalUseOnly = "true"))
+	static UTestShaderAsyncAction* DrawComputeShaderResultTiledAsync(
+		class UTextureRenderTarget2D* ComputedRenderTarget,
+		AActor* Ac,
+		FMyShaderStructData ShaderStructData,
+		FMyTiledGenerationSettings Settings,
+		EGraphicToolsOutputFormat OutputFormat = EGraphicToolsOutputFormat::FloatRGBA
+		);
+};
+
+/** A region of a UMyShaderAtlas page, valid until it is freed */
+USTRUCT(BlueprintType)
+struct FMyShaderAtlasEntry
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = ShaderData)
+	int32 Id = INDEX_NONE;
+
+	/** The page the entry is on, what materials sample */
+	UPROPERTY(BlueprintReadOnly, Category = ShaderData)
+	class UTextureRenderTarget2D* Texture = nullptr;
+
+	/** Maps the entry's [0, 1] UVs onto the page: PageUV = UV * (R, G) + (B, A) */
+	UPROPERTY(BlueprintReadOnly, Category = ShaderData)
+	FLinearColor UVScaleBias = FLinearColor(1.0f, 1.0f, 0.0f, 0.0f);
+
+	UPROPERTY(BlueprintReadOnly, Category = ShaderData)
+	FIntPoint Size = FIntPoint::ZeroValue;
+};
+
+/**
+ * Packs many small DrawTestShaderRenderTarget outputs into a few large render target pages instead of one
+ * render target each. Entries are placed on shelves as tall as the first entry that opened them, with a texel of
+ * padding drawn around each so bilinear sampling doesn't bleed between neighbours, and freed entries are reused
+ * by later ones of the same size. DrawEntry only records the draw; once a frame every page with entries drawn
+ * goes out as one GPU scheduler job of one render pass, switching viewports from entry to entry.
+ */
+UCLASS(BlueprintType)
+class UMyShaderAtlas : public UObject, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** PageSize is the edge of the square pages, entries larger than it can't be allocated */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+	static UMyShaderAtlas* CreateShaderAtlas(int32 PageSize = 2048, EGraphicToolsOutputFormat Format = EGraphicToolsOutputFormat::FloatRGBA);
+
+	/** Returns an entry with Id INDEX_NONE when Size is empty or larger than a page */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+	FMyShaderAtlasEntry Allocate(FIntPoint Size);
+
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+	void Free(const FMyShaderAtlasEntry& Entry);
+
+	/** DrawTestShaderRenderTarget into the entry's region, on the next tick with the other entries of its page */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+	void DrawEntry(const FMyShaderAtlasEntry& Entry, FLinearColor MyColor, UTexture* MyTexture, FMyShaderStructData ShaderStructData);
+
+	/** Sets TextureParameter to the entry's page and ScaleBiasParameter to its UVScaleBias */
+	UFUNCTION(BlueprintCallable, Category = "ShaderTestPlugin")
+	static void ApplyEntryToMaterial(
+		const FMyShaderAtlasEntry& Entry,
+		class UMaterialInstanceDynamic* Material,
+		FName TextureParameter = TEXT("AtlasTexture"),
+		FName ScaleBiasParameter = TEXT("AtlasScaleBias")
+		);
+
+	int32 GetNumPages() const { return Pages.Num(); }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return PendingDraws.Num() > 0; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UMyShaderAtlas, STATGROUP_Tickables); }
+	// End of FTickableGameObject interface
+
+private:
+	struct FShelf
+	{
+		int32 Y = 0;
+		int32 Height = 0;
+		int32 NextX = 0;
+	};
+
+	struct FSlot
+	{
+		int32 Page = 0;
+		/** Including the padding */
+		FIntRect Rect;
+	};
+
+	struct FPendingDraw
+	{
+		FIntRect Rect;
+		FLinearColor MyColor;
+		TWeakObjectPtr<UTexture> MyTexture;
+		FMyShaderStructData ShaderStructData;
+	};
+
+	bool AllocateOnPage(int32 PageIndex, FIntPoint PaddedSize, FIntRect& OutRect);
+	FMyShaderAtlasEntry MakeEntry(int32 Id, const FSlot& Slot) const;
+
+	UPROPERTY()
+	TArray<class UTextureRenderTarget2D*> Pages;
+
+	int32 PageSize = 2048;
+	EGraphicToolsOutputFormat Format = EGraphicToolsOutputFormat::FloatRGBA;
+
+	/** Per page, top to bottom */
+	TArray<TArray<FShelf>> Shelves;
+	TMap<int32, FSlot> Slots;
+	TArray<FSlot> FreeSlots;
+	int32 NextId = 0;
+
+	/** Per page, drawn on the next tick */
+	TMap<int32, TArray<FPendingDraw>> PendingDraws;
 };
@@ -28,6 +28,7 @@ public class ShaderTestPlugin : ModuleRules
 				"Core",
 				"CoreUObject",
 				"Engine",
+				"GraphicTools",
 				"RenderCore",
 				"Renderer",
 				"Projects",
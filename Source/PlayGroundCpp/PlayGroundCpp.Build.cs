@@ -8,6 +8,8 @@ public class PlayGroundCpp : ModuleRules
 	{
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
-		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay" });
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "AIModule", "SignificanceManager" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "RHI", "RenderCore", "GraphicTools" });
 	}
 }
@@ -1,7 +1,24 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "PlayGroundCpp.h"
+#include "PlayGroundCppFireLatency.h"
 #include "Modules/ModuleManager.h"
+#include "Misc/App.h"
+#include "RHI.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, PlayGroundCpp, "PlayGroundCpp" );
- 
\ No newline at end of file
+class FPlayGroundCppModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void ShutdownModule() override
+	{
+		// the rendering thread has stopped by now, so the tracker's end of frame delegates can go
+		FPlayGroundCppFireLatencyTracker::Shutdown();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FPlayGroundCppModule, PlayGroundCpp, "PlayGroundCpp" );
+
+bool PlayGroundCpp::IsHeadless()
+{
+	return !FApp::CanEverRender() || GUsingNullRHI;
+}
@@ -3,3 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+
+namespace PlayGroundCpp
+{
+	/** Returns true when this process never presents a frame (dedicated server, commandlet or -nullrhi), so purely cosmetic work can be skipped. */
+	bool IsHeadless();
+}
@@ -0,0 +1,63 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppBotController.h"
+#include "PlayGroundCppCharacter.h"
+
+APlayGroundCppBotController::APlayGroundCppBotController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	FireRate = 2.0f;
+	HeadingChangeInterval = 3.0f;
+
+	TimeUntilHeadingChange = 0.0f;
+	TimeUntilNextShot = 0.0f;
+}
+
+void APlayGroundCppBotController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	ChooseHeading();
+
+	// spread the first shot over a whole fire interval so bots spawned in the same frame don't fire in lockstep
+	TimeUntilNextShot = (FireRate > 0.0f) ? FMath::FRandRange(0.0f, 1.0f / FireRate) : 0.0f;
+}
+
+void APlayGroundCppBotController::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	APlayGroundCppCharacter* Bot = Cast<APlayGroundCppCharacter>(GetPawn());
+	if (Bot == nullptr)
+	{
+		return;
+	}
+
+	TimeUntilHeadingChange -= DeltaSeconds;
+	if (TimeUntilHeadingChange <= 0.0f)
+	{
+		ChooseHeading();
+	}
+
+	// walk along the current heading, the character yaw follows the control rotation
+	Bot->AddMovementInput(FRotator(0.0f, GetControlRotation().Yaw, 0.0f).Vector(), 1.0f);
+
+	if (FireRate > 0.0f)
+	{
+		TimeUntilNextShot -= DeltaSeconds;
+		if (TimeUntilNextShot <= 0.0f)
+		{
+			Bot->FireWeapon();
+
+			// at most one shot per frame, a hitch must not turn into a burst of spawns
+			TimeUntilNextShot = FMath::Max(TimeUntilNextShot + 1.0f / FireRate, 0.0f);
+		}
+	}
+}
+
+void APlayGroundCppBotController::ChooseHeading()
+{
+	SetControlRotation(FRotator(FMath::FRandRange(-10.0f, 30.0f), FMath::FRandRange(0.0f, 360.0f), 0.0f));
+	TimeUntilHeadingChange = HeadingChangeInterval * FMath::FRandRange(0.5f, 1.5f);
+}
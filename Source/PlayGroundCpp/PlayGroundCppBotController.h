@@ -0,0 +1,40 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "PlayGroundCppBotController.generated.h"
+
+/**
+ * Minimal AI used by the load test: wanders in a random direction, changing heading every few seconds,
+ * and pulls the trigger of its APlayGroundCppCharacter at a fixed rate. No navmesh is required.
+ */
+UCLASS()
+class APlayGroundCppBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	APlayGroundCppBotController();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Shots per second, 0 disables firing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = LoadTest)
+	float FireRate;
+
+	/** Seconds between heading changes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = LoadTest)
+	float HeadingChangeInterval;
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+
+private:
+	/** Picks a new random heading and aim pitch */
+	void ChooseHeading();
+
+	float TimeUntilHeadingChange;
+	float TimeUntilNextShot;
+};
@@ -1,12 +1,27 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "PlayGroundCppCharacter.h"
+#include "PlayGroundCpp.h"
+#include "PlayGroundCppFireAudioSubsystem.h"
+#include "PlayGroundCppFireLatency.h"
+#include "PlayGroundCppInputReplaySubsystem.h"
 #include "PlayGroundCppProjectile.h"
+#include "PlayGroundCppRewindSubsystem.h"
+#include "PlayGroundCppSignificanceSubsystem.h"
+#include "PlayGroundCppTracerSubsystem.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/SphereComponent.h"
 #include "Components/InputComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "GameFramework/DamageType.h"
 #include "GameFramework/InputSettings.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/ProjectileMovementComponent.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "MotionControllerComponent.h"
@@ -14,6 +29,9 @@
 
 DEFINE_LOG_CATEGORY_STATIC(LogFPChar, Warning, All);
 
+// Farthest a client's shot may start from its capsule, the muzzle plus what the character moved since it fired
+static const float MaxShotOriginDistance = 300.0f;
+
 //////////////////////////////////////////////////////////////////////////
 // APlayGroundCppCharacter
 
@@ -22,6 +40,9 @@ APlayGroundCppCharacter::APlayGroundCppCharacter()
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(55.f, 96.0f);
 
+	// Let the third person mesh skip animation updates when it is small on screen
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+
 	// set our turn rates for input
 	BaseTurnRate = 45.f;
 	BaseLookUpRate = 45.f;
@@ -40,12 +61,14 @@ APlayGroundCppCharacter::APlayGroundCppCharacter()
 	Mesh1P->CastShadow = false;
 	Mesh1P->SetRelativeRotation(FRotator(1.9f, -19.19f, 5.2f));
 	Mesh1P->SetRelativeLocation(FVector(-0.5f, -4.4f, -155.7f));
+	Mesh1P->bEnableUpdateRateOptimizations = true;
 
 	// Create a gun mesh component
 	FP_Gun = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("FP_Gun"));
 	FP_Gun->SetOnlyOwnerSee(false);			// otherwise won't be visible in the multiplayer
 	FP_Gun->bCastDynamicShadow = false;
 	FP_Gun->CastShadow = false;
+	FP_Gun->bEnableUpdateRateOptimizations = true;
 	// FP_Gun->SetupAttachment(Mesh1P, TEXT("GripPoint"));
 	FP_Gun->SetupAttachment(RootComponent);
 
@@ -72,6 +95,7 @@ APlayGroundCppCharacter::APlayGroundCppCharacter()
 	VR_Gun->SetOnlyOwnerSee(false);			// otherwise won't be visible in the multiplayer
 	VR_Gun->bCastDynamicShadow = false;
 	VR_Gun->CastShadow = false;
+	VR_Gun->bEnableUpdateRateOptimizations = true;
 	VR_Gun->SetupAttachment(R_MotionController);
 	VR_Gun->SetRelativeRotation(FRotator(0.0f, -90.0f, 0.0f));
 
@@ -82,6 +106,8 @@ APlayGroundCppCharacter::APlayGroundCppCharacter()
 
 	// Uncomment the following line to turn motion controllers on by default:
 	//bUsingMotionControllers = true;
+
+	NumDisabledTickFunctions = 0;
 }
 
 void APlayGroundCppCharacter::BeginPlay()
@@ -92,19 +118,129 @@ void APlayGroundCppCharacter::BeginPlay()
 	//Attach gun mesh component to Skeleton, doing it here because the skeleton is not yet created in the constructor
 	FP_Gun->AttachToComponent(Mesh1P, FAttachmentTransformRules(EAttachmentRule::SnapToTarget, true), TEXT("GripPoint"));
 
+	// The game mode usually preloaded these while the map was loading, in which case this just holds on to them.
+	// Otherwise (e.g. on clients) they stream in now so the first shot doesn't hitch on a synchronous load.
+	TArray<FSoftObjectPath> FireAssets;
+	GetFireAssetPaths(FireAssets);
+	if (FireAssets.Num() > 0)
+	{
+		FireAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(FireAssets, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	// Nothing is ever drawn or heard without rendering, so stop the cosmetic components from ticking at all.
+	// The meshes stay attached so the muzzle locations still resolve for projectile spawning.
+	if (PlayGroundCpp::IsHeadless())
+	{
+		Mesh1P->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		FP_Gun->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		VR_Gun->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		DisableComponentTick(R_MotionController);
+		DisableComponentTick(L_MotionController);
+	}
 	// Show or hide the two versions of the gun based on whether or not we're using motion controllers.
-	if (bUsingMotionControllers)
+	else if (bUsingMotionControllers)
 	{
 		VR_Gun->SetHiddenInGame(false, true);
 		Mesh1P->SetHiddenInGame(true, true);
+
+		// hidden meshes have nothing to animate
+		DisableComponentTick(Mesh1P);
+		DisableComponentTick(FP_Gun);
 	}
 	else
 	{
 		VR_Gun->SetHiddenInGame(true, true);
 		Mesh1P->SetHiddenInGame(false, true);
+
+		// hidden meshes have nothing to animate and nothing reads the controllers
+		DisableComponentTick(VR_Gun);
+		DisableComponentTick(R_MotionController);
+		DisableComponentTick(L_MotionController);
+	}
+
+	// Throttle ticking with the distance to the players, servers included so bots far away from everyone get cheaper
+	UPlayGroundCppSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UPlayGroundCppSignificanceSubsystem>();
+	if (Significance != nullptr)
+	{
+		Significance->RegisterCharacter(this);
+		Significance->AddDisabledTickFunctions(NumDisabledTickFunctions);
+	}
+
+	// The authority keeps a short history of where this character was so shots can be checked against what the shooter saw
+	UPlayGroundCppRewindSubsystem* Rewind = GetWorld()->GetSubsystem<UPlayGroundCppRewindSubsystem>();
+	if (Rewind != nullptr && HasAuthority())
+	{
+		Rewind->RegisterCharacter(this);
 	}
 }
 
+void APlayGroundCppCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UPlayGroundCppSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UPlayGroundCppSignificanceSubsystem>();
+	if (Significance != nullptr)
+	{
+		Significance->Unregister(this);
+		Significance->AddDisabledTickFunctions(-NumDisabledTickFunctions);
+	}
+	NumDisabledTickFunctions = 0;
+
+	UPlayGroundCppRewindSubsystem* Rewind = GetWorld()->GetSubsystem<UPlayGroundCppRewindSubsystem>();
+	if (Rewind != nullptr)
+	{
+		Rewind->UnregisterCharacter(this);
+	}
+
+	UPlayGroundCppFireAudioSubsystem* FireAudio = GetWorld()->GetSubsystem<UPlayGroundCppFireAudioSubsystem>();
+	if (FireAudio != nullptr)
+	{
+		FireAudio->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void APlayGroundCppCharacter::DisableComponentTick(UActorComponent* Component)
+{
+	if (Component->IsComponentTickEnabled())
+	{
+		Component->SetComponentTickEnabled(false);
+		++NumDisabledTickFunctions;
+	}
+}
+
+int32 APlayGroundCppCharacter::ApplySignificanceTickInterval(float TickInterval)
+{
+	int32 NumTickFunctions = 0;
+
+	SetActorTickInterval(TickInterval);
+	if (IsActorTickEnabled())
+	{
+		++NumTickFunctions;
+	}
+
+	// update rate optimizations already skip animation frames by screen size, this slows down the component tick itself
+	for (USkeletalMeshComponent* MeshComponent : { GetMesh(), Mesh1P, FP_Gun, VR_Gun })
+	{
+		MeshComponent->SetComponentTickInterval(TickInterval);
+		if (MeshComponent->IsComponentTickEnabled())
+		{
+			++NumTickFunctions;
+		}
+	}
+
+	// player movement is driven by the client's moves, only AI movement can be slowed down
+	if (!IsPlayerControlled())
+	{
+		GetCharacterMovement()->SetComponentTickInterval(TickInterval);
+		if (GetCharacterMovement()->IsComponentTickEnabled())
+		{
+			++NumTickFunctions;
+		}
+	}
+
+	return NumTickFunctions;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -114,11 +250,11 @@ void APlayGroundCppCharacter::SetupPlayerInputComponent(class UInputComponent* P
 	check(PlayerInputComponent);
 
 	// Bind jump events
-	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
+	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &APlayGroundCppCharacter::OnJumpInput);
+	PlayerInputComponent->BindAction("Jump", IE_Released, this, &APlayGroundCppCharacter::OnStopJumpingInput);
 
 	// Bind fire event
-	PlayerInputComponent->BindAction("Fire", IE_Pressed, this, &APlayGroundCppCharacter::OnFire);
+	PlayerInputComponent->BindAction("Fire", IE_Pressed, this, &APlayGroundCppCharacter::OnFireInput);
 
 	// Enable touchscreen input
 	EnableTouchscreenMovement(PlayerInputComponent);
@@ -126,31 +262,61 @@ void APlayGroundCppCharacter::SetupPlayerInputComponent(class UInputComponent* P
 	PlayerInputComponent->BindAction("ResetVR", IE_Pressed, this, &APlayGroundCppCharacter::OnResetVR);
 
 	// Bind movement events
-	PlayerInputComponent->BindAxis("MoveForward", this, &APlayGroundCppCharacter::MoveForward);
-	PlayerInputComponent->BindAxis("MoveRight", this, &APlayGroundCppCharacter::MoveRight);
+	PlayerInputComponent->BindAxis("MoveForward", this, &APlayGroundCppCharacter::OnMoveForwardInput);
+	PlayerInputComponent->BindAxis("MoveRight", this, &APlayGroundCppCharacter::OnMoveRightInput);
 
 	// We have 2 versions of the rotation bindings to handle different kinds of devices differently
 	// "turn" handles devices that provide an absolute delta, such as a mouse.
 	// "turnrate" is for devices that we choose to treat as a rate of change, such as an analog joystick
-	PlayerInputComponent->BindAxis("Turn", this, &APawn::AddControllerYawInput);
+	PlayerInputComponent->BindAxis("Turn", this, &APlayGroundCppCharacter::OnTurnInput);
 	PlayerInputComponent->BindAxis("TurnRate", this, &APlayGroundCppCharacter::TurnAtRate);
-	PlayerInputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
+	PlayerInputComponent->BindAxis("LookUp", this, &APlayGroundCppCharacter::OnLookUpInput);
 	PlayerInputComponent->BindAxis("LookUpRate", this, &APlayGroundCppCharacter::LookUpAtRate);
 }
 
+void APlayGroundCppCharacter::OnFireInput()
+{
+	if (!FilterLiveInput(EPlayGroundCppInputAction::Fire))
+	{
+		return;
+	}
+
+	FPlayGroundCppFireLatencyTracker::Get().MarkInput();
+	OnFire();
+}
+
+void APlayGroundCppCharacter::FireWeapon()
+{
+	OnFire();
+}
+
 void APlayGroundCppCharacter::OnFire()
 {
-	// try and fire a projectile
-	if (ProjectileClass != nullptr)
+	FPlayGroundCppFireLatencyTracker& FireLatency = FPlayGroundCppFireLatencyTracker::Get();
+	FireLatency.MarkFireBegin();
+
+	// try and fire a projectile, a class that hasn't finished streaming in yet can't be fired
+	UClass* const LoadedProjectileClass = ProjectileClass.Get();
+	if (LoadedProjectileClass != nullptr)
 	{
 		UWorld* const World = GetWorld();
 		if (World != nullptr)
 		{
+			// the projectile knows who fired it
+			FActorSpawnParameters ActorSpawnParams;
+			ActorSpawnParams.Owner = this;
+			ActorSpawnParams.Instigator = this;
+
 			if (bUsingMotionControllers)
 			{
 				const FRotator SpawnRotation = VR_MuzzleLocation->GetComponentRotation();
 				const FVector SpawnLocation = VR_MuzzleLocation->GetComponentLocation();
-				World->SpawnActor<APlayGroundCppProjectile>(ProjectileClass, SpawnLocation, SpawnRotation);
+				if (World->SpawnActor<APlayGroundCppProjectile>(LoadedProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams) != nullptr)
+				{
+					FireLatency.MarkProjectileSpawned();
+					BroadcastTracer(SpawnLocation, SpawnRotation);
+					ReportShot(SpawnLocation, SpawnRotation);
+				}
 			}
 			else
 			{
@@ -159,35 +325,171 @@ void APlayGroundCppCharacter::OnFire()
 				const FVector SpawnLocation = ((FP_MuzzleLocation != nullptr) ? FP_MuzzleLocation->GetComponentLocation() : GetActorLocation()) + SpawnRotation.RotateVector(GunOffset);
 
 				//Set Spawn Collision Handling Override
-				FActorSpawnParameters ActorSpawnParams;
 				ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
 
 				// spawn the projectile at the muzzle
-				World->SpawnActor<APlayGroundCppProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+				if (World->SpawnActor<APlayGroundCppProjectile>(LoadedProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams) != nullptr)
+				{
+					FireLatency.MarkProjectileSpawned();
+					BroadcastTracer(SpawnLocation, SpawnRotation);
+					ReportShot(SpawnLocation, SpawnRotation);
+				}
 			}
 		}
 	}
 
-	// try and play the sound if specified
-	if (FireSound != nullptr)
+	FireLatency.MarkFireEnd();
+
+	// sound and animation are purely cosmetic, skip them when nothing is rendered
+	if (PlayGroundCpp::IsHeadless())
+	{
+		return;
+	}
+
+	// try and play the sound if specified, on one of the character's pooled voices
+	USoundBase* const LoadedFireSound = FireSound.Get();
+	UPlayGroundCppFireAudioSubsystem* FireAudio = GetWorld()->GetSubsystem<UPlayGroundCppFireAudioSubsystem>();
+	if (LoadedFireSound != nullptr && FireAudio != nullptr)
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, GetActorLocation());
+		FireAudio->PlayFireSound(this, LoadedFireSound);
 	}
 
 	// try and play a firing animation if specified
-	if (FireAnimation != nullptr)
+	UAnimMontage* const LoadedFireAnimation = FireAnimation.Get();
+	if (LoadedFireAnimation != nullptr)
 	{
 		// Get the animation object for the arms mesh
 		UAnimInstance* AnimInstance = Mesh1P->GetAnimInstance();
 		if (AnimInstance != nullptr)
 		{
-			AnimInstance->Montage_Play(FireAnimation, 1.f);
+			AnimInstance->Montage_Play(LoadedFireAnimation, 1.f);
 		}
 	}
 }
 
+void APlayGroundCppCharacter::GetFireAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	if (!ProjectileClass.IsNull())
+	{
+		OutPaths.Add(ProjectileClass.ToSoftObjectPath());
+	}
+
+	if (PlayGroundCpp::IsHeadless())
+	{
+		return;
+	}
+
+	if (!FireSound.IsNull())
+	{
+		OutPaths.Add(FireSound.ToSoftObjectPath());
+	}
+	if (!FireAnimation.IsNull())
+	{
+		OutPaths.Add(FireAnimation.ToSoftObjectPath());
+	}
+}
+
+void APlayGroundCppCharacter::BroadcastTracer(const FVector& Location, const FRotator& Rotation)
+{
+	// standalone games have no one to send it to
+	if (HasAuthority() && GetNetMode() != NM_Standalone)
+	{
+		MulticastFireTracer(Location, Rotation);
+	}
+}
+
+void APlayGroundCppCharacter::ReportShot(const FVector& Origin, const FRotator& Rotation)
+{
+	if (HasAuthority())
+	{
+		QueueRewindShot(Origin, Rotation.Vector());
+	}
+	else if (IsLocallyControlled())
+	{
+		ServerReportShot(Origin, Rotation.Vector());
+	}
+}
+
+void APlayGroundCppCharacter::ServerReportShot_Implementation(FVector_NetQuantize Origin, FVector_NetQuantizeNormal Direction)
+{
+	// the muzzle is never far from the capsule, a shot from anywhere else didn't come from this character
+	if (FVector::DistSquared(Origin, GetActorLocation()) > FMath::Square(MaxShotOriginDistance))
+	{
+		UE_LOG(LogFPChar, Warning, TEXT("%s reported a shot %.0f units away from it, ignored"), *GetName(), FVector::Dist(Origin, GetActorLocation()));
+		return;
+	}
+
+	QueueRewindShot(Origin, Direction);
+}
+
+void APlayGroundCppCharacter::QueueRewindShot(const FVector& Origin, const FVector& Direction)
+{
+	UWorld* const World = GetWorld();
+	UPlayGroundCppRewindSubsystem* Rewind = World->GetSubsystem<UPlayGroundCppRewindSubsystem>();
+	UClass* const LoadedProjectileClass = ProjectileClass.Get();
+	if (Rewind == nullptr || LoadedProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	// the shot is taken as a straight line as far as the projectile flies in its lifetime, walls don't move so
+	// they are traced in the present
+	const APlayGroundCppProjectile* Projectile = GetDefault<APlayGroundCppProjectile>(LoadedProjectileClass);
+	const float Range = Projectile->InitialLifeSpan > 0.0f ? Projectile->GetProjectileMovement()->InitialSpeed * Projectile->InitialLifeSpan : WORLD_MAX;
+	FVector End = Origin + Direction.GetSafeNormal() * Range;
+
+	FHitResult WorldHit;
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(RewindShot), false, this);
+	if (World->LineTraceSingleByObjectType(WorldHit, Origin, End, FCollisionObjectQueryParams(FCollisionObjectQueryParams::AllStaticObjects), QueryParams))
+	{
+		End = WorldHit.Location;
+	}
+
+	// the client saw the world half a round trip ago
+	const APlayerState* ShooterState = GetPlayerState();
+
+	FPlayGroundCppRewindShot Shot;
+	Shot.Start = Origin;
+	Shot.End = End;
+	Shot.Radius = Projectile->GetCollisionComp()->GetScaledSphereRadius();
+	Shot.RewindSeconds = (ShooterState != nullptr) ? ShooterState->ExactPing * 0.5f * 0.001f : 0.0f;
+	Shot.Shooter = this;
+	Shot.OnValidated = FOnRewindShotValidated::CreateUObject(this, &APlayGroundCppCharacter::OnRewindShotValidated, Projectile->Damage);
+	Rewind->QueueShot(MoveTemp(Shot));
+}
+
+void APlayGroundCppCharacter::OnRewindShotValidated(AActor* HitActor, float Damage)
+{
+	// the engine's damage path, characters and their Blueprints react to it through TakeDamage and OnTakeAnyDamage
+	if (HitActor != nullptr)
+	{
+		UGameplayStatics::ApplyDamage(HitActor, Damage, GetController(), this, UDamageType::StaticClass());
+	}
+}
+
+void APlayGroundCppCharacter::MulticastFireTracer_Implementation(FVector_NetQuantize Location, FRotator Rotation)
+{
+	// the server has the projectile actor, and a client that fired it locally already sees its own
+	if (HasAuthority() || IsLocallyControlled())
+	{
+		return;
+	}
+
+	UWorld* const World = GetWorld();
+	UPlayGroundCppTracerSubsystem* const Tracers = (World != nullptr) ? World->GetSubsystem<UPlayGroundCppTracerSubsystem>() : nullptr;
+	if (Tracers != nullptr)
+	{
+		Tracers->FireTracer(Location, Rotation);
+	}
+}
+
 void APlayGroundCppCharacter::OnResetVR()
 {
+	if (PlayGroundCpp::IsHeadless())
+	{
+		return;
+	}
+
 	UHeadMountedDisplayFunctionLibrary::ResetOrientationAndPosition();
 }
 
@@ -199,7 +501,7 @@ void APlayGroundCppCharacter::BeginTouch(const ETouchIndex::Type FingerIndex, co
 	}
 	if ((FingerIndex == TouchItem.FingerIndex) && (TouchItem.bMoved == false))
 	{
-		OnFire();
+		OnFireInput();
 	}
 	TouchItem.bIsPressed = true;
 	TouchItem.FingerIndex = FingerIndex;
@@ -274,14 +576,96 @@ void APlayGroundCppCharacter::MoveRight(float Value)
 
 void APlayGroundCppCharacter::TurnAtRate(float Rate)
 {
-	// calculate delta for this frame from the rate information
-	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
+	// calculate delta for this frame from the rate information, recorded as the rotation it turns into
+	OnTurnInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
 }
 
 void APlayGroundCppCharacter::LookUpAtRate(float Rate)
 {
-	// calculate delta for this frame from the rate information
-	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
+	// calculate delta for this frame from the rate information, recorded as the rotation it turns into
+	OnLookUpInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
+}
+
+void APlayGroundCppCharacter::OnJumpInput()
+{
+	if (FilterLiveInput(EPlayGroundCppInputAction::JumpPressed))
+	{
+		Jump();
+	}
+}
+
+void APlayGroundCppCharacter::OnStopJumpingInput()
+{
+	if (FilterLiveInput(EPlayGroundCppInputAction::JumpReleased))
+	{
+		StopJumping();
+	}
+}
+
+void APlayGroundCppCharacter::OnMoveForwardInput(float Value)
+{
+	if (FilterLiveInput(EPlayGroundCppInputAxis::MoveForward, Value))
+	{
+		MoveForward(Value);
+	}
+}
+
+void APlayGroundCppCharacter::OnMoveRightInput(float Value)
+{
+	if (FilterLiveInput(EPlayGroundCppInputAxis::MoveRight, Value))
+	{
+		MoveRight(Value);
+	}
+}
+
+void APlayGroundCppCharacter::OnTurnInput(float Value)
+{
+	if (FilterLiveInput(EPlayGroundCppInputAxis::Turn, Value))
+	{
+		AddControllerYawInput(Value);
+	}
+}
+
+void APlayGroundCppCharacter::OnLookUpInput(float Value)
+{
+	if (FilterLiveInput(EPlayGroundCppInputAxis::LookUp, Value))
+	{
+		AddControllerPitchInput(Value);
+	}
+}
+
+bool APlayGroundCppCharacter::FilterLiveInput(EPlayGroundCppInputAxis Axis, float Value) const
+{
+	UPlayGroundCppInputReplaySubsystem* InputReplay = GetWorld()->GetSubsystem<UPlayGroundCppInputReplaySubsystem>();
+	return InputReplay == nullptr || InputReplay->FilterLiveInput(this, Axis, Value);
+}
+
+bool APlayGroundCppCharacter::FilterLiveInput(EPlayGroundCppInputAction Action) const
+{
+	UPlayGroundCppInputReplaySubsystem* InputReplay = GetWorld()->GetSubsystem<UPlayGroundCppInputReplaySubsystem>();
+	return InputReplay == nullptr || InputReplay->FilterLiveInput(this, Action);
+}
+
+void APlayGroundCppCharacter::ApplyReplayedInput(const FPlayGroundCppInputFrame& Frame)
+{
+	MoveForward(Frame.Axes[(int32)EPlayGroundCppInputAxis::MoveForward]);
+	MoveRight(Frame.Axes[(int32)EPlayGroundCppInputAxis::MoveRight]);
+	AddControllerYawInput(Frame.Axes[(int32)EPlayGroundCppInputAxis::Turn]);
+	AddControllerPitchInput(Frame.Axes[(int32)EPlayGroundCppInputAxis::LookUp]);
+
+	if (Frame.HasAction(EPlayGroundCppInputAction::JumpPressed))
+	{
+		Jump();
+	}
+	if (Frame.HasAction(EPlayGroundCppInputAction::JumpReleased))
+	{
+		StopJumping();
+	}
+	if (Frame.HasAction(EPlayGroundCppInputAction::Fire))
+	{
+		FPlayGroundCppFireLatencyTracker::Get().MarkInput();
+		OnFire();
+	}
 }
 
 bool APlayGroundCppCharacter::EnableTouchscreenMovement(class UInputComponent* PlayerInputComponent)
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "PlayGroundCppInputReplaySubsystem.h"
 #include "PlayGroundCppCharacter.generated.h"
 
 class UInputComponent;
@@ -56,6 +57,7 @@ public:
 
 protected:
 	virtual void BeginPlay();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
@@ -70,27 +72,67 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
 	FVector GunOffset;
 
-	/** Projectile class to spawn */
+	/** Projectile class to spawn, streamed in ahead of the first shot */
 	UPROPERTY(EditDefaultsOnly, Category=Projectile)
-	TSubclassOf<class APlayGroundCppProjectile> ProjectileClass;
+	TSoftClassPtr<class APlayGroundCppProjectile> ProjectileClass;
 
-	/** Sound to play each time we fire */
+	/** Sound to play each time we fire, streamed in ahead of the first shot */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
-	USoundBase* FireSound;
+	TSoftObjectPtr<USoundBase> FireSound;
 
-	/** AnimMontage to play each time we fire */
+	/** AnimMontage to play each time we fire, streamed in ahead of the first shot */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
-	UAnimMontage* FireAnimation;
+	TSoftObjectPtr<UAnimMontage> FireAnimation;
 
 	/** Whether to use motion controller location for aiming. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	uint8 bUsingMotionControllers : 1;
 
+	/** Pulls the trigger without going through the input bindings, for AI controlled characters such as load test bots. */
+	void FireWeapon();
+
 protected:
 	
 	/** Fires a projectile. */
 	void OnFire();
 
+	/** Fire input handler, timestamps the input for latency tracking before firing. */
+	void OnFireInput();
+
+	/** Shows a projectile fired with authority to the clients that didn't fire it, as a cosmetic GPU tracer. */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastFireTracer(FVector_NetQuantize Location, FRotator Rotation);
+
+	/** Sends a projectile the server just spawned to the clients as a tracer. */
+	void BroadcastTracer(const FVector& Location, const FRotator& Rotation);
+
+	/** Has the authority check a shot just fired against the character poses the shooter saw, and damage what it hit. */
+	void ReportShot(const FVector& Origin, const FRotator& Rotation);
+
+	/** A shot a client fired, its projectile only exists on that client. */
+	UFUNCTION(Server, Reliable)
+	void ServerReportShot(FVector_NetQuantize Origin, FVector_NetQuantizeNormal Direction);
+
+	/** Queues the shot's whole path, up to the first static geometry, for validation against the rewound poses. */
+	void QueueRewindShot(const FVector& Origin, const FVector& Direction);
+
+	/** Rewind validation result, HitActor is null when the shot missed every character. */
+	void OnRewindShotValidated(AActor* HitActor, float Damage);
+
+	/** Jump input handlers, recorded and dropped during replays like the other bound input. */
+	void OnJumpInput();
+	void OnStopJumpingInput();
+
+	/** Axis input handlers, recorded and dropped during replays before they move or turn the character. */
+	void OnMoveForwardInput(float Value);
+	void OnMoveRightInput(float Value);
+	void OnTurnInput(float Value);
+	void OnLookUpInput(float Value);
+
+	/** Whether live input should be acted on, passing it to the input recorder on the way. */
+	bool FilterLiveInput(EPlayGroundCppInputAxis Axis, float Value) const;
+	bool FilterLiveInput(EPlayGroundCppInputAction Action) const;
+
 	/** Resets HMD orientation and position in VR. */
 	void OnResetVR();
 
@@ -124,6 +166,15 @@ protected:
 	void EndTouch(const ETouchIndex::Type FingerIndex, const FVector Location);
 	void TouchUpdate(const ETouchIndex::Type FingerIndex, const FVector Location);
 	TouchData	TouchItem;
+
+	/** Keeps the fire assets resident for as long as this character is alive */
+	TSharedPtr<struct FStreamableHandle> FireAssetsHandle;
+
+	/** Switches off the tick of a component that has nothing to do, counting it for the significance stats */
+	void DisableComponentTick(UActorComponent* Component);
+
+	/** Number of tick functions switched off by DisableComponentTick */
+	int32 NumDisabledTickFunctions;
 	
 protected:
 	// APawn interface
@@ -139,6 +190,18 @@ protected:
 	bool EnableTouchscreenMovement(UInputComponent* InputComponent);
 
 public:
+	/**
+	 * Applies the tick interval of the significance bucket this character currently falls into.
+	 * @returns the number of tick functions that are now running at that interval.
+	 */
+	int32 ApplySignificanceTickInterval(float TickInterval);
+
+	/** Gathers the assets OnFire needs, cosmetic ones are left out when nothing is rendered */
+	void GetFireAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+
+	/** Acts on a frame of recorded input as if it had come from the bindings, see UPlayGroundCppInputReplaySubsystem */
+	void ApplyReplayedInput(const FPlayGroundCppInputFrame& Frame);
+
 	/** Returns Mesh1P subobject **/
 	USkeletalMeshComponent* GetMesh1P() const { return Mesh1P; }
 	/** Returns FirstPersonCameraComponent subobject **/
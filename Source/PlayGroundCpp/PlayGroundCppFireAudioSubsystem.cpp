@@ -0,0 +1,291 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppFireAudioSubsystem.h"
+#include "PlayGroundCpp.h"
+#include "AudioThread.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Sound/SoundBase.h"
+#include "Sound/SoundConcurrency.h"
+
+DECLARE_STATS_GROUP(TEXT("FireAudio"), STATGROUP_PlayGroundCppFireAudio, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Play fire sound"), STAT_FireAudio_Play, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_CYCLE_STAT(TEXT("Update fire audio"), STAT_FireAudio_Tick, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled voices"), STAT_FireAudio_PooledVoices, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Playing voices"), STAT_FireAudio_PlayingVoices, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shots played"), STAT_FireAudio_Played, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shots culled by distance"), STAT_FireAudio_Culled, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Voices retriggered"), STAT_FireAudio_Retriggered, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Voices stolen"), STAT_FireAudio_Stolen, STATGROUP_PlayGroundCppFireAudio);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Audio thread latency (ms)"), STAT_FireAudio_AudioThreadLatency, STATGROUP_PlayGroundCppFireAudio);
+
+CSV_DEFINE_CATEGORY(FireAudio, true);
+
+UPlayGroundCppFireAudioSubsystem::UPlayGroundCppFireAudioSubsystem()
+{
+	VoicesPerCharacter = 2;
+	MaxVoices = 16;
+	MaxAudibleDistance = 0.0f;
+	RetriggerSeconds = 0.05f;
+	Concurrency = nullptr;
+}
+
+bool UPlayGroundCppFireAudioSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// OnFire skips its sound when nothing is rendered
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World != nullptr && World->IsGameWorld() && !PlayGroundCpp::IsHeadless();
+}
+
+void UPlayGroundCppFireAudioSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Concurrency = NewObject<USoundConcurrency>(this, TEXT("FireConcurrency"), RF_Transient);
+	Concurrency->Concurrency.MaxCount = FMath::Max(MaxVoices, 1);
+	Concurrency->Concurrency.bLimitToOwner = false;
+	Concurrency->Concurrency.ResolutionRule = EMaxConcurrentResolutionRule::StopFarthestThenOldest;
+}
+
+void UPlayGroundCppFireAudioSubsystem::Deinitialize()
+{
+	for (const TPair<TWeakObjectPtr<AActor>, FVoicePool>& Pair : Pools)
+	{
+		for (const TWeakObjectPtr<UAudioComponent>& Voice : Pair.Value.Voices)
+		{
+			if (Voice.IsValid())
+			{
+				Voice->Stop();
+			}
+		}
+	}
+	Pools.Reset();
+
+	// a probe still in flight holds its own reference
+	AudioThreadProbe.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPlayGroundCppFireAudioSubsystem::PlayFireSound(AActor* Shooter, USoundBase* Sound)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FireAudio_Play);
+
+	UWorld* World = GetWorld();
+	if (Shooter == nullptr || Sound == nullptr || World->GetAudioDeviceRaw() == nullptr)
+	{
+		return;
+	}
+
+	const float MaxDistance = (MaxAudibleDistance > 0.0f) ? MaxAudibleDistance : Sound->GetMaxDistance();
+	if (!IsAudible(Shooter->GetActorLocation(), MaxDistance))
+	{
+		INC_DWORD_STAT(STAT_FireAudio_Culled);
+		CSV_CUSTOM_STAT(FireAudio, Culled, 1, ECsvCustomStatOp::Accumulate);
+		return;
+	}
+
+	const double Now = World->GetTimeSeconds();
+	FVoicePool& Pool = Pools.FindOrAdd(Shooter);
+
+	UAudioComponent* Voice = AcquireVoice(Shooter, Pool, Now);
+	if (Voice == nullptr)
+	{
+		return;
+	}
+
+	if (Voice->Sound != Sound)
+	{
+		Voice->SetSound(Sound);
+	}
+
+	// a retriggered or stolen voice is stopped and starts over
+	Voice->Play();
+
+	INC_DWORD_STAT(STAT_FireAudio_Played);
+	CSV_CUSTOM_STAT(FireAudio, Played, 1, ECsvCustomStatOp::Accumulate);
+}
+
+UAudioComponent* UPlayGroundCppFireAudioSubsystem::AcquireVoice(AActor* Shooter, FVoicePool& Pool, double Now)
+{
+	// rapid fire keeps restarting one voice rather than stacking copies of the same transient
+	if (Pool.Voices.IsValidIndex(Pool.LastVoice)
+		&& Pool.Voices[Pool.LastVoice].IsValid()
+		&& Now - Pool.StartTimes[Pool.LastVoice] < RetriggerSeconds)
+	{
+		INC_DWORD_STAT(STAT_FireAudio_Retriggered);
+		Pool.StartTimes[Pool.LastVoice] = Now;
+		return Pool.Voices[Pool.LastVoice].Get();
+	}
+
+	int32 FreeVoice = INDEX_NONE;
+	int32 OldestVoice = INDEX_NONE;
+	for (int32 Index = 0; Index < Pool.Voices.Num(); ++Index)
+	{
+		const UAudioComponent* Voice = Pool.Voices[Index].Get();
+		if (Voice == nullptr)
+		{
+			continue;
+		}
+
+		if (!Voice->IsPlaying())
+		{
+			FreeVoice = Index;
+			break;
+		}
+
+		if (OldestVoice == INDEX_NONE || Pool.StartTimes[Index] < Pool.StartTimes[OldestVoice])
+		{
+			OldestVoice = Index;
+		}
+	}
+
+	if (FreeVoice == INDEX_NONE && Pool.Voices.Num() < FMath::Max(VoicesPerCharacter, 1))
+	{
+		UAudioComponent* Voice = NewObject<UAudioComponent>(Shooter, NAME_None, RF_Transient);
+		Voice->bAutoActivate = false;
+		Voice->bAutoDestroy = false;
+		Voice->bStopWhenOwnerDestroyed = true;
+		Voice->ConcurrencySet.Add(Concurrency);
+		Voice->SetupAttachment(Shooter->GetRootComponent());
+		Voice->RegisterComponent();
+
+		FreeVoice = Pool.Voices.Add(Voice);
+		Pool.StartTimes.Add(Now);
+	}
+	else if (FreeVoice == INDEX_NONE)
+	{
+		FreeVoice = OldestVoice;
+		if (FreeVoice != INDEX_NONE)
+		{
+			INC_DWORD_STAT(STAT_FireAudio_Stolen);
+			CSV_CUSTOM_STAT(FireAudio, Stolen, 1, ECsvCustomStatOp::Accumulate);
+		}
+	}
+
+	if (FreeVoice == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	Pool.StartTimes[FreeVoice] = Now;
+	Pool.LastVoice = FreeVoice;
+	return Pool.Voices[FreeVoice].Get();
+}
+
+bool UPlayGroundCppFireAudioSubsystem::IsAudible(const FVector& Location, float MaxDistance) const
+{
+	// no attenuation, heard everywhere
+	if (MaxDistance <= 0.0f || MaxDistance >= WORLD_MAX)
+	{
+		return true;
+	}
+
+	const float MaxDistanceSquared = FMath::Square(MaxDistance);
+	for (const FVector& ListenerLocation : ListenerLocations)
+	{
+		if (FVector::DistSquared(ListenerLocation, Location) <= MaxDistanceSquared)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UPlayGroundCppFireAudioSubsystem::Unregister(AActor* Shooter)
+{
+	FVoicePool Pool;
+	if (Pools.RemoveAndCopyValue(Shooter, Pool))
+	{
+		for (const TWeakObjectPtr<UAudioComponent>& Voice : Pool.Voices)
+		{
+			if (Voice.IsValid())
+			{
+				Voice->Stop();
+			}
+		}
+	}
+}
+
+ETickableTickType UPlayGroundCppFireAudioSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+UWorld* UPlayGroundCppFireAudioSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UPlayGroundCppFireAudioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPlayGroundCppFireAudioSubsystem, STATGROUP_Tickables);
+}
+
+void UPlayGroundCppFireAudioSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FireAudio_Tick);
+
+	// only local players hear anything, where the audio device listens from rather than where the camera is
+	ListenerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (PlayerController != nullptr && PlayerController->IsLocalController())
+		{
+			FVector Location;
+			FVector FrontDir;
+			FVector RightDir;
+			PlayerController->GetAudioListenerPosition(Location, FrontDir, RightDir);
+			ListenerLocations.Add(Location);
+		}
+	}
+
+	int32 NumPooledVoices = 0;
+	int32 NumPlayingVoices = 0;
+	for (auto It = Pools.CreateIterator(); It; ++It)
+	{
+		if (!It->Key.IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		for (const TWeakObjectPtr<UAudioComponent>& Voice : It->Value.Voices)
+		{
+			if (Voice.IsValid())
+			{
+				++NumPooledVoices;
+				NumPlayingVoices += Voice->IsPlaying() ? 1 : 0;
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_FireAudio_PooledVoices, NumPooledVoices);
+	SET_DWORD_STAT(STAT_FireAudio_PlayingVoices, NumPlayingVoices);
+	CSV_CUSTOM_STAT(FireAudio, PlayingVoices, NumPlayingVoices, ECsvCustomStatOp::Set);
+
+	// how long a command waits for the audio thread, which grows as the mixer falls behind; one probe at a time
+	if (AudioThreadProbe.IsValid() && AudioThreadProbe->ExecutedCycles.Load() != 0)
+	{
+		const float LatencyMs = FPlatformTime::ToMilliseconds64(AudioThreadProbe->ExecutedCycles.Load() - AudioThreadProbe->EnqueuedCycles);
+		SET_FLOAT_STAT(STAT_FireAudio_AudioThreadLatency, LatencyMs);
+		CSV_CUSTOM_STAT(FireAudio, AudioThreadLatencyMs, LatencyMs, ECsvCustomStatOp::Set);
+		AudioThreadProbe.Reset();
+	}
+
+	if (!AudioThreadProbe.IsValid())
+	{
+		TSharedPtr<FAudioThreadProbe, ESPMode::ThreadSafe> Probe = MakeShared<FAudioThreadProbe, ESPMode::ThreadSafe>();
+		Probe->EnqueuedCycles = FPlatformTime::Cycles64();
+		AudioThreadProbe = Probe;
+
+		FAudioThread::RunCommandOnAudioThread([Probe]()
+		{
+			Probe->ExecutedCycles.Store(FPlatformTime::Cycles64());
+		});
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PlayGroundCppFireAudioSubsystem.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+class USoundConcurrency;
+
+/**
+ * Plays fire sounds through a few audio components each character keeps, instead of starting a new one-shot
+ * active sound per shot, so a crowd of bots firing doesn't flood the audio mixer and the game thread.
+ *
+ * A shot out of every local listener's earshot is dropped on the game thread before the audio thread hears of it.
+ * A shot fired within RetriggerSeconds of the previous one restarts that voice, otherwise a free voice is used
+ * and once all of a character's voices play the oldest is stolen. All voices share one concurrency group that
+ * keeps at most MaxVoices playing across the world, stopping the farthest and then the oldest. Processes that
+ * never render don't create it.
+ */
+UCLASS(config=Game)
+class UPlayGroundCppFireAudioSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UPlayGroundCppFireAudioSubsystem();
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Plays Sound at Shooter on one of its pooled voices, which are created on first use and follow it */
+	void PlayFireSound(AActor* Shooter, USoundBase* Sound);
+
+	/** Stops and forgets Shooter's voices, called when it leaves play */
+	void Unregister(AActor* Shooter);
+
+	/** Voices kept per character, the oldest is stolen when a shot finds them all playing */
+	UPROPERTY(config, EditAnywhere, Category = FireAudio)
+	int32 VoicesPerCharacter;
+
+	/** Fire sounds playing at once across the world, the farthest and then the oldest are stopped beyond it */
+	UPROPERTY(config, EditAnywhere, Category = FireAudio)
+	int32 MaxVoices;
+
+	/** Shots farther than this from every listener aren't played, 0 uses the sound's attenuation distance */
+	UPROPERTY(config, EditAnywhere, Category = FireAudio)
+	float MaxAudibleDistance;
+
+	/** A shot within this many seconds of the character's previous one restarts its voice instead of adding one */
+	UPROPERTY(config, EditAnywhere, Category = FireAudio)
+	float RetriggerSeconds;
+
+private:
+	struct FVoicePool
+	{
+		/** Owned and kept alive by the shooter, they are attached to its root */
+		TArray<TWeakObjectPtr<UAudioComponent>> Voices;
+		TArray<double> StartTimes;
+		int32 LastVoice = INDEX_NONE;
+	};
+
+	/** Picks the voice to play the next shot on, creating one while the pool isn't full */
+	UAudioComponent* AcquireVoice(AActor* Shooter, FVoicePool& Pool, double Now);
+
+	bool IsAudible(const FVector& Location, float MaxDistance) const;
+
+	/** Shared by every voice so the audio engine enforces MaxVoices */
+	UPROPERTY(Transient)
+	USoundConcurrency* Concurrency;
+
+	TMap<TWeakObjectPtr<AActor>, FVoicePool> Pools;
+
+	/** Local listeners, gathered every tick */
+	TArray<FVector> ListenerLocations;
+
+	/** Timestamps a command on the audio thread to measure how far behind the game thread it runs */
+	struct FAudioThreadProbe
+	{
+		uint64 EnqueuedCycles = 0;
+		TAtomic<uint64> ExecutedCycles { 0 };
+	};
+
+	TSharedPtr<FAudioThreadProbe, ESPMode::ThreadSafe> AudioThreadProbe;
+};
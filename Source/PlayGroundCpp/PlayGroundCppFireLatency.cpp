@@ -0,0 +1,307 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppFireLatency.h"
+#include "PlayGroundCpp.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "RenderingThread.h"
+#include "Stats/Stats.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFireLatency, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("FireLatency"), STATGROUP_FireLatency, STATCAT_Advanced);
+
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Input to present submitted, last (ms)"), STAT_FireLatency_InputToPresentSubmittedLast, STATGROUP_FireLatency);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Input to present submitted, p50 (ms)"), STAT_FireLatency_InputToPresentSubmittedP50, STATGROUP_FireLatency);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Input to present submitted, p95 (ms)"), STAT_FireLatency_InputToPresentSubmittedP95, STATGROUP_FireLatency);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Input to present submitted, p99 (ms)"), STAT_FireLatency_InputToPresentSubmittedP99, STATGROUP_FireLatency);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Input to OnFire, p50 (ms)"), STAT_FireLatency_InputToFireP50, STATGROUP_FireLatency);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("OnFire to spawned, p50 (ms)"), STAT_FireLatency_FireToSpawnedP50, STATGROUP_FireLatency);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Spawned to render submit, p50 (ms)"), STAT_FireLatency_SpawnedToRenderSubmitP50, STATGROUP_FireLatency);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Render submit to present submitted, p50 (ms)"), STAT_FireLatency_RenderSubmitToPresentSubmittedP50, STATGROUP_FireLatency);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Samples in window"), STAT_FireLatency_Samples, STATGROUP_FireLatency);
+
+CSV_DEFINE_CATEGORY(FireLatency, true);
+
+static TAutoConsoleVariable<int32> CVarFireLatencyEnable(
+	TEXT("PlayGroundCpp.FireLatency.Enable"),
+	1,
+	TEXT("Tracks the latency of player shots from input until their frame is submitted for present."));
+
+static FAutoConsoleCommand FireLatencyDumpCommand(
+	TEXT("PlayGroundCpp.FireLatency.Dump"),
+	TEXT("Logs the histogram and percentiles of the recent fire latency samples."),
+	FConsoleCommandDelegate::CreateLambda([]() { FPlayGroundCppFireLatencyTracker::Get().DumpHistogram(); }));
+
+/** Number of most recent shots the percentiles and histogram are computed from */
+static const int32 FireLatencyWindowSize = 256;
+
+/** Width and count of the histogram buckets, the last bucket collects everything above */
+static const float FireLatencyBucketMs = 2.0f;
+static const int32 FireLatencyNumBuckets = 32;
+
+static float ToMilliseconds(uint64 StartCycles, uint64 EndCycles)
+{
+	return (float)FPlatformTime::ToMilliseconds64(EndCycles - StartCycles);
+}
+
+static float Percentile(const TArray<float>& SortedValues, float Fraction)
+{
+	if (SortedValues.Num() == 0)
+	{
+		return 0.0f;
+	}
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
+
+static TUniquePtr<FPlayGroundCppFireLatencyTracker> GFireLatencyTracker;
+
+FPlayGroundCppFireLatencyTracker& FPlayGroundCppFireLatencyTracker::Get()
+{
+	if (!GFireLatencyTracker.IsValid())
+	{
+		GFireLatencyTracker.Reset(new FPlayGroundCppFireLatencyTracker());
+	}
+	return *GFireLatencyTracker;
+}
+
+void FPlayGroundCppFireLatencyTracker::Shutdown()
+{
+	GFireLatencyTracker.Reset();
+}
+
+FPlayGroundCppFireLatencyTracker::FPlayGroundCppFireLatencyTracker()
+	: PendingInputCycles(0)
+	, NextShotId(1)
+	, WindowHead(0)
+{
+	Window.Reserve(FireLatencyWindowSize);
+
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FPlayGroundCppFireLatencyTracker::OnEndFrame);
+	EndFrameRenderThreadHandle = FCoreDelegates::OnEndFrameRT.AddRaw(this, &FPlayGroundCppFireLatencyTracker::OnEndFrameRenderThread);
+}
+
+FPlayGroundCppFireLatencyTracker::~FPlayGroundCppFireLatencyTracker()
+{
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+	FCoreDelegates::OnEndFrameRT.Remove(EndFrameRenderThreadHandle);
+}
+
+bool FPlayGroundCppFireLatencyTracker::IsEnabled() const
+{
+	// without a rendered frame there is nothing to measure up to
+	return CVarFireLatencyEnable.GetValueOnGameThread() != 0 && !PlayGroundCpp::IsHeadless();
+}
+
+void FPlayGroundCppFireLatencyTracker::MarkInput()
+{
+	check(IsInGameThread());
+
+	PendingInputCycles = IsEnabled() ? FPlatformTime::Cycles64() : 0;
+}
+
+void FPlayGroundCppFireLatencyTracker::MarkFireBegin()
+{
+	check(IsInGameThread());
+
+	if (PendingInputCycles == 0)
+	{
+		return;
+	}
+
+	CurrentShot = FShot();
+	CurrentShot.Id = NextShotId++;
+	CurrentShot.InputCycles = PendingInputCycles;
+	CurrentShot.FireCycles = FPlatformTime::Cycles64();
+	PendingInputCycles = 0;
+}
+
+void FPlayGroundCppFireLatencyTracker::MarkProjectileSpawned()
+{
+	check(IsInGameThread());
+
+	if (CurrentShot.Id == 0)
+	{
+		return;
+	}
+
+	CurrentShot.SpawnedCycles = FPlatformTime::Cycles64();
+	{
+		FScopeLock Lock(&ShotsCriticalSection);
+		ShotsInFlight.Add(CurrentShot);
+	}
+
+	// executes when the render thread starts on the frame that contains the new projectile
+	const uint32 ShotId = CurrentShot.Id;
+	ENQUEUE_RENDER_COMMAND(FireLatencyRenderSubmit)(
+		[this, ShotId](FRHICommandListImmediate& RHICmdList)
+		{
+			MarkRenderSubmit_RenderThread(ShotId);
+		});
+
+	CurrentShot = FShot();
+}
+
+void FPlayGroundCppFireLatencyTracker::MarkFireEnd()
+{
+	check(IsInGameThread());
+
+	CurrentShot = FShot();
+}
+
+void FPlayGroundCppFireLatencyTracker::MarkRenderSubmit_RenderThread(uint32 ShotId)
+{
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+
+	FScopeLock Lock(&ShotsCriticalSection);
+	for (FShot& Shot : ShotsInFlight)
+	{
+		if (Shot.Id == ShotId)
+		{
+			Shot.RenderSubmitCycles = NowCycles;
+			break;
+		}
+	}
+}
+
+void FPlayGroundCppFireLatencyTracker::OnEndFrameRenderThread()
+{
+	// the render thread has handed the frame to the RHI thread, which presents it later. RHI thread and GPU time
+	// aren't part of the measurement
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+
+	FScopeLock Lock(&ShotsCriticalSection);
+	for (int32 Index = ShotsInFlight.Num() - 1; Index >= 0; --Index)
+	{
+		FShot& Shot = ShotsInFlight[Index];
+		if (Shot.RenderSubmitCycles != 0)
+		{
+			Shot.PresentSubmittedCycles = NowCycles;
+			CompletedShots.Add(Shot);
+			ShotsInFlight.RemoveAtSwap(Index);
+		}
+	}
+}
+
+void FPlayGroundCppFireLatencyTracker::OnEndFrame()
+{
+	TArray<FShot> NewlyCompleted;
+	{
+		FScopeLock Lock(&ShotsCriticalSection);
+		if (CompletedShots.Num() == 0)
+		{
+			return;
+		}
+		Swap(NewlyCompleted, CompletedShots);
+	}
+
+	// a frame can complete several shots, the CSV keeps the extremes of each stage and how many there were
+	float MinInputToPresentSubmitted = MAX_flt;
+	FSample MaxSample = {};
+
+	for (const FShot& Shot : NewlyCompleted)
+	{
+		FSample Sample;
+		Sample.InputToFire = ToMilliseconds(Shot.InputCycles, Shot.FireCycles);
+		Sample.FireToSpawned = ToMilliseconds(Shot.FireCycles, Shot.SpawnedCycles);
+		Sample.SpawnedToRenderSubmit = ToMilliseconds(Shot.SpawnedCycles, Shot.RenderSubmitCycles);
+		Sample.RenderSubmitToPresentSubmitted = ToMilliseconds(Shot.RenderSubmitCycles, Shot.PresentSubmittedCycles);
+		Sample.InputToPresentSubmitted = ToMilliseconds(Shot.InputCycles, Shot.PresentSubmittedCycles);
+
+		if (Window.Num() < FireLatencyWindowSize)
+		{
+			Window.Add(Sample);
+		}
+		else
+		{
+			Window[WindowHead] = Sample;
+			WindowHead = (WindowHead + 1) % FireLatencyWindowSize;
+		}
+
+		MinInputToPresentSubmitted = FMath::Min(MinInputToPresentSubmitted, Sample.InputToPresentSubmitted);
+		MaxSample.InputToFire = FMath::Max(MaxSample.InputToFire, Sample.InputToFire);
+		MaxSample.FireToSpawned = FMath::Max(MaxSample.FireToSpawned, Sample.FireToSpawned);
+		MaxSample.SpawnedToRenderSubmit = FMath::Max(MaxSample.SpawnedToRenderSubmit, Sample.SpawnedToRenderSubmit);
+		MaxSample.RenderSubmitToPresentSubmitted = FMath::Max(MaxSample.RenderSubmitToPresentSubmitted, Sample.RenderSubmitToPresentSubmitted);
+		MaxSample.InputToPresentSubmitted = FMath::Max(MaxSample.InputToPresentSubmitted, Sample.InputToPresentSubmitted);
+		SET_FLOAT_STAT(STAT_FireLatency_InputToPresentSubmittedLast, Sample.InputToPresentSubmitted);
+	}
+
+	CSV_CUSTOM_STAT(FireLatency, Shots, NewlyCompleted.Num(), ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(FireLatency, InputToPresentSubmittedMinMs, MinInputToPresentSubmitted, ECsvCustomStatOp::Min);
+	CSV_CUSTOM_STAT(FireLatency, InputToPresentSubmittedMaxMs, MaxSample.InputToPresentSubmitted, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(FireLatency, InputToFireMaxMs, MaxSample.InputToFire, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(FireLatency, FireToSpawnedMaxMs, MaxSample.FireToSpawned, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(FireLatency, SpawnedToRenderSubmitMaxMs, MaxSample.SpawnedToRenderSubmit, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(FireLatency, RenderSubmitToPresentSubmittedMaxMs, MaxSample.RenderSubmitToPresentSubmitted, ECsvCustomStatOp::Max);
+
+	PublishStats();
+}
+
+void FPlayGroundCppFireLatencyTracker::PublishStats()
+{
+#if STATS
+	TArray<float> InputToPresentSubmitted, InputToFire, FireToSpawned, SpawnedToRenderSubmit, RenderSubmitToPresentSubmitted;
+	for (const FSample& Sample : Window)
+	{
+		InputToPresentSubmitted.Add(Sample.InputToPresentSubmitted);
+		InputToFire.Add(Sample.InputToFire);
+		FireToSpawned.Add(Sample.FireToSpawned);
+		SpawnedToRenderSubmit.Add(Sample.SpawnedToRenderSubmit);
+		RenderSubmitToPresentSubmitted.Add(Sample.RenderSubmitToPresentSubmitted);
+	}
+	InputToPresentSubmitted.Sort();
+	InputToFire.Sort();
+	FireToSpawned.Sort();
+	SpawnedToRenderSubmit.Sort();
+	RenderSubmitToPresentSubmitted.Sort();
+
+	SET_FLOAT_STAT(STAT_FireLatency_InputToPresentSubmittedP50, Percentile(InputToPresentSubmitted, 0.50f));
+	SET_FLOAT_STAT(STAT_FireLatency_InputToPresentSubmittedP95, Percentile(InputToPresentSubmitted, 0.95f));
+	SET_FLOAT_STAT(STAT_FireLatency_InputToPresentSubmittedP99, Percentile(InputToPresentSubmitted, 0.99f));
+	SET_FLOAT_STAT(STAT_FireLatency_InputToFireP50, Percentile(InputToFire, 0.50f));
+	SET_FLOAT_STAT(STAT_FireLatency_FireToSpawnedP50, Percentile(FireToSpawned, 0.50f));
+	SET_FLOAT_STAT(STAT_FireLatency_SpawnedToRenderSubmitP50, Percentile(SpawnedToRenderSubmit, 0.50f));
+	SET_FLOAT_STAT(STAT_FireLatency_RenderSubmitToPresentSubmittedP50, Percentile(RenderSubmitToPresentSubmitted, 0.50f));
+	SET_DWORD_STAT(STAT_FireLatency_Samples, Window.Num());
+#endif
+}
+
+void FPlayGroundCppFireLatencyTracker::DumpHistogram() const
+{
+	if (Window.Num() == 0)
+	{
+		UE_LOG(LogFireLatency, Log, TEXT("No fire latency samples recorded yet."));
+		return;
+	}
+
+	TArray<float> InputToPresentSubmitted;
+	int32 Buckets[FireLatencyNumBuckets] = {};
+	for (const FSample& Sample : Window)
+	{
+		InputToPresentSubmitted.Add(Sample.InputToPresentSubmitted);
+		Buckets[FMath::Min((int32)(Sample.InputToPresentSubmitted / FireLatencyBucketMs), FireLatencyNumBuckets - 1)]++;
+	}
+	InputToPresentSubmitted.Sort();
+
+	UE_LOG(LogFireLatency, Log, TEXT("Input to present submitted over the last %d shots: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms"),
+		InputToPresentSubmitted.Num(), Percentile(InputToPresentSubmitted, 0.50f), Percentile(InputToPresentSubmitted, 0.95f), Percentile(InputToPresentSubmitted, 0.99f), InputToPresentSubmitted.Last());
+
+	for (int32 Bucket = 0; Bucket < FireLatencyNumBuckets; ++Bucket)
+	{
+		if (Buckets[Bucket] == 0)
+		{
+			continue;
+		}
+
+		const bool bOverflow = Bucket == FireLatencyNumBuckets - 1;
+		UE_LOG(LogFireLatency, Log, TEXT("  %5.1f - %s ms: %4d %s"),
+			Bucket * FireLatencyBucketMs,
+			bOverflow ? TEXT("    ") : *FString::Printf(TEXT("%5.1f"), (Bucket + 1) * FireLatencyBucketMs),
+			Buckets[Bucket],
+			*FString::ChrN(FMath::CeilToInt(60.0f * Buckets[Bucket] / Window.Num()), TEXT('#')));
+	}
+}
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Measures the latency of player initiated shots along the whole fire path:
+ *
+ *   input received -> OnFire -> projectile spawned -> render thread picked the frame up -> present submitted
+ *
+ * The last stage ends when the render thread hands the frame off, the RHI thread presents it and the GPU finishes
+ * it after that, so that time isn't included.
+ * Completed shots go into a rolling window from which percentiles are published to "stat FireLatency".
+ * The FireLatency CSV category gets the fastest and slowest shot of every stage and the number of shots
+ * completed each frame. PlayGroundCpp.FireLatency.Dump prints the window's histogram.
+ *
+ * All Mark* functions are game thread only and cheap no-ops when no input is pending, so shots that
+ * didn't originate from player input (e.g. load test bots) are ignored.
+ */
+class FPlayGroundCppFireLatencyTracker
+{
+public:
+	static FPlayGroundCppFireLatencyTracker& Get();
+
+	/** Destroys the tracker if it was ever used, called when the module shuts down */
+	static void Shutdown();
+
+	~FPlayGroundCppFireLatencyTracker();
+
+	/** The fire input was received */
+	void MarkInput();
+
+	/** OnFire started handling the input marked last */
+	void MarkFireBegin();
+
+	/** The projectile of the shot in flight was spawned */
+	void MarkProjectileSpawned();
+
+	/** OnFire is done, a shot that didn't spawn anything is dropped */
+	void MarkFireEnd();
+
+	/** Logs the histogram and percentiles of the current window */
+	void DumpHistogram() const;
+
+private:
+	FPlayGroundCppFireLatencyTracker();
+
+	/** One shot moving down the pipeline, all timestamps are FPlatformTime::Cycles64 */
+	struct FShot
+	{
+		uint32 Id = 0;
+		uint64 InputCycles = 0;
+		uint64 FireCycles = 0;
+		uint64 SpawnedCycles = 0;
+		uint64 RenderSubmitCycles = 0;
+		uint64 PresentSubmittedCycles = 0;
+	};
+
+	/** Per-stage latencies of a completed shot, in milliseconds */
+	struct FSample
+	{
+		float InputToFire;
+		float FireToSpawned;
+		float SpawnedToRenderSubmit;
+		float RenderSubmitToPresentSubmitted;
+		float InputToPresentSubmitted;
+	};
+
+	void MarkRenderSubmit_RenderThread(uint32 ShotId);
+	void OnEndFrameRenderThread();
+	void OnEndFrame();
+	void PublishStats();
+
+	bool IsEnabled() const;
+
+	/** Shared between the game thread (adding shots) and the render thread (completing them) */
+	mutable FCriticalSection ShotsCriticalSection;
+	TArray<FShot> ShotsInFlight;
+	TArray<FShot> CompletedShots;
+
+	FDelegateHandle EndFrameHandle;
+	FDelegateHandle EndFrameRenderThreadHandle;
+
+	/** Game thread only */
+	uint64 PendingInputCycles;
+	FShot CurrentShot;
+	uint32 NextShotId;
+	TArray<FSample> Window;
+	int32 WindowHead;
+};
@@ -3,15 +3,113 @@
 #include "PlayGroundCppGameMode.h"
 #include "PlayGroundCppHUD.h"
 #include "PlayGroundCppCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "PlayGroundCppLoadTestDirector.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CommandLine.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPlayGroundCppGameMode, Log, All);
 
 APlayGroundCppGameMode::APlayGroundCppGameMode()
 	: Super()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnClassFinder(TEXT("/Game/FirstPersonCPP/Blueprints/FirstPersonCharacter"));
-	DefaultPawnClass = PlayerPawnClassFinder.Class;
+	// set default pawn class to our Blueprinted character, it is streamed in by InitGame rather than loaded with this class
+	DefaultPawnSoftClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/FirstPersonCPP/Blueprints/FirstPersonCharacter.FirstPersonCharacter_C")));
+	DefaultPawnClass = nullptr;
+	bPlayerAssetsLoaded = false;
 
 	// use our custom HUD class
 	HUDClass = APlayGroundCppHUD::StaticClass();
 }
+
+void APlayGroundCppGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	// a subclass setting its own pawn class has nothing to stream in but its fire assets
+	if (DefaultPawnClass != nullptr)
+	{
+		OnDefaultPawnClassLoaded();
+		return;
+	}
+
+	DefaultPawnClassHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		DefaultPawnSoftClass.ToSoftObjectPath(),
+		FStreamableDelegate::CreateUObject(this, &APlayGroundCppGameMode::OnDefaultPawnClassLoaded),
+		FStreamableManager::AsyncLoadHighPriority);
+
+	if (!DefaultPawnClassHandle.IsValid())
+	{
+		OnDefaultPawnClassLoaded();
+	}
+}
+
+void APlayGroundCppGameMode::OnDefaultPawnClassLoaded()
+{
+	if (DefaultPawnClass == nullptr)
+	{
+		DefaultPawnClass = DefaultPawnSoftClass.Get();
+		if (DefaultPawnClass == nullptr)
+		{
+			UE_LOG(LogPlayGroundCppGameMode, Error, TEXT("Couldn't load the default pawn class %s, players spawn without a pawn"), *DefaultPawnSoftClass.ToString());
+		}
+	}
+
+	TArray<FSoftObjectPath> FireAssets;
+	if (DefaultPawnClass != nullptr)
+	{
+		const APlayGroundCppCharacter* DefaultCharacter = Cast<APlayGroundCppCharacter>(DefaultPawnClass->GetDefaultObject());
+		if (DefaultCharacter != nullptr)
+		{
+			DefaultCharacter->GetFireAssetPaths(FireAssets);
+		}
+	}
+
+	if (FireAssets.Num() > 0)
+	{
+		FireAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+			FireAssets,
+			FStreamableDelegate::CreateUObject(this, &APlayGroundCppGameMode::OnPlayerAssetsLoaded),
+			FStreamableManager::AsyncLoadHighPriority);
+	}
+
+	if (!FireAssetsHandle.IsValid())
+	{
+		OnPlayerAssetsLoaded();
+	}
+}
+
+void APlayGroundCppGameMode::OnPlayerAssetsLoaded()
+{
+	if (bPlayerAssetsLoaded)
+	{
+		return;
+	}
+	bPlayerAssetsLoaded = true;
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (PlayerController != nullptr && PlayerController->GetPawn() == nullptr && PlayerCanRestart(PlayerController))
+		{
+			RestartPlayer(PlayerController);
+		}
+	}
+}
+
+bool APlayGroundCppGameMode::PlayerCanRestart_Implementation(APlayerController* Player)
+{
+	return bPlayerAssetsLoaded && Super::PlayerCanRestart_Implementation(Player);
+}
+
+void APlayGroundCppGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("LoadTest")))
+	{
+		APlayGroundCppLoadTestDirector::StartLoadTest(GetWorld());
+	}
+}
@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "PlayGroundCppGameMode.generated.h"
 
+struct FStreamableHandle;
+
 UCLASS(minimalapi)
 class APlayGroundCppGameMode : public AGameModeBase
 {
@@ -13,6 +15,31 @@ class APlayGroundCppGameMode : public AGameModeBase
 
 public:
 	APlayGroundCppGameMode();
+
+	/** Kicks off the asynchronous preload of the player pawn and its fire assets while the map is loading */
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+
+	/** Starts the bot load test when the map was launched with -LoadTest */
+	virtual void StartPlay() override;
+
+	/** Players are held back until the preload has finished, they are restarted as soon as it does */
+	virtual bool PlayerCanRestart_Implementation(APlayerController* Player) override;
+
+protected:
+	/** Blueprinted character used as the default pawn unless DefaultPawnClass is set, only loaded once a map using this game mode loads */
+	UPROPERTY(EditDefaultsOnly, Category = Classes)
+	TSoftClassPtr<APawn> DefaultPawnSoftClass;
+
+private:
+	/** Called once the pawn class is in memory, chains the preload of its fire assets */
+	void OnDefaultPawnClassLoaded();
+
+	/** Called once everything a player needs is in memory, restarts the players that were waiting */
+	void OnPlayerAssetsLoaded();
+
+	TSharedPtr<FStreamableHandle> DefaultPawnClassHandle;
+	TSharedPtr<FStreamableHandle> FireAssetsHandle;
+	bool bPlayerAssetsLoaded;
 };
 
 
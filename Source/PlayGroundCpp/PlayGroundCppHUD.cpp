@@ -5,20 +5,33 @@
 #include "Engine/Texture2D.h"
 #include "TextureResource.h"
 #include "CanvasItem.h"
-#include "UObject/ConstructorHelpers.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
 
 APlayGroundCppHUD::APlayGroundCppHUD()
 {
-	// Set the crosshair texture
-	static ConstructorHelpers::FObjectFinder<UTexture2D> CrosshairTexObj(TEXT("/Game/FirstPerson/Textures/FirstPersonCrosshair"));
-	CrosshairTex = CrosshairTexObj.Object;
+	// Set the crosshair texture, HUDs are never spawned on a dedicated server so it never gets loaded there
+	CrosshairTex = TSoftObjectPtr<UTexture2D>(FSoftObjectPath(TEXT("/Game/FirstPerson/Textures/FirstPersonCrosshair.FirstPersonCrosshair")));
 }
 
+void APlayGroundCppHUD::BeginPlay()
+{
+	Super::BeginPlay();
+
+	CrosshairHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(CrosshairTex.ToSoftObjectPath(), FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+}
 
 void APlayGroundCppHUD::DrawHUD()
 {
 	Super::DrawHUD();
 
+	// nothing to draw until the crosshair has streamed in
+	UTexture2D* const Crosshair = CrosshairTex.Get();
+	if (Crosshair == nullptr)
+	{
+		return;
+	}
+
 	// Draw very simple crosshair
 
 	// find center of the Canvas
@@ -29,7 +42,7 @@ void APlayGroundCppHUD::DrawHUD()
 										   (Center.Y + 20.0f));
 
 	// draw the crosshair
-	FCanvasTileItem TileItem( CrosshairDrawPosition, CrosshairTex->Resource, FLinearColor::White);
+	FCanvasTileItem TileItem( CrosshairDrawPosition, Crosshair->Resource, FLinearColor::White);
 	TileItem.BlendMode = SE_BLEND_Translucent;
 	Canvas->DrawItem( TileItem );
 }
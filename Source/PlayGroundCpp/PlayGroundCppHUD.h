@@ -17,9 +17,15 @@ public:
 	/** Primary draw call for the HUD */
 	virtual void DrawHUD() override;
 
+protected:
+	virtual void BeginPlay() override;
+
 private:
-	/** Crosshair asset pointer */
-	class UTexture2D* CrosshairTex;
+	/** Crosshair asset, streamed in when the HUD starts instead of being loaded with the class */
+	TSoftObjectPtr<class UTexture2D> CrosshairTex;
+
+	/** Keeps the crosshair resident while the HUD is alive */
+	TSharedPtr<struct FStreamableHandle> CrosshairHandle;
 
 };
 
@@ -0,0 +1,568 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppInputReplaySubsystem.h"
+#include "PlayGroundCppCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogInputReplay, Log, All);
+
+CSV_DEFINE_CATEGORY(InputReplay, true);
+
+/** "PGIR" */
+static const uint32 InputRecordingMagic = 0x52494750;
+static const uint32 InputRecordingVersion = 1;
+
+// Every frame starts with a byte saying what follows it: bit N for axis N when it differs from the previous
+// frame, a bit for a changed duration, then the actions. Only what changed is written, as floats
+static const uint8 FrameDeltaSecondsChangedBit = 1 << (int32)EPlayGroundCppInputAxis::Num;
+static const int32 FrameActionsShift = (int32)EPlayGroundCppInputAxis::Num + 1;
+static_assert(FrameActionsShift + (int32)EPlayGroundCppInputAction::Num <= 8, "The frame header has to fit in a byte");
+
+static TAutoConsoleVariable<int32> CVarInputReplayExitOnCompletion(
+	TEXT("PlayGroundCpp.InputReplay.ExitOnCompletion"),
+	0,
+	TEXT("When non-zero, the process exits once a replay has finished."));
+
+static UPlayGroundCppInputReplaySubsystem* GetInputReplay(UWorld* World)
+{
+	return (World != nullptr) ? World->GetSubsystem<UPlayGroundCppInputReplaySubsystem>() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs InputRecordStartCommand(
+	TEXT("PlayGroundCpp.InputRecord.Start"),
+	TEXT("Records the local player's input: PlayGroundCpp.InputRecord.Start [File=Session]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UPlayGroundCppInputReplaySubsystem* InputReplay = GetInputReplay(World))
+		{
+			InputReplay->StartRecording((Args.Num() > 0) ? Args[0] : FString(TEXT("Session")));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld InputRecordStopCommand(
+	TEXT("PlayGroundCpp.InputRecord.Stop"),
+	TEXT("Stops recording input and writes the file."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UPlayGroundCppInputReplaySubsystem* InputReplay = GetInputReplay(World))
+		{
+			InputReplay->StopRecording();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs InputReplayStartCommand(
+	TEXT("PlayGroundCpp.InputReplay.Start"),
+	TEXT("Replays recorded input at a fixed timestep: PlayGroundCpp.InputReplay.Start File [FPS=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UPlayGroundCppInputReplaySubsystem* InputReplay = GetInputReplay(World);
+		if (InputReplay != nullptr && Args.Num() > 0)
+		{
+			InputReplay->StartReplay(Args[0], (Args.Num() > 1) ? FCString::Atof(*Args[1]) : 60.0f);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld InputReplayStopCommand(
+	TEXT("PlayGroundCpp.InputReplay.Stop"),
+	TEXT("Stops the running replay."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UPlayGroundCppInputReplaySubsystem* InputReplay = GetInputReplay(World))
+		{
+			InputReplay->StopReplay();
+		}
+	}));
+
+static void SerializeFrames(FArchive& Ar, TArray<FPlayGroundCppInputFrame>& Frames)
+{
+	int32 NumFrames = Frames.Num();
+	Ar << NumFrames;
+	if (Ar.IsLoading())
+	{
+		if (NumFrames < 0)
+		{
+			Ar.SetError();
+			return;
+		}
+		Frames.SetNum(NumFrames);
+	}
+
+	FPlayGroundCppInputFrame Previous;
+	for (int32 Index = 0; Index < NumFrames && !Ar.IsError(); ++Index)
+	{
+		FPlayGroundCppInputFrame& Frame = Frames[Index];
+
+		uint8 Header = 0;
+		if (Ar.IsSaving())
+		{
+			for (int32 Axis = 0; Axis < (int32)EPlayGroundCppInputAxis::Num; ++Axis)
+			{
+				Header |= (Frame.Axes[Axis] != Previous.Axes[Axis]) ? (1 << Axis) : 0;
+			}
+			Header |= (Frame.DeltaSeconds != Previous.DeltaSeconds) ? FrameDeltaSecondsChangedBit : 0;
+			Header |= Frame.Actions << FrameActionsShift;
+		}
+		Ar << Header;
+
+		if (Ar.IsLoading())
+		{
+			Frame = Previous;
+			Frame.Actions = Header >> FrameActionsShift;
+		}
+		for (int32 Axis = 0; Axis < (int32)EPlayGroundCppInputAxis::Num; ++Axis)
+		{
+			if (Header & (1 << Axis))
+			{
+				Ar << Frame.Axes[Axis];
+			}
+		}
+		if (Header & FrameDeltaSecondsChangedBit)
+		{
+			Ar << Frame.DeltaSeconds;
+		}
+
+		Previous = Frame;
+	}
+}
+
+UPlayGroundCppInputReplaySubsystem::UPlayGroundCppInputReplaySubsystem()
+{
+	State = EState::Idle;
+	RandomSeed = 0;
+	StartLocation = FVector::ZeroVector;
+	StartControlRotation = FRotator::ZeroRotator;
+	ReplayCursor = 0;
+	ReplayTime = 0.0;
+	FixedDeltaTime = 0.0f;
+	bPreviousUseFixedTimeStep = false;
+	PreviousFixedDeltaTime = 0.0;
+	LastFrameSeconds = 0.0;
+	TotalFrameSeconds = 0.0;
+	MaxFrameSeconds = 0.0;
+	NumReplayedFrames = 0;
+	bStartedCapture = false;
+}
+
+bool UPlayGroundCppInputReplaySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World != nullptr && World->IsGameWorld();
+}
+
+void UPlayGroundCppInputReplaySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UPlayGroundCppInputReplaySubsystem::OnWorldPreActorTick);
+}
+
+void UPlayGroundCppInputReplaySubsystem::Deinitialize()
+{
+	// a recording cut short by a map change or quitting is still worth keeping
+	if (IsRecording())
+	{
+		StopRecording();
+	}
+	if (IsReplaying())
+	{
+		StopReplay();
+	}
+
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+
+	Super::Deinitialize();
+}
+
+void UPlayGroundCppInputReplaySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// only for the first map, later ones would overwrite the recording or replay it out of place
+	static bool bHandledCommandLine = false;
+	if (bHandledCommandLine)
+	{
+		return;
+	}
+	bHandledCommandLine = true;
+
+	FString CommandLineFilename;
+	if (FParse::Value(FCommandLine::Get(), TEXT("InputRecord="), CommandLineFilename))
+	{
+		StartRecording(CommandLineFilename);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("InputReplay="), CommandLineFilename))
+	{
+		float FixedFrameRate = 60.0f;
+		FParse::Value(FCommandLine::Get(), TEXT("InputReplayFPS="), FixedFrameRate);
+		StartReplay(CommandLineFilename, FixedFrameRate);
+	}
+}
+
+FString UPlayGroundCppInputReplaySubsystem::ResolveFilename(const FString& Filename)
+{
+	FString Resolved = FPaths::GetPath(Filename).IsEmpty() ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("InputRecordings"), Filename) : Filename;
+	if (FPaths::GetExtension(Resolved).IsEmpty())
+	{
+		Resolved += TEXT(".pgir");
+	}
+	return Resolved;
+}
+
+APlayGroundCppCharacter* UPlayGroundCppInputReplaySubsystem::FindLocalCharacter() const
+{
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	return (PlayerController != nullptr && PlayerController->IsLocalController()) ? Cast<APlayGroundCppCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+bool UPlayGroundCppInputReplaySubsystem::StartRecording(const FString& Filename)
+{
+	if (State != EState::Idle)
+	{
+		UE_LOG(LogInputReplay, Warning, TEXT("Already recording or replaying."));
+		return false;
+	}
+
+	RecordingFilename = ResolveFilename(Filename);
+	Frames.Reset();
+	State = EState::WaitingToRecord;
+	return true;
+}
+
+void UPlayGroundCppInputReplaySubsystem::BeginRecording(APlayGroundCppCharacter* Character, float DeltaSeconds)
+{
+	TargetCharacter = Character;
+	MapName = GetWorld()->GetMapName();
+	StartLocation = Character->GetActorLocation();
+	StartControlRotation = Character->GetControlRotation();
+
+	// the replay resets the streams to the same seed, so whatever rolls dice in the same order rolls the same numbers
+	RandomSeed = (int32)FPlatformTime::Cycles();
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+
+	CurrentFrame = FPlayGroundCppInputFrame();
+	CurrentFrame.DeltaSeconds = DeltaSeconds;
+	State = EState::Recording;
+
+	UE_LOG(LogInputReplay, Log, TEXT("Recording input to %s."), *RecordingFilename);
+}
+
+bool UPlayGroundCppInputReplaySubsystem::StopRecording()
+{
+	if (!IsRecording())
+	{
+		return false;
+	}
+
+	const bool bStarted = (State == EState::Recording);
+	State = EState::Idle;
+	TargetCharacter.Reset();
+	if (!bStarted)
+	{
+		return false;
+	}
+	Frames.Add(CurrentFrame);
+
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	uint32 Magic = InputRecordingMagic;
+	uint32 Version = InputRecordingVersion;
+	Writer << Magic << Version << MapName << RandomSeed << StartLocation << StartControlRotation;
+	SerializeFrames(Writer, Frames);
+
+	double Duration = 0.0;
+	for (const FPlayGroundCppInputFrame& Frame : Frames)
+	{
+		Duration += Frame.DeltaSeconds;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(Data, *RecordingFilename))
+	{
+		UE_LOG(LogInputReplay, Error, TEXT("Couldn't write the input recording to %s."), *RecordingFilename);
+		return false;
+	}
+
+	UE_LOG(LogInputReplay, Log, TEXT("Recorded %d frames (%.1f s) of input to %s, %d bytes."), Frames.Num(), Duration, *RecordingFilename, Data.Num());
+	return true;
+}
+
+bool UPlayGroundCppInputReplaySubsystem::StartReplay(const FString& Filename, float FixedFrameRate)
+{
+	if (State != EState::Idle)
+	{
+		UE_LOG(LogInputReplay, Warning, TEXT("Already recording or replaying."));
+		return false;
+	}
+
+	RecordingFilename = ResolveFilename(Filename);
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *RecordingFilename))
+	{
+		UE_LOG(LogInputReplay, Error, TEXT("Couldn't read the input recording %s."), *RecordingFilename);
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != InputRecordingMagic || Version != InputRecordingVersion)
+	{
+		UE_LOG(LogInputReplay, Error, TEXT("%s isn't an input recording of version %u."), *RecordingFilename, InputRecordingVersion);
+		return false;
+	}
+	Reader << MapName << RandomSeed << StartLocation << StartControlRotation;
+	SerializeFrames(Reader, Frames);
+	if (Reader.IsError() || Frames.Num() == 0)
+	{
+		UE_LOG(LogInputReplay, Error, TEXT("The input recording %s is truncated or empty."), *RecordingFilename);
+		return false;
+	}
+
+	if (MapName != GetWorld()->GetMapName())
+	{
+		UE_LOG(LogInputReplay, Warning, TEXT("%s was recorded on %s, replaying it on %s."), *RecordingFilename, *MapName, *GetWorld()->GetMapName());
+	}
+
+	FrameStartTimes.SetNumUninitialized(Frames.Num());
+	double FrameStartTime = 0.0;
+	for (int32 Index = 0; Index < Frames.Num(); ++Index)
+	{
+		FrameStartTimes[Index] = FrameStartTime;
+		FrameStartTime += Frames[Index].DeltaSeconds;
+	}
+
+	FixedDeltaTime = 1.0f / FMath::Max(FixedFrameRate, 1.0f);
+	State = EState::WaitingToReplay;
+	return true;
+}
+
+void UPlayGroundCppInputReplaySubsystem::BeginReplay(APlayGroundCppCharacter* Character)
+{
+	TargetCharacter = Character;
+
+	Character->TeleportTo(StartLocation, Character->GetActorRotation(), false, true);
+	Character->GetCharacterMovement()->StopMovementImmediately();
+	if (AController* Controller = Character->GetController())
+	{
+		Controller->SetControlRotation(StartControlRotation);
+	}
+
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+
+	// every frame simulates the same step however long it takes, and the engine doesn't wait between frames
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FixedDeltaTime);
+
+	ReplayCursor = 0;
+	ReplayTime = 0.0;
+	TotalFrameSeconds = 0.0;
+	MaxFrameSeconds = 0.0;
+	NumReplayedFrames = 0;
+
+#if CSV_PROFILER
+	if (!FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::Get()->BeginCapture();
+		bStartedCapture = true;
+	}
+#endif
+	CSV_EVENT(InputReplay, TEXT("Start %s"), *FPaths::GetBaseFilename(RecordingFilename));
+
+	State = EState::Replaying;
+
+	UE_LOG(LogInputReplay, Log, TEXT("Replaying %d frames of input from %s at a fixed %.2f ms step."), Frames.Num(), *RecordingFilename, FixedDeltaTime * 1000.0f);
+}
+
+void UPlayGroundCppInputReplaySubsystem::StopReplay()
+{
+	if (State == EState::Replaying)
+	{
+		FinishReplay();
+	}
+	State = EState::Idle;
+	TargetCharacter.Reset();
+}
+
+void UPlayGroundCppInputReplaySubsystem::FinishReplay()
+{
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	CSV_EVENT(InputReplay, TEXT("End"));
+#if CSV_PROFILER
+	if (bStartedCapture)
+	{
+		FCsvProfiler::Get()->EndCapture();
+		bStartedCapture = false;
+	}
+#endif
+
+	// the first replayed frame has no previous one to be timed from
+	const int32 NumTimedFrames = NumReplayedFrames - 1;
+	const double AverageFrameMs = (NumTimedFrames > 0) ? TotalFrameSeconds * 1000.0 / NumTimedFrames : 0.0;
+	UE_LOG(LogInputReplay, Log, TEXT("Replay of %s finished: %d frames, %.2f ms average frame, %.2f ms worst."),
+		*RecordingFilename, NumReplayedFrames, AverageFrameMs, MaxFrameSeconds * 1000.0);
+
+	State = EState::Idle;
+	TargetCharacter.Reset();
+}
+
+bool UPlayGroundCppInputReplaySubsystem::FilterLiveInput(const APlayGroundCppCharacter* Character, EPlayGroundCppInputAxis Axis, float Value)
+{
+	if (Character != TargetCharacter.Get())
+	{
+		return true;
+	}
+	if (State == EState::Recording)
+	{
+		CurrentFrame.Axes[(int32)Axis] += Value;
+	}
+	return State != EState::Replaying;
+}
+
+bool UPlayGroundCppInputReplaySubsystem::FilterLiveInput(const APlayGroundCppCharacter* Character, EPlayGroundCppInputAction Action)
+{
+	if (Character != TargetCharacter.Get())
+	{
+		return true;
+	}
+	if (State == EState::Recording)
+	{
+		CurrentFrame.AddAction(Action);
+	}
+	return State != EState::Replaying;
+}
+
+void UPlayGroundCppInputReplaySubsystem::OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld() || State == EState::Idle || InWorld->IsPaused())
+	{
+		return;
+	}
+
+	switch (State)
+	{
+	case EState::WaitingToRecord:
+		if (APlayGroundCppCharacter* Character = FindLocalCharacter())
+		{
+			BeginRecording(Character, DeltaSeconds);
+		}
+		break;
+
+	case EState::Recording:
+		if (!TargetCharacter.IsValid())
+		{
+			UE_LOG(LogInputReplay, Warning, TEXT("The recorded character is gone, stopping the recording."));
+			StopRecording();
+			break;
+		}
+		// the input of the previous frame is complete, this frame's is added during the actor tick that follows
+		Frames.Add(CurrentFrame);
+		CurrentFrame = FPlayGroundCppInputFrame();
+		CurrentFrame.DeltaSeconds = DeltaSeconds;
+		break;
+
+	case EState::WaitingToReplay:
+		// the fixed timestep applies from the next frame on, which is the first replayed one
+		if (APlayGroundCppCharacter* Character = FindLocalCharacter())
+		{
+			BeginReplay(Character);
+		}
+		break;
+
+	case EState::Replaying:
+		ReplayFrame(DeltaSeconds);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UPlayGroundCppInputReplaySubsystem::ReplayFrame(float DeltaSeconds)
+{
+	APlayGroundCppCharacter* Character = TargetCharacter.Get();
+	if (Character == nullptr)
+	{
+		UE_LOG(LogInputReplay, Warning, TEXT("The replayed character is gone, stopping the replay."));
+		FinishReplay();
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (NumReplayedFrames > 0)
+	{
+		const double FrameSeconds = Now - LastFrameSeconds;
+		TotalFrameSeconds += FrameSeconds;
+		MaxFrameSeconds = FMath::Max(MaxFrameSeconds, FrameSeconds);
+	}
+	LastFrameSeconds = Now;
+	++NumReplayedFrames;
+
+	Character->ApplyReplayedInput(ResampleFrame(DeltaSeconds));
+	CSV_CUSTOM_STAT(InputReplay, Frame, NumReplayedFrames, ECsvCustomStatOp::Set);
+
+	if (ReplayCursor >= Frames.Num())
+	{
+		FinishReplay();
+
+		if (CVarInputReplayExitOnCompletion.GetValueOnGameThread() != 0)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+}
+
+FPlayGroundCppInputFrame UPlayGroundCppInputReplaySubsystem::ResampleFrame(float DeltaSeconds)
+{
+	const double StepStart = ReplayTime;
+	const double StepEnd = ReplayTime + DeltaSeconds;
+
+	FPlayGroundCppInputFrame Resampled;
+	Resampled.DeltaSeconds = DeltaSeconds;
+
+	for (int32 Index = ReplayCursor; Index < Frames.Num() && FrameStartTimes[Index] < StepEnd; ++Index)
+	{
+		const FPlayGroundCppInputFrame& Frame = Frames[Index];
+		const double FrameStart = FrameStartTimes[Index];
+		const double FrameEnd = FrameStart + Frame.DeltaSeconds;
+		const double Overlap = FMath::Max(FMath::Min(StepEnd, FrameEnd) - FMath::Max(StepStart, FrameStart), 0.0);
+
+		// look input is a rotation per frame, split by time; movement is a direction held over the frame, averaged
+		const float LookFraction = (Frame.DeltaSeconds > 0.0f) ? (float)(Overlap / Frame.DeltaSeconds) : ((FrameStart >= StepStart) ? 1.0f : 0.0f);
+		const float MoveWeight = (DeltaSeconds > 0.0f) ? (float)(Overlap / DeltaSeconds) : 0.0f;
+		Resampled.Axes[(int32)EPlayGroundCppInputAxis::MoveForward] += Frame.Axes[(int32)EPlayGroundCppInputAxis::MoveForward] * MoveWeight;
+		Resampled.Axes[(int32)EPlayGroundCppInputAxis::MoveRight] += Frame.Axes[(int32)EPlayGroundCppInputAxis::MoveRight] * MoveWeight;
+		Resampled.Axes[(int32)EPlayGroundCppInputAxis::Turn] += Frame.Axes[(int32)EPlayGroundCppInputAxis::Turn] * LookFraction;
+		Resampled.Axes[(int32)EPlayGroundCppInputAxis::LookUp] += Frame.Axes[(int32)EPlayGroundCppInputAxis::LookUp] * LookFraction;
+
+		// actions happen once, in the step their frame starts in
+		if (FrameStart >= StepStart)
+		{
+			Resampled.Actions |= Frame.Actions;
+		}
+	}
+
+	while (ReplayCursor < Frames.Num() && FrameStartTimes[ReplayCursor] + Frames[ReplayCursor].DeltaSeconds <= StepEnd)
+	{
+		++ReplayCursor;
+	}
+
+	ReplayTime = StepEnd;
+	return Resampled;
+}
@@ -0,0 +1,157 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PlayGroundCppInputReplaySubsystem.generated.h"
+
+class APlayGroundCppCharacter;
+
+/** Axis bindings of APlayGroundCppCharacter that are recorded, the gamepad rates are folded into Turn and LookUp */
+enum class EPlayGroundCppInputAxis : uint8
+{
+	MoveForward,
+	MoveRight,
+	Turn,
+	LookUp,
+	Num
+};
+
+/** Action bindings of APlayGroundCppCharacter that are recorded */
+enum class EPlayGroundCppInputAction : uint8
+{
+	Fire,
+	JumpPressed,
+	JumpReleased,
+	Num
+};
+
+/** The input of one frame: what every axis added up to and which actions were triggered */
+struct FPlayGroundCppInputFrame
+{
+	float DeltaSeconds = 0.0f;
+	float Axes[(int32)EPlayGroundCppInputAxis::Num] = {};
+	uint8 Actions = 0;
+
+	bool HasAction(EPlayGroundCppInputAction Action) const { return (Actions & (1 << (int32)Action)) != 0; }
+	void AddAction(EPlayGroundCppInputAction Action) { Actions |= (1 << (int32)Action); }
+};
+
+/**
+ * Records the local player's gameplay input and plays it back, so a session played by hand can be repeated
+ * frame for frame across builds for performance comparisons.
+ *
+ * While recording, every axis and action APlayGroundCppCharacter binds is summed per frame and written with the
+ * frame's duration to a small binary file, along with the map, the character's starting location and view and
+ * the seed the random streams were reset to. Replaying puts the character back at its start, reseeds the
+ * random streams and switches the engine to a fixed timestep, so the simulation no longer depends on how fast
+ * the build runs. The recording is resampled onto that timestep before actors tick each frame: look input is
+ * split by time, movement is averaged over the step and actions fire in the step they were recorded in. Live
+ * input to the character is ignored while a replay drives it. A replay runs inside a CSV profiler capture and
+ * logs its average and worst frame times when it ends.
+ *
+ * Start from the command line with -InputRecord=<File> or -InputReplay=<File> [-InputReplayFPS=60], or with
+ * the PlayGroundCpp.InputRecord.* and PlayGroundCpp.InputReplay.* console commands. Files without a
+ * directory go to Saved/InputRecordings.
+ */
+UCLASS()
+class UPlayGroundCppInputReplaySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UPlayGroundCppInputReplaySubsystem();
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// End of UWorldSubsystem interface
+
+	/** Records the first local player's character from the next frame on, or once it has spawned */
+	bool StartRecording(const FString& Filename);
+
+	/** Writes the file, returns false if nothing was being recorded or it couldn't be written */
+	bool StopRecording();
+
+	/** Loads the file and replays it at FixedFrameRate, from the next frame on or once the character has spawned */
+	bool StartReplay(const FString& Filename, float FixedFrameRate);
+
+	void StopReplay();
+
+	bool IsRecording() const { return State == EState::Recording || State == EState::WaitingToRecord; }
+	bool IsReplaying() const { return State == EState::Replaying || State == EState::WaitingToReplay; }
+
+	/**
+	 * Called by the character with its live input. Returns whether the character should act on it, false while a
+	 * replay drives it. Input of the recorded character is added to the current frame.
+	 */
+	bool FilterLiveInput(const APlayGroundCppCharacter* Character, EPlayGroundCppInputAxis Axis, float Value);
+	bool FilterLiveInput(const APlayGroundCppCharacter* Character, EPlayGroundCppInputAction Action);
+
+private:
+	enum class EState : uint8
+	{
+		Idle,
+		WaitingToRecord,
+		Recording,
+		WaitingToReplay,
+		Replaying,
+	};
+
+	void OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	/** The first local player's character, null until it has spawned */
+	APlayGroundCppCharacter* FindLocalCharacter() const;
+
+	void BeginRecording(APlayGroundCppCharacter* Character, float DeltaSeconds);
+	void BeginReplay(APlayGroundCppCharacter* Character);
+	void ReplayFrame(float DeltaSeconds);
+	void FinishReplay();
+
+	/** The recorded input overlapping [ReplayTime, ReplayTime + DeltaSeconds), advancing the cursor past what was used up */
+	FPlayGroundCppInputFrame ResampleFrame(float DeltaSeconds);
+
+	static FString ResolveFilename(const FString& Filename);
+
+	EState State;
+
+	/** Resolved path of the file being recorded or replayed */
+	FString RecordingFilename;
+
+	/** The character being recorded or replayed */
+	TWeakObjectPtr<APlayGroundCppCharacter> TargetCharacter;
+
+	/** Header of the recording, written or read */
+	FString MapName;
+	int32 RandomSeed;
+	FVector StartLocation;
+	FRotator StartControlRotation;
+
+	/** Recorded frames, CurrentFrame is the one live input is being added to */
+	TArray<FPlayGroundCppInputFrame> Frames;
+	FPlayGroundCppInputFrame CurrentFrame;
+
+	/** Replay: start time of every recorded frame, the first frame not used up yet and the time replayed so far */
+	TArray<double> FrameStartTimes;
+	int32 ReplayCursor;
+	double ReplayTime;
+	float FixedDeltaTime;
+
+	/** Replay: fixed timestep settings to restore and the wall clock frame times */
+	bool bPreviousUseFixedTimeStep;
+	double PreviousFixedDeltaTime;
+	double LastFrameSeconds;
+	double TotalFrameSeconds;
+	double MaxFrameSeconds;
+	int32 NumReplayedFrames;
+	bool bStartedCapture;
+
+	FDelegateHandle PreActorTickHandle;
+};
@@ -0,0 +1,304 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppLoadTestDirector.h"
+#include "PlayGroundCppBotController.h"
+#include "PlayGroundCppProjectile.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogLoadTest, Log, All);
+
+CSV_DEFINE_CATEGORY(LoadTest, true);
+
+static TAutoConsoleVariable<int32> CVarLoadTestInitialBots(
+	TEXT("PlayGroundCpp.LoadTest.InitialBots"),
+	4,
+	TEXT("Number of bots spawned when the load test starts."));
+
+static TAutoConsoleVariable<int32> CVarLoadTestMaxBots(
+	TEXT("PlayGroundCpp.LoadTest.MaxBots"),
+	64,
+	TEXT("Number of bots at which the ramp stops and the load test ends."));
+
+static TAutoConsoleVariable<int32> CVarLoadTestBotsPerStep(
+	TEXT("PlayGroundCpp.LoadTest.BotsPerStep"),
+	4,
+	TEXT("Number of bots added at every ramp step."));
+
+static TAutoConsoleVariable<float> CVarLoadTestStepSeconds(
+	TEXT("PlayGroundCpp.LoadTest.StepSeconds"),
+	10.0f,
+	TEXT("Seconds spent at each bot count before ramping up."));
+
+static TAutoConsoleVariable<float> CVarLoadTestFireRate(
+	TEXT("PlayGroundCpp.LoadTest.FireRate"),
+	2.0f,
+	TEXT("Shots per second fired by each bot, 0 disables firing."));
+
+static TAutoConsoleVariable<float> CVarLoadTestHeadingChangeInterval(
+	TEXT("PlayGroundCpp.LoadTest.HeadingChangeInterval"),
+	3.0f,
+	TEXT("Average seconds between bot heading changes."));
+
+static TAutoConsoleVariable<float> CVarLoadTestSpawnRadius(
+	TEXT("PlayGroundCpp.LoadTest.SpawnRadius"),
+	1500.0f,
+	TEXT("Radius around the player starts in which bots are spawned."));
+
+static TAutoConsoleVariable<int32> CVarLoadTestExitOnCompletion(
+	TEXT("PlayGroundCpp.LoadTest.ExitOnCompletion"),
+	0,
+	TEXT("When non-zero, the process exits once the load test has finished."));
+
+static FAutoConsoleCommandWithWorld LoadTestStartCommand(
+	TEXT("PlayGroundCpp.LoadTest.Start"),
+	TEXT("Starts the bot load test, configured through the PlayGroundCpp.LoadTest.* variables."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World) { APlayGroundCppLoadTestDirector::StartLoadTest(World); }));
+
+static FAutoConsoleCommandWithWorld LoadTestStopCommand(
+	TEXT("PlayGroundCpp.LoadTest.Stop"),
+	TEXT("Stops the running bot load test and removes its bots."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World) { APlayGroundCppLoadTestDirector::StopLoadTest(World); }));
+
+APlayGroundCppLoadTestDirector::APlayGroundCppLoadTestDirector()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// bots and projectiles are done moving by then, so the counts match what the frame actually simulated
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	TargetBots = 0;
+	TimeInStep = 0.0f;
+	bStartedCapture = false;
+}
+
+APlayGroundCppLoadTestDirector* APlayGroundCppLoadTestDirector::StartLoadTest(UWorld* World)
+{
+	if (World == nullptr || World->GetNetMode() == NM_Client)
+	{
+		UE_LOG(LogLoadTest, Warning, TEXT("The load test can only be started on the authority."));
+		return nullptr;
+	}
+
+	for (TActorIterator<APlayGroundCppLoadTestDirector> It(World); It; ++It)
+	{
+		UE_LOG(LogLoadTest, Warning, TEXT("A load test is already running."));
+		return *It;
+	}
+
+	return World->SpawnActor<APlayGroundCppLoadTestDirector>();
+}
+
+void APlayGroundCppLoadTestDirector::StopLoadTest(UWorld* World)
+{
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	for (TActorIterator<APlayGroundCppLoadTestDirector> It(World); It; ++It)
+	{
+		It->Destroy();
+	}
+}
+
+void APlayGroundCppLoadTestDirector::BeginPlay()
+{
+	Super::BeginPlay();
+
+	for (TActorIterator<APlayerStart> It(GetWorld()); It; ++It)
+	{
+		SpawnOrigins.Add(It->GetActorLocation());
+	}
+	if (SpawnOrigins.Num() == 0)
+	{
+		SpawnOrigins.Add(GetActorLocation());
+	}
+
+#if CSV_PROFILER
+	if (!FCsvProfiler::Get()->IsCapturing())
+	{
+		FCsvProfiler::Get()->BeginCapture();
+		bStartedCapture = true;
+	}
+#endif
+
+	TargetBots = FMath::Max(CVarLoadTestInitialBots.GetValueOnGameThread(), 0);
+	Steps.Add({ TargetBots, 0, 0.0, 0 });
+
+	CSV_EVENT(LoadTest, TEXT("Bots=%d"), TargetBots);
+	UE_LOG(LogLoadTest, Log, TEXT("Load test started with %d bots, ramping to %d."), TargetBots, CVarLoadTestMaxBots.GetValueOnGameThread());
+}
+
+void APlayGroundCppLoadTestDirector::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (APlayGroundCppBotController* BotController : BotControllers)
+	{
+		if (BotController != nullptr)
+		{
+			BotController->Destroy();
+		}
+	}
+	for (APawn* Bot : Bots)
+	{
+		if (Bot != nullptr)
+		{
+			Bot->Destroy();
+		}
+	}
+	BotControllers.Reset();
+	Bots.Reset();
+
+#if CSV_PROFILER
+	if (bStartedCapture)
+	{
+		FCsvProfiler::Get()->EndCapture();
+		bStartedCapture = false;
+	}
+#endif
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void APlayGroundCppLoadTestDirector::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// bots can fall out of the world or be destroyed by gameplay, those are respawned to hold the target count
+	Bots.RemoveAll([](APawn* Bot) { return Bot == nullptr || Bot->IsPendingKill(); });
+	for (int32 Index = BotControllers.Num() - 1; Index >= 0; --Index)
+	{
+		APlayGroundCppBotController* BotController = BotControllers[Index];
+		if (BotController == nullptr || BotController->IsPendingKill() || BotController->GetPawn() == nullptr)
+		{
+			if (BotController != nullptr)
+			{
+				BotController->Destroy();
+			}
+			BotControllers.RemoveAtSwap(Index);
+		}
+	}
+	if (Bots.Num() < TargetBots)
+	{
+		SpawnBots(TargetBots - Bots.Num());
+	}
+
+	RecordFrameStats();
+
+	TimeInStep += DeltaSeconds;
+	if (TimeInStep < CVarLoadTestStepSeconds.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	FinishStep();
+
+	const int32 MaxBots = CVarLoadTestMaxBots.GetValueOnGameThread();
+	if (TargetBots >= MaxBots)
+	{
+		FinishLoadTest();
+		return;
+	}
+
+	TargetBots = FMath::Min(TargetBots + FMath::Max(CVarLoadTestBotsPerStep.GetValueOnGameThread(), 1), MaxBots);
+	Steps.Add({ TargetBots, 0, 0.0, 0 });
+	CSV_EVENT(LoadTest, TEXT("Bots=%d"), TargetBots);
+}
+
+void APlayGroundCppLoadTestDirector::SpawnBots(int32 Count)
+{
+	UWorld* World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+	if (GameMode == nullptr || GameMode->DefaultPawnClass == nullptr)
+	{
+		return;
+	}
+
+	const float SpawnRadius = CVarLoadTestSpawnRadius.GetValueOnGameThread();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const FVector2D Offset = FMath::RandPointInCircle(SpawnRadius);
+		const FVector SpawnLocation = SpawnOrigins[FMath::RandHelper(SpawnOrigins.Num())] + FVector(Offset.X, Offset.Y, 0.0f);
+
+		// a blocked spot is simply retried from another random location on the next frame
+		APawn* Bot = World->SpawnActor<APawn>(GameMode->DefaultPawnClass, SpawnLocation, FRotator::ZeroRotator, SpawnParams);
+		if (Bot == nullptr)
+		{
+			continue;
+		}
+
+		APlayGroundCppBotController* BotController = World->SpawnActor<APlayGroundCppBotController>();
+		if (BotController == nullptr)
+		{
+			// an uncontrolled bot would only stand there and skew the step, take it back out
+			Bot->Destroy();
+			continue;
+		}
+
+		BotController->FireRate = CVarLoadTestFireRate.GetValueOnGameThread();
+		BotController->HeadingChangeInterval = CVarLoadTestHeadingChangeInterval.GetValueOnGameThread();
+		BotController->Possess(Bot);
+
+		Bots.Add(Bot);
+		BotControllers.Add(BotController);
+	}
+}
+
+void APlayGroundCppLoadTestDirector::RecordFrameStats()
+{
+	int32 NumProjectiles = 0;
+	for (TActorIterator<APlayGroundCppProjectile> It(GetWorld()); It; ++It)
+	{
+		++NumProjectiles;
+	}
+
+	FStepSummary& Step = Steps.Last();
+	Step.NumFrames++;
+	Step.TotalFrameSeconds += FApp::GetDeltaTime();
+	Step.MaxProjectiles = FMath::Max(Step.MaxProjectiles, NumProjectiles);
+
+	// frame, game thread, render thread and GPU times are captured by the CSV profiler itself
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	CSV_CUSTOM_STAT(LoadTest, Bots, Bots.Num(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(LoadTest, Actors, GetWorld()->GetActorCount(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(LoadTest, Projectiles, NumProjectiles, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(LoadTest, UsedPhysicalMB, float(MemoryStats.UsedPhysical / (1024.0 * 1024.0)), ECsvCustomStatOp::Set);
+}
+
+void APlayGroundCppLoadTestDirector::FinishStep()
+{
+	const FStepSummary& Step = Steps.Last();
+	const double AverageFrameMs = (Step.NumFrames > 0) ? Step.TotalFrameSeconds * 1000.0 / Step.NumFrames : 0.0;
+
+	UE_LOG(LogLoadTest, Log, TEXT("Step %d: %d bots, %.2f ms average frame over %d frames, peak %d projectiles."),
+		Steps.Num() - 1, Step.NumBots, AverageFrameMs, Step.NumFrames, Step.MaxProjectiles);
+
+	TimeInStep = 0.0f;
+}
+
+void APlayGroundCppLoadTestDirector::FinishLoadTest()
+{
+	// summary table, the knee is where the per-step frame time stops growing linearly with the bot count
+	UE_LOG(LogLoadTest, Log, TEXT("Load test finished:"));
+	UE_LOG(LogLoadTest, Log, TEXT("  Bots  AvgFrameMs  PeakProjectiles"));
+	for (const FStepSummary& Step : Steps)
+	{
+		const double AverageFrameMs = (Step.NumFrames > 0) ? Step.TotalFrameSeconds * 1000.0 / Step.NumFrames : 0.0;
+		UE_LOG(LogLoadTest, Log, TEXT("  %4d  %10.2f  %15d"), Step.NumBots, AverageFrameMs, Step.MaxProjectiles);
+	}
+
+	Destroy();
+
+	if (CVarLoadTestExitOnCompletion.GetValueOnGameThread() != 0)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "PlayGroundCppLoadTestDirector.generated.h"
+
+class APawn;
+class APlayGroundCppBotController;
+
+/**
+ * Drives a bot load test on the authority: spawns AI-controlled characters, ramps their count up in steps
+ * and records bot/actor/projectile counts and memory into a CSV profiler capture next to the frame, game
+ * thread, render thread and GPU times the profiler already records.
+ *
+ * Start it with "-LoadTest" on the command line or the PlayGroundCpp.LoadTest.Start console command,
+ * and tune it through the PlayGroundCpp.LoadTest.* console variables.
+ */
+UCLASS(NotPlaceable, Transient)
+class APlayGroundCppLoadTestDirector : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	APlayGroundCppLoadTestDirector();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Spawns a director in the world unless one is already running */
+	static APlayGroundCppLoadTestDirector* StartLoadTest(UWorld* World);
+
+	/** Stops the running director of the world, if any */
+	static void StopLoadTest(UWorld* World);
+
+	/** Returns the number of bots currently alive */
+	int32 GetNumBots() const { return Bots.Num(); }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/** Spawns up to Count more bots around the player starts */
+	void SpawnBots(int32 Count);
+
+	/** Logs the average frame time of the step that just finished and starts a new one */
+	void FinishStep();
+
+	/** Records the per-frame custom stats into the CSV capture */
+	void RecordFrameStats();
+
+	/** Ends the test, tearing down the bots and the capture */
+	void FinishLoadTest();
+
+	struct FStepSummary
+	{
+		int32 NumBots;
+		int32 NumFrames;
+		double TotalFrameSeconds;
+		int32 MaxProjectiles;
+	};
+
+	UPROPERTY()
+	TArray<APawn*> Bots;
+
+	UPROPERTY()
+	TArray<APlayGroundCppBotController*> BotControllers;
+
+	TArray<FVector> SpawnOrigins;
+	TArray<FStepSummary> Steps;
+
+	int32 TargetBots;
+	float TimeInStep;
+	bool bStartedCapture;
+};
@@ -1,8 +1,10 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "PlayGroundCppProjectile.h"
+#include "PlayGroundCppSignificanceSubsystem.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
+#include "Engine/World.h"
 
 APlayGroundCppProjectile::APlayGroundCppProjectile() 
 {
@@ -29,6 +31,37 @@ APlayGroundCppProjectile::APlayGroundCppProjectile()
 
 	// Die after 3 seconds by default
 	InitialLifeSpan = 3.0f;
+
+	Damage = 20.0f;
+}
+
+void APlayGroundCppProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UPlayGroundCppSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UPlayGroundCppSignificanceSubsystem>();
+	if (Significance != nullptr)
+	{
+		Significance->RegisterProjectile(this);
+	}
+}
+
+void APlayGroundCppProjectile::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UPlayGroundCppSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UPlayGroundCppSignificanceSubsystem>();
+	if (Significance != nullptr)
+	{
+		Significance->Unregister(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+int32 APlayGroundCppProjectile::ApplySignificanceTickInterval(float TickInterval)
+{
+	// the movement sweeps the whole distance covered since its last tick, so hits are still found at lower rates
+	ProjectileMovement->SetComponentTickInterval(TickInterval);
+	return ProjectileMovement->IsComponentTickEnabled() ? 1 : 0;
 }
 
 void APlayGroundCppProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
@@ -40,4 +73,4 @@ void APlayGroundCppProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* Other
 
 		Destroy();
 	}
-}
\ No newline at end of file
+}
@@ -25,10 +25,30 @@ class APlayGroundCppProjectile : public AActor
 public:
 	APlayGroundCppProjectile();
 
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+
 	/** called when projectile hits something */
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/**
+	 * Damage dealt to a character the shot hit, once per shot. The authority checks the shot when it is fired against
+	 * the poses the shooter saw, the projectile itself deals none
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Projectile)
+	float Damage;
+
+	/**
+	 * Applies the tick interval of the significance bucket this projectile currently falls into.
+	 * @returns the number of tick functions that are now running at that interval.
+	 */
+	int32 ApplySignificanceTickInterval(float TickInterval);
+
+public:
 	/** Returns CollisionComp subobject **/
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
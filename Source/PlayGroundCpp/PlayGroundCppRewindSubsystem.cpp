@@ -0,0 +1,363 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppRewindSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogRewind, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("Rewind"), STATGROUP_PlayGroundCppRewind, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Record frame"), STAT_Rewind_RecordFrame, STATGROUP_PlayGroundCppRewind);
+DECLARE_CYCLE_STAT(TEXT("Validate shots"), STAT_Rewind_ValidateShots, STATGROUP_PlayGroundCppRewind);
+DECLARE_MEMORY_STAT(TEXT("History memory"), STAT_Rewind_HistoryMemory, STATGROUP_PlayGroundCppRewind);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tracked characters"), STAT_Rewind_TrackedCharacters, STATGROUP_PlayGroundCppRewind);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shots validated"), STAT_Rewind_ShotsValidated, STATGROUP_PlayGroundCppRewind);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Broadphase candidates"), STAT_Rewind_Candidates, STATGROUP_PlayGroundCppRewind);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits confirmed"), STAT_Rewind_HitsConfirmed, STATGROUP_PlayGroundCppRewind);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Validation cost per shot (us)"), STAT_Rewind_MicrosecondsPerShot, STATGROUP_PlayGroundCppRewind);
+
+/** Slab test of the segment Start + T * Dir, T in [0, 1], against an axis aligned box */
+static bool SegmentIntersectsBox(const FVector& Start, const FVector& InvDir, const FVector& BoxMin, const FVector& BoxMax)
+{
+	float TMin = 0.0f;
+	float TMax = 1.0f;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		const float T0 = (BoxMin[Axis] - Start[Axis]) * InvDir[Axis];
+		const float T1 = (BoxMax[Axis] - Start[Axis]) * InvDir[Axis];
+		TMin = FMath::Max(TMin, FMath::Min(T0, T1));
+		TMax = FMath::Min(TMax, FMath::Max(T0, T1));
+	}
+	return TMin <= TMax;
+}
+
+UPlayGroundCppRewindSubsystem::UPlayGroundCppRewindSubsystem()
+{
+	HistoryLength = 64;
+	MaxCharacters = 128;
+	MaxRewindSeconds = 0.25f;
+	HeadFrame = INDEX_NONE;
+	NextSerial = 1;
+	HighestUsedSlot = INDEX_NONE;
+}
+
+bool UPlayGroundCppRewindSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// poses are only ever rewound by whoever decides what got hit
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World != nullptr && World->IsGameWorld() && World->GetNetMode() != NM_Client;
+}
+
+void UPlayGroundCppRewindSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	HistoryLength = FMath::Max(HistoryLength, 2);
+	MaxCharacters = FMath::Max(MaxCharacters, 1);
+
+	// everything is sized once up front, recording never allocates
+	const int32 NumPositions = HistoryLength * MaxCharacters;
+	PositionX.SetNumZeroed(NumPositions);
+	PositionY.SetNumZeroed(NumPositions);
+	PositionZ.SetNumZeroed(NumPositions);
+
+	// serial 0 marks a frame that was never recorded
+	FrameTimes.SetNumZeroed(HistoryLength);
+	FrameSerials.SetNumZeroed(HistoryLength);
+
+	// slot serial 0 marks a free slot, free slots are handed out lowest first to keep the used range tight
+	SlotCharacters.SetNum(MaxCharacters);
+	SlotRadius.SetNumZeroed(MaxCharacters);
+	SlotHalfHeight.SetNumZeroed(MaxCharacters);
+	SlotFirstSerial.SetNumZeroed(MaxCharacters);
+	FreeSlots.Reset(MaxCharacters);
+	for (int32 Slot = MaxCharacters - 1; Slot >= 0; --Slot)
+	{
+		FreeSlots.Add(Slot);
+	}
+
+	Candidates.Reserve(MaxCharacters);
+
+	SET_MEMORY_STAT(STAT_Rewind_HistoryMemory,
+		PositionX.GetAllocatedSize() + PositionY.GetAllocatedSize() + PositionZ.GetAllocatedSize() +
+		FrameTimes.GetAllocatedSize() + FrameSerials.GetAllocatedSize() +
+		SlotCharacters.GetAllocatedSize() + SlotRadius.GetAllocatedSize() + SlotHalfHeight.GetAllocatedSize() +
+		SlotFirstSerial.GetAllocatedSize() + FreeSlots.GetAllocatedSize() + Candidates.GetAllocatedSize());
+}
+
+void UPlayGroundCppRewindSubsystem::Deinitialize()
+{
+	PendingShots.Reset();
+	SET_MEMORY_STAT(STAT_Rewind_HistoryMemory, 0);
+
+	Super::Deinitialize();
+}
+
+ETickableTickType UPlayGroundCppRewindSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+UWorld* UPlayGroundCppRewindSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UPlayGroundCppRewindSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPlayGroundCppRewindSubsystem, STATGROUP_Tickables);
+}
+
+void UPlayGroundCppRewindSubsystem::Tick(float DeltaTime)
+{
+	// tickable objects run after the actors, so this frame's poses are final and this frame's hits are queued
+	RecordFrame();
+	ValidatePendingShots();
+}
+
+void UPlayGroundCppRewindSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (Character == nullptr || SlotCharacters.Contains(Character))
+	{
+		return;
+	}
+
+	if (FreeSlots.Num() == 0)
+	{
+		UE_LOG(LogRewind, Warning, TEXT("Rewind history is full (%d characters), %s won't be lag compensated"), MaxCharacters, *Character->GetName());
+		return;
+	}
+
+	const int32 Slot = FreeSlots.Pop(false);
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+
+	SlotCharacters[Slot] = Character;
+	SlotRadius[Slot] = Capsule->GetScaledCapsuleRadius();
+	SlotHalfHeight[Slot] = Capsule->GetScaledCapsuleHalfHeight();
+	// frames recorded before this point belong to whoever had the slot before
+	SlotFirstSerial[Slot] = NextSerial;
+	HighestUsedSlot = FMath::Max(HighestUsedSlot, Slot);
+}
+
+void UPlayGroundCppRewindSubsystem::UnregisterCharacter(ACharacter* Character)
+{
+	const int32 Slot = SlotCharacters.IndexOfByKey(Character);
+	if (Slot == INDEX_NONE)
+	{
+		return;
+	}
+
+	SlotCharacters[Slot].Reset();
+	SlotFirstSerial[Slot] = 0;
+	FreeSlots.Add(Slot);
+
+	while (HighestUsedSlot >= 0 && SlotFirstSerial[HighestUsedSlot] == 0)
+	{
+		--HighestUsedSlot;
+	}
+}
+
+void UPlayGroundCppRewindSubsystem::QueueShot(FPlayGroundCppRewindShot&& Shot)
+{
+	PendingShots.Add(MoveTemp(Shot));
+}
+
+void UPlayGroundCppRewindSubsystem::RecordFrame()
+{
+	SCOPE_CYCLE_COUNTER(STAT_Rewind_RecordFrame);
+
+	HeadFrame = (HeadFrame + 1) % HistoryLength;
+	FrameTimes[HeadFrame] = GetWorld()->GetTimeSeconds();
+	FrameSerials[HeadFrame] = NextSerial++;
+
+	int32 NumTracked = 0;
+	const int32 Base = HeadFrame * MaxCharacters;
+	for (int32 Slot = 0; Slot <= HighestUsedSlot; ++Slot)
+	{
+		const ACharacter* Character = SlotCharacters[Slot].Get();
+		if (Character == nullptr)
+		{
+			continue;
+		}
+
+		const FVector Location = Character->GetCapsuleComponent()->GetComponentLocation();
+		PositionX[Base + Slot] = Location.X;
+		PositionY[Base + Slot] = Location.Y;
+		PositionZ[Base + Slot] = Location.Z;
+		++NumTracked;
+	}
+
+	SET_DWORD_STAT(STAT_Rewind_TrackedCharacters, NumTracked);
+}
+
+bool UPlayGroundCppRewindSubsystem::FindFrames(double Time, int32& OutOlderFrame, int32& OutNewerFrame, float& OutAlpha) const
+{
+	if (HeadFrame == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// walk back from the newest frame, anything newer than the head is clamped to it
+	int32 NewerFrame = HeadFrame;
+	for (int32 Age = 0; Age < HistoryLength; ++Age)
+	{
+		const int32 Frame = (HeadFrame - Age + HistoryLength) % HistoryLength;
+		if (FrameSerials[Frame] == 0)
+		{
+			break;
+		}
+
+		if (FrameTimes[Frame] <= Time)
+		{
+			const double Span = FrameTimes[NewerFrame] - FrameTimes[Frame];
+			OutOlderFrame = Frame;
+			OutNewerFrame = NewerFrame;
+			OutAlpha = Span > 0.0 ? (float)((Time - FrameTimes[Frame]) / Span) : 0.0f;
+			return true;
+		}
+
+		NewerFrame = Frame;
+	}
+
+	// older than the whole history, use the oldest pose there is
+	OutOlderFrame = NewerFrame;
+	OutNewerFrame = NewerFrame;
+	OutAlpha = 0.0f;
+	return true;
+}
+
+void UPlayGroundCppRewindSubsystem::ValidatePendingShots()
+{
+	if (PendingShots.Num() == 0)
+	{
+		SET_DWORD_STAT(STAT_Rewind_ShotsValidated, 0);
+		SET_DWORD_STAT(STAT_Rewind_Candidates, 0);
+		SET_DWORD_STAT(STAT_Rewind_HitsConfirmed, 0);
+		SET_FLOAT_STAT(STAT_Rewind_MicrosecondsPerShot, 0.0f);
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_Rewind_ValidateShots);
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	const double Now = GetWorld()->GetTimeSeconds();
+	int32 NumCandidates = 0;
+	int32 NumConfirmed = 0;
+
+	// callbacks may queue further shots, those wait for next frame
+	TArray<FPlayGroundCppRewindShot> Shots = MoveTemp(PendingShots);
+	PendingShots.Reset();
+
+	TArray<TPair<FOnRewindShotValidated, TWeakObjectPtr<AActor>>, TInlineAllocator<16>> Results;
+	Results.Reserve(Shots.Num());
+
+	for (FPlayGroundCppRewindShot& Shot : Shots)
+	{
+		ACharacter* HitCharacter = nullptr;
+
+		int32 OlderFrame;
+		int32 NewerFrame;
+		float Alpha;
+		const double RewindTime = Now - FMath::Clamp(Shot.RewindSeconds, 0.0f, MaxRewindSeconds);
+		if (FindFrames(RewindTime, OlderFrame, NewerFrame, Alpha))
+		{
+			const FVector Dir = Shot.End - Shot.Start;
+			const FVector InvDir(
+				Dir.X != 0.0f ? 1.0f / Dir.X : BIG_NUMBER,
+				Dir.Y != 0.0f ? 1.0f / Dir.Y : BIG_NUMBER,
+				Dir.Z != 0.0f ? 1.0f / Dir.Z : BIG_NUMBER);
+			const uint32 OlderSerial = FrameSerials[OlderFrame];
+			const uint32 NewerSerial = FrameSerials[NewerFrame];
+			const int32 OlderBase = OlderFrame * MaxCharacters;
+			const int32 NewerBase = NewerFrame * MaxCharacters;
+
+			// broadphase: the box around both bracketing poses of every slot, straight off the position arrays
+			Candidates.Reset();
+			for (int32 Slot = 0; Slot <= HighestUsedSlot; ++Slot)
+			{
+				const uint32 FirstSerial = SlotFirstSerial[Slot];
+				if (FirstSerial == 0 || NewerSerial < FirstSerial)
+				{
+					continue;
+				}
+
+				// registered in between the two frames, only the newer pose is its own
+				const int32 Older = (OlderSerial < FirstSerial ? NewerBase : OlderBase) + Slot;
+				const int32 Newer = NewerBase + Slot;
+				const float Radius = SlotRadius[Slot] + Shot.Radius;
+				const float HalfHeight = SlotHalfHeight[Slot] + Shot.Radius;
+
+				const FVector BoxMin(
+					FMath::Min(PositionX[Older], PositionX[Newer]) - Radius,
+					FMath::Min(PositionY[Older], PositionY[Newer]) - Radius,
+					FMath::Min(PositionZ[Older], PositionZ[Newer]) - HalfHeight);
+				const FVector BoxMax(
+					FMath::Max(PositionX[Older], PositionX[Newer]) + Radius,
+					FMath::Max(PositionY[Older], PositionY[Newer]) + Radius,
+					FMath::Max(PositionZ[Older], PositionZ[Newer]) + HalfHeight);
+
+				if (SegmentIntersectsBox(Shot.Start, InvDir, BoxMin, BoxMax))
+				{
+					Candidates.Add(Slot);
+				}
+			}
+			NumCandidates += Candidates.Num();
+
+			// exact test against the interpolated capsules, closest hit along the segment wins
+			const AActor* Shooter = Shot.Shooter.Get();
+			const float DirSizeSquared = Dir.SizeSquared();
+			float ClosestT = BIG_NUMBER;
+			for (const int32 Slot : Candidates)
+			{
+				ACharacter* Character = SlotCharacters[Slot].Get();
+				if (Character == nullptr || Character == Shooter)
+				{
+					continue;
+				}
+
+				const int32 Older = (OlderSerial < SlotFirstSerial[Slot] ? NewerBase : OlderBase) + Slot;
+				const int32 Newer = NewerBase + Slot;
+				const FVector Center(
+					FMath::Lerp(PositionX[Older], PositionX[Newer], Alpha),
+					FMath::Lerp(PositionY[Older], PositionY[Newer], Alpha),
+					FMath::Lerp(PositionZ[Older], PositionZ[Newer], Alpha));
+
+				const float Radius = SlotRadius[Slot] + Shot.Radius;
+				const FVector AxisOffset(0.0f, 0.0f, FMath::Max(SlotHalfHeight[Slot] - SlotRadius[Slot], 0.0f));
+
+				FVector OnShot;
+				FVector OnAxis;
+				FMath::SegmentDistToSegmentSafe(Shot.Start, Shot.End, Center - AxisOffset, Center + AxisOffset, OnShot, OnAxis);
+				if (FVector::DistSquared(OnShot, OnAxis) <= FMath::Square(Radius))
+				{
+					const float T = DirSizeSquared > 0.0f ? ((OnShot - Shot.Start) | Dir) / DirSizeSquared : 0.0f;
+					if (T < ClosestT)
+					{
+						ClosestT = T;
+						HitCharacter = Character;
+					}
+				}
+			}
+		}
+
+		if (HitCharacter != nullptr)
+		{
+			++NumConfirmed;
+		}
+		Results.Emplace(MoveTemp(Shot.OnValidated), HitCharacter);
+	}
+
+	const float Microseconds = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles) * 1000.0f;
+	SET_DWORD_STAT(STAT_Rewind_ShotsValidated, Shots.Num());
+	SET_DWORD_STAT(STAT_Rewind_Candidates, NumCandidates);
+	SET_DWORD_STAT(STAT_Rewind_HitsConfirmed, NumConfirmed);
+	SET_FLOAT_STAT(STAT_Rewind_MicrosecondsPerShot, Microseconds / Shots.Num());
+
+	// delegates run last so whatever they do isn't billed to validation
+	for (TPair<FOnRewindShotValidated, TWeakObjectPtr<AActor>>& Result : Results)
+	{
+		Result.Key.ExecuteIfBound(Result.Value.Get());
+	}
+}
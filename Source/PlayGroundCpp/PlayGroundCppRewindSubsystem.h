@@ -0,0 +1,111 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PlayGroundCppRewindSubsystem.generated.h"
+
+class ACharacter;
+
+DECLARE_DELEGATE_OneParam(FOnRewindShotValidated, AActor* /*HitActor*/);
+
+/** A shot to be checked against the character poses of the past */
+struct FPlayGroundCppRewindShot
+{
+	/** Segment the shot travelled along, in world space */
+	FVector Start;
+	FVector End;
+
+	/** Radius of whatever travelled along the segment, 0 for a ray */
+	float Radius = 0.0f;
+
+	/** How far back from the current server time the shooter saw the world */
+	float RewindSeconds = 0.0f;
+
+	/** Never hit by its own shot */
+	TWeakObjectPtr<AActor> Shooter;
+
+	/** Called with the closest character the segment hits in the rewound poses, or nullptr */
+	FOnRewindShotValidated OnValidated;
+};
+
+/**
+ * Server side lag compensation. Records the capsule position of every registered character once per frame into
+ * a fixed-size structure-of-arrays ring buffer and validates queued shots against the poses at the time the
+ * shooter saw them. Shots are validated together at the end of the frame: a cheap broadphase over all slots
+ * finds the capsules whose rewound bounds the shot crosses, and only those are interpolated and tested exactly.
+ */
+UCLASS(config=Game)
+class UPlayGroundCppRewindSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UPlayGroundCppRewindSubsystem();
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	void RegisterCharacter(ACharacter* Character);
+	void UnregisterCharacter(ACharacter* Character);
+
+	/** Queues a shot, its delegate fires at the end of the frame once all queued shots have been validated */
+	void QueueShot(FPlayGroundCppRewindShot&& Shot);
+
+	/** Number of frames kept in the history */
+	UPROPERTY(config)
+	int32 HistoryLength;
+
+	/** Number of characters that can be tracked at once */
+	UPROPERTY(config)
+	int32 MaxCharacters;
+
+	/** Shots are never rewound further than this, whatever the shooter's latency */
+	UPROPERTY(config)
+	float MaxRewindSeconds;
+
+private:
+	/** Writes the current capsule positions of all tracked characters into the next history frame */
+	void RecordFrame();
+
+	/** Runs every queued shot through the broadphase and the exact capsule test */
+	void ValidatePendingShots();
+
+	/** Finds the two recorded frames around Time and how far Time lies between them */
+	bool FindFrames(double Time, int32& OutOlderFrame, int32& OutNewerFrame, float& OutAlpha) const;
+
+	/** Positions, frame major: [Frame * MaxCharacters + Slot] */
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+
+	/** Per frame */
+	TArray<double> FrameTimes;
+	TArray<uint32> FrameSerials;
+
+	/** Per slot */
+	TArray<TWeakObjectPtr<ACharacter>> SlotCharacters;
+	TArray<float> SlotRadius;
+	TArray<float> SlotHalfHeight;
+	TArray<uint32> SlotFirstSerial;
+	TArray<int32> FreeSlots;
+
+	TArray<FPlayGroundCppRewindShot> PendingShots;
+	TArray<int32> Candidates;
+
+	int32 HeadFrame;
+	uint32 NextSerial;
+	int32 HighestUsedSlot;
+};
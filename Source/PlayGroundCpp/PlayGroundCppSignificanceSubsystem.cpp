@@ -0,0 +1,203 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppSignificanceSubsystem.h"
+#include "PlayGroundCpp.h"
+#include "PlayGroundCppCharacter.h"
+#include "PlayGroundCppProjectile.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_STATS_GROUP(TEXT("Significance"), STATGROUP_PlayGroundCppSignificance, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Update significance"), STAT_Significance_Update, STATGROUP_PlayGroundCppSignificance);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Ticks saved per frame"), STAT_Significance_TicksSaved, STATGROUP_PlayGroundCppSignificance);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Throttled actors"), STAT_Significance_ThrottledActors, STATGROUP_PlayGroundCppSignificance);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Disabled tick functions"), STAT_Significance_DisabledTickFunctions, STATGROUP_PlayGroundCppSignificance);
+
+static const FName CharacterSignificanceTag(TEXT("PlayGroundCppCharacter"));
+static const FName ProjectileSignificanceTag(TEXT("PlayGroundCppProjectile"));
+
+UPlayGroundCppSignificanceSubsystem::UPlayGroundCppSignificanceSubsystem()
+{
+	bDemoteNotRendered = true;
+	NumDisabledTickFunctions = 0;
+}
+
+bool UPlayGroundCppSignificanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World != nullptr && World->IsGameWorld();
+}
+
+void UPlayGroundCppSignificanceSubsystem::Deinitialize()
+{
+	ThrottledActors.Reset();
+	NumDisabledTickFunctions = 0;
+
+	Super::Deinitialize();
+}
+
+ETickableTickType UPlayGroundCppSignificanceSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+UWorld* UPlayGroundCppSignificanceSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UPlayGroundCppSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPlayGroundCppSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+void UPlayGroundCppSignificanceSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Significance_Update);
+
+	UWorld* World = GetWorld();
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(World);
+	if (SignificanceManager == nullptr)
+	{
+		return;
+	}
+
+	// local players on clients, every player on the server so bots far away from all of them get throttled
+	Viewpoints.Reset();
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController != nullptr)
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			Viewpoints.Add(FTransform(ViewRotation, ViewLocation));
+		}
+	}
+
+	SignificanceManager->Update(Viewpoints);
+
+	float TicksSaved = (float)NumDisabledTickFunctions;
+	for (const TPair<AActor*, FThrottledActor>& Pair : ThrottledActors)
+	{
+		if (Pair.Value.TickInterval > 0.0f)
+		{
+			TicksSaved += Pair.Value.NumTickFunctions * (1.0f - FMath::Min(DeltaTime / Pair.Value.TickInterval, 1.0f));
+		}
+	}
+
+	SET_FLOAT_STAT(STAT_Significance_TicksSaved, TicksSaved);
+	SET_DWORD_STAT(STAT_Significance_ThrottledActors, ThrottledActors.Num());
+	SET_DWORD_STAT(STAT_Significance_DisabledTickFunctions, NumDisabledTickFunctions);
+}
+
+void UPlayGroundCppSignificanceSubsystem::RegisterCharacter(APlayGroundCppCharacter* Character)
+{
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (SignificanceManager == nullptr)
+	{
+		return;
+	}
+
+	SignificanceManager->RegisterObject(
+		Character,
+		CharacterSignificanceTag,
+		[this](USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint) { return CalculateSignificance(ObjectInfo, Viewpoint); },
+		USignificanceManager::EPostSignificanceType::Sequential,
+		[this](USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal) { ApplySignificance(ObjectInfo, OldSignificance, Significance, bFinal); });
+}
+
+void UPlayGroundCppSignificanceSubsystem::RegisterProjectile(APlayGroundCppProjectile* Projectile)
+{
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (SignificanceManager == nullptr)
+	{
+		return;
+	}
+
+	SignificanceManager->RegisterObject(
+		Projectile,
+		ProjectileSignificanceTag,
+		[this](USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint) { return CalculateSignificance(ObjectInfo, Viewpoint); },
+		USignificanceManager::EPostSignificanceType::Sequential,
+		[this](USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal) { ApplySignificance(ObjectInfo, OldSignificance, Significance, bFinal); });
+}
+
+void UPlayGroundCppSignificanceSubsystem::Unregister(AActor* Actor)
+{
+	ThrottledActors.Remove(Actor);
+
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (SignificanceManager != nullptr)
+	{
+		SignificanceManager->UnregisterObject(Actor);
+	}
+}
+
+void UPlayGroundCppSignificanceSubsystem::AddDisabledTickFunctions(int32 Delta)
+{
+	NumDisabledTickFunctions += Delta;
+}
+
+int32 UPlayGroundCppSignificanceSubsystem::GetBucketIndex(float Significance) const
+{
+	return FMath::Clamp(Buckets.Num() - FMath::RoundToInt(Significance), 0, FMath::Max(Buckets.Num() - 1, 0));
+}
+
+float UPlayGroundCppSignificanceSubsystem::CalculateSignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint) const
+{
+	const AActor* Actor = CastChecked<AActor>(ObjectInfo->GetObject());
+	const int32 NumBuckets = Buckets.Num();
+
+	// whatever the player is looking through is always fully significant
+	const APawn* Pawn = Cast<APawn>(Actor);
+	if (NumBuckets == 0 || (Pawn != nullptr && Pawn->IsLocallyControlled()))
+	{
+		return (float)NumBuckets;
+	}
+
+	const float DistanceSquared = FVector::DistSquared(Actor->GetActorLocation(), Viewpoint.GetLocation());
+	int32 BucketIndex = NumBuckets - 1;
+	for (int32 Index = 0; Index < NumBuckets - 1; ++Index)
+	{
+		if (DistanceSquared <= FMath::Square(Buckets[Index].MaxDistance))
+		{
+			BucketIndex = Index;
+			break;
+		}
+	}
+
+	// nothing is ever rendered when headless, distance alone decides there
+	if (bDemoteNotRendered && !PlayGroundCpp::IsHeadless() && !Actor->WasRecentlyRendered())
+	{
+		BucketIndex = FMath::Min(BucketIndex + 1, NumBuckets - 1);
+	}
+
+	return (float)(NumBuckets - BucketIndex);
+}
+
+void UPlayGroundCppSignificanceSubsystem::ApplySignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal)
+{
+	// the object is going away, nothing left to throttle
+	if (bFinal || Buckets.Num() == 0)
+	{
+		return;
+	}
+
+	const float TickInterval = Buckets[GetBucketIndex(Significance)].TickInterval;
+
+	AActor* Actor = CastChecked<AActor>(ObjectInfo->GetObject());
+	int32 NumTickFunctions = 0;
+	if (APlayGroundCppCharacter* Character = Cast<APlayGroundCppCharacter>(Actor))
+	{
+		NumTickFunctions = Character->ApplySignificanceTickInterval(TickInterval);
+	}
+	else if (APlayGroundCppProjectile* Projectile = Cast<APlayGroundCppProjectile>(Actor))
+	{
+		NumTickFunctions = Projectile->ApplySignificanceTickInterval(TickInterval);
+	}
+
+	ThrottledActors.Add(Actor, FThrottledActor{ NumTickFunctions, TickInterval });
+}
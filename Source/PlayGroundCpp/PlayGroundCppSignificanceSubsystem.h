@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SignificanceManager.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PlayGroundCppSignificanceSubsystem.generated.h"
+
+class APlayGroundCppCharacter;
+class APlayGroundCppProjectile;
+
+/** A distance band and the tick interval applied to everything that falls into it */
+USTRUCT()
+struct FPlayGroundCppSignificanceBucket
+{
+	GENERATED_BODY()
+
+	/** Objects up to this distance from the closest viewpoint fall into the bucket, ignored for the last bucket */
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float MaxDistance = 0.0f;
+
+	/** Tick interval in seconds for actors in this bucket, 0 ticks every frame */
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float TickInterval = 0.0f;
+};
+
+/**
+ * Feeds the world's significance manager with the player viewpoints every frame and throttles the tick rate
+ * of registered characters and projectiles according to the configured distance buckets. Objects that haven't
+ * been rendered recently drop one bucket further. Buckets are configured in DefaultGame.ini.
+ */
+UCLASS(config=Game)
+class UPlayGroundCppSignificanceSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UPlayGroundCppSignificanceSubsystem();
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	void RegisterCharacter(APlayGroundCppCharacter* Character);
+	void RegisterProjectile(APlayGroundCppProjectile* Projectile);
+	void Unregister(AActor* Actor);
+
+	/** Tracks tick functions switched off outright (e.g. hidden components) for the ticks saved stat */
+	void AddDisabledTickFunctions(int32 Delta);
+
+	/** Distance buckets, ordered from the closest to the farthest */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	TArray<FPlayGroundCppSignificanceBucket> Buckets;
+
+	/** Whether objects that weren't rendered recently are moved one bucket further out */
+	UPROPERTY(config, EditAnywhere, Category = Significance)
+	bool bDemoteNotRendered;
+
+private:
+	float CalculateSignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint) const;
+	void ApplySignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal);
+
+	/** Significance is NumBuckets for the closest bucket, down to 1 for the farthest */
+	int32 GetBucketIndex(float Significance) const;
+
+	struct FThrottledActor
+	{
+		int32 NumTickFunctions;
+		float TickInterval;
+	};
+
+	TMap<AActor*, FThrottledActor> ThrottledActors;
+	TArray<FTransform> Viewpoints;
+	int32 NumDisabledTickFunctions;
+};
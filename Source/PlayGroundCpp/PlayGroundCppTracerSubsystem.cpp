@@ -0,0 +1,155 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PlayGroundCppTracerSubsystem.h"
+#include "PlayGroundCpp.h"
+#include "PlayGroundCppProjectile.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+
+DECLARE_STATS_GROUP(TEXT("Tracers"), STATGROUP_PlayGroundCppTracers, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Tick tracers"), STAT_Tracers_Tick, STATGROUP_PlayGroundCppTracers);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live tracers"), STAT_Tracers_Live, STATGROUP_PlayGroundCppTracers);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Collision boxes"), STAT_Tracers_CollisionBoxes, STATGROUP_PlayGroundCppTracers);
+
+static void FireTracerBurst(const TArray<FString>& Args, UWorld* World)
+{
+	UPlayGroundCppTracerSubsystem* TracerSubsystem = (World != nullptr) ? World->GetSubsystem<UPlayGroundCppTracerSubsystem>() : nullptr;
+	const APlayerController* PlayerController = (World != nullptr) ? World->GetFirstPlayerController() : nullptr;
+	if (TracerSubsystem == nullptr || PlayerController == nullptr)
+	{
+		return;
+	}
+
+	const int32 Count = (Args.Num() > 0) ? FCString::Atoi(*Args[0]) : 1000;
+	const float SpreadDegrees = (Args.Num() > 1) ? FCString::Atof(*Args[1]) : 10.0f;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const FVector ViewDirection = ViewRotation.Vector();
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		TracerSubsystem->FireTracer(ViewLocation, FMath::VRandCone(ViewDirection, FMath::DegreesToRadians(SpreadDegrees)).Rotation());
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs TracerBurstCommand(
+	TEXT("PlayGroundCpp.Tracers.Burst"),
+	TEXT("Fires tracers from the first player's view in a cone: PlayGroundCpp.Tracers.Burst [Count=1000] [SpreadDegrees=10]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FireTracerBurst));
+
+UPlayGroundCppTracerSubsystem::UPlayGroundCppTracerSubsystem()
+{
+	MaxTracers = 32768;
+	Radius = 2.0f;
+	StreakSeconds = 0.02f;
+	Color = FLinearColor(40.0f, 12.0f, 2.0f);
+	InitialSpeed = 0.0f;
+}
+
+bool UPlayGroundCppTracerSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// nothing to see without a renderer
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World != nullptr && World->IsGameWorld() && !PlayGroundCpp::IsHeadless();
+}
+
+void UPlayGroundCppTracerSubsystem::Deinitialize()
+{
+	Tracers.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPlayGroundCppTracerSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// fly like the projectile actor would, so a tracer and an actor fired side by side stay together
+	const APlayGroundCppProjectile* Projectile = GetDefault<APlayGroundCppProjectile>();
+	const UProjectileMovementComponent* Movement = Projectile->GetProjectileMovement();
+
+	InitialSpeed = (Movement->MaxSpeed > 0.0f) ? FMath::Min(Movement->InitialSpeed, Movement->MaxSpeed) : Movement->InitialSpeed;
+
+	FGraphicToolsTracerSettings Settings;
+	Settings.MaxTracers = MaxTracers;
+	Settings.Lifetime = (Projectile->InitialLifeSpan > 0.0f) ? Projectile->InitialLifeSpan : Settings.Lifetime;
+	Settings.Gravity = FVector(0.0f, 0.0f, InWorld.GetGravityZ() * Movement->ProjectileGravityScale);
+	Settings.Bounciness = Movement->bShouldBounce ? Movement->Bounciness : 0.0f;
+	Settings.Friction = Movement->bShouldBounce ? Movement->Friction : 1.0f;
+	Settings.BounceStopSpeed = Movement->BounceVelocityStopSimulatingThreshold;
+	Settings.Radius = Radius;
+	Settings.StreakSeconds = StreakSeconds;
+	Settings.Color = Color;
+
+	Tracers = MakeUnique<FGraphicToolsTracers>(&InWorld, Settings);
+	RefreshCollision();
+}
+
+void UPlayGroundCppTracerSubsystem::RefreshCollision()
+{
+	if (!Tracers.IsValid())
+	{
+		return;
+	}
+
+	// the bounds of static geometry projectiles would bounce off, boxes are all the simulation knows
+	TArray<FBox> Boxes;
+	for (TActorIterator<AStaticMeshActor> It(GetWorld()); It; ++It)
+	{
+		const UStaticMeshComponent* Mesh = It->GetStaticMeshComponent();
+		if (Mesh != nullptr
+			&& Mesh->Mobility == EComponentMobility::Static
+			&& Mesh->IsCollisionEnabled()
+			&& Mesh->GetCollisionResponseToChannel(ECC_WorldDynamic) == ECR_Block)
+		{
+			Boxes.Add(Mesh->Bounds.GetBox());
+		}
+	}
+
+	// only the first GraphicToolsMaxTracerCollisionBoxes are kept, floors and walls matter more than props
+	Boxes.Sort([](const FBox& A, const FBox& B) { return A.GetVolume() > B.GetVolume(); });
+	Tracers->SetCollisionBoxes(Boxes);
+
+	SET_DWORD_STAT(STAT_Tracers_CollisionBoxes, FMath::Min(Boxes.Num(), GraphicToolsMaxTracerCollisionBoxes));
+}
+
+void UPlayGroundCppTracerSubsystem::FireTracer(const FVector& Location, const FRotator& Rotation)
+{
+	if (Tracers.IsValid())
+	{
+		Tracers->Spawn(Location, Rotation.Vector() * InitialSpeed);
+	}
+}
+
+ETickableTickType UPlayGroundCppTracerSubsystem::GetTickableTickType() const
+{
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+UWorld* UPlayGroundCppTracerSubsystem::GetTickableGameObjectWorld() const
+{
+	return GetWorld();
+}
+
+TStatId UPlayGroundCppTracerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPlayGroundCppTracerSubsystem, STATGROUP_Tickables);
+}
+
+void UPlayGroundCppTracerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Tracers_Tick);
+
+	if (Tracers.IsValid())
+	{
+		Tracers->Tick(DeltaTime);
+		SET_DWORD_STAT(STAT_Tracers_Live, Tracers->GetNumLive());
+	}
+}
@@ -0,0 +1,70 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphicToolsTracers.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "PlayGroundCppTracerSubsystem.generated.h"
+
+/**
+ * Purely cosmetic projectiles, simulated and drawn on the GPU by FGraphicToolsTracers, for shots that only need
+ * to be seen: remote players' fire and ambient effects. They fly with the speed, gravity, bounce and lifetime of
+ * APlayGroundCppProjectile's defaults and bounce off the bounding boxes of the level's static meshes, but hit
+ * nothing, so gameplay-relevant projectiles remain actors. Processes that never render don't create it.
+ */
+UCLASS(config=Game)
+class UPlayGroundCppTracerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UPlayGroundCppTracerSubsystem();
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// End of UWorldSubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Fires a tracer the way APlayGroundCppProjectile would be fired from Location facing Rotation, ignored before the world begins play */
+	UFUNCTION(BlueprintCallable, Category = Tracers)
+	void FireTracer(const FVector& Location, const FRotator& Rotation);
+
+	/** Gathers the boxes tracers bounce off again, for levels that stream static geometry in */
+	UFUNCTION(BlueprintCallable, Category = Tracers)
+	void RefreshCollision();
+
+	/** GPU slots, a tracer fired into a full system replaces the oldest */
+	UPROPERTY(config, EditAnywhere, Category = Tracers)
+	int32 MaxTracers;
+
+	/** Half the width of a streak */
+	UPROPERTY(config, EditAnywhere, Category = Tracers)
+	float Radius;
+
+	/** A streak trails its tracer by the distance it covers in this many seconds */
+	UPROPERTY(config, EditAnywhere, Category = Tracers)
+	float StreakSeconds;
+
+	/** HDR color added to the scene at the head of a streak */
+	UPROPERTY(config, EditAnywhere, Category = Tracers)
+	FLinearColor Color;
+
+private:
+	TUniquePtr<FGraphicToolsTracers> Tracers;
+
+	/** Launch speed of the projectile the tracers stand in for */
+	float InitialSpeed;
+};